@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace planner {
+
+// --- 動的メモリ確保の計測 (CMake の PLANNER_ALLOC_PROFILE=ON の場合のみ有効) ---
+// 有効な場合は大域の operator new/delete を置き換え、確保の回数、バイト数、生存中のバイト数の最大値を
+// その時点のスレッドの「段階」ごとに数え、プログラムの終了時に標準エラー出力へ表示する
+// 解放は確保した段階に計上するので、段階をまたいで生き残るメモリも確保した段階の生存量として残る
+// アリーナ (mmap) の領域は operator new を通らないので数えない
+enum class AllocPhase : uint8_t {
+    Other,          // どの段階にも属さない確保
+    Parse,          // 入力ファイルの読み込み
+    Ground,         // PDDL のグラウンディング
+    HeuristicSetup, // ヒューリスティックの前計算
+    Expansion,      // 探索 (後続状態の生成や、以下の 3 つに当たらない探索中の確保)
+    Evaluation,     // ヒューリスティックの評価
+    Open,           // オープンリストへの挿入
+    Closed,         // 状態の登録 (ハッシュ表、ノード配列)
+    Count,
+};
+
+const char* alloc_phase_name(AllocPhase ph) noexcept;
+
+// 計測が有効なビルドかどうか
+constexpr bool alloc_profile_enabled() noexcept {
+#ifdef PLANNER_ALLOC_PROFILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef PLANNER_ALLOC_PROFILE
+
+// 現在のスレッドの段階を返す関数
+AllocPhase current_alloc_phase() noexcept;
+
+// 生存している間、現在のスレッドの段階を ph にし、破棄時に元に戻す
+class AllocPhaseScope {
+public:
+    explicit AllocPhaseScope(AllocPhase ph) noexcept;
+    ~AllocPhaseScope();
+
+    AllocPhaseScope(const AllocPhaseScope&) = delete;
+    AllocPhaseScope& operator=(const AllocPhaseScope&) = delete;
+
+private:
+    AllocPhase prev_;
+};
+
+// ここまでの段階ごとの集計を表示する関数 (終了時には自動で呼ばれる)
+void alloc_profile_report(std::FILE* out);
+
+#define PLANNER_ALLOC_PHASE_CAT2(a, b) a##b
+#define PLANNER_ALLOC_PHASE_CAT(a, b) PLANNER_ALLOC_PHASE_CAT2(a, b)
+// 現在のブロックの終わりまで段階を切り替えるマクロ (無効なビルドでは何もしない)
+#define PLANNER_ALLOC_PHASE(ph) \
+    ::planner::AllocPhaseScope PLANNER_ALLOC_PHASE_CAT(planner_alloc_phase_, __LINE__)(::planner::AllocPhase::ph)
+
+#else
+
+#define PLANNER_ALLOC_PHASE(ph) ((void)0)
+
+#endif
+
+} // namespace planner
@@ -0,0 +1,145 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace planner {
+
+// --- 探索用の大きな配列を置くアリーナの設定 ---
+struct ArenaOptions {
+    enum class HugePages {
+        Off,         // 通常のページ
+        Transparent, // madvise(MADV_HUGEPAGE) で透過的ヒュージページを要求する
+        Explicit,    // MAP_HUGETLB で明示的なヒュージページを確保する (確保できない場合は Transparent に戻す)
+    };
+
+    HugePages huge_pages = HugePages::Transparent;
+    std::string backing_dir; // 空でない場合、このディレクトリの一時ファイルを背後に持つ (OS がページを書き出せる)
+    // 各アリーナが最初に予約する仮想アドレスの大きさ (以降は必要に応じて倍々に広げる)
+    // 予約も RLIMIT_AS に数えられるので、配列ごとに大きく取ると --search-mem-limit-mb を無駄に消費する
+    std::size_t initial_reserve = std::size_t(2) << 20;
+};
+
+// プロセス全体で共有するアリーナの設定 (探索の開始前に変更する)
+ArenaOptions& arena_options();
+
+// --- 1 つの連続した仮想アドレス領域 ---
+// 予約した領域はページに触れた時点で初めて実メモリを消費する
+// 予約を超える場合は mremap で領域を倍々に広げるので、既存の内容はコピーされない (アドレスは変わりうる)
+// 先読みの予約が仮想メモリの上限に掛かる場合は、必要な大きさだけを予約し直す (予約の余りで確保に失敗しない)
+// 新しく使えるようになった領域はゼロで埋まっている
+class Arena {
+public:
+    Arena() : Arena(arena_options()) {}
+    explicit Arena(const ArenaOptions& opt);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&& o) noexcept { swap(o); }
+    Arena& operator=(Arena&& o) noexcept { swap(o); return *this; }
+
+    void swap(Arena& o) noexcept;
+
+    // 先頭から bytes バイトまでを使えるようにし、先頭アドレスを返す関数 (確保できない場合は std::bad_alloc)
+    void* ensure(std::size_t bytes);
+
+    void* data() const noexcept { return base_; }
+    std::size_t reserved() const noexcept { return reserved_; }
+    std::size_t committed() const noexcept { return committed_; }
+
+private:
+    void map_initial(std::size_t bytes);
+    void* map_range(std::size_t res); // res バイトを設定に応じた方式で mmap する関数 (失敗時は MAP_FAILED)
+    void grow(std::size_t bytes);
+
+    void* base_ = nullptr;
+    std::size_t reserved_ = 0;  // 予約済みの仮想アドレスの大きさ
+    std::size_t committed_ = 0; // 使用可能として払い出した大きさ (ファイルの場合はファイルの大きさ)
+    std::size_t pending_reserve_ = 0; // 最初の確保時に予約する大きさ
+    int fd_ = -1;               // ファイルを背後に持つ場合のファイル記述子
+    bool hugetlb_ = false;      // MAP_HUGETLB で確保しているかどうか
+    ArenaOptions::HugePages huge_ = ArenaOptions::HugePages::Off;
+};
+
+// --- アリーナ上の動的配列 ---
+// std::vector の部分集合のインターフェースを持ち、伸長時に要素をコピーしない (要素はトリビアルにコピー可能な型に限る)
+template <class T>
+class ArenaVector {
+    static_assert(std::is_trivially_copyable_v<T>, "ArenaVector requires a trivially copyable element type");
+
+public:
+    ArenaVector() = default;
+    ArenaVector(std::size_t n, const T& v) { assign(n, v); }
+
+    ArenaVector(ArenaVector&& o) noexcept { swap(o); }
+    ArenaVector& operator=(ArenaVector&& o) noexcept { swap(o); return *this; }
+
+    void swap(ArenaVector& o) noexcept {
+        arena_.swap(o.arena_);
+        std::swap(data_, o.data_);
+        std::swap(size_, o.size_);
+    }
+
+    std::size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+    T* data() noexcept { return data_; }
+    const T* data() const noexcept { return data_; }
+    T* begin() noexcept { return data_; }
+    T* end() noexcept { return data_ + size_; }
+    const T* begin() const noexcept { return data_; }
+    const T* end() const noexcept { return data_ + size_; }
+
+    T& operator[](std::size_t i) noexcept { return data_[i]; }
+    const T& operator[](std::size_t i) const noexcept { return data_[i]; }
+    T& back() noexcept { return data_[size_ - 1]; }
+
+    void reserve(std::size_t n) { ensure_(n); }
+
+    void clear() noexcept { size_ = 0; }
+
+    void resize(std::size_t n) { resize(n, T{}); }
+
+    void resize(std::size_t n, const T& v) {
+        if (n > size_) {
+            ensure_(n);
+            for (std::size_t i = size_; i < n; ++i) {
+                new (data_ + i) T(v);
+            }
+        }
+        size_ = n;
+    }
+
+    void assign(std::size_t n, const T& v) {
+        clear();
+        resize(n, v);
+    }
+
+    template <class... Args>
+    T& emplace_back(Args&&... args) {
+        ensure_(size_ + 1);
+        new (data_ + size_) T{std::forward<Args>(args)...};
+        return data_[size_++];
+    }
+
+    void push_back(const T& v) { (void)emplace_back(v); }
+
+    void pop_back() noexcept { --size_; }
+
+private:
+    void ensure_(std::size_t n) {
+        if (n * sizeof(T) > arena_.committed()) {
+            data_ = static_cast<T*>(arena_.ensure(n * sizeof(T)));
+        }
+    }
+
+    Arena arena_;
+    T* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+} // namespace planner
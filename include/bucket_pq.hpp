@@ -10,6 +10,8 @@
 #include <vector>
 #include <functional>
 
+#include "arena.hpp"
+#include "alloc_profile.hpp"
 #include "sas/parallel_SOC/stats.hpp"
 #include "sas/parallel_SOC/concurrency.hpp"
 
@@ -221,6 +223,7 @@ public:
 
     // insert 関数
     void insert(Value v, Key k) {
+        PLANNER_ALLOC_PHASE(Open);
 
         // Key と Value がコンテナに入るように調整する
         ensure_buckets_(static_cast<uint32_t>(k));
@@ -324,7 +327,7 @@ private:
     };
 
     DynamicArray< DynamicArray<Value> > buckets_; // ノード id の動的配列を要素とする動的配列. buckets_[key] = [values...]
-    DynamicArray<Pos> pos_; //Pos Structure を要素とする動的配列. pos_[value] = {key, idx, present}
+    planner::ArenaVector<Pos> pos_; //Pos Structure を要素とする動的配列. pos_[value] = {key, idx, present} (ノード数に比例して大きくなるので、アリーナ上に置く)
     Key min_key_; // 現在の最小値を追跡する変数
     uint32_t count_; // 要素の数をカウントする変数
 
@@ -437,8 +440,26 @@ public:
     // 総要素数を返す関数
     uint64_t size() const noexcept { return count_; }
 
+    // 最小キーを返す関数 (空の場合は UINT32_MAX)
+    Key min_key() const {
+        if (count_ == 0) {
+            return UINT32_MAX;
+        }
+        const int f = fbits_.find_first();
+        const int h = layers_[static_cast<uint32_t>(f)].hbits.find_first();
+        return (static_cast<Key>(f) << H_BITS) | (static_cast<Key>(h) & H_MASK);
+    }
+
+    // f 層を先頭から n 層分確保しておく関数 (探索中の拡張を減らす)
+    void reserve_f(uint32_t n) {
+        if (n > 0) {
+            ensure_f_(n - 1);
+        }
+    }
+
     // value (node id) に Key (f, h pack) を設定して挿入する関数
     void insert(Value v, Key k) {
+        PLANNER_ALLOC_PHASE(Open);
         ensure_pos_(v);
 
         uint32_t idx = id2idx_.at(v);
@@ -710,8 +731,8 @@ private:
     // 非空 f をビットで管理
     Bitset fbits_;
 
-    // pos_[value]
-    DynamicArray<Pos> pos_;
+    // pos_[value] (ノード数に比例して大きくなるので、アリーナ上に置く)
+    planner::ArenaVector<Pos> pos_;
 
     // 総要素数
     uint64_t count_;
@@ -721,7 +742,7 @@ private:
     void ensure_pos_(Value v) {
         auto it = id2idx_.find(v);
         if (it == id2idx_.end()) {
-            uint32_t idx = pos_.size();
+            uint32_t idx = static_cast<uint32_t>(pos_.size());
             pos_.resize(idx + 1);
             id2idx_.emplace(v, idx);
         }
@@ -810,3 +831,177 @@ private:
     // 64-bit 外部 ID -> 連番 idx（0..pos_.size()-1）へのマップ
      std::unordered_map<Value, uint32_t> id2idx_;
 };
+
+
+// --- Lazy Two-level Bucket Queue ---
+// decrease_key を持たず、同じ値の重複挿入を許すバケットキュー (古いエントリは取り出し側で読み捨てる)
+// 値ごとの位置表を持たないため、状態のランクのような疎で巨大な ID 空間でも追加のメモリを必要としない
+template <class V = uint32_t>
+class LazyBucketQueue {
+public:
+    using Value = V;
+    using Key   = UKey;
+
+    bool empty() const noexcept { return count_ == 0; }
+
+    uint64_t size() const noexcept { return count_; }
+
+    // value に Key (f, h pack) を設定して挿入する関数
+    void insert(Value v, Key k) {
+        PLANNER_ALLOC_PHASE(Open);
+        const uint32_t f = static_cast<uint32_t>(unpack_f(k));
+        const uint32_t h = static_cast<uint32_t>(unpack_h(k));
+
+        if (f >= layers_.size()) {
+            layers_.resize(f + 1);
+        }
+        Layer &L = layers_[f];
+        if (h >= L.buckets.size()) {
+            L.buckets.resize(h + 1);
+        }
+        L.buckets[h].push_back(v);
+
+        // 各層・全体の最小値のカーソルを戻す
+        if (L.count == 0 || h < L.min_h) {
+            L.min_h = h;
+        }
+        if (count_ == 0 || f < min_f_) {
+            min_f_ = f;
+        }
+        ++L.count;
+        ++count_;
+    }
+
+    // 最小キー（最小 f、同値時は最小 h）を 1 つ取り出す関数、同じバケット内では LIFO
+    std::pair<Value, Key> extract_min() {
+        assert(count_ > 0);
+
+        while (layers_[min_f_].count == 0) {
+            ++min_f_;
+        }
+        Layer &L = layers_[min_f_];
+        while (L.buckets[L.min_h].empty()) {
+            ++L.min_h;
+        }
+
+        auto &bucket = L.buckets[L.min_h];
+        Value v = bucket.back();
+        bucket.pop_back();
+        --L.count;
+        --count_;
+
+        return {v, (static_cast<Key>(min_f_) << H_BITS) | (static_cast<Key>(L.min_h) & H_MASK)};
+    }
+
+    void clear() {
+        layers_.clear();
+        min_f_ = 0;
+        count_ = 0;
+    }
+
+private:
+    struct Layer {
+        std::vector<std::vector<Value>> buckets; // buckets[h] = [values...]
+        uint32_t min_h = 0; // 空でない最小の h (の下界)
+        uint64_t count = 0; // 層内の要素数
+    };
+
+    std::vector<Layer> layers_; // layers_[f]
+    uint32_t min_f_ = 0; // 空でない最小の f (の下界)
+    uint64_t count_ = 0;
+};
+
+
+// --- FIFO Two-level Bucket Queue ---
+// LazyBucketQueue と同じく decrease_key を持たないが、同じバケット内では挿入順 (FIFO) に取り出す
+// 各バケットは配列 1 本と読み出し位置のみで表し、空になった時点で先頭から使い直す
+// f の層が空になったら層ごとバケットを解放するので、f が単調に増える探索 (単位コスト + consistent なヒューリスティック) では、生きている層の分しかメモリを持たない
+template <class V = uint32_t>
+class FifoBucketQueue {
+public:
+    using Value = V;
+    using Key   = UKey;
+
+    bool empty() const noexcept { return count_ == 0; }
+
+    uint64_t size() const noexcept { return count_; }
+
+    // value に Key (f, h pack) を設定して挿入する関数
+    void insert(Value v, Key k) {
+        PLANNER_ALLOC_PHASE(Open);
+        const uint32_t f = static_cast<uint32_t>(unpack_f(k));
+        const uint32_t h = static_cast<uint32_t>(unpack_h(k));
+
+        if (f >= layers_.size()) {
+            layers_.resize(f + 1);
+        }
+        Layer &L = layers_[f];
+        if (h >= L.buckets.size()) {
+            L.buckets.resize(h + 1);
+        }
+        L.buckets[h].items.push_back(v);
+
+        // 各層・全体の最小値のカーソルを戻す
+        if (L.count == 0 || h < L.min_h) {
+            L.min_h = h;
+        }
+        if (count_ == 0 || f < min_f_) {
+            min_f_ = f;
+        }
+        ++L.count;
+        ++count_;
+    }
+
+    // 最小キー（最小 f、同値時は最小 h）を 1 つ取り出す関数、同じバケット内では FIFO
+    std::pair<Value, Key> extract_min() {
+        assert(count_ > 0);
+
+        while (layers_[min_f_].count == 0) {
+            release(layers_[min_f_]);
+            ++min_f_;
+        }
+        Layer &L = layers_[min_f_];
+        while (L.buckets[L.min_h].head == L.buckets[L.min_h].items.size()) {
+            ++L.min_h;
+        }
+
+        Bucket &b = L.buckets[L.min_h];
+        Value v = b.items[b.head++];
+        if (b.head == b.items.size()) {
+            b.items.clear();
+            b.head = 0;
+        }
+        --L.count;
+        --count_;
+
+        return {v, (static_cast<Key>(min_f_) << H_BITS) | (static_cast<Key>(L.min_h) & H_MASK)};
+    }
+
+    void clear() {
+        layers_.clear();
+        min_f_ = 0;
+        count_ = 0;
+    }
+
+private:
+    struct Bucket {
+        std::vector<Value> items;
+        std::size_t head = 0; // 次に取り出す位置
+    };
+
+    struct Layer {
+        std::vector<Bucket> buckets; // buckets[h]
+        uint32_t min_h = 0; // 空でない最小の h (の下界)
+        uint64_t count = 0; // 層内の要素数
+    };
+
+    // 空になった層のバケットを解放する関数 (後から同じ f で挿入された場合は作り直す)
+    static void release(Layer &L) {
+        std::vector<Bucket>().swap(L.buckets);
+        L.min_h = 0;
+    }
+
+    std::vector<Layer> layers_; // layers_[f]
+    uint32_t min_f_ = 0; // 空でない最小の f (の下界)
+    uint64_t count_ = 0;
+};
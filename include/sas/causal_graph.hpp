@@ -0,0 +1,53 @@
+#pragma once
+#include <limits>
+#include <utility>
+#include <vector>
+#include "sas/sas_reader.hpp"
+
+namespace planner { namespace sas {
+
+// --- 因果グラフ ---
+// 変数 u の値が変数 v を変える演算子の条件になる場合 (pre -> eff) と、同じ演算子が u と v の両方を変える場合 (eff -- eff) に辺を持つ
+struct CausalGraph {
+    std::vector<std::vector<int>> pre_to_eff;   // pre_to_eff[u] = u の値を条件として変わる変数 v
+    std::vector<std::vector<int>> eff_to_eff;   // eff_to_eff[u] = u と同じ演算子で変わる変数 v (対称)
+    std::vector<std::vector<int>> successors;   // 上の 2 つの和 (u -> v)
+    std::vector<std::vector<int>> predecessors; // successors の逆向き
+
+    explicit CausalGraph(const Task& T);
+
+    // 辺の向きに閉路を持たないかどうか
+    bool is_acyclic() const;
+};
+
+// --- 領域遷移グラフ (DTG) の遷移 ---
+// 演算子 op の 1 つの効果による、変数の値 from -> to の遷移 (conds はこの変数以外の変数に対する条件で、(var, val) の昇順)
+struct DTGTransition {
+    int from = -1;
+    int to = -1;
+    int op = -1;
+    int cost = 0;
+    std::vector<std::pair<int, int>> conds;
+};
+
+// --- 1 つの変数の領域遷移グラフ ---
+// 前提条件の値を持たない効果 (pre = -1) は、post 以外の全ての値からの遷移として展開する
+// dist は条件を無視した値の間の最短距離で、構築時に全点対を求めておく
+struct DomainTransitionGraph {
+    static constexpr int UNREACHABLE = std::numeric_limits<int>::max();
+
+    int var = -1;
+    int domain = 0;
+    std::vector<std::vector<DTGTransition>> out; // out[from]
+    std::vector<int> dist;                        // dist[from * domain + to]
+
+    int distance(int from, int to) const { return dist[static_cast<std::size_t>(from) * domain + to]; }
+
+    // どの遷移も他の変数の条件を持たないかどうか (この場合 dist がそのまま遷移のコストになる)
+    bool unconditioned() const;
+};
+
+// 全ての変数の DTG を作る関数 (返り値の添字は変数の番号)
+std::vector<DomainTransitionGraph> build_dtgs(const Task& T);
+
+}} // namespace planner::sas
@@ -0,0 +1,126 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "sas/sas_reader.hpp"
+#include "arena.hpp"
+
+namespace planner { namespace sas {
+
+// --- 状態のランク付け (完全ハッシュ) ---
+// 変数 v の値を混合基数 (mixed radix) の v 桁目とみなし、状態を 0..num_states-1 の整数に一対一で対応させる
+// rank(s) = Σ_v s[v] * mult[v], mult[v] = Π_{u<v} domain(u)
+class StateRanker {
+public:
+    // 状態数 (ドメインサイズの積) が max_states 以下の場合のみ fits() が true となる
+    StateRanker(const Task& T, uint64_t max_states);
+
+    bool fits() const noexcept { return fits_; }
+    uint64_t num_states() const noexcept { return num_states_; }
+
+    // 状態をランクに変換する関数
+    uint64_t rank(const State& s) const noexcept {
+        uint64_t r = 0;
+        for (std::size_t v = 0; v < mult_.size(); ++v) {
+            r += static_cast<uint64_t>(s[v]) * mult_[v];
+        }
+        return r;
+    }
+
+    // 変数 var の値が old_val から new_val に変化した時のランクを差分で求める関数 (符号なしの剰余演算で計算する)
+    uint64_t rerank(uint64_t r, int var, int old_val, int new_val) const noexcept {
+        return r - static_cast<uint64_t>(old_val) * mult_[var] + static_cast<uint64_t>(new_val) * mult_[var];
+    }
+
+    // 親状態 parent に演算子を適用した succ のランクを、undo 履歴 (var, old_value) の mark 以降の差分から求める関数
+    // 同じ変数が複数回書き換わる場合は最初の 1 回のみ数える
+    template <class UndoLog>
+    uint64_t rank_after(uint64_t r, const State& parent, const State& succ, const UndoLog& u, std::size_t mark) const noexcept {
+        for (std::size_t i = mark; i < u.size(); ++i) {
+            const int var = u[i].first;
+            bool seen = false;
+            for (std::size_t j = mark; j < i; ++j) {
+                if (u[j].first == var) {
+                    seen = true;
+                    break;
+                }
+            }
+            if (!seen) {
+                r = rerank(r, var, parent[var], succ[var]);
+            }
+        }
+        return r;
+    }
+
+    // ランクから状態を復元する関数 (out は変数の数の大きさにリサイズされる)
+    void unrank(uint64_t r, State& out) const {
+        out.resize(dom_.size());
+        for (std::size_t v = 0; v < dom_.size(); ++v) {
+            const uint64_t d = dom_[v];
+            out[v] = static_cast<int>(r % d);
+            r /= d;
+        }
+    }
+
+private:
+    std::vector<uint64_t> dom_;  // 各変数のドメインサイズ
+    std::vector<uint64_t> mult_; // 各変数の桁の重み
+    uint64_t num_states_ = 0;
+    bool fits_ = false;
+};
+
+// --- ランクで引く密な状態表 ---
+// 1 状態あたり 16 byte のメタ情報のみを保持し、状態そのものやハッシュ値は保存しない
+// h は状態ごとに不変なので、初めて訪れた時に 1 度だけ書き込み、g-value の改善時には評価し直さない
+struct DenseMeta {
+    static constexpr uint32_t NO_PARENT = UINT32_MAX;
+    static constexpr uint32_t CLOSED_BIT = 1u << 31;
+
+    uint32_t g1;        // g-value + 1 (0 は未訪問を表す)
+    uint32_t parent;    // 親状態のランク (初期状態は NO_PARENT)
+    uint32_t op_closed; // 下位 31bit は適用した演算子 ID、最上位 bit は closed フラグ
+    uint32_t h_value;   // ヒューリスティック値
+
+    bool seen() const noexcept { return g1 != 0; }
+    int g() const noexcept { return static_cast<int>(g1 - 1); }
+    int h() const noexcept { return static_cast<int>(h_value); }
+    bool closed() const noexcept { return (op_closed & CLOSED_BIT) != 0; }
+    uint32_t op() const noexcept { return op_closed & ~CLOSED_BIT; }
+
+    void set(int g_value, uint32_t parent_rank, uint32_t op_id) noexcept {
+        g1 = static_cast<uint32_t>(g_value) + 1u;
+        parent = parent_rank;
+        op_closed = op_id; // 新規登録・g-value の更新時は open 扱いにする
+    }
+    void set_h(int h_val) noexcept { h_value = static_cast<uint32_t>(h_val); }
+    void close() noexcept { op_closed |= CLOSED_BIT; }
+    void reopen() noexcept { op_closed &= ~CLOSED_BIT; }
+};
+
+class DenseStateTable {
+public:
+    // 親のランクを 32bit で保持するため、状態数は UINT32_MAX 未満に制限する
+    static constexpr uint64_t MAX_STATES = UINT32_MAX - 1ull;
+
+    // ゼロ初期化済みの領域をアリーナ上に確保する (触れたページのみが実メモリを消費する)
+    explicit DenseStateTable(uint64_t num_states);
+
+    DenseStateTable(const DenseStateTable&) = delete;
+    DenseStateTable& operator=(const DenseStateTable&) = delete;
+
+    DenseMeta& operator[](uint64_t r) noexcept { return data_[r]; }
+    const DenseMeta& operator[](uint64_t r) const noexcept { return data_[r]; }
+
+    uint64_t size() const noexcept { return n_; }
+    std::size_t bytes() const noexcept { return static_cast<std::size_t>(n_) * sizeof(DenseMeta); }
+
+private:
+    Arena arena_;
+    DenseMeta* data_ = nullptr;
+    uint64_t n_ = 0;
+};
+
+// ゴール状態から初期状態までの親をたどり、適用した演算子の列を返す関数
+std::vector<uint32_t> extract_plan_dense(const DenseStateTable& table, uint64_t goal_rank);
+
+}} // namespace planner::sas
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "sas/sas_reader.hpp"
+#include "sas/sas_heuristic.hpp"
+#include "sas/sas_search.hpp"
+
+namespace planner { namespace sas {
+
+// プロセス間の接続の種類
+enum class HdaTransport {
+    Unix, // socketpair(AF_UNIX)
+    Tcp,  // 127.0.0.1 上の TCP
+};
+
+struct HdaParams {
+    int num_procs = 2;                         // 探索に参加するプロセスの数 (呼び出し元を含む)
+    HdaTransport transport = HdaTransport::Unix;
+    int tcp_port = 0;                          // TCP の場合、プロセス r は tcp_port + r で待ち受ける (0 の場合は空いているポートを使う)
+    std::size_t batch_bytes = 16 * 1024;       // 宛先ごとの後続状態のバッファがこの大きさを超えたら送る
+    int expansions_per_poll = 64;              // ソケットを確認する間に展開するノード数
+};
+
+struct HdaResult {
+    Result result;                // プランと、全プロセスの統計の合計
+    std::vector<Stats> per_proc;  // プロセスごとの統計 (番号順)
+    uint64_t messages = 0;        // 送った後続状態のバッチの数 (全プロセスの合計)
+    uint64_t bytes = 0;           // 送ったバイト数 (全プロセスの合計)
+};
+
+// --- 複数プロセスによる HDA* (hash distributed A*) ---
+// 呼び出し元をプロセス 0 として num_procs - 1 個のプロセスを fork し、状態のハッシュ値で状態空間を分割して各プロセスが担当する
+// 後続状態は担当のプロセスへ、宛先ごとにまとめ、各変数をドメインの大きさに合わせた bit 数に詰めて送る (h の計算は担当のプロセスで行う)
+// ゴールを見つけたプロセスは暫定解のコストを全てのプロセスに知らせ、各プロセスは f がそれ以上のノードを展開しない
+// 終了判定は Mattern のメッセージ数を数える方式 (Safra のトークンリング) で行い、全てのプロセスが受動的で送受信数が一致した時点で終える
+// 整数コストのタスクのみを扱う (それ以外は std::domain_error を投げる)
+HdaResult distributed_astar(const Task& T, HeuristicFn h, const HdaParams& hp, const Params& p);
+
+}} // namespace planner::sas
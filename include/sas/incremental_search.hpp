@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <set>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "sas/sas_reader.hpp"
+#include "sas/sas_heuristic.hpp"
+#include "sas/sas_search.hpp"
+#include "sas/state_index.hpp"
+
+namespace planner { namespace sas {
+
+// --- 初期状態や演算子のコストの変更に対して、探索グラフを使い回して再計画する LPA* ---
+// 展開済みの状態と、その間の辺 (親, 演算子) を保持し、g 値と rhs 値 (親の g 値から見積もった最短距離) が一致しない状態のみを
+// 優先度付きキューに入れて修正するので、変更の影響を受けた部分だけが再展開される
+// ゴール状態は、コスト 0 の辺で仮想的なゴールノードにつながっているものとして扱う
+// ヒューリスティックは consistent でなければならず、コストを下げる変更の後も consistent である必要がある (blind は常に満たす)
+class IncrementalPlanner {
+public:
+    IncrementalPlanner(const Task& T, HeuristicFn h, const Params& p = {});
+
+    // 現在の初期状態・コストでの最適プランを求める関数 (2 回目以降は前回の探索グラフを修正する)
+    // R.stats は今回の呼び出しで行った分のみを数え、R.nodes は空のままにする
+    Result plan();
+
+    // 初期状態の変数の値を変更する関数 ((var, value) の列)
+    void update_init(const std::vector<std::pair<int, int>>& changes);
+
+    // 演算子のコストを変更する関数 ((op index, cost) の列)
+    void update_costs(const std::vector<std::pair<int, int>>& changes);
+
+    // 変更を反映したタスク (init と ops[].cost が更新される)
+    const Task& task() const noexcept { return T_; }
+
+    // これまでに生成した状態の数
+    std::size_t num_nodes() const noexcept { return nodes_.size() - 1; }
+
+private:
+    struct Edge {
+        int node; // 辺の反対側のノード
+        int op;   // 演算子 (仮想ゴールへの辺は -1)
+    };
+
+    using Key = std::tuple<double, double, int>;
+
+    struct LNode {
+        State s;
+        double g = std::numeric_limits<double>::infinity();
+        double rhs = std::numeric_limits<double>::infinity();
+        double h = 0.0;
+        bool goal_state = false;
+        bool expanded = false;   // 後続状態を生成済みかどうか
+        bool queued = false;
+        Key key{};               // キューに入っている場合のキー
+        std::vector<Edge> preds; // 展開済みの親からの辺
+        std::vector<Edge> succs; // 後続状態への辺 (expanded の場合のみ)
+    };
+
+    static constexpr int GOAL = 0; // 仮想ゴールノードの ID
+
+    double edge_cost(int op) const { return op < 0 ? 0.0 : static_cast<double>(T_.ops[op].cost); }
+    Key calc_key(int u) const;
+    int node_of(const State& s, Stats& st);
+    void ensure_expanded(int u, Stats& st);
+    void update_vertex(int u);
+    void enqueue(int u);
+    void dequeue(int u);
+
+    Task T_;
+    HeuristicFn h_;
+    Params p_;
+    std::vector<LNode> nodes_;
+    StateIndex index_of_;
+    SuccessorBatch batch_;
+    std::vector<std::vector<std::pair<int, int>>> edges_of_op_; // 演算子ごとの (親, 子) の辺
+    std::set<std::pair<Key, int>> open_;
+    int start_ = -1;
+};
+
+}} // namespace planner::sas
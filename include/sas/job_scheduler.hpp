@@ -0,0 +1,90 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+#include "sas/planner_session.hpp"
+#include "sas/resumable_search.hpp"
+
+namespace planner { namespace sas {
+
+// スケジューラに投入する 1 つの探索
+struct JobSpec {
+    std::shared_ptr<const Task> task;
+    std::string algo = "astar";          // astar / gbfs
+    std::string heuristic = "goalcount"; // make_heuristic() に渡す名前 (ジョブごとに構築する)
+    int priority = 1;                    // 大きいほど多くの時間を割り当てる (1 以上)
+    int64_t time_limit_ms = -1;          // 投入時点からの実時間の上限 (負の場合は無効)
+    CancelToken cancel;
+    Params params;                       // 探索パラメータ (verbose と control はスケジューラが上書きする)
+};
+
+// 投入したジョブの結果の受け取り口
+struct JobHandle {
+    uint64_t id = 0;
+    CancelToken cancel; // JobSpec::cancel と同じフラグ
+    std::shared_future<SolveResult> result;
+};
+
+// --- 少数のスレッドで多数の小さな探索を交互に進めるスケジューラ ---
+// 各ジョブは ResumableSearch として状態を保ったまま、time slice ごとに空いたスレッドで再開される
+// 実行するジョブは stride scheduling で選ぶ: 各ジョブの仮想時間 (使った実時間 / priority) が最小のものを優先する
+class JobScheduler {
+public:
+    struct Config {
+        uint32_t num_threads = 0;          // 0 の場合は hardware_concurrency() を用いる
+        uint64_t slice_expansions = 1000;  // 1 回の time slice で展開する最大ノード数
+    };
+
+    explicit JobScheduler(Config cfg);
+    JobScheduler() : JobScheduler(Config{}) {}
+
+    // 未完了のジョブを全て中断し、スレッドを終了させる
+    ~JobScheduler();
+
+    JobScheduler(const JobScheduler&) = delete;
+    JobScheduler& operator=(const JobScheduler&) = delete;
+
+    // ジョブを投入する関数
+    JobHandle submit(JobSpec spec);
+
+    // 実行待ちまたは実行中のジョブの数
+    std::size_t active() const;
+
+private:
+    struct Job {
+        uint64_t id = 0;
+        JobSpec spec;
+        SearchControl control;
+        std::unique_ptr<ResumableSearch> search; // 初回の time slice で作る
+        std::promise<SolveResult> promise;
+        double pass = 0.0;       // 仮想時間
+        double search_sec = 0.0; // 探索に使った実時間
+    };
+
+    struct LaterPass {
+        bool operator()(const Job* a, const Job* b) const {
+            return a->pass > b->pass || (a->pass == b->pass && a->id > b->id);
+        }
+    };
+
+    void worker();
+    bool run_slice(Job& job); // ジョブが終了した場合に true を返す
+
+    Config cfg_;
+    mutable std::mutex mu_;
+    std::condition_variable cv_;
+    std::priority_queue<Job*, std::vector<Job*>, LaterPass> ready_;
+    std::vector<std::unique_ptr<Job>> jobs_; // 未完了のジョブ (所有権)
+    double vtime_ = 0.0; // 最後に選んだジョブの仮想時間 (新しいジョブはここから始める)
+    uint64_t next_id_ = 0;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+};
+
+}} // namespace planner::sas
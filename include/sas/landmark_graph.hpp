@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "sas/sas_reader.hpp"
+
+namespace planner { namespace sas {
+
+// ランドマーク: facts のいずれかが、プランのどこかで必ず真になる
+// facts が 1 つなら fact landmark、2 つ以上なら disjunctive fact landmark
+// achiever が 1 つしかない場合、その演算子はプランに必ず現れる (action landmark)
+struct Landmark {
+    std::vector<std::pair<int, int>> facts; // (変数, 値)
+    std::vector<uint32_t> achievers;        // facts のいずれかを追加しうる演算子 (初期状態から緩和到達可能なもののみ)
+    std::vector<int> parents;               // この landmark を達成する直前までに真になる必要がある landmark (必要順序)
+    bool goal = false;                      // ゴールの fact かどうか
+};
+
+// --- ランドマークグラフ ---
+// ゴールの fact から始め、landmark の全ての achiever に共通する前提条件を新しい fact landmark とし、
+// 全ての achiever が同じ変数に前提条件を持つ場合は、その値の和集合を disjunctive fact landmark とする (後ろ向きの連鎖)
+// 辺 (parents) はいずれも必要順序なので、状態 s から先で必要な landmark は s だけから求まる (required)
+class LandmarkGraph {
+public:
+    explicit LandmarkGraph(const Task& T, std::size_t max_landmarks = 10000, std::size_t max_disjunction = 4);
+
+    const std::vector<Landmark>& landmarks() const noexcept { return lms_; }
+    std::size_t size() const noexcept { return lms_.size(); }
+    std::size_t num_disjunctive() const noexcept { return num_disjunctive_; }
+    std::size_t num_action() const noexcept { return num_action_; }
+
+    // landmark id が状態 s で満たされているかどうか
+    bool satisfied(int id, const State& s) const;
+
+    // 状態 s から先のどのプランでも達成する必要がある landmark の番号を out に積む関数
+    // s で偽のゴール landmark から、s で偽の landmark だけを通って parents をたどった閉包を返す
+    // mark は size() 個の 0 で初期化した作業領域 (戻る時に 0 に戻す)
+    void required(const State& s, std::vector<int>& out, std::vector<uint8_t>& mark) const;
+
+private:
+    std::vector<Landmark> lms_;
+    std::vector<int> goals_; // ゴール landmark の番号
+    std::size_t num_disjunctive_ = 0;
+    std::size_t num_action_ = 0;
+};
+
+}} // namespace planner::sas
@@ -0,0 +1,112 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace planner { namespace sas {
+
+// --- 線形計画問題 ---
+// maximize obj^T x  s.t.  rows[i] * x <= rhs[i] (i = 0..m-1),  x >= 0
+// rhs[i] >= 0 を仮定する (原点が実行可能なので、スラック変数を基底とした単体法をそのまま始められる)
+// コスト分割のような、非負の予算を変数で分け合う問題がこの形になる
+struct LinearProgram {
+    int num_cols = 0;
+    std::vector<double> obj;                                  // 目的関数の係数 (num_cols 個)
+    std::vector<std::vector<std::pair<int, double>>> rows;    // 制約の係数 (列番号, 係数)
+    std::vector<double> rhs;                                  // 制約の右辺
+
+    // 行を追加し、その番号を返す関数
+    int add_row(std::vector<std::pair<int, double>> coeffs, double b) {
+        rows.push_back(std::move(coeffs));
+        rhs.push_back(b);
+        return static_cast<int>(rows.size()) - 1;
+    }
+};
+
+enum class LPStatus {
+    Optimal,
+    Unbounded,
+    Infeasible,
+    IterationLimit,
+};
+
+struct LPSolution {
+    LPStatus status = LPStatus::Optimal;
+    double objective = 0.0;     // status が IterationLimit の場合は、打ち切った時点の実行可能解の値
+    std::vector<double> x;      // 主問題の解 (num_cols 個)
+    std::vector<double> duals;  // 各制約の双対変数 (Optimal の場合のみ意味を持つ)
+    int iterations = 0;
+};
+
+// 単体法 (密な縮約タブロー、m x num_cols) で解く関数
+// 既定では最大の被約費用の列を選び、退化した反復が続く場合は Bland の規則に切り替えて巡回を避ける
+// rhs に負の値がある場合は std::invalid_argument を投げる
+LPSolution solve_lp(const LinearProgram& lp, int max_iterations = 10000);
+
+// --- 疎行列 (CSR) ---
+// 行 i の要素は index/value の [row_start[i], row_start[i+1]) にある
+struct SparseMatrix {
+    int num_rows = 0;
+    int num_cols = 0;
+    std::vector<int> row_start{0};
+    std::vector<int> index;
+    std::vector<double> value;
+
+    // (列番号, 係数) の行の並びから作る関数 (同じ列の係数は足し合わせ、0 の係数は捨てる)
+    static SparseMatrix from_rows(int num_cols, const std::vector<std::vector<std::pair<int, double>>>& rows);
+
+    SparseMatrix transpose() const;
+    std::size_t nnz() const noexcept { return value.size(); }
+};
+
+// --- 右辺だけが変わる線形計画問題 ---
+// minimize cost^T y  s.t.  A y >= b,  y >= 0  (cost >= 0)
+// cost >= 0 なので、どの b に対してもスラック変数の基底は双対実行可能であり、双対単体法を phase 1 なしで始められる
+struct MinCostLP {
+    SparseMatrix A;   // m x n (CSR)
+    SparseMatrix At;  // A の転置 (列ごとの走査に使う)
+    std::vector<double> cost;
+
+    // cost に負の値がある場合や、大きさが合わない場合は std::invalid_argument を投げる
+    MinCostLP(SparseMatrix a, std::vector<double> c);
+};
+
+// --- 双対単体法 (基底の逆行列を密に持つ改訂単体法) ---
+// solve() は直前の solve() の最適基底から始める (右辺だけが変わるので、その基底は双対実行可能なまま)
+// 反復の途中の基底も双対実行可能なので、反復の上限で打ち切った場合の目的関数値は最適値の下界になる
+// 1 つのインスタンスを複数のスレッドで同時に使ってはならない
+class DualSimplex {
+public:
+    explicit DualSimplex(std::shared_ptr<const MinCostLP> lp);
+
+    // b (m 個) に対して解く関数 (実行不可能な場合は status が Infeasible、objective が +inf)
+    LPSolution solve(const std::vector<double>& b, int max_iterations = 10000);
+
+    // スラック変数の基底に戻す関数
+    void reset();
+
+    uint64_t total_iterations() const noexcept { return total_iterations_; }
+    uint64_t num_solves() const noexcept { return num_solves_; }
+
+private:
+    void refactor();
+    void compute_duals();
+
+    std::shared_ptr<const MinCostLP> lp_;
+    int m_ = 0;
+    int n_ = 0;
+    std::vector<int> head_;     // head_[r] = r 行目の基底変数 (0..n-1 は y、n..n+m-1 はスラック)
+    std::vector<int> pos_;      // pos_[j] = 変数 j が基底の何行目か (非基底は -1)
+    std::vector<double> binv_;  // 基底の逆行列 (m x m、行優先)
+    std::vector<double> d_;     // 被約費用 (n+m 個)
+    std::vector<double> xb_;    // 基底変数の値
+    std::vector<double> alpha_; // 出る行の、各変数の係数
+    std::vector<double> col_;   // 入る列の B^-1 a_q
+    int since_refactor_ = 0;
+    uint64_t total_iterations_ = 0;
+    uint64_t num_solves_ = 0;
+};
+
+}} // namespace planner::sas
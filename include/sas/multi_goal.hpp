@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "sas/sas_reader.hpp"
+#include "sas/sas_heuristic.hpp"
+#include "sas/sas_search.hpp"
+
+namespace planner { namespace sas {
+
+// ゴール条件 (var == val の組)
+using GoalCondition = std::vector<std::pair<int, int>>;
+
+// 1 つのゴール条件に対する結果
+struct GoalPlan {
+    bool solved = false;
+    double plan_cost = 0.0;
+    std::vector<uint32_t> plan;
+    uint64_t expanded_at = 0; // 見つけた時点での総展開数
+};
+
+struct MultiGoalResult {
+    std::vector<GoalPlan> goals; // 入力のゴール条件と同じ順
+    Stats stats;
+    bool bound_exhausted = false; // 未到達のゴールについて、上界未満のプランが存在しないことを示したかどうか
+    StopReason stop = StopReason::None;
+
+    std::size_t num_solved() const;
+};
+
+// ゴール条件ごとのヒューリスティックを作る関数 (引数はゴールを差し替えたタスク)
+using HeuristicFactory = std::function<HeuristicFn(const Task&)>;
+
+// --- 同じ初期状態から複数のゴール条件への最適プランを、1 回の前向き探索で求める関数 ---
+// f = g + min(未到達のゴール i の h_i) とする A* を行い、展開したノードが未到達のゴール条件を満たせば、その時点の g 値のプランを記録する
+// 未到達のゴールの h_i の最小値は、どの未到達のゴールに対しても許容的なので、各ゴールについて最適なプランが得られる
+// make_h が空の場合は h = 0 (均一コスト探索) とする
+MultiGoalResult multi_goal_search(const Task& T, const std::vector<GoalCondition>& goals,
+                                  const HeuristicFactory& make_h, const Params& p);
+
+// ゴール条件のファイルを読み込む関数
+// 1 行に 1 つのゴール条件を "var=val var=val ..." の形で書く (var は変数の番号か名前、空行と # から始まる行は無視する)
+std::vector<GoalCondition> read_goals_file(const Task& T, const std::string& path);
+
+}} // namespace planner::sas
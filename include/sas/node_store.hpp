@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "sas/sas_reader.hpp"
+#include "arena.hpp"
+
+namespace planner { namespace sas {
+
+// 探索ノードの状態の保持方法
+enum class StateStorage {
+    Full,  // 各ノードが完全な状態 (State) を持つ
+    Delta, // チェックポイントのノードのみ詰めた完全な状態を持ち、他は親との差分 (var, val) の列のみを持つ
+};
+
+// --- 親との差分で状態を保持するノードストア ---
+// 親の深さ + 1 が checkpoint_interval に達したノード (と根) をチェックポイントとし、変数ごとに必要な bit 数で詰めて保存する
+// それ以外のノードは登録時の親からの差分のみを保存し、取り出す時はチェックポイントから差分を順に適用して復元する
+// 復元した状態は ID で引く direct-mapped のキャッシュに置き、よく参照される状態の再構成を省く
+// プランの復元に用いる親と演算子もここで持つ (g-value の改善で親が変わっても、差分の基準は登録時の親のまま)
+class NodeStateStore {
+public:
+    NodeStateStore(const Task& T, int checkpoint_interval, std::size_t cache_slots = 4096);
+
+    // 変数の数・ドメインの大きさが差分の表現 (16bit, 16bit) に収まる場合のみ使える
+    bool fits() const noexcept { return fits_; }
+
+    // 根の状態を ID 0 として登録する関数
+    void push_root(const State& s);
+
+    // 状態 s を、ノード parent に演算子 op を適用した ID size() のノードとして登録する関数 (parent_state は ID parent の状態)
+    void push(const State& s, int parent, int op, const State& parent_state);
+
+    // プランの復元に用いる親と演算子 (根は -1, -1)
+    int parent(int id) const noexcept { return links_[id].parent; }
+    int op(int id) const noexcept { return links_[id].op; }
+    void set_parent(int id, int parent, int op) noexcept { links_[id] = Link{parent, op}; }
+
+    // ID の状態を返す関数 (返り値はキャッシュ内の参照で、次に get() を呼ぶまで有効)
+    const State& get(int id);
+
+    std::size_t size() const noexcept { return entries_.size(); }
+
+    // 状態の保存に用いているバイト数 (キャッシュを除く)
+    std::size_t bytes() const noexcept;
+
+private:
+    struct Entry {
+        uint64_t offset; // チェックポイントは full_ 内、それ以外は deltas_ 内の開始位置
+        int32_t base;    // 差分の基準となるノード ID (チェックポイントは -1)
+        uint16_t len;    // 差分の要素数
+        uint16_t depth;  // 直近のチェックポイントからの深さ
+    };
+
+    struct Link {
+        int32_t parent;
+        int32_t op;
+    };
+
+    struct CacheSlot {
+        int32_t id = -1;
+        State s;
+    };
+
+    void pack(const State& s);
+    void unpack(uint64_t offset, State& out) const;
+
+    std::size_t nvars_ = 0;
+    int interval_ = 1;
+    bool fits_ = false;
+
+    // 完全な状態を詰める際の、各変数の word 位置・シフト量・マスク (変数は word をまたがない)
+    std::vector<uint32_t> word_of_;
+    std::vector<uint32_t> shift_of_;
+    std::vector<uint64_t> mask_of_;
+    std::size_t words_per_state_ = 0;
+
+    ArenaVector<Entry> entries_;
+    ArenaVector<Link> links_;
+    ArenaVector<uint64_t> full_;    // チェックポイントの詰めた状態
+    ArenaVector<uint32_t> deltas_;  // 差分 (var << 16 | val)
+
+    std::vector<CacheSlot> cache_;
+    std::vector<int> chain_; // 復元時の作業領域
+};
+
+}} // namespace planner::sas
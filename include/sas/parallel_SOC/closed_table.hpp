@@ -8,6 +8,7 @@
 #include "sas/parallel_SOC/state_hasher.hpp"
 #include "sas/parallel_SOC/node.hpp"
 #include "sas/parallel_SOC/parallel_soc_all.hpp"
+#include "alloc_profile.hpp"
 
 namespace planner {
 namespace sas {
@@ -44,7 +45,13 @@ public:
 
     // 既出で g-value の改善がなければ true, 新規または g-value の改善がある場合は false
     bool prune_or_update(const sas::State& s, int g, uint64_t node_id) {
-        const uint32_t tmp = stripe_of(s); // index を求める
+        return prune_or_update(s, g, node_id, stripe_of(s));
+    }
+
+    // ストライプを決めるハッシュ値 (抽象化 Zobrist ハッシュなど) を呼び出し側で与える版
+    bool prune_or_update(const sas::State& s, int g, uint64_t node_id, uint64_t stripe_key) {
+        PLANNER_ALLOC_PHASE(Closed);
+        const uint32_t tmp = static_cast<uint32_t>(stripe_key % stripes_); // index を求める
         std::unique_lock lk(locks_[tmp]); // lock を掛ける
 
         auto& mp = maps_[tmp];
@@ -67,7 +74,11 @@ public:
 
     // closed list に登録されている状態から、ClosedEntry を取り出す関数
     std::optional<ClosedEntry> get(const sas::State& s) const {
-        const uint32_t tmp = stripe_of(s);
+        return get(s, stripe_of(s));
+    }
+
+    std::optional<ClosedEntry> get(const sas::State& s, uint64_t stripe_key) const {
+        const uint32_t tmp = static_cast<uint32_t>(stripe_key % stripes_);
         std::shared_lock lk(locks_[tmp]);
         auto& mp = maps_[tmp];
         auto it = mp.find(s);
@@ -17,6 +17,7 @@ namespace parallel_SOC {
 
 class Heuristic {
     planner::sas::HeuristicFn hfn_;
+    planner::sas::BatchHeuristicFn batch_; // 空でない場合、作業スレッドは 1 回の展開の後続状態をまとめて評価する
 
 public:
 
@@ -26,6 +27,12 @@ double operator()(const Task& task, const State& s) const {
     return hfn_(task,s); // 関数呼出演算子
 }
 
+bool has_batch() const { return static_cast<bool>(batch_); }
+
+void eval_batch(const Task& task, const std::vector<State>& states, std::vector<double>& out) const {
+    batch_(task, states, out);
+}
+
 static Heuristic goalcount() { // goalcount() をメンバ変数に持つ Heuristic object を返す関数
     return Heuristic(planner::sas::goalcount());
 }
@@ -42,6 +49,20 @@ static Heuristic hlm(const Task& task) {
     return Heuristic(planner::sas::hlm(task));
 }
 
+static Heuristic hmax(const Task& task) { // 後続状態をビットスライスでまとめて評価する
+    Heuristic h(planner::sas::hmax(task));
+    h.batch_ = planner::sas::hmax_batched(task);
+    return h;
+}
+
+static Heuristic hpot(const Task& task) { // 重みは構築時に 1 度だけ求め、評価は重みの和だけ
+    return Heuristic(planner::sas::hpot_init(task));
+}
+
+static Heuristic hpot_samples(const Task& task) {
+    return Heuristic(planner::sas::hpot_samples(task));
+}
+
 };
 
 } // namespace parallel_SOC
@@ -21,7 +21,10 @@ struct Node {
     int g; // g-value
     int h; // h-value
     uint32_t op_id; // 適用した演算子の ID
+    uint32_t shard = 0; // 状態の抽象化 Zobrist ハッシュ (Params::shard_mode が Abstraction の場合にシャードの選択に用いる)
     uint64_t parent; // 親状態 ID
+    uint32_t key = 0; // オープンリストでの優先度 (g + w·h を bucket_delta の幅で区切ったバケットの番号)
+    uint32_t tie = 0; // 同じバケット内でのタイブレーク値 (小さい方を優先する)
     // 軽量化のために State は保持しない
 
     inline int f() const { // f-value を計算する関数
@@ -31,13 +34,13 @@ struct Node {
 
 struct NodeLess {
     bool operator()(const Node& a, const Node& b) const { // 比較演算子
-        if (a.f() != b.f()) { // f-value が小さい方を優先する
-            return a.f() > b.f();
+        if (a.key != b.key) { // バケットの番号が小さい方を優先する
+            return a.key > b.key;
         }
-        if (a.h != b.h) { // タイブレークは h-value が小さい方を優先する
-            return a.h > b.h;
+        if (a.tie != b.tie) { // タイブレークは Params::tie_break に従って計算した値が小さい方を優先する
+            return a.tie > b.tie;
         }
-        // f-value も h-value も同じ場合は、ID の大きさによって決定する
+        // バケットもタイブレーク値も同じ場合は、ID の大きさによって決定する
         return a.id > b.id;
     }
 };
@@ -1,5 +1,6 @@
 #pragma once
 #include <optional>
+#include <limits>
 #include <vector>
 #include <cstdint>
 #include "sas/sas_reader.hpp"
@@ -18,26 +19,19 @@ namespace planner {
 namespace sas {
 namespace parallel_SOC {
 
-// 探索を特徴づけするパラメータ
-struct SearchParams {
-    uint32_t num_threads = 1; // スレッドの数
-    SharedOpen::Kind open_kind = SharedOpen::Kind::MultiQueue; // オープンリストの種類
-    uint32_t num_queues = 0; // キューの数
-    int time_limit_ms = -1; // タイムリミット
-    uint32_t num_bucket_shards = 0;
-    uint32_t num_k_select = 2;
-    uint32_t random_seed = 634u; // 探索ごとのランダムシード
-    uint32_t heuristic_kind = 0; // 0 -> blind, 1 -> goalcount, 2-> ff, 3-> lm
-};
-
 // 探索結果
 struct SearchResult {
     bool solved = false;
     int cost = -1;
     std::vector<uint32_t> plan_ops; // 演算子のシーケンス
+    bool bound_exhausted = false; // コスト上界未満のプランが存在しないことを示したかどうか
+    double lower_bound = 0.0; // 探索終了時に示せた最適コストの下界 (h が許容的な場合のみ意味を持つ)
 };
 
 // A* Search
-SearchResult astar_soc(const sas::Task& T, const SearchParams& P, planner::sas::soc::GlobalStats* stats_out = nullptr);
+// 優先度は g + weight·h を bucket_delta の幅で区切ったバケットの番号とし、同じバケット内は tie_break に従う
+// weight > 1 や bucket_delta > 1 の場合は最適性を保証しない代わりに、同じバケットを共有するノードが増えてスレッド間の競合が減る
+// 解を見つけた場合は、オープンリストに残ったノードの g + h の最小値から最適コストの下界を求めて lower_bound に返す
+SearchResult astar_soc(const sas::Task& T, const Params& P, planner::sas::soc::GlobalStats* stats_out = nullptr);
 
 }}} // namespace
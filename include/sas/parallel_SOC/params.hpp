@@ -2,6 +2,7 @@
 #include <cstddef>
 #include <cstdint>
 #include <algorithm>
+#include <limits>
 #include "sas/parallel_SOC/parallel_soc_all.hpp"
 
 namespace planner {
@@ -19,11 +20,18 @@ enum class TieBreak : uint8_t { // Tie-Break の手法
     FIFO   = 2 // 単純な f 値 FIFO        
 };
 
+enum class ShardMode : uint8_t { // ノードをシャードに割り当てる方法
+    NodeId      = 0, // ノード ID の乗算ハッシュ
+    Abstraction = 1  // 一部の変数に対する抽象化 Zobrist ハッシュ (後続状態の多くが親と同じシャードに入る)
+};
+
 struct Params {
     // 並列構成
     uint32_t num_threads = 1;
     uint32_t num_queues = 0;
     uint32_t closed_stripes = 0; // closed list の分割数
+    ShardMode shard_mode = ShardMode::NodeId;
+    uint32_t shard_balance = 16; // Abstraction の場合の、シャードあたりの抽象状態の数の下限 (大きいほど負荷が均等になり、小さいほど局所性が高くなる)
 
     // 探索ポリシー
     QueueKind queue_kind = QueueKind::BucketPQ;
@@ -32,6 +40,11 @@ struct Params {
     bool reopen_closed = true;
     bool early_terminate_on_first_goal = true;
 
+    // 探索の制限
+    int time_limit_ms = -1; // タイムリミット (負の場合は無制限)
+    uint32_t heuristic_kind = 1; // 0 -> blind, 1 -> goalcount, 2-> ff, 3-> lm, 4 -> hmax (まとめて評価), 5 -> pot, 6 -> pot_samples
+    double cost_bound = std::numeric_limits<double>::infinity(); // コストがこの値未満のプランのみを探索する
+
     // ロギング・再現性
     uint32_t random_seed = 634u;
     uint32_t log_interval_ms = 1000u;
@@ -40,8 +53,8 @@ struct Params {
     std::size_t memory_soft_limit_mb = 0; // 0 => 無効
 
     // BucketPQ 用パラメータ
-    float bucket_delta = 1.0f;
-    uint32_t buckets_window = 256;
+    float bucket_delta = 1.0f; // 優先度 g + weight·h をこの幅で区切ってバケットにまとめる
+    uint32_t buckets_window = 256; // 各シャードであらかじめ確保しておくバケットの数
     uint32_t bucket_shards = 0;
     uint32_t bucket_select_k = 2;
     bool bucket_fifo = true;
@@ -69,6 +82,8 @@ struct Params {
 
         weight = (weight < 1.0f) ? 1.0f : weight; // weight が 1.0 未満の場合は、すべて 1.0 とする
 
+        shard_balance = std::max<uint32_t>(shard_balance, 1u);
+
         bucket_delta = (bucket_delta <= 0.0f) ? 1.0f : bucket_delta;
         buckets_window = std::max<uint32_t>(buckets_window, 32u);
         bucket_shards = (bucket_shards == 0) ? std::max<uint32_t>(num_threads, 2u) : bucket_shards;
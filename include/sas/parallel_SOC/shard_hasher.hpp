@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "sas/sas_reader.hpp"
+#include "sas/parallel_SOC/parallel_soc_all.hpp"
+
+namespace planner {
+namespace sas {
+namespace parallel_SOC {
+
+// 抽象化 Zobrist ハッシュ (オープンリストのシャードとクローズドリストのストライプの割り当てに用いる)
+// 一部の変数 (抽象化変数) の値のみから Zobrist ハッシュを計算するので、抽象化変数を変更しない演算子による後続状態は、親と同じシャードに入る
+// 抽象化変数は、それを変更する演算子が少ないものから貪欲に選び、抽象状態の数が num_shards * balance 以上になった時点で止める
+// balance を大きくすると抽象状態が細かくなって負荷が均等になり、小さくすると親と同じシャードに入る後続状態が増える
+class ShardHasher {
+public:
+    ShardHasher() = default;
+    ShardHasher(const Task& T, uint32_t num_shards, uint32_t balance);
+
+    // 状態 s の抽象状態のハッシュ値を返す関数
+    uint32_t operator()(const State& s) const noexcept {
+        uint64_t x = 0;
+        for (int v : vars_) {
+            x ^= table_[offset_[v] + static_cast<uint32_t>(s[v])];
+        }
+        return static_cast<uint32_t>(x >> 32);
+    }
+
+    // 選んだ抽象化変数
+    const std::vector<int>& vars() const noexcept { return vars_; }
+
+    // 後続状態が親と異なるシャードに移りうる演算子の割合 (選択時の見積もり)
+    double moving_op_ratio() const noexcept { return moving_op_ratio_; }
+
+private:
+    std::vector<int> vars_;
+    std::vector<uint32_t> offset_; // 変数ごとの table_ の先頭位置
+    std::vector<uint64_t> table_;  // (変数, 値) ごとの乱数
+    double moving_op_ratio_ = 1.0;
+};
+
+} // namespace parallel_SOC
+} // namespace sas
+} // namespace planner
@@ -35,10 +35,22 @@ class MultiQueueOpen {
         std::priority_queue<Node, std::vector<Node>, NodeLess> q; // Node を要素とし、比較関数は、NodeLess とする (node.hpp)
         planner::sas::soc::SpinLock m; // 軽量ロック、書き込みメイン
         std::atomic<uint64_t> size{0}; // 各優先度付きキューのサイズ
+        std::atomic<uint64_t> top{UINT64_MAX}; // 先頭ノードの (key, tie) (ロックを掛けずに比較するための近似値)
+
+        void publish_top() { // ロックを掛けた状態で呼ぶ
+            top.store(q.empty() ? UINT64_MAX : (static_cast<uint64_t>(q.top().key) << 32) | q.top().tie, std::memory_order_relaxed);
+        }
     };
 
     std::vector<PQ> qs_; // PQ を積んだベクトル
     uint32_t k_choice_; // pop 時にランダムサンプリングするキューの数
+    bool by_abstraction_ = false; // ノードの抽象化 Zobrist ハッシュでキューを選ぶかどうか
+
+    // このスレッドが最後にノードを取り出したキュー (展開中のノードのキュー)
+    static uint32_t& home_queue() {
+        thread_local uint32_t q = UINT32_MAX;
+        return q;
+    }
 
     // 乱数生成
     static uint32_t rng_next() {
@@ -60,10 +72,15 @@ public:
         gstats_ = p;
     }
 
+    void set_shard_by_abstraction(bool on) {
+        by_abstraction_ = on;
+    }
+
     // push 関数
     void push(Node&& n) {
         const uint32_t N = (uint32_t)qs_.size(); // マルチキューに含まれるキューの数
-        const uint32_t sid = pick_shard(n.id, N); // シャード ID
+        const uint32_t sid = by_abstraction_ ? n.shard % N : pick_shard(n.id, N); // シャード ID
+        const uint32_t home = home_queue();
         auto& pq = qs_[sid]; // 該当シャードを参照として確保する
 
         // critical section
@@ -71,12 +88,18 @@ public:
             planner::sas::soc::ScopedLock<planner::sas::soc::SpinLock> lg(pq.m); // その priority queue をロックする
             pq.q.push(std::move(n)); // Queue に値を入れる
             pq.size.fetch_add(1, std::memory_order_relaxed); // キューに含まれる要素の数を 1 インクリメントする
+            if (by_abstraction_) {
+                pq.publish_top();
+            }
         }
         
         if (gstats_) {
             auto tid = planner::sas::soc::current_thread_index(); // 現在のスレッドの ID の取得
             auto& S = gstats_->per_thread[tid];
             S.pushes++; // プッシュした回数を 1 インクリメントする
+            if (home != UINT32_MAX && home != sid) { // 親とは別のキューに入れた場合
+                S.remote_pushes++;
+            }
             auto s = size();
             if (s >S.max_open_size_seen) { // スレッドごとに観測したオープンサイズの最大のサイズを更新する
                 S.max_open_size_seen = s;
@@ -94,6 +117,38 @@ public:
 
         uint32_t seed = rng_next(); // シード値の設定
 
+        // 抽象化 Zobrist ハッシュの場合は、直前に取り出したキュー (後続状態の多くが入っている) と k 個のランダムなキューのうち、
+        // 先頭の優先度が最も良いものから取り出す (同じ場合は直前のキューを優先する)
+        if (by_abstraction_) {
+            size_t sid = home_queue() < N ? home_queue() : size_t(rng_next()) % N;
+            uint64_t best = qs_[sid].top.load(std::memory_order_relaxed);
+            for (uint32_t t = 0; t < k_choice_; ++t) {
+                const size_t c = size_t(rng_next()) % N;
+                const uint64_t top = qs_[c].top.load(std::memory_order_relaxed);
+                if (top < best) {
+                    best = top;
+                    sid = c;
+                }
+            }
+            auto& pq = qs_[sid];
+            if (best != UINT64_MAX) {
+                planner::sas::soc::ScopedLock<planner::sas::soc::SpinLock> lg(pq.m);
+                if (!pq.q.empty()) {
+                    Node n = std::move(const_cast<Node&>(pq.q.top()));
+                    pq.q.pop();
+                    pq.size.fetch_sub(1, std::memory_order_relaxed);
+                    pq.publish_top();
+
+                    if (gstats_) {
+                        auto tid = planner::sas::soc::current_thread_index();
+                        gstats_->per_thread[tid].pops++;
+                    }
+                    home_queue() = static_cast<uint32_t>(sid);
+                    return n;
+                }
+            }
+        }
+
         // k-choice サンプリングを行う
         for (uint32_t t = 0; t < k_choice_; ++t) {
             size_t sid = size_t(rng_next()) % N; // シャード ID を決定する
@@ -105,11 +160,15 @@ public:
                 Node n = std::move(const_cast<Node&>(pq.q.top()));
                 pq.q.pop();
                 pq.size.fetch_sub(1, std::memory_order_relaxed);
+                if (by_abstraction_) {
+                    pq.publish_top();
+                }
 
                 if (gstats_) {
                     auto tid = planner::sas::soc::current_thread_index();
                     gstats_->per_thread[tid].pops++;
                 }
+                home_queue() = static_cast<uint32_t>(sid);
                 return n;
             }
         }
@@ -125,11 +184,15 @@ public:
                 Node n = std::move(const_cast<Node&>(pq.q.top()));
                 pq.q.pop();
                 pq.size.fetch_sub(1, std::memory_order_relaxed);
+                if (by_abstraction_) {
+                    pq.publish_top();
+                }
 
                 if (gstats_) {
                     auto tid = planner::sas::soc::current_thread_index();
                     gstats_->per_thread[tid].pops++;
                 }
+                home_queue() = static_cast<uint32_t>(sid);
                 return n;
             }
         }
@@ -168,10 +231,33 @@ class TwoLevelBucketOpen {
         BucketPQ pq;
         std::unordered_map<BucketPQ::Value, Node> store; // node 本体を保存するハッシュマップ (bucket_pq.hpp 自体は ID (uint_32t) の保存しかできない)
         std::atomic<uint64_t> size{0};
+        std::atomic<UKey> top{UINT32_MAX}; // 最小キー (ロックを掛けずに比較するための近似値)
     };
 
     std::vector<Shard> shards_; // シャードを積んだベクタ
     uint32_t k_choice_; // pop 時にサンプルするシャードの個数
+    bool by_abstraction_ = false; // ノードの抽象化 Zobrist ハッシュでシャードを選ぶかどうか
+
+    // このスレッドが最後にノードを取り出したシャード (展開中のノードのシャード)
+    static uint32_t& home_shard() {
+        thread_local uint32_t sh = UINT32_MAX;
+        return sh;
+    }
+
+    // シャード sh から最小のノードを取り出す関数 (ロックは呼び出し側で掛ける)
+    std::optional<Node> take_min_(Shard& sh) {
+        auto [vid, key] = sh.pq.extract_min();
+        (void)key;
+        auto it = sh.store.find(vid);
+        if (it == sh.store.end()) {
+            return std::nullopt;
+        }
+        Node out = std::move(it->second);
+        sh.store.erase(it);
+        sh.size.fetch_sub(1, std::memory_order_relaxed);
+        sh.top.store(sh.pq.min_key(), std::memory_order_relaxed);
+        return out;
+    }
 
     // 乱数生成器 (スレッドごとに独立)
     static uint32_t rng_next() {
@@ -191,9 +277,13 @@ class TwoLevelBucketOpen {
     }
 
 public:
-    explicit TwoLevelBucketOpen(uint32_t shards, uint32_t k_choice = 2) // コンストラクタ、k-choice のデフォルト値は 2
+    explicit TwoLevelBucketOpen(uint32_t shards, uint32_t k_choice = 2, uint32_t window = 0) // コンストラクタ、k-choice のデフォルト値は 2
         : shards_(shards ? shards : 1) // シャード数が与えられなければ 1 とする
-        , k_choice_(k_choice ? k_choice : 2) {}
+        , k_choice_(k_choice ? k_choice : 2) {
+        for (auto& sh : shards_) {
+            sh.pq.reserve_f(window); // 先頭の window 個のバケットはあらかじめ確保しておく
+        }
+    }
 
     void set_stats(planner::sas::soc::GlobalStats* p) {
         gstats_ = p;
@@ -202,14 +292,18 @@ public:
         }
     }
 
+    void set_shard_by_abstraction(bool on) {
+        by_abstraction_ = on;
+    }
+
     // push 関数
     void push(Node&& n) { // 第一引数の Queue-ID はこの関数では無視する
         const uint32_t num_shards = static_cast<uint32_t>(shards_.size()); // シャードの数
-        const uint32_t sid = pick_shard(n.id, num_shards); // どのシャードにそのノードを入れるかのインデックス
+        const uint32_t sid = by_abstraction_ ? n.shard % num_shards : pick_shard(n.id, num_shards); // どのシャードにそのノードを入れるかのインデックス
+        const uint32_t home = home_shard();
         auto& sh = shards_[sid]; // 該当シャード
 
-        const int h = n.h; // h-value
-        const UKey key = pack_key(n.g + h, h); // パックする
+        const UKey key = pack_key(static_cast<int>(n.key), static_cast<int>(n.tie)); // パックする
 
         // critical section
         {
@@ -218,12 +312,18 @@ public:
             sh.store.emplace(id, std::move(n)); // ハッシュマップに、ID と ノードを入れる
             sh.pq.insert(id, key); // バケットに挿入する
             sh.size.fetch_add(1, std::memory_order_relaxed); // シャードに含まれるノード数を増加させる
+            if (by_abstraction_ && key < sh.top.load(std::memory_order_relaxed)) {
+                sh.top.store(key, std::memory_order_relaxed);
+            }
         }
 
         if (gstats_) {
             auto tid = planner::sas::soc::current_thread_index(); // 現在のスレッドの ID の取得
             auto& stats = gstats_->per_thread[tid];
             stats.pushes++; // プッシュ回数を 1 インクリメントする
+            if (home != UINT32_MAX && home != sid) { // 親とは別のシャードに入れた場合
+                stats.remote_pushes++;
+            }
             auto total = size(); // 二段バケットに含まれる全ノード数を取得
             if (total > stats.max_open_size_seen) { // スレッドごとに観測したオープンリストの最大のサイズを更新する
                 stats.max_open_size_seen = total;
@@ -245,6 +345,35 @@ public:
 
         uint32_t seed = rng_next(); // シード値 (thread_local)
 
+        // 抽象化 Zobrist ハッシュの場合は、直前に取り出したシャード (後続状態の多くが入っている) と k 個のランダムなシャードのうち、
+        // 最小キーが最も小さいものから取り出す (同じ場合は直前のシャードを優先する)
+        if (by_abstraction_) {
+            uint32_t sid = home_shard() < num_shards ? home_shard() : rng_next() % num_shards;
+            UKey best = shards_[sid].top.load(std::memory_order_relaxed);
+            for (uint32_t t = 0; t < k_choice_; ++t) {
+                const uint32_t c = rng_next() % num_shards;
+                const UKey top = shards_[c].top.load(std::memory_order_relaxed);
+                if (top < best) {
+                    best = top;
+                    sid = c;
+                }
+            }
+            auto& sh = shards_[sid];
+            if (best != UINT32_MAX) {
+                planner::sas::soc::ScopedLock<planner::sas::soc::TicketLock> lg(sh.m);
+                if (!sh.pq.empty()) {
+                    if (auto out = take_min_(sh)) {
+                        if (gstats_) {
+                            auto tid = planner::sas::soc::current_thread_index();
+                            gstats_->per_thread[tid].pops++;
+                        }
+                        home_shard() = sid;
+                        return out;
+                    }
+                }
+            }
+        }
+
         // k-choice sampling
         for (uint32_t t = 0; t < k_choice_; ++t) {
             uint32_t sid = rng_next() % num_shards; // (thread-id + seed-value + (0~k-1)) をシャード数で割った余り
@@ -268,12 +397,16 @@ public:
                 Node out = std::move(it->second); // 該当ノードを取得
                 sh.store.erase(it); // ハッシュマップから、そのノードを削除する
                 sh.size.fetch_sub(1, std::memory_order_relaxed); // ノードに含まれるノード数を 1 減らす
+                if (by_abstraction_) {
+                    sh.top.store(sh.pq.min_key(), std::memory_order_relaxed);
+                }
 
                 if (gstats_) { // 統計値を取っている場合
                     auto tid = planner::sas::soc::current_thread_index(); // 現在のスレッド ID の取得
                     gstats_->per_thread[tid].pops++; // ポップできた回数を 1 インクリメントする
                 }
 
+                home_shard() = sid;
                 return out;
             }
         }
@@ -301,6 +434,9 @@ public:
                 Node out = std::move(it->second);
                 sh.store.erase(it);
                 sh.size.fetch_sub(1, std::memory_order_relaxed);
+                if (by_abstraction_) {
+                    sh.top.store(sh.pq.min_key(), std::memory_order_relaxed);
+                }
 
                 if (gstats_) { // 統計値を取っている場合
                     auto tid = planner::sas::soc::current_thread_index(); // 現在のスレッド ID の取得
@@ -311,6 +447,7 @@ public:
                     }
                 }
             
+                home_shard() = sid;
                 return out;
             }
         }
@@ -349,14 +486,16 @@ private:
 
 public:
     // コンストラクタ
-    explicit SharedOpen(Kind k, uint32_t num_queues, uint32_t bucket_shards = 0, uint32_t bucket_select_k = 2)
+    explicit SharedOpen(Kind k, uint32_t num_queues, uint32_t bucket_shards = 0, uint32_t bucket_select_k = 2, uint32_t buckets_window = 0)
         : kind_(k)
-        , mq_(num_queues ? num_queues : 1) // マルチキュー型、シャード数と、k-value は用いない
-        , tlb_(bucket_shards ? bucket_shards : std::max(2u, (num_queues?num_queues:1)), bucket_select_k ? bucket_select_k : 2) // 二段バケット型、num_queues は用いない
+        , mq_(k == Kind::MultiQueue ? (num_queues ? num_queues : 1) : 1) // マルチキュー型、シャード数と、k-value は用いない
+        , tlb_(k == Kind::TwoLevelBucket ? (bucket_shards ? bucket_shards : std::max(2u, (num_queues?num_queues:1))) : 1,
+               bucket_select_k ? bucket_select_k : 2, k == Kind::TwoLevelBucket ? buckets_window : 0) // 二段バケット型、num_queues は用いない
     {}
 
     // push 関数
     void push(Node&& n) {
+        PLANNER_ALLOC_PHASE(Open);
         switch (kind_) {
             case Kind::MultiQueue: mq_.push(std::move(n)); break;
             case Kind::TwoLevelBucket: tlb_.push(std::move(n)); break;
@@ -396,6 +535,12 @@ public:
         mq_.set_stats(p);
         tlb_.set_stats(p);
     }
+
+    // ノードの抽象化 Zobrist ハッシュ (Node::shard) でシャードを選ぶかどうか設定する関数
+    void set_shard_by_abstraction(bool on) {
+        mq_.set_shard_by_abstraction(on);
+        tlb_.set_shard_by_abstraction(on);
+    }
 };
 
 } // namespace parallel_SOC
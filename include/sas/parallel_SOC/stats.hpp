@@ -21,11 +21,13 @@ struct alignas(SOC_CACHELINE_SIZE) ThreadStats { // false sharing を防ぐた
     uint64_t evaluated = 0;
     uint64_t reopened  = 0;
     uint64_t duplicates_pruned = 0;
+    uint64_t pruned_by_bound = 0; // コスト上界によって枝刈りした後続ノードの数
 
     // Open 操作
     uint64_t pushes = 0;
     uint64_t pops = 0;
     uint64_t steals = 0; // 他キュー/他シャードから盗んだ回数
+    uint64_t remote_pushes = 0; // 展開中のノードを取り出したシャードとは別のシャードに入れた回数
 
     // バケットPQ
     uint64_t bucket_window_slides = 0; // outer window を前進させた回数
@@ -40,8 +42,8 @@ struct alignas(SOC_CACHELINE_SIZE) ThreadStats { // false sharing を防ぐた
 
     // 各統計値を 0 に戻す関数
     void reset() {
-        generated = expanded = evaluated = reopened = duplicates_pruned = 0;
-        pushes = pops = steals = 0;
+        generated = expanded = evaluated = reopened = duplicates_pruned = pruned_by_bound = 0;
+        pushes = pops = steals = remote_pushes = 0;
         bucket_window_slides = bucket_push_collisions = bucket_pop_empty_probes = 0;
         relax_eval_ns = 0;
         max_open_size_seen = 0;
@@ -54,9 +56,11 @@ struct alignas(SOC_CACHELINE_SIZE) ThreadStats { // false sharing を防ぐた
         evaluated += o.evaluated;
         reopened  += o.reopened;
         duplicates_pruned += o.duplicates_pruned;
+        pruned_by_bound += o.pruned_by_bound;
         pushes += o.pushes;
         pops   += o.pops;
         steals += o.steals;
+        remote_pushes += o.remote_pushes;
         bucket_window_slides += o.bucket_window_slides;
         bucket_push_collisions += o.bucket_push_collisions;
         bucket_pop_empty_probes += o.bucket_pop_empty_probes;
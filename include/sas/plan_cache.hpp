@@ -0,0 +1,47 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "sas/sas_reader.hpp"
+
+namespace planner { namespace sas {
+
+// キャッシュに保存するプラン
+struct CachedPlan {
+    std::vector<uint32_t> plan; // 演算子の番号の列
+    double cost = 0.0;
+    bool optimal = false;       // 最適であることが示されているかどうか
+};
+
+// --- ディレクトリに置く、プランのキャッシュ ---
+// タスクの指紋と探索の設定 (アルゴリズム、ヒューリスティック、上界など) の組ごとに 1 ファイルを置く
+// 取り出したプランは、返す前にタスク上で実行してゴールに達することとコストを確かめる (満たさない項目は消す)
+// 項目の数が max_entries を超えると、最後に使われた時刻 (ファイルの更新時刻) が古いものから消す (LRU)
+// 書き込みは一時ファイルを rename() で置き換え、削除はディレクトリのロックファイルを flock() してから行うので、
+// 複数のプロセスが同じディレクトリを同時に使ってよい
+class PlanCache {
+public:
+    explicit PlanCache(std::string dir, std::size_t max_entries = 1000);
+
+    // タスクと設定に対応するプランを探す関数 (見つからない場合や、検証に失敗した場合は nullopt)
+    std::optional<CachedPlan> lookup(const Task& T, const std::string& config);
+
+    // プランを保存する関数 (同じ項目は上書きする)
+    void store(const Task& T, const std::string& config, const CachedPlan& p);
+
+    std::size_t max_entries() const noexcept { return max_entries_; }
+
+    // 現在の項目の数
+    std::size_t size() const;
+
+private:
+    std::string entry_path(uint64_t fp, const std::string& config) const;
+    void evict();
+
+    std::string dir_;
+    std::size_t max_entries_;
+};
+
+}} // namespace planner::sas
@@ -0,0 +1,99 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "sas/sas_reader.hpp"
+#include "sas/sas_heuristic.hpp"
+#include "sas/sas_search.hpp"
+
+namespace planner { namespace sas {
+
+// 探索の終了状態
+enum class SolveStatus {
+    Solved,          // プランを発見した
+    Unsolvable,      // 探索空間を網羅し、プランが存在しないことを示した
+    BoundExhausted,  // コスト上界未満のプランが存在しないことを示した
+    NotFound,        // コスト上界未満の探索空間を網羅したが、ヒューリスティックが許容的でないのでプランが存在しないことは示せていない
+    ExpansionLimit,  // 展開数の上限に達した
+    Timeout,         // 期限 (または CPU 時間の上限) に達した
+    Cancelled,       // 中断を要求された
+    MemoryLimit,     // メモリ予算を超えた
+};
+
+const char* to_string(SolveStatus s);
+
+// 探索結果から終了状態を求める関数 (heuristic は探索に用いたヒューリスティックの名前で、上界による証明の可否の判定に用いる)
+SolveStatus solve_status_of(const Result& R, const Params& p, const std::string& heuristic);
+
+// 別のスレッドから探索の中断を要求するためのトークン (コピーしても同じフラグを共有する)
+class CancelToken {
+public:
+    CancelToken() : flag_(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void cancel() noexcept { flag_->store(true, std::memory_order_relaxed); }
+    bool cancelled() const noexcept { return flag_->load(std::memory_order_relaxed); }
+    void reset() noexcept { flag_->store(false, std::memory_order_relaxed); }
+    const std::atomic<bool>* flag() const noexcept { return flag_.get(); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> flag_;
+};
+
+// 1 回の solve() の設定
+struct SolveOptions {
+    std::string algo = "astar";          // astar / gbfs / bi_search
+    std::string heuristic = "goalcount"; // make_heuristic() に渡す名前
+    double cost_bound = std::numeric_limits<double>::infinity();
+    int64_t time_limit_ms = -1;          // 実時間の上限 (負の場合は無効)
+    std::size_t memory_budget_mb = 0;    // プロセスの常駐メモリの上限 (0 の場合は無効)
+    CancelToken cancel;
+    std::function<void(const Progress&)> on_progress;
+    uint64_t progress_interval = 10000;
+    Params params;                       // 探索パラメータ (verbose と control はセッションが上書きする)
+};
+
+// solve() の結果
+struct SolveResult {
+    SolveStatus status = SolveStatus::Unsolvable;
+    std::vector<uint32_t> plan; // op index の列
+    double plan_cost = 0.0;
+    Stats stats;
+    double search_seconds = 0.0;
+};
+
+// --- プランナを他のプログラムに組み込むための窓口 ---
+// タスクと、準備したヒューリスティックを保持し、同じタスクに対して何度でも solve() できる
+// 探索エンジンは標準出力に何も書かず、プロセスを終了させることもない
+class PlannerSession {
+public:
+    explicit PlannerSession(Task T);
+
+    // SAS ファイルを読み込んでセッションを作る関数 (読み込みに失敗した場合は例外を投げる)
+    static std::unique_ptr<PlannerSession> from_sas_file(const std::string& path);
+
+    const Task& task() const noexcept { return task_; }
+
+    // ヒューリスティックを事前に構築する関数 (solve() の初回にも自動で呼ばれる)
+    void prepare_heuristic(const std::string& name);
+
+    // 探索を行う関数 (同じセッションへの呼び出しは直列化される)
+    SolveResult solve(const SolveOptions& opt = {});
+
+    // プランを VAL 形式の文字列にする関数
+    std::string plan_to_val(const std::vector<uint32_t>& plan) const;
+
+private:
+    const HeuristicFn& heuristic(const std::string& name);
+
+    Task task_;
+    std::map<std::string, HeuristicFn> heuristics_;
+    std::mutex mu_;
+};
+
+}} // namespace planner::sas
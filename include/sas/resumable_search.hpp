@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include "sas/sas_reader.hpp"
+#include "sas/sas_heuristic.hpp"
+#include "sas/sas_search.hpp"
+
+namespace planner { namespace sas {
+
+// step() の後の探索の状態
+enum class StepStatus {
+    Running,        // まだ続きがある (再び step() を呼べる)
+    Solved,         // プランを発見した
+    Exhausted,      // オープンリストが空になった
+    ExpansionLimit, // Params::max_expansions に達した
+    Stopped,        // search_interrupted() により打ち切った (理由は result().stop)
+};
+
+// --- 途中で止めて再開できる A* / GBFS ---
+// astar / gbfs と同じ探索エンジン (astar_steps / gbfs_steps) を用い、step(n) で最大 n ノードだけ展開して戻る
+// 探索の全ての状態 (オープンリスト、ノード、状態表) はコルーチンのフレームに置かれ、このオブジェクトが所有する
+// 密な状態表・単位コストの探索・差分による状態の保持など、astar / gbfs と同じ経路を同じ展開順で通る
+class ResumableSearch {
+public:
+    enum class Mode { AStar, GBFS };
+
+    // ヒューリスティック値は整数として扱う (h は丸めて用いる)
+    // p.control を指定する場合、その SearchControl は探索が終わるまで有効でなければならない
+    ResumableSearch(const Task& T, HeuristicFn h, Mode mode, const Params& p);
+
+    ResumableSearch(const ResumableSearch&) = delete;
+    ResumableSearch& operator=(const ResumableSearch&) = delete;
+
+    // 最大 n ノードを展開する関数 (終了していれば何もしない)
+    StepStatus step(uint64_t n);
+
+    StepStatus status() const noexcept { return status_; }
+    bool finished() const noexcept { return status_ != StepStatus::Running; }
+    const Result& result() const noexcept { return R_; }
+    Result& result() noexcept { return R_; }
+
+private:
+    HeuristicFn h_;
+    Params p_;
+    Result R_;
+    StepStatus status_ = StepStatus::Running;
+    SearchSteps steps_; // h_・p_・R_ を参照するので、最後に宣言して最初に破棄する
+};
+
+}} // namespace planner::sas
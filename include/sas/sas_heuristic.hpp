@@ -1,14 +1,105 @@
 #pragma once
 #include "sas/sas_reader.hpp"
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <string>
+#include <vector>
 
 namespace planner { namespace sas {
     using HeuristicFn = std::function<double(const planner::sas::Task&, const State&)>;
+    // 複数の状態をまとめて評価する関数 (out[i] に states[i] の値を書く)
+    using BatchHeuristicFn = std::function<void(const planner::sas::Task&, const std::vector<State>&, std::vector<double>&)>;
 
     HeuristicFn goalcount(); // ゴールカウント
     HeuristicFn blind(); // ブラインド
     HeuristicFn hff(const Task& T); // FF
     HeuristicFn hlm(const Task& T); // ランドマーク
+    HeuristicFn hcg(const Task& T); // 因果グラフ (DTG 上の文脈つき最短経路)
+    HeuristicFn hcea(const Task& T); // context-enhanced additive
+
+    // ランドマークのコスト分割 (許容的)
+    // 状態から先で必要な landmark (fact, disjunctive fact, action) の間で演算子のコストを分け合い、その和を返す
+    enum class LMCostPartitioning {
+        Uniform, // 演算子のコストを、それが達成しうる必要な landmark の間で等分する
+        Optimal, // 分け方を LP で最適化する (評価ごとに単体法を解く)
+    };
+    HeuristicFn hlm_cp(const Task& T, LMCostPartitioning cp);
+    HeuristicFn hlm_ucp(const Task& T); // hlm_cp(T, Uniform)
+    HeuristicFn hlm_ocp(const Task& T); // hlm_cp(T, Optimal)
+
+    // 演算子カウント (許容的)
+    // 各演算子の実行回数 Y_o >= 0 についての制約を集め、min sum cost(o) Y_o の LP を双対単体法で解く
+    // 制約の行列は状態によらず右辺だけが変わるので、スレッドごとに直前の最適基底から解き直す
+    struct OperatorCountingOptions {
+        bool state_equation = true; // fact ごとの生成回数 - 消費回数の制約 (状態方程式)
+        bool landmarks = true;      // landmark ごとに achiever の実行回数の和 >= 1
+        bool posthoc = true;        // ゴールの変数ごとの原子的な射影による事後最適化の制約
+    };
+    HeuristicFn hopcount(const Task& T, const OperatorCountingOptions& opts);
+    HeuristicFn hseq(const Task& T); // 状態方程式のみ
+    HeuristicFn hpho(const Task& T); // 事後最適化の制約のみ
+    HeuristicFn hoc(const Task& T);  // 全ての制約
+
+    // ポテンシャルヒューリスティック (許容的かつ整合的)
+    // fact ごとの重みを構築時に LP で 1 度だけ求め、状態の値は重みの和 (状態の値を添字にした gather と加算) で求める
+    enum class PotentialObjective {
+        Initial, // 初期状態の値を最大化する
+        Samples, // 初期状態からのランダムウォークで集めた状態の値の平均を最大化する
+    };
+    struct PotentialOptions {
+        PotentialObjective objective = PotentialObjective::Initial;
+        int num_samples = 1000;
+        uint32_t seed = 1234;
+    };
+
+    class PotentialFunction {
+    public:
+        PotentialFunction(const Task& T, const PotentialOptions& opts);
+
+        double operator()(const State& s) const;
+
+        std::size_t num_relevant_vars() const noexcept { return vars_.size(); } // 重みが 0 でない変数の数
+
+    private:
+        double base_ = 0.0;           // ゴールの fact の重みの和
+        std::vector<int> vars_;       // 重みが 0 でない変数
+        std::vector<int> offset_;     // vars_[i] の値 d の重みは weight_[offset_[i] + d]
+        std::vector<double> weight_;
+        bool integer_costs_ = true;
+    };
+
+    HeuristicFn hpot(const Task& T, const PotentialOptions& opts);
+    HeuristicFn hpot_init(const Task& T);    // Initial
+    HeuristicFn hpot_samples(const Task& T); // Samples
+
+    BatchHeuristicFn batched(HeuristicFn h); // 1 状態ずつ h を呼ぶ BatchHeuristicFn
+
+    // 層の数による h^max (緩和した到達可能性で、全てのゴールに到達するまでの層の数に、最も安い演算子のコストを掛けた値)
+    // 単位コストでは層の数そのもので、コストが 0 の演算子があれば 0 (到達できない状態を除く) になる。常に許容的
+    HeuristicFn hmax(const Task& T);
+    // hmax を、fact ごとのビット列で hmax_batch_lanes() 状態ずつまとめて計算する BatchHeuristicFn (値は hmax と同じ)
+    BatchHeuristicFn hmax_batched(const Task& T);
+    std::size_t hmax_batch_lanes() noexcept; // AVX2 が使えるビルドでは 256、それ以外は 64
+
+    // build を別のスレッドで実行し始め、すぐに HeuristicFn を返す関数
+    // 返した関数は、最初の評価の時点で build が終わっていなければ待つ (build が投げた例外はその時点で投げ直す)
+    // 探索の準備とヒューリスティックの前計算を重ねるために用いる
+    HeuristicFn async_heuristic(std::function<HeuristicFn()> build);
+    // h が async_heuristic の返した関数であれば、build の完成を待って h を完成した関数そのものに置き換える関数
+    // 探索は最初の評価の直前にこれを呼ぶので、以降の評価では future を引かず、関数呼び出しも 1 段で済む
+    void resolve_async(HeuristicFn& h);
+
+    // 名前 (--h の値) で指定したヒューリスティックが許容的かどうか
+    // 上界未満のプランがないことの証明と、最適なプランのキャッシュに用いる (planner_sas と PlannerSession で共有する)
+    bool heuristic_is_admissible(const std::string& name);
+
+    // 名前からヒューリスティックを構築する関数 (goalcount / blind / ff / hmax / lm / lm_ucp / lm_ocp / seq / pho / oc / pot /
+    // pot_samples / cg / cea、それ以外は std::invalid_argument を投げる)
+    HeuristicFn make_heuristic(const std::string& name, const Task& T);
+    // make_heuristic と同じだが、前計算を async_heuristic で別のスレッドに任せてすぐに返す関数 (T は探索の終了まで生存すること)
+    // 未知の名前は、その場で std::invalid_argument を投げる
+    HeuristicFn make_heuristic_async(const std::string& name, const Task& T);
 
 
 }}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <iosfwd>
 #include <string>
 #include <vector>
 #include <tuple>
@@ -44,6 +45,13 @@ struct Task {
 bool violates_mutex(const Task& T, const State& s);
 
 // SASファイルをパースし、タスクを返す関数
-Task read_file(const std::string& path);
+// 演算子は読み込みと並行して parse_threads 個のスレッドで解析する (負の場合はハードウェアに合わせて決め、0 の場合は呼び出し元のみ)
+Task read_file(const std::string& path, int parse_threads = -1);
+
+// SAS 形式のテキストをストリームから読み取る関数
+Task read_stream(std::istream& in, int parse_threads = -1);
+
+// タスクを SAS 形式で書き出す関数
+void write_sas(const Task& T, std::ostream& out);
 
 }} // namespace planner::sas
@@ -5,10 +5,13 @@
 #include <cstdint>
 #include "sas/sas_reader.hpp"
 #include "sas/sas_heuristic.hpp"
+#include "sas/node_store.hpp"
+#include "sas/search_steps.hpp"
 #include <atomic>
 #include <chrono>
 #include <ctime>
 #include <iostream>
+#include <limits>
 
 namespace planner { namespace sas { // sas 
 
@@ -25,6 +28,32 @@ struct Stats {
     uint64_t generated = 0;
     uint64_t evaluated = 0;
     uint64_t duplicates = 0;
+    uint64_t pruned_by_bound = 0; // コスト上界によって枝刈りした後続ノードの数
+};
+
+// 探索を途中で打ち切った理由
+enum class StopReason {
+    None,        // 打ち切っていない (解の発見、オープンリストの枯渇、展開数の上限による終了)
+    Timeout,     // CPU 時間の上限、または SearchControl の期限に達した
+    Cancelled,   // SearchControl を通じて中断を要求された
+    MemoryLimit, // SearchControl のメモリ予算を超えた
+};
+
+// 探索の進捗 (SearchControl::on_progress に渡す)
+struct Progress {
+    Stats stats;
+    double elapsed_sec = 0.0; // SearchControl::start からの経過時間
+};
+
+// 探索を外部から制御するための設定 (1 つの探索でのみ用いる)
+struct SearchControl {
+    const std::atomic<bool>* cancel = nullptr; // true になった時点で探索を打ち切る
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    std::size_t memory_budget_bytes = 0; // プロセスの常駐メモリの上限 (0 の場合は無効)
+    std::function<void(const Progress&)> on_progress; // progress_interval 展開ごとに呼ばれる
+    uint64_t progress_interval = 10000;
+    mutable uint64_t next_progress = 0; // 次に進捗を通知する展開数
 };
 
 // 探索結果
@@ -37,6 +66,8 @@ struct Result {
     bool meet = false;
     size_t reg_plan_len = 0;
     int which_directon = 0; // 1 -> forward で探索が終了, 2 -> regression で探索が終了, 0 -> meeting で探索が終了
+    bool bound_exhausted = false; // コスト上界未満の探索空間を網羅し、上界未満のプランが存在しないことを示したかどうか
+    StopReason stop = StopReason::None; // 探索を途中で打ち切った理由
 };
 
 // 検索パラメータ（必要に応じて拡張）
@@ -44,6 +75,19 @@ struct Params {
     uint64_t max_expansions = (1ull<<62);
     bool reopen_closed = true;
     bool stop_on_first_meet = true;
+    // コスト上界 C (g+h >= C となる後続ノードは生成時に捨てる、既定値は無効)
+    // 許容的なヒューリスティックを用いた場合、bound_exhausted は上界未満のプランが存在しないことの証明となる
+    // (上界がある場合は GBFS も g-value が改善した状態を開き直すので、同じことが言える)
+    double cost_bound = std::numeric_limits<double>::infinity();
+    // 状態数 (ドメインサイズの積) がこの値以下の場合、ハッシュ表の代わりにランクで引く密な状態表を用いる (0 で無効)
+    uint64_t dense_max_states = (1ull<<26);
+    // ハッシュ表を用いる A* / GBFS でのノードの状態の保持方法と、Delta の場合のチェックポイントの間隔 (深さ)
+    StateStorage state_storage = StateStorage::Full;
+    int checkpoint_interval = 16;
+    // 探索の方式などの情報を標準出力に表示するかどうか
+    bool verbose = true;
+    // 中断要求・期限・メモリ予算・進捗の通知 (nullptr の場合は CPU 時間の上限のみを確認する)
+    const SearchControl* control = nullptr;
 };
 
 // --- ユーティリティ ---
@@ -54,6 +98,13 @@ std::string plan_to_val(const planner::sas::Task& T, const std::vector<uint32_t>
 // A* / GBFS
 Result astar   (const planner::sas::Task& T, HeuristicFn h, bool h_is_integer, const Params& p);
 Result gbfs    (const planner::sas::Task& T, HeuristicFn h, bool h_is_integer, const Params& p);
+// 展開ごとに、新しい後続状態をまとめて hb で評価する GBFS (展開の順序と結果は gbfs と同じ)
+Result gbfs_batched(const planner::sas::Task& T, BatchHeuristicFn hb, bool h_is_integer, const Params& p);
+
+// astar / gbfs と同じ探索を、展開ごとに中断できる形で返す関数 (結果は R に書き込む)
+// 返した SearchSteps を進め終わるまで、T・h・p・R は有効でなければならない
+SearchSteps astar_steps(const planner::sas::Task& T, HeuristicFn& h, bool h_is_integer, const Params& p, Result& R);
+SearchSteps gbfs_steps (const planner::sas::Task& T, HeuristicFn& h, bool h_is_integer, const Params& p, Result& R);
 
 // Search の際中だけ有効にする CPU 時間の audit
 extern std::atomic<bool> g_search_timed_out; // タイムアウトを表すフラグ
@@ -95,4 +146,11 @@ inline void set_search_cpu_budget(double cpu_limit_sec) {
     }
 }
 
+// 探索を打ち切るべきかどうかを判定する関数 (打ち切る場合は R.stop に理由を設定する)
+// CPU 時間の上限と p.control を確認し、必要であれば進捗を通知する
+bool search_interrupted(const Params& p, Result& R);
+
+// 探索エンジンの情報表示用の出力先 (p.verbose が false の場合は何も出力しない)
+std::ostream& note_out(const Params& p);
+
 }} // namespace planner::sas
@@ -0,0 +1,50 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace planner { namespace sas {
+
+// 評価ごとの作業領域を、同時に評価しているスレッドの数だけ持ち、評価のたびに使い回すための置き場
+// 探索が 1 スレッドの場合は 1 つの作業領域だけを使い続ける
+template <class Scratch, class Data>
+class ScratchPool {
+public:
+    explicit ScratchPool(const Data& d) : data_(d) {}
+
+    // 作業領域を借り、スコープを抜ける時に返す
+    class Lease {
+    public:
+        Lease(ScratchPool& pool, std::unique_ptr<Scratch> s) : pool_(pool), s_(std::move(s)) {}
+        ~Lease() { pool_.release(std::move(s_)); }
+        Scratch& operator*() { return *s_; }
+
+    private:
+        ScratchPool& pool_;
+        std::unique_ptr<Scratch> s_;
+    };
+
+    Lease acquire() {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            if (!free_.empty()) {
+                auto s = std::move(free_.back());
+                free_.pop_back();
+                return Lease(*this, std::move(s));
+            }
+        }
+        return Lease(*this, std::make_unique<Scratch>(data_));
+    }
+
+private:
+    void release(std::unique_ptr<Scratch> s) {
+        std::lock_guard<std::mutex> lk(mu_);
+        free_.push_back(std::move(s));
+    }
+
+    const Data& data_;
+    std::mutex mu_;
+    std::vector<std::unique_ptr<Scratch>> free_;
+};
+
+}} // namespace planner::sas
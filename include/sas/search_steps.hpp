@@ -0,0 +1,72 @@
+#pragma once
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <limits>
+#include <utility>
+
+namespace planner { namespace sas {
+
+// --- 展開の直前で中断できる探索 ---
+// A* / GBFS の各エンジンはコルーチンとして書かれており、主ループの先頭で co_yield R.stats.expanded を実行する
+// run_until(n) は展開数が n に達した時点で探索を中断して戻り、次の run_until() で同じ場所から再開する
+// 中断しない限り co_yield は分岐 1 つで済むので、一度に最後まで探索する場合も同じコードを使う
+class SearchSteps {
+public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    // 展開数が上限に達した場合にのみ中断する awaiter
+    struct Pause {
+        bool stop;
+        bool await_ready() const noexcept { return !stop; }
+        void await_suspend(std::coroutine_handle<>) const noexcept {}
+        void await_resume() const noexcept {}
+    };
+
+    struct promise_type {
+        uint64_t stop_at = std::numeric_limits<uint64_t>::max(); // 展開数がこの値に達したら中断する
+        std::exception_ptr error; // 探索中に投げられた例外 (run_until() で投げ直す)
+
+        SearchSteps get_return_object() noexcept { return SearchSteps(Handle::from_promise(*this)); }
+        std::suspend_always initial_suspend() const noexcept { return {}; } // 最初の run_until() まで何もしない
+        std::suspend_always final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() noexcept { error = std::current_exception(); }
+        Pause yield_value(uint64_t expanded) const noexcept { return Pause{expanded >= stop_at}; }
+    };
+
+    SearchSteps() = default; // 何もせずに終わっている探索
+    SearchSteps(SearchSteps&& o) noexcept : h_(std::exchange(o.h_, nullptr)) {}
+    SearchSteps& operator=(SearchSteps&& o) noexcept { std::swap(h_, o.h_); return *this; }
+    ~SearchSteps() {
+        if (h_) {
+            h_.destroy();
+        }
+    }
+
+    bool done() const noexcept { return !h_ || h_.done(); }
+
+    // 展開数が stop_at に達するか、探索が終わるまで進める関数 (探索が終わった場合は true を返す)
+    bool run_until(uint64_t stop_at) {
+        if (done()) {
+            return true;
+        }
+        h_.promise().stop_at = stop_at;
+        h_.resume();
+        if (h_.promise().error) {
+            std::rethrow_exception(std::exchange(h_.promise().error, nullptr));
+        }
+        return h_.done();
+    }
+
+    // 探索を最後まで進める関数
+    void run() { (void)run_until(std::numeric_limits<uint64_t>::max()); }
+
+private:
+    explicit SearchSteps(Handle h) noexcept : h_(h) {}
+
+    Handle h_ = nullptr;
+};
+
+}} // namespace planner::sas
@@ -0,0 +1,160 @@
+#pragma once
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include "sas/sas_reader.hpp"
+
+// SAS 形式の探索エンジン (sas_search, two_bit_bfs など) が共有する状態操作のユーティリティ
+namespace planner { namespace sas {
+
+// mutex チェックのモード (実体は sas_search.cpp)
+extern int g_mutex_mode;
+enum { MUTEX_AUTO=0, MUTEX_ON=1, MUTEX_OFF=2 };
+
+static inline bool should_check_mutex_runtime(const Task& T) {
+    using namespace planner::sas;
+    if (g_mutex_mode == MUTEX_OFF) {
+        return false;
+    }
+    if (g_mutex_mode == MUTEX_ON)  {
+        return true;
+    }
+    return !T.mutexes.empty();
+}
+
+// ハッシュ／比較
+struct VecHash {
+    std::size_t operator()(const State& v) const noexcept {
+        // シンプルな 64-bit mix
+        std::size_t h = 1469598103934665603ull;
+        for (int x : v) {
+            std::size_t y = static_cast<std::size_t>(x) + 0x9e3779b97f4a7c15ull;
+            h ^= y;
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+};
+
+struct VecEq {
+    bool operator()(const State& a, const State& b) const noexcept {
+        return a == b;
+    }
+};
+
+// ゴール判定
+static inline bool is_goal(const Task& T, const State& s) {
+    for (auto [v,val] : T.goal) {
+        if (s[v] != val) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 適用判定
+static inline bool is_applicable(const Task& T, const State& s, const Operator& op) {
+    (void)T; // 現状では未使用
+    // prevail 条件
+    for (auto [v,val] : op.prevail) {
+        if (s[v] != val) {
+            return false;
+        }
+    }
+
+    // 条件付き効果の条件
+    for (const auto& pp : op.pre_posts) {
+        const auto& conds = std::get<0>(pp);
+        for (auto [cv,cval] : conds) {
+            if (s[cv] != cval) {
+                return false;
+            }
+        }
+    }
+
+    // pre_post の pre チェック（-1 は don't care）
+    for (const auto& pp : op.pre_posts) {
+        int var = std::get<1>(pp);
+        int pre = std::get<2>(pp);
+        if (pre >= 0 && s[var] != pre) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 差分適用（Undo 付き）
+using Undo = std::vector<std::pair<int,int>>; // (var, old_value)
+
+static inline std::size_t undo_mark(const Undo& u) { return u.size(); }
+
+static inline void undo_to(State& s, Undo& u, std::size_t mark) {
+    for (std::size_t i = u.size(); i-- > mark; ) {
+        const auto [var, oldv] = u[i];
+        s[var] = oldv;
+    }
+    u.resize(mark);
+}
+
+static inline void apply_inplace(const Task& T, const Operator& op, State& s, Undo& u) {
+    (void)T; // 現状では未使用
+    // 代入効果：var := post
+    for (const auto& pp : op.pre_posts) {
+        int var  = std::get<1>(pp);
+        int post = std::get<3>(pp);
+        if (s[var] != post) {
+            u.emplace_back(var, s[var]);
+            s[var] = post;
+        }
+    }
+}
+
+// 整数判定／丸め
+static inline bool all_action_costs_are_integers(const Task& T, double eps = 1e-12) {
+    for (const auto& op : T.ops) {
+        if (!std::isfinite(op.cost)) {
+            return false;
+        }
+        double nearest = std::round(op.cost);
+        if (std::fabs(op.cost - nearest) > eps) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 全ての演算子のコストが 1 かどうか (単位コストの探索経路を選ぶ判定)
+static inline bool all_action_costs_are_unit(const Task& T) {
+    for (const auto& op : T.ops) {
+        if (op.cost != 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static inline int rounding(double v) {
+    long long k = std::llround(v);
+    if (k < 0) {
+        throw std::runtime_error("negative value not supported");
+    }
+    return static_cast<int>(k);
+}
+
+// RAII で必ず巻き戻すためのガード
+struct UndoGuard {
+    State& work;
+    Undo& undo;
+    std::size_t mark;
+    ~UndoGuard() { undo_to(work, undo, mark); }
+};
+
+// タスクの構造 (変数のドメイン、初期状態、ゴール、演算子) から 64-bit の指紋を計算する関数
+// 保存したテーブルなどが同じタスクから作られたものかを確認するために用いる
+uint64_t task_fingerprint(const Task& T);
+
+}} // namespace planner::sas
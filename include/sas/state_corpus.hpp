@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+#include "sas/sas_reader.hpp"
+#include "sas/sas_heuristic.hpp"
+
+namespace planner { namespace sas {
+
+// --- 探索中に評価された状態の標本 ---
+// ヒューリスティックの呼び出しを包んで評価された状態と値を受け取り、reservoir sampling で最大 capacity 個を一様に残す
+// 書き出したファイル (コーパス) にはタスクそのものも含まれるので、探索をやり直さずにヒューリスティックの速度と値を比べられる
+class StateRecorder {
+public:
+    explicit StateRecorder(std::size_t capacity, uint64_t seed = 634);
+
+    // 評価された状態と値を 1 つ受け取る関数 (複数のスレッドから呼んでよい)
+    void offer(const State& s, double h);
+
+    // h を包み、評価した状態を全て offer() に渡すヒューリスティックを返す関数 (返した関数より先にこのオブジェクトを破棄しないこと)
+    HeuristicFn wrap(HeuristicFn h);
+
+    uint64_t seen() const;      // これまでに受け取った状態の数
+    std::size_t size() const;   // 保持している状態の数
+
+    // コーパスをファイルに書き出す関数 (heuristic には記録時に用いたヒューリスティックの名前を渡す)
+    void write(const std::string& path, const Task& T, const std::string& heuristic) const;
+
+private:
+    std::size_t capacity_;
+    mutable std::mutex mu_;
+    std::mt19937_64 rng_;
+    uint64_t seen_ = 0;
+    std::vector<State> states_;
+    std::vector<double> values_;
+};
+
+// ファイルから読み込んだコーパス
+struct StateCorpus {
+    Task task;
+    std::string heuristic;       // 記録時のヒューリスティックの名前
+    std::vector<State> states;
+    std::vector<double> values;  // 記録時のヒューリスティックの値 (states[i] に対応)
+    uint64_t seen = 0;           // 記録時に評価された状態の総数
+};
+
+// コーパスを読み込む関数 (形式が壊れている場合や、タスクの指紋が一致しない場合は例外を投げる)
+StateCorpus read_corpus(const std::string& path);
+
+}} // namespace planner::sas
@@ -0,0 +1,123 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "sas/sas_reader.hpp"
+#include "arena.hpp"
+
+namespace planner { namespace sas {
+
+// --- 状態 -> ノード ID の開番地法ハッシュ表 ---
+// スロットには (ハッシュ値の上位 32bit, ノード ID) の 8 byte のみを置き、状態そのものは呼び出し側のノード配列と比較する
+// ハッシュ値を先に計算して prefetch() でスロットを先読みしておくことで、複数の後続状態の重複検出のキャッシュミスを重ねて待つ
+class StateIndex {
+public:
+    static constexpr int32_t EMPTY = -1;
+
+    explicit StateIndex(std::size_t initial_capacity = 1u << 15);
+
+    // 状態のハッシュ値を求める関数 (FNV-1a の後に下位 bit もよく混ざるように最終ミックスを行う)
+    static uint64_t hash(const State& s) noexcept {
+        uint64_t h = 1469598103934665603ull;
+        for (int x : s) {
+            h ^= static_cast<uint64_t>(static_cast<uint32_t>(x));
+            h *= 1099511628211ull;
+        }
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // ハッシュ値 h の探索開始スロットをキャッシュに先読みする関数
+    void prefetch(uint64_t h) const noexcept {
+        __builtin_prefetch(&slots_[h & mask_]);
+    }
+
+    // 状態 s (ハッシュ値 h) のノード ID を返す関数、見つからない場合は EMPTY を返す
+    // state_of(id) は、ノード ID から登録済みの状態への const 参照を返す関数
+    template <class StateOf>
+    int find(const State& s, uint64_t h, const StateOf& state_of) const {
+        const uint32_t tag = static_cast<uint32_t>(h >> 32);
+        for (std::size_t i = h & mask_; ; i = (i + 1) & mask_) {
+            const Slot& sl = slots_[i];
+            if (sl.id == EMPTY) {
+                return EMPTY;
+            }
+            if (sl.tag == tag && state_of(sl.id) == s) {
+                return sl.id;
+            }
+        }
+    }
+
+    // 未登録の状態 (ハッシュ値 h) をノード ID id で登録する関数 (負荷率が 1/2 を超える場合は表を 2 倍にする)
+    template <class StateOf>
+    void insert(uint64_t h, int id, const StateOf& state_of) {
+        if ((size_ + 1) * 2 > slots_.size()) {
+            ArenaVector<Slot> old;
+            old.swap(slots_);
+            slots_.assign(old.size() * 2, Slot{0, EMPTY});
+            mask_ = slots_.size() - 1;
+            for (const Slot& sl : old) {
+                if (sl.id != EMPTY) {
+                    place(hash(state_of(sl.id)), sl.id);
+                }
+            }
+        }
+        place(h, id);
+        ++size_;
+    }
+
+    std::size_t size() const noexcept { return size_; }
+
+private:
+    struct Slot {
+        uint32_t tag; // ハッシュ値の上位 32bit
+        int32_t id;   // ノード ID (EMPTY は空きスロット)
+    };
+
+    void place(uint64_t h, int id) noexcept;
+
+    ArenaVector<Slot> slots_; // 大きくなっても要素のコピーが起こらないように、アリーナ上に置く
+    std::size_t mask_ = 0;
+    std::size_t size_ = 0;
+};
+
+// --- 1 回の展開で生成した後続状態のバッファ ---
+// 要素の State は再利用され、容量を保ったままコピー代入されるので、展開ごとのメモリ確保は起こらない
+class SuccessorBatch {
+public:
+    void clear() noexcept { n_ = 0; }
+    std::size_t size() const noexcept { return n_; }
+
+    void push(const State& s, int op_id) {
+        if (n_ == states_.size()) {
+            states_.emplace_back();
+            ops_.emplace_back();
+            hashes_.emplace_back();
+        }
+        states_[n_] = s;
+        ops_[n_] = op_id;
+        ++n_;
+    }
+
+    // 全ての後続状態のハッシュ値を計算し、それぞれの探索開始スロットを先読みする関数
+    void hash_and_prefetch(const StateIndex& index) noexcept {
+        for (std::size_t i = 0; i < n_; ++i) {
+            hashes_[i] = StateIndex::hash(states_[i]);
+            index.prefetch(hashes_[i]);
+        }
+    }
+
+    const State& state(std::size_t i) const noexcept { return states_[i]; }
+    int op(std::size_t i) const noexcept { return ops_[i]; }
+    uint64_t hash(std::size_t i) const noexcept { return hashes_[i]; }
+
+private:
+    std::vector<State> states_;
+    std::vector<int> ops_;
+    std::vector<uint64_t> hashes_;
+    std::size_t n_ = 0;
+};
+
+}} // namespace planner::sas
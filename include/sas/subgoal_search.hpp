@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "sas/sas_reader.hpp"
+#include "sas/sas_heuristic.hpp"
+#include "sas/sas_search.hpp"
+#include "sas/multi_goal.hpp"
+
+namespace planner { namespace sas {
+
+struct SubgoalParams {
+    uint64_t max_sub_expansions = 100000; // 部分問題 1 つあたりの展開数の上限
+    int max_backtracks = 4;               // 最後のゴールへの探索が失敗した時に、遡って解き直すチェックポイントの数
+    bool fallback = true;                 // 分解で解けなかった場合に、元のタスクを gbfs で解くかどうか
+};
+
+struct SubgoalResult {
+    Result result;                     // 連結したプランと、全ての部分問題の探索を合わせた統計
+    std::size_t num_landmarks = 0;     // LandmarkGraph の landmark の数
+    std::size_t subgoals_solved = 0;   // 解けた部分問題の数 (最後のゴールへの探索を除く)
+    std::size_t subgoals_failed = 0;   // 展開数の上限までに解けず、飛ばした部分問題の数
+    std::size_t backtracks = 0;        // 最後のゴールへの探索のために遡った回数
+    bool fell_back = false;            // 元のタスクの gbfs で解いたかどうか
+};
+
+// --- landmark を部分ゴールとして順に解く探索 ---
+// LandmarkGraph の必要順序 (parents) で親が全て処理済みになった landmark のうち、
+// 現在の状態から DTG 上の距離が最も近い fact を 1 つ選び、それだけをゴールとした部分問題を gbfs で解いてプランをつなげる
+// (ゴールの landmark は、それ以外の候補がなくなってから選ぶ)
+// landmark が尽きたら元のゴールを部分問題として解き、失敗した場合はチェックポイントを遡って解き直し、
+// それでも解けなければ (fallback の場合) 初期状態から元のタスクを gbfs で解く
+// 部分問題のヒューリスティックは、ゴールと初期状態を差し替えたタスクに対して make_h で作る (空の場合は blind)
+// 得られるプランは最適とは限らない
+SubgoalResult subgoal_search(const Task& T, const HeuristicFactory& make_h, bool h_is_integer,
+                             const SubgoalParams& sp, const Params& p);
+
+}} // namespace planner::sas
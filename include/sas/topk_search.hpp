@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "sas/sas_reader.hpp"
+#include "sas/sas_heuristic.hpp"
+#include "sas/sas_search.hpp"
+
+namespace planner { namespace sas {
+
+struct TopKParams {
+    std::size_t k = 1;              // 求めるプランの数
+    double diversity = 0.0;         // > 0 の場合、既に選んだ全てのプランとの演算子集合の Jaccard 距離がこの値以上のプランのみを選ぶ
+    uint64_t max_candidates = 1000000; // 1 回の列挙で取り出す候補の上限 (diversity > 0 で候補が尽きない場合の打ち切り)
+};
+
+struct TopKResult {
+    std::vector<std::vector<uint32_t>> plans; // コストの昇順
+    std::vector<double> costs;
+    Stats stats;
+    bool exhausted = false; // 探索空間を網羅した (k 個に満たない場合、それ以上のプランは存在しない)
+    StopReason stop = StopReason::None;
+};
+
+// --- 1 回の探索で、コストの小さい順に k 個のプラン (または k 個の互いに異なるプラン) を求める関数 ---
+// A* で展開した状態と、その間の全ての辺を保持し、最短経路木から外れる辺 (sidetrack) の列で経路を表して小さい順に列挙する (Eppstein / K* と同じ表現)
+// オープンリストの f の最小値を超えるコストのプランは、まだ展開していない状態を通りうるので、k 個が f の最小値以下で揃うまで展開を続ける
+// 同じ状態を何度も通るプランも異なるプランとして数える、ヒューリスティックは consistent でなければならない
+TopKResult topk_search(const Task& T, HeuristicFn h, const TopKParams& kp, const Params& p);
+
+}} // namespace planner::sas
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "sas/sas_reader.hpp"
+#include "sas/sas_heuristic.hpp"
+#include "sas/dense_state_table.hpp"
+
+namespace planner { namespace sas {
+
+// --- ゴール距離表 ---
+// ランクで引く 1 byte/状態 の表で、ゴールまでの最短ステップ数を保持する
+// 列挙に用いる 2bit/状態 の配列の 4 倍のメモリを使い、距離は MAX_DIST で頭打ちになる
+// (距離を 3 で割った余りだけを 2bit で持つ方式は、状態空間が有向なので後続状態をたどって距離を復元できず、ヒューリスティックとして引けない)
+// 値 UNREACHABLE は、ゴールに到達できない状態 (または初期状態から到達不能な状態) を表す
+class GoalDistanceTable {
+public:
+    static constexpr uint8_t UNREACHABLE = 255;
+    static constexpr uint8_t MAX_DIST = 254; // これを超える距離は MAX_DIST に丸める (許容的な下界となる)
+
+    GoalDistanceTable(const Task& T, uint64_t max_states);
+
+    bool fits() const noexcept { return ranker_.fits(); }
+    const StateRanker& ranker() const noexcept { return ranker_; }
+    std::vector<uint8_t>& data() noexcept { return dist_; }
+    const std::vector<uint8_t>& data() const noexcept { return dist_; }
+
+    uint8_t distance(const State& s) const { return dist_[ranker_.rank(s)]; }
+
+    int min_cost() const noexcept { return min_cost_; }
+    bool truncated() const noexcept { return truncated_; }
+    void set_truncated(bool t) noexcept { truncated_ = t; }
+
+    // 表をファイルに保存・読み込みする関数 (タスクの指紋が一致しない場合は例外を投げる)
+    void save(const std::string& path) const;
+    static std::shared_ptr<GoalDistanceTable> load(const Task& T, const std::string& path);
+
+private:
+    StateRanker ranker_;
+    std::vector<uint8_t> dist_;
+    uint64_t fingerprint_ = 0;
+    int min_cost_ = 0; // 演算子コストの最小値 (距離 × min_cost が許容的なヒューリスティック値となる)
+    bool truncated_ = false; // MAX_DIST で距離を打ち切ったかどうか
+};
+
+// 距離表をヒューリスティック関数として用いる (h = 距離 × 最小演算子コスト、ユニットコストでは完全なヒューリスティック)
+HeuristicFn distance_table_heuristic(std::shared_ptr<const GoalDistanceTable> table);
+
+// --- 2-bit 幅優先列挙 ---
+struct Bfs2Params {
+    uint32_t num_threads = 0; // 0 の場合は hardware_concurrency() を用いる
+    uint64_t max_states = DenseStateTable::MAX_STATES; // これより状態空間が大きい場合は列挙しない
+    bool compute_goal_distance = true; // 到達可能状態についてゴール距離表を作るかどうか
+};
+
+struct Bfs2Result {
+    bool fits = false; // 状態空間がランク付けできる大きさだったかどうか
+    uint64_t num_states = 0; // ランク空間の大きさ
+    uint64_t reachable = 0; // 初期状態から到達可能な状態数
+    uint64_t goal_states = 0; // 到達可能なゴール状態数
+    std::vector<uint64_t> layer_sizes; // 初期状態からの各深さの状態数
+    std::shared_ptr<GoalDistanceTable> table; // compute_goal_distance の場合のみ
+    int init_distance = -1; // 初期状態のゴール距離 (到達不能の場合は -1)
+    std::vector<uint32_t> plan; // 距離表を下ることで得られるステップ数最小のプラン
+    bool timed_out = false; // CPU 時間の制限により列挙を打ち切ったかどうか
+};
+
+// 到達可能な状態空間を、状態のランクで引く 2bit/状態 の配列 (unseen / open / closed / next) を用いて層ごとに列挙する
+Bfs2Result two_bit_bfs(const Task& T, const Bfs2Params& p = {});
+
+}} // namespace planner::sas
@@ -1,5 +1,6 @@
 #pragma once
 #include <cmath>
+#include <limits>
 #include "strips.hpp"
 #include "heuristic.hpp"
 #include <vector>
@@ -25,6 +26,7 @@ struct SearchStats {
     int generated = 0;
     int expanded  = 0;
     int duplicates = 0;
+    int pruned_by_bound = 0; // コスト上界によって枝刈りした後続ノードの数
 };
 
 // 探索結果の返り値として用いるための struct
@@ -34,6 +36,7 @@ struct SearchResult {
     double plan_cost = 0.0;
     SearchStats stats;
     std::vector<Node> nodes; // 経路上のノードを格納する用の vector
+    bool bound_exhausted = false; // コスト上界未満のプランが存在しないことを示したかどうか
 };
 
 // 探索用のパラメータをまとめた struct
@@ -41,6 +44,7 @@ struct SearchParams {
     int   max_expansions = 500000000;
     bool  reopen_closed  = true; // closed をもう一度 open するかどうか
     bool  stop_on_generate_goal = true; // 生成時に goal 条件を満たしていたら停止
+    double cost_bound = std::numeric_limits<double>::infinity(); // コストがこの値未満のプランのみを探索する (g+h >= cost_bound のノードは枝刈り)
 };
 
 // ノード id と bool の値を保存する用の bitpack structure
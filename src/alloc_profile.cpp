@@ -0,0 +1,212 @@
+#include "alloc_profile.hpp"
+
+namespace planner {
+
+const char* alloc_phase_name(AllocPhase ph) noexcept {
+    switch (ph) {
+        case AllocPhase::Other:          return "other";
+        case AllocPhase::Parse:          return "parse";
+        case AllocPhase::Ground:         return "ground";
+        case AllocPhase::HeuristicSetup: return "heuristic setup";
+        case AllocPhase::Expansion:      return "expansion";
+        case AllocPhase::Evaluation:     return "evaluation";
+        case AllocPhase::Open:           return "open";
+        case AllocPhase::Closed:         return "closed";
+        case AllocPhase::Count:          break;
+    }
+    return "?";
+}
+
+} // namespace planner
+
+#ifdef PLANNER_ALLOC_PROFILE
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace planner {
+
+namespace {
+
+constexpr std::size_t NUM_PHASES = static_cast<std::size_t>(AllocPhase::Count);
+constexpr std::size_t MAX_SLOTS = 256; // 専用の集計領域を持てるスレッドの数 (それ以降のスレッドは最後の領域を共有する)
+constexpr std::size_t HEADER = 16;     // 確保した領域の直前に置くヘッダの大きさ (malloc の整列を保つ)
+
+// 確保した領域の直前に置き、解放時に大きさと確保した段階を知るためのヘッダ
+struct Header {
+    uint64_t size;
+    uint32_t phase;
+    uint32_t offset; // malloc が返したアドレスから、呼び出し元に返したアドレスまでの距離
+};
+static_assert(sizeof(Header) == HEADER);
+
+// スレッドごとの集計 (書き込むのは持ち主のスレッドのみなので、加算は競合しない)
+struct alignas(64) Slot {
+    std::atomic<uint64_t> allocs[NUM_PHASES];
+    std::atomic<uint64_t> bytes[NUM_PHASES];
+    std::atomic<uint64_t> frees[NUM_PHASES];
+};
+
+// 静的な 0 初期化のみで使えるようにし、他の翻訳単位の静的初期化中の確保も数えられるようにする
+Slot g_slots[MAX_SLOTS];
+std::atomic<uint32_t> g_next_slot{0};
+std::atomic<int64_t> g_live[NUM_PHASES];  // 段階ごとの生存中のバイト数 (解放は別のスレッドで起こりうるので共有する)
+std::atomic<int64_t> g_peak[NUM_PHASES];  // その最大値
+
+thread_local AllocPhase t_phase = AllocPhase::Other;
+thread_local Slot* t_slot = nullptr;
+
+Slot& my_slot() noexcept {
+    if (t_slot == nullptr) {
+        const uint32_t i = g_next_slot.fetch_add(1, std::memory_order_relaxed);
+        t_slot = &g_slots[i < MAX_SLOTS ? i : MAX_SLOTS - 1];
+    }
+    return *t_slot;
+}
+
+void count_alloc(std::size_t size, std::size_t ph) noexcept {
+    Slot& s = my_slot();
+    s.allocs[ph].fetch_add(1, std::memory_order_relaxed);
+    s.bytes[ph].fetch_add(size, std::memory_order_relaxed);
+    const int64_t live = g_live[ph].fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed) + static_cast<int64_t>(size);
+    int64_t peak = g_peak[ph].load(std::memory_order_relaxed);
+    while (live > peak && !g_peak[ph].compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+// align 以上に整列した領域を確保し、直前にヘッダを書く関数 (確保できない場合は nullptr)
+void* profiled_alloc(std::size_t size, std::size_t align) noexcept {
+    const std::size_t offset = align > HEADER ? align : HEADER;
+    for (;;) {
+        void* base = nullptr;
+        if (align > HEADER) {
+            const std::size_t total = (size + offset + align - 1) / align * align;
+            base = std::aligned_alloc(align, total);
+        } else {
+            base = std::malloc(size + offset);
+        }
+        if (base != nullptr) {
+            char* p = static_cast<char*>(base) + offset;
+            const std::size_t ph = static_cast<std::size_t>(t_phase);
+            Header* hd = reinterpret_cast<Header*>(p - HEADER);
+            hd->size = size;
+            hd->phase = static_cast<uint32_t>(ph);
+            hd->offset = static_cast<uint32_t>(offset);
+            count_alloc(size, ph);
+            return p;
+        }
+        std::new_handler nh = std::get_new_handler();
+        if (nh == nullptr) {
+            return nullptr;
+        }
+        nh();
+    }
+}
+
+void profiled_free(void* ptr) noexcept {
+    if (ptr == nullptr) {
+        return;
+    }
+    char* p = static_cast<char*>(ptr);
+    const Header* hd = reinterpret_cast<const Header*>(p - HEADER);
+    const std::size_t ph = hd->phase;
+    my_slot().frees[ph].fetch_add(1, std::memory_order_relaxed);
+    g_live[ph].fetch_sub(static_cast<int64_t>(hd->size), std::memory_order_relaxed);
+    std::free(p - hd->offset);
+}
+
+void* alloc_or_throw(std::size_t size, std::size_t align) {
+    void* p = profiled_alloc(size, align);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void report_at_exit() {
+    alloc_profile_report(stderr);
+}
+
+// 終了時に集計を表示するように登録する
+const bool g_registered = (std::atexit(report_at_exit), true);
+
+} // namespace
+
+AllocPhase current_alloc_phase() noexcept {
+    return t_phase;
+}
+
+AllocPhaseScope::AllocPhaseScope(AllocPhase ph) noexcept : prev_(t_phase) {
+    t_phase = ph;
+}
+
+AllocPhaseScope::~AllocPhaseScope() {
+    t_phase = prev_;
+}
+
+void alloc_profile_report(std::FILE* out) {
+    (void)g_registered;
+    const uint32_t used = g_next_slot.load(std::memory_order_relaxed);
+    const std::size_t n = used < MAX_SLOTS ? used : MAX_SLOTS;
+
+    std::fprintf(out, "[ALLOC] %-16s %14s %16s %14s %16s %16s\n",
+                 "phase", "allocs", "bytes", "frees", "live bytes", "peak live");
+    uint64_t total_allocs = 0, total_bytes = 0, total_frees = 0;
+    for (std::size_t ph = 0; ph < NUM_PHASES; ++ph) {
+        uint64_t allocs = 0, bytes = 0, frees = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            allocs += g_slots[i].allocs[ph].load(std::memory_order_relaxed);
+            bytes += g_slots[i].bytes[ph].load(std::memory_order_relaxed);
+            frees += g_slots[i].frees[ph].load(std::memory_order_relaxed);
+        }
+        total_allocs += allocs;
+        total_bytes += bytes;
+        total_frees += frees;
+        if (allocs == 0) {
+            continue;
+        }
+        std::fprintf(out, "[ALLOC] %-16s %14llu %16llu %14llu %16lld %16lld\n",
+                     alloc_phase_name(static_cast<AllocPhase>(ph)),
+                     static_cast<unsigned long long>(allocs), static_cast<unsigned long long>(bytes),
+                     static_cast<unsigned long long>(frees),
+                     static_cast<long long>(g_live[ph].load(std::memory_order_relaxed)),
+                     static_cast<long long>(g_peak[ph].load(std::memory_order_relaxed)));
+    }
+    std::fprintf(out, "[ALLOC] %-16s %14llu %16llu %14llu  (%zu threads)\n", "total",
+                 static_cast<unsigned long long>(total_allocs), static_cast<unsigned long long>(total_bytes),
+                 static_cast<unsigned long long>(total_frees), static_cast<std::size_t>(used));
+    std::fflush(out);
+}
+
+} // namespace planner
+
+// --- 大域の operator new/delete の置き換え ---
+
+void* operator new(std::size_t size) { return planner::alloc_or_throw(size, 0); }
+void* operator new[](std::size_t size) { return planner::alloc_or_throw(size, 0); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return planner::profiled_alloc(size, 0); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return planner::profiled_alloc(size, 0); }
+void* operator new(std::size_t size, std::align_val_t al) { return planner::alloc_or_throw(size, static_cast<std::size_t>(al)); }
+void* operator new[](std::size_t size, std::align_val_t al) { return planner::alloc_or_throw(size, static_cast<std::size_t>(al)); }
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return planner::profiled_alloc(size, static_cast<std::size_t>(al));
+}
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return planner::profiled_alloc(size, static_cast<std::size_t>(al));
+}
+
+void operator delete(void* p) noexcept { planner::profiled_free(p); }
+void operator delete[](void* p) noexcept { planner::profiled_free(p); }
+void operator delete(void* p, std::size_t) noexcept { planner::profiled_free(p); }
+void operator delete[](void* p, std::size_t) noexcept { planner::profiled_free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { planner::profiled_free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { planner::profiled_free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { planner::profiled_free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { planner::profiled_free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { planner::profiled_free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { planner::profiled_free(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { planner::profiled_free(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { planner::profiled_free(p); }
+
+#endif // PLANNER_ALLOC_PROFILE
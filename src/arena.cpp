@@ -0,0 +1,173 @@
+#include "arena.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+namespace planner {
+
+namespace {
+
+constexpr std::size_t COMMIT_CHUNK = std::size_t(2) << 20; // 払い出しの単位 (ヒュージページ 1 枚分)
+
+std::size_t round_up(std::size_t n, std::size_t unit) {
+    return (n + unit - 1) / unit * unit;
+}
+
+} // namespace
+
+ArenaOptions& arena_options() {
+    static ArenaOptions opt;
+    return opt;
+}
+
+Arena::Arena(const ArenaOptions& opt) : pending_reserve_(opt.initial_reserve), huge_(opt.huge_pages) {
+    // 実際の予約は最初の ensure() まで遅らせる (使われない配列は仮想アドレスも消費しない)
+    if (!opt.backing_dir.empty()) {
+#if defined(__linux__)
+        std::string tmpl = opt.backing_dir + "/planner_arena_XXXXXX";
+        fd_ = ::mkstemp(tmpl.data());
+        if (fd_ < 0) {
+            throw std::runtime_error("failed to create arena backing file in " + opt.backing_dir);
+        }
+        ::unlink(tmpl.c_str()); // 名前は不要なので、プロセス終了時に自動で消えるようにする
+#endif
+    }
+}
+
+Arena::~Arena() {
+#if defined(__linux__)
+    if (base_ != nullptr) {
+        ::munmap(base_, reserved_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+#else
+    std::free(base_);
+#endif
+}
+
+void Arena::swap(Arena& o) noexcept {
+    std::swap(base_, o.base_);
+    std::swap(reserved_, o.reserved_);
+    std::swap(committed_, o.committed_);
+    std::swap(fd_, o.fd_);
+    std::swap(hugetlb_, o.hugetlb_);
+    std::swap(huge_, o.huge_);
+    std::swap(pending_reserve_, o.pending_reserve_);
+}
+
+#if defined(__linux__)
+
+void Arena::map_initial(std::size_t bytes) {
+    std::size_t res = round_up(std::max(bytes, pending_reserve_), COMMIT_CHUNK);
+    void* p = map_range(res);
+    if (p == MAP_FAILED && res > bytes) {
+        // 先読みの予約が仮想メモリの上限に掛かった場合は、必要な大きさだけを予約する
+        res = round_up(bytes, COMMIT_CHUNK);
+        p = map_range(res);
+    }
+    if (p == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    if (!hugetlb_ && fd_ < 0 && huge_ != ArenaOptions::HugePages::Off) {
+        (void)::madvise(p, res, MADV_HUGEPAGE); // 透過的ヒュージページが無効な環境では単に失敗する
+    }
+    base_ = p;
+    reserved_ = res;
+}
+
+void* Arena::map_range(std::size_t res) {
+    void* p = MAP_FAILED;
+
+    if (fd_ >= 0) {
+        p = ::mmap(nullptr, res, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_NORESERVE, fd_, 0);
+    } else {
+        if (huge_ == ArenaOptions::HugePages::Explicit) {
+            // MAP_NORESERVE を付けると、ヒュージページのプールが足りない場合に触れた時点で SIGBUS となるので、予約時に確保させる
+            p = ::mmap(nullptr, res, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            hugetlb_ = (p != MAP_FAILED);
+        }
+        if (p == MAP_FAILED) {
+            p = ::mmap(nullptr, res, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        }
+    }
+    return p;
+}
+
+void Arena::grow(std::size_t bytes) {
+    std::size_t res = round_up(std::max(bytes, reserved_ * 2), COMMIT_CHUNK);
+
+    // ページテーブルの付け替えのみで領域を広げる (内容はコピーされない)
+    void* p = ::mremap(base_, reserved_, res, MREMAP_MAYMOVE);
+    if (p == MAP_FAILED && res > bytes) {
+        // 倍の予約が仮想メモリの上限に掛かった場合は、必要な大きさだけに広げる
+        res = bytes;
+        p = ::mremap(base_, reserved_, res, MREMAP_MAYMOVE);
+    }
+    if (p == MAP_FAILED) {
+        // mremap に対応しないマッピングの場合は、新しい領域を確保してコピーする (確保できなければ元の領域を残す)
+        p = map_range(res);
+        if (p == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        std::memcpy(p, base_, committed_);
+        ::munmap(base_, reserved_);
+    }
+    if (!hugetlb_ && fd_ < 0 && huge_ != ArenaOptions::HugePages::Off) {
+        (void)::madvise(p, res, MADV_HUGEPAGE);
+    }
+    base_ = p;
+    reserved_ = res;
+}
+
+void* Arena::ensure(std::size_t bytes) {
+    if (bytes <= committed_) {
+        return base_;
+    }
+    const std::size_t want = round_up(bytes, COMMIT_CHUNK);
+    if (base_ == nullptr) {
+        map_initial(want);
+    } else if (want > reserved_) {
+        grow(want);
+    }
+    if (fd_ >= 0) { // ファイルの大きさを広げる (触れていない部分はゼロとして読める)
+        if (::ftruncate(fd_, static_cast<off_t>(want)) != 0) {
+            throw std::bad_alloc();
+        }
+    }
+    committed_ = want;
+    return base_;
+}
+
+#else
+
+// mmap が使えない環境では realloc で代用する
+void Arena::map_initial(std::size_t) {}
+void* Arena::map_range(std::size_t) { return nullptr; }
+void Arena::grow(std::size_t) {}
+
+void* Arena::ensure(std::size_t bytes) {
+    if (bytes <= committed_) {
+        return base_;
+    }
+    const std::size_t want = round_up(std::max(bytes, committed_ * 2), COMMIT_CHUNK);
+    void* p = std::realloc(base_, want);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    std::memset(static_cast<char*>(p) + committed_, 0, want - committed_);
+    base_ = p;
+    reserved_ = committed_ = want;
+    return base_;
+}
+
+#endif
+
+} // namespace planner
@@ -1,4 +1,5 @@
 #include "grounding.hpp"
+#include "alloc_profile.hpp"
 #include <stdexcept>
 #include <sstream>
 #include <algorithm>
@@ -348,6 +349,7 @@ static inline std::string key_of_ids(int pid, const std::vector<int>& ids) {
 
 GroundTask ground(const Domain& d, const Problem& p)
 {
+    PLANNER_ALLOC_PHASE(Ground);
     GroundTask G;
 
     for (auto& [name, ty] :d.constants) {
@@ -7,6 +7,7 @@
 #include <chrono>
 #include <filesystem>
 #include <cmath>
+#include <limits>
 
 #include "lexer.hpp"
 #include "parser.hpp"
@@ -31,10 +32,11 @@ static std::string slurp(const std::string& path) {
 static void print_usage(const char* argv0) {
     std::cerr
       << "Usage:\n"
-      << "  " << argv0 << " <domain.pddl> <problem.pddl> [--algo astar] "<< "[--h blind|goalcount|wgoalcount W] [--plan-dir <DIR>]\n"
+      << "  " << argv0 << " <domain.pddl> <problem.pddl> [--algo astar] "<< "[--h blind|goalcount|wgoalcount W] [--plan-dir <DIR>] [--bound C]\n"
       << "Examples:\n"
       << "  " << argv0 << " domain.pddl problem.pddl --algo astar --h goalcount --plan-dir directory\n"
-      << "  " << argv0 << " domain.pddl problem.pddl --algo astar --h wgoalcount 2.0 --plan-dir directory\n";
+      << "  " << argv0 << " domain.pddl problem.pddl --algo astar --h wgoalcount 2.0 --plan-dir directory\n"
+      << "  " << argv0 << " domain.pddl problem.pddl --algo astar --h goalcount --bound 12   # plans with cost < 12 only\n";
 }
 
 // 整数かどうか判定する関数
@@ -61,6 +63,7 @@ int main(int argc, char** argv) {
         std::string hname = "goalcount";
         double w = 1.0;
         std::string plan_dir; // plan を出力するディレクトリ
+        double cost_bound = std::numeric_limits<double>::infinity(); // コスト上界 (inf の場合は上界なし)
 
         for (int i=3; i<argc; ++i) {
             std::string a = argv[i];
@@ -82,6 +85,10 @@ int main(int argc, char** argv) {
                 plan_dir = argv[++i];
                 continue;
             }
+            if (a == "--bound" && i+1 < argc) { // コスト上界を指定する引数の場合
+                cost_bound = std::stod(argv[++i]);
+                continue;
+            }
             if (a == "--help" || a == "-h") { //　使用法を確認したい場合
                 print_usage(argv[0]);
                 return 0;
@@ -154,6 +161,7 @@ int main(int argc, char** argv) {
 
         // --- Search ---
         SearchParams params;
+        params.cost_bound = cost_bound;
         SearchResult  res;
         double search_time = 0.0;
 
@@ -182,6 +190,8 @@ int main(int argc, char** argv) {
             std::cout << "Solution found." << std::endl;
             std::cout << "Plan length: " << res.plan.size() << " step(s)" << std::endl;
             std::cout << "Plan cost: "   << res.plan_cost << std::endl;
+        } else if (res.bound_exhausted) {
+            std::cout << "Completely explored state space below bound " << cost_bound << " — no solution!" << std::endl;
         } else {
             std::cout << "Completely explored state space — no solution!" << std::endl;
         }
@@ -189,6 +199,9 @@ int main(int argc, char** argv) {
         // FD 互換の統計行
         std::cout << "Expanded "  << res.stats.expanded  << " state(s)" << std::endl;
         std::cout << "Generated " << res.stats.generated << " state(s)" << std::endl;
+        if (std::isfinite(cost_bound)) {
+            std::cout << "Pruned by bound " << res.stats.pruned_by_bound << " state(s)" << std::endl;
+        }
         std::cout << "Search time: " << search_time_s << "s" << std::endl;
         std::cout << "Total time: "  << total_time_s  << "s" << std::endl;
 
@@ -221,7 +234,7 @@ int main(int argc, char** argv) {
         }
         int exit_code = 0;
         if (!res.solved) {
-            exit_code = 1; // 解なし（探索完了）を 1 に
+            exit_code = res.bound_exhausted ? 2 : 1; // 解なし（探索完了）を 1 に、上界未満の解なしを 2 に
         }
         return exit_code;
 
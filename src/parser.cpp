@@ -1,4 +1,5 @@
 #include "parser.hpp"
+#include "alloc_profile.hpp"
 #include <unordered_set>
 #include <unordered_map>
 #include <stdexcept>
@@ -476,6 +477,7 @@ std::vector<std::pair<std::string,std::string>> Parser::parseConstantsSection(){
 
 // ドメインの解析
 Domain Parser::parseDomain(){
+    PLANNER_ALLOC_PHASE(Parse);
     Domain d;
 
     // (define (domain NAME) ... ) の形を予想して読み込む
@@ -718,6 +720,7 @@ void Parser::parseMetricSectionInto(Problem& p){
 
 // 問題の解析
 Problem Parser::parseProblem(){
+    PLANNER_ALLOC_PHASE(Parse);
     Problem p;
 
     // (define (problem NAME) (:domain NAME) ... ) の冒頭部分を解析する
@@ -1,5 +1,7 @@
 #include "sas/bi_search.hpp"
 #include "bucket_pq.hpp"
+#include "sas/state_index.hpp"
+#include "alloc_profile.hpp"
 #include <robin_hood.h>
 
 #include <unordered_map>
@@ -7,6 +9,7 @@
 #include <limits>
 #include <cmath>
 #include <cassert>
+#include <stdexcept>
 #include <iostream>
 
 // コンパイラに対するヒントのためのマクロ変数
@@ -34,27 +37,6 @@ static inline bool should_check_mutex_runtime(const Task& T) {
     return !T.mutexes.empty();
 }
 
-// --- unordered_map 用のハッシュ関数と等価比較関数の設計 ---
-// 状態 (vector<int>) のハッシュ関数 (FNV-1a)
-struct FwdHash {
-    std::size_t operator()(const State& v) const noexcept {
-        std::size_t h = 1469598103934665603ull;
-        for (int x : v) {
-            std::size_t y = static_cast<std::size_t>(x) + 0x9e3779b97f4a7c15ull;
-            h ^= y;
-            h *= 1099511628211ull;
-        }
-        return h;
-    }
-};
-
-// 状態 (vector<int>) の等価比較を行う関数オブジェクト
-struct FwdEq {
-    bool operator()(const State& a, const State& b) const noexcept {
-        return a == b;
-    }
-};
-
 // --- unknown を扱う後ろ向き探索用の state を表すデータ構造 ---
 using RegState = std::vector<int>;
 
@@ -399,6 +381,7 @@ struct BackNode {
 };
 
 Result bidir_astar(const Task& T, HeuristicFn h, bool h_is_integer, const Params& p) {
+    PLANNER_ALLOC_PHASE(Expansion);
     Result R;
     R.solved = false;
     R.plan_cost = 0.0;
@@ -421,6 +404,10 @@ Result bidir_astar(const Task& T, HeuristicFn h, bool h_is_integer, const Params
 
     // 初期状態がすでにゴールを満たしている場合の判定
     if (forward_state_satisfies_reg(s0, g0)) {
+        if (0.0 >= p.cost_bound) { // 空のプランでさえ上界以上の場合
+            R.bound_exhausted = true;
+            return R;
+        }
         R.solved = true;
         R.plan_cost = 0.0;
         R.plan.clear();
@@ -434,14 +421,11 @@ Result bidir_astar(const Task& T, HeuristicFn h, bool h_is_integer, const Params
     R.nodes.push_back(Node{ s0, -1, -1 });
 
     // 前向きノードの状態と ID を保管するハッシュマップ
-#if defined(USE_ROBIN_HOOD)
-    robin_hood::unordered_map<State, int, FwdHash, FwdEq> index_fwd;
-#else
-    std::unordered_map<State, int, VecHash, VecEq> index_fwd;
-    index_fwd.max_load_factor(0.5f);
-#endif
-    index_fwd.reserve(1<<15);
-    index_fwd.emplace(R.nodes[0].s, 0);
+    // (前向き側は開番地法の表に ID のみを置き、後続状態をまとめてハッシュ値の計算と先読みを行ってから引く)
+    auto state_of = [&R](int id) -> const State& { return R.nodes[id].s; };
+    StateIndex index_fwd(1<<15);
+    SuccessorBatch batch_f;
+    index_fwd.insert(StateIndex::hash(R.nodes[0].s), 0, state_of);
 
     // regression search 用の探索ノード管理用のベクタの設計と初期ノードの登録
     std::vector<BackNode> back_nodes;
@@ -460,7 +444,8 @@ Result bidir_astar(const Task& T, HeuristicFn h, bool h_is_integer, const Params
 
     // forwarding と regression search の meeting 情報
     bool   have_meeting = false;
-    double best_cost = std::numeric_limits<double>::infinity();
+    double best_cost = p.cost_bound; // コスト上界未満の meeting のみを受け付ける (上界なしの場合は inf)
+    bool   fwd_exhausted = false; // 前向き側のオープンリストを使い切ったかどうか
     int best_f = -1;
     int best_b = -1;
 
@@ -468,9 +453,9 @@ Result bidir_astar(const Task& T, HeuristicFn h, bool h_is_integer, const Params
     {
         const bool do_mutex = should_check_mutex_runtime(T);
         if (do_mutex) {
-            std::cout << "Mutex check: ON\n";
+            note_out(p) << "Mutex check: ON\n";
         } else {
-            std::cout << "Mutex check: OFF\n";
+            note_out(p) << "Mutex check: OFF\n";
         }
     }
 
@@ -478,7 +463,7 @@ Result bidir_astar(const Task& T, HeuristicFn h, bool h_is_integer, const Params
     const bool integer_mode = (all_action_costs_are_integers(T) && h_is_integer);
 
     if (likely(integer_mode)) {
-        std::cout << "Note: all action costs are integers; using integer bidirectional A* + BucketPQ.\n";
+        note_out(p) << "Note: all action costs are integers; using integer bidirectional A* + BucketPQ.\n";
 
         // クローズドリスト用のデータ構造
         struct MetaF { int g; int h; bool closed; };
@@ -492,10 +477,16 @@ Result bidir_astar(const Task& T, HeuristicFn h, bool h_is_integer, const Params
         TwoLevelBucketPQ open_fwd;
         TwoLevelBucketPQ open_bwd;
 
-        // 初期ノードのヒューリスティック
+        // 初期ノードのヒューリスティック (非同期に作ったヒューリスティックは、ここで完成を待つ)
+        resolve_async(h);
         const int h0 = rounding(h(T, s0));
         ++R.stats.evaluated;
         meta_fwd[0] = MetaF{0, h0, false};
+        if (h0 >= p.cost_bound) { // 初期状態の f-value が上界以上の場合は、探索せずに終了する
+            ++R.stats.pruned_by_bound;
+            R.bound_exhausted = true;
+            return R;
+        }
         open_fwd.insert(0, pack_fh_asc(h0, h0)); // f = g + h = h0, h = h0
 
         // 後ろ向き側は UCS（h=0）で管理する
@@ -510,9 +501,8 @@ Result bidir_astar(const Task& T, HeuristicFn h, bool h_is_integer, const Params
         bool expand_forward_turn = true; // forward/backward どちらの方向を展開するのか表すフラグ
 
         while (!open_fwd.empty() || !open_bwd.empty()) {
-            if (unlikely(planner::sas::time_exceeded_cpu())) {
-                std::cerr << "error: CPU time limit exceeded (" << planner::sas::g_cpu_limit_sec << " sec)\n";
-                std::exit(101);
+            if (unlikely(search_interrupted(p, R))) {
+                return R;
             }
 
             if (unlikely(R.stats.expanded > p.max_expansions)) {
@@ -547,7 +537,7 @@ Result bidir_astar(const Task& T, HeuristicFn h, bool h_is_integer, const Params
 
                     // forward search でゴールにたどり着いてしまった場合
                     if (is_goal(T, su)) {
-                        std::cout << "reach a goal state in forward search" << "\n"; // デバッグ用
+                        note_out(p) << "reach a goal state in forward search" << "\n"; // デバッグ用
                         R.solved = true;
                         R.plan = extract_plan_forward(R.nodes, u);
                         R.plan_cost = eval_plan_cost(T, R.plan);
@@ -561,7 +551,8 @@ Result bidir_astar(const Task& T, HeuristicFn h, bool h_is_integer, const Params
                     ++R.stats.expanded;
                     did_expand = true;
 
-                    // ノードの展開を行う
+                    // ノードの展開を行う (後続状態は一旦 batch_f に溜める)
+                    batch_f.clear();
                     for (int a=0; a < (int)T.ops.size(); ++a) {
                         const auto& op = T.ops[a];
 
@@ -588,22 +579,42 @@ Result bidir_astar(const Task& T, HeuristicFn h, bool h_is_integer, const Params
                         const int step_cost = rounding(op.cost);
                         const int tentative_g = meta_fwd[u].g + step_cost;
 
-                        auto it = index_fwd.find(work_f); // 展開後の state の ID の確認
+                        if (tentative_g >= p.cost_bound) { // g-value だけで上界に達している場合
+                            ++R.stats.pruned_by_bound;
+                            continue;
+                        }
+
+                        batch_f.push(work_f, a);
+                    }
+                    batch_f.hash_and_prefetch(index_fwd); // ハッシュ表のスロットを先読みしておく
+
+                    for (std::size_t i = 0; i < batch_f.size(); ++i) {
+                        const State& succ = batch_f.state(i);
+                        const int a = batch_f.op(i);
+                        const auto& op = T.ops[a];
+                        const int tentative_g = meta_fwd[u].g + rounding(op.cost);
+
+                        const int found = index_fwd.find(succ, batch_f.hash(i), state_of); // 展開後の state の ID の確認
                         int v; // state の新規 ID または既存 ID
 
-                        if (it == index_fwd.end()) { // 新規ノードの場合
+                        if (found == StateIndex::EMPTY) { // 新規ノードの場合
+                            const int hv = rounding(h(T, succ));
+                            ++R.stats.evaluated;
+
+                            if (tentative_g + hv >= p.cost_bound) { // g+h が上界以上の場合は、ノードを登録せずに捨てる
+                                ++R.stats.pruned_by_bound;
+                                continue;
+                            }
+
                             v = (int)R.nodes.size(); // ID の割り当て
 
-                            R.nodes.push_back(Node{work_f, u, a}); // ノードの登録を行う
-                            index_fwd.emplace(R.nodes[v].s, v); // ノードと ID のハッシュマップへの登録も行う
+                            R.nodes.push_back(Node{succ, u, a}); // ノードの登録を行う
+                            index_fwd.insert(batch_f.hash(i), v, state_of); // ノードと ID のハッシュ表への登録も行う
 
                             if ((int)meta_fwd.size() <= v) { // ID がクローズドリストのサイズよりも大きい場合
                                 meta_fwd.resize(v+1, MetaF{0,0,false});
                             }
 
-                            const int hv = rounding(h(T, R.nodes[v].s));
-                            ++R.stats.evaluated;
-
                             // クローズリストへの登録
                             meta_fwd[v].g = tentative_g;
                             meta_fwd[v].h = hv;
@@ -611,7 +622,7 @@ Result bidir_astar(const Task& T, HeuristicFn h, bool h_is_integer, const Params
 
                             open_fwd.insert(static_cast<BucketPQ::Value>(v), pack_fh_asc(tentative_g + hv, hv)); // オープンリストへの挿入
                         } else { // 新規ノードでない場合
-                            v = it->second; // 既存 ID の取り出し
+                            v = found; // 既存 ID の取り出し
 
                             if (tentative_g < meta_fwd[v].g) { // g-value が更新される場合
                                 meta_fwd[v].g = tentative_g;
@@ -622,6 +633,11 @@ Result bidir_astar(const Task& T, HeuristicFn h, bool h_is_integer, const Params
                                 ++R.stats.evaluated;
                                 meta_fwd[v].h = hv;
 
+                                if (tentative_g + hv >= p.cost_bound) { // 改善後も上界に達する場合は、オープンリストに戻さない
+                                    ++R.stats.pruned_by_bound;
+                                    continue;
+                                }
+
                                 const UKey new_key = pack_fh_asc(meta_fwd[v].g + meta_fwd[v].h, meta_fwd[v].h);
 
                                 if (likely(meta_fwd[v].closed)) { // クローズドリストに含まれる場合
@@ -694,7 +710,7 @@ Result bidir_astar(const Task& T, HeuristicFn h, bool h_is_integer, const Params
 
                 // regression search で初期状態にたどり着いてしまった場合
                 if (forward_state_satisfies_reg(s0, su)) {
-                    std::cout << "reach the initial state in regression search" << "\n"; // デバッグ用
+                    note_out(p) << "reach the initial state in regression search" << "\n"; // デバッグ用
                     R.solved = true;
                     
                     for (int id = u; id >= 0 && back_nodes[id].parent >=0; id = back_nodes[id].parent) {
@@ -726,6 +742,11 @@ Result bidir_astar(const Task& T, HeuristicFn h, bool h_is_integer, const Params
                     const int step_cost = rounding(op.cost);
                     const int tentative_g = meta_bwd[u].g + step_cost;
 
+                    if (tentative_g >= p.cost_bound) { // 後ろ向き側は h=0 なので g-value のみで上界と比較する
+                        ++R.stats.pruned_by_bound;
+                        continue;
+                    }
+
                     auto it = index_bwd.find(prev); // regresision 適用前の state をハッシュマップから探す
                     int v;
 
@@ -816,10 +837,17 @@ Result bidir_astar(const Task& T, HeuristicFn h, bool h_is_integer, const Params
 
             if (!did_expand) { // 展開が行えなかった場合
                 if (open_fwd.empty() && open_bwd.empty()) { // 両者のオープンリストがともに空の場合
+                    fwd_exhausted = true;
                     break;
                 }
             }
 
+            // 前向き側が上界未満の状態空間を網羅した場合、後ろ向き側を続けても新たなプランは見つからない
+            if (open_fwd.empty() && std::isfinite(p.cost_bound)) {
+                fwd_exhausted = true;
+                break;
+            }
+
             // 前後を交互に切り替える
             expand_forward_turn = !expand_forward_turn;
 
@@ -831,11 +859,11 @@ Result bidir_astar(const Task& T, HeuristicFn h, bool h_is_integer, const Params
         }
 
     } else { // コストに整数以外のものが含まれている場合 (未実装)
-        std::cerr << "error: action costs or heuristic are non-integer.\n";
-        std::exit(201);
+        throw std::domain_error("action costs or heuristic are non-integer");
     }
 
     if (!have_meeting) { // 両方向のオープンリストが空かつ meeting できない場合
+        R.bound_exhausted = fwd_exhausted && std::isfinite(p.cost_bound);
         R.solved = false;
         R.plan.clear();
         R.plan_cost = std::numeric_limits<double>::infinity(); // 負のコストにキャストまたはオーバーフローしてバグの元になるかも
@@ -853,8 +881,8 @@ Result bidir_astar(const Task& T, HeuristicFn h, bool h_is_integer, const Params
     }
 
     // デバッグ用
-    std::cout << "forward plan length: " << prefix.size() << "\n";
-    std::cout << "regression plan length: " << suffix.size() << "\n";
+    note_out(p) << "forward plan length: " << prefix.size() << "\n";
+    note_out(p) << "regression plan length: " << suffix.size() << "\n";
 
     R.reg_plan_len = suffix.size();
 
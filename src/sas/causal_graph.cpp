@@ -0,0 +1,209 @@
+#include "sas/causal_graph.hpp"
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+namespace planner { namespace sas {
+
+static void sort_unique(std::vector<int>& v) {
+    std::sort(v.begin(), v.end());
+    v.erase(std::unique(v.begin(), v.end()), v.end());
+}
+
+CausalGraph::CausalGraph(const Task& T) {
+    const std::size_t n = T.vars.size();
+    pre_to_eff.resize(n);
+    eff_to_eff.resize(n);
+    successors.resize(n);
+    predecessors.resize(n);
+
+    for (const auto& op : T.ops) {
+        for (const auto& [conds, var, pre, post] : op.pre_posts) {
+            (void)pre;
+            (void)post;
+            for (const auto& [u, val] : op.prevail) {
+                pre_to_eff[u].push_back(var);
+            }
+            for (const auto& [u, val] : conds) {
+                pre_to_eff[u].push_back(var);
+            }
+            for (const auto& other : op.pre_posts) {
+                const int u = std::get<1>(other);
+                if (std::get<2>(other) >= 0) {
+                    pre_to_eff[u].push_back(var);
+                }
+                if (u != var) {
+                    eff_to_eff[u].push_back(var);
+                }
+            }
+        }
+    }
+
+    for (std::size_t u = 0; u < n; ++u) {
+        // 自己ループは除く
+        pre_to_eff[u].erase(std::remove(pre_to_eff[u].begin(), pre_to_eff[u].end(), (int)u), pre_to_eff[u].end());
+        sort_unique(pre_to_eff[u]);
+        sort_unique(eff_to_eff[u]);
+
+        successors[u] = pre_to_eff[u];
+        successors[u].insert(successors[u].end(), eff_to_eff[u].begin(), eff_to_eff[u].end());
+        sort_unique(successors[u]);
+        for (int v : successors[u]) {
+            predecessors[v].push_back(static_cast<int>(u));
+        }
+    }
+}
+
+bool CausalGraph::is_acyclic() const {
+    const std::size_t n = successors.size();
+    std::vector<int> indeg(n, 0);
+    for (const auto& succ : successors) {
+        for (int v : succ) {
+            ++indeg[v];
+        }
+    }
+    std::vector<int> stack;
+    for (std::size_t v = 0; v < n; ++v) {
+        if (indeg[v] == 0) {
+            stack.push_back(static_cast<int>(v));
+        }
+    }
+    std::size_t removed = 0;
+    while (!stack.empty()) {
+        const int u = stack.back();
+        stack.pop_back();
+        ++removed;
+        for (int v : successors[u]) {
+            if (--indeg[v] == 0) {
+                stack.push_back(v);
+            }
+        }
+    }
+    return removed == n;
+}
+
+bool DomainTransitionGraph::unconditioned() const {
+    for (const auto& ts : out) {
+        for (const auto& t : ts) {
+            if (!t.conds.empty()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// 演算子 op の効果 e による遷移の条件を集める関数 (条件が矛盾する場合は false を返す)
+// 変数自身への条件 (prevail や効果の条件) は、遷移元の値の制約として own に返す
+static bool collect_conditions(const Operator& op, std::size_t e, std::vector<std::pair<int, int>>& conds, int& own) {
+    const auto& [econds, var, pre, post] = op.pre_posts[e];
+    (void)post;
+    conds.clear();
+    own = pre;
+
+    auto add = [&](int u, int val) {
+        if (u == var) {
+            if (own >= 0 && own != val) {
+                return false;
+            }
+            own = val;
+            return true;
+        }
+        conds.emplace_back(u, val);
+        return true;
+    };
+
+    for (const auto& [u, val] : op.prevail) {
+        if (!add(u, val)) {
+            return false;
+        }
+    }
+    for (const auto& [u, val] : econds) {
+        if (!add(u, val)) {
+            return false;
+        }
+    }
+    for (std::size_t k = 0; k < op.pre_posts.size(); ++k) {
+        const int u = std::get<1>(op.pre_posts[k]);
+        const int upre = std::get<2>(op.pre_posts[k]);
+        if (k != e && upre >= 0 && !add(u, upre)) {
+            return false;
+        }
+    }
+
+    std::sort(conds.begin(), conds.end());
+    conds.erase(std::unique(conds.begin(), conds.end()), conds.end());
+    for (std::size_t i = 1; i < conds.size(); ++i) {
+        if (conds[i].first == conds[i - 1].first) { // 同じ変数に異なる値を求める
+            return false;
+        }
+    }
+    return true;
+}
+
+// 条件を無視した全点対最短距離を求める関数
+static void compute_distances(DomainTransitionGraph& g) {
+    const int d = g.domain;
+    g.dist.assign(static_cast<std::size_t>(d) * d, DomainTransitionGraph::UNREACHABLE);
+
+    using Entry = std::pair<int, int>; // (距離, 値)
+    for (int src = 0; src < d; ++src) {
+        int* row = &g.dist[static_cast<std::size_t>(src) * d];
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> pq;
+        row[src] = 0;
+        pq.emplace(0, src);
+        while (!pq.empty()) {
+            const auto [du, u] = pq.top();
+            pq.pop();
+            if (du != row[u]) {
+                continue;
+            }
+            for (const auto& t : g.out[u]) {
+                const int nd = du + t.cost;
+                if (nd < row[t.to]) {
+                    row[t.to] = nd;
+                    pq.emplace(nd, t.to);
+                }
+            }
+        }
+    }
+}
+
+std::vector<DomainTransitionGraph> build_dtgs(const Task& T) {
+    std::vector<DomainTransitionGraph> dtgs(T.vars.size());
+    for (std::size_t v = 0; v < T.vars.size(); ++v) {
+        dtgs[v].var = static_cast<int>(v);
+        dtgs[v].domain = T.vars[v].domain;
+        dtgs[v].out.resize(T.vars[v].domain);
+    }
+
+    std::vector<std::pair<int, int>> conds;
+    for (int a = 0; a < (int)T.ops.size(); ++a) {
+        const auto& op = T.ops[a];
+        for (std::size_t e = 0; e < op.pre_posts.size(); ++e) {
+            const int var = std::get<1>(op.pre_posts[e]);
+            const int post = std::get<3>(op.pre_posts[e]);
+            int own = -1;
+            if (!collect_conditions(op, e, conds, own)) {
+                continue;
+            }
+
+            DomainTransitionGraph& g = dtgs[var];
+            const int lo = own >= 0 ? own : 0;
+            const int hi = own >= 0 ? own + 1 : g.domain;
+            for (int from = lo; from < hi; ++from) {
+                if (from == post) {
+                    continue;
+                }
+                g.out[from].push_back(DTGTransition{from, post, a, op.cost, conds});
+            }
+        }
+    }
+
+    for (auto& g : dtgs) {
+        compute_distances(g);
+    }
+    return dtgs;
+}
+
+}} // namespace planner::sas
@@ -0,0 +1,487 @@
+#include "sas/sas_heuristic.hpp"
+#include "sas/causal_graph.hpp"
+#include "sas/scratch_pool.hpp"
+#include "alloc_profile.hpp"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <queue>
+
+namespace planner { namespace sas {
+
+namespace { // 衝突を避けるために無名名前空間を使用する
+
+constexpr int INF_COST = std::numeric_limits<int>::max() / 4; // 到達不能 (足し合わせても溢れない大きさ)
+constexpr double PSEUDOINF = 1 << 16; // hff と同じく、ゴールに到達できない場合の値
+
+// 局所問題で用いる遷移 (条件は文脈変数の添字で持つ)
+struct LocalTransition {
+    int to;
+    int cost;
+    std::vector<std::pair<int, int>> conds; // (ctx_vars の添字, 値)
+};
+
+// 1 つの変数の DTG を、局所問題の形に直したもの
+// 最後の要素は仮想的なゴール変数 (0 -> 1 の遷移 1 本で、条件がゴール条件)
+struct LocalDTG {
+    int domain = 0;
+    std::vector<int> ctx_vars;                         // 遷移の条件に現れる変数
+    std::vector<std::vector<LocalTransition>> out;     // out[from]
+    const DomainTransitionGraph* full = nullptr;       // 条件を無視した最短距離 (ゴール変数では nullptr)
+    bool leaf = false;                                 // 条件を持たない (full->dist がそのままコストになる)
+
+    int leaf_cost(int from, int to) const {
+        const int d = full->distance(from, to);
+        return d == DomainTransitionGraph::UNREACHABLE ? INF_COST : d;
+    }
+};
+
+// DTG から局所問題を作る関数
+// keep(v, u) が false の条件は落とす (hcg では因果グラフを非巡回にするために、番号が v 以上の変数への条件を落とす)
+std::vector<LocalDTG> make_local_dtgs(const Task& T, const std::vector<DomainTransitionGraph>& dtgs,
+                                      const std::function<bool(int, int)>& keep) {
+    const int n = static_cast<int>(T.vars.size());
+    std::vector<LocalDTG> L(n + 1);
+
+    for (int v = 0; v < n; ++v) {
+        const DomainTransitionGraph& g = dtgs[v];
+        LocalDTG& l = L[v];
+        l.domain = g.domain;
+        l.full = &g;
+        l.out.resize(g.domain);
+
+        for (const auto& ts : g.out) {
+            for (const auto& t : ts) {
+                for (const auto& [u, val] : t.conds) {
+                    if (keep(v, u)) {
+                        l.ctx_vars.push_back(u);
+                    }
+                }
+            }
+        }
+        std::sort(l.ctx_vars.begin(), l.ctx_vars.end());
+        l.ctx_vars.erase(std::unique(l.ctx_vars.begin(), l.ctx_vars.end()), l.ctx_vars.end());
+        l.leaf = l.ctx_vars.empty();
+
+        auto ctx_index = [&](int u) {
+            return static_cast<int>(std::lower_bound(l.ctx_vars.begin(), l.ctx_vars.end(), u) - l.ctx_vars.begin());
+        };
+        for (const auto& ts : g.out) {
+            for (const auto& t : ts) {
+                LocalTransition lt{t.to, t.cost, {}};
+                for (const auto& [u, val] : t.conds) {
+                    if (keep(v, u)) {
+                        lt.conds.emplace_back(ctx_index(u), val);
+                    }
+                }
+                l.out[t.from].push_back(std::move(lt));
+            }
+        }
+    }
+
+    // ゴール変数
+    LocalDTG& goal = L[n];
+    goal.domain = 2;
+    goal.out.resize(2);
+    for (const auto& [v, val] : T.goal) {
+        goal.ctx_vars.push_back(v);
+    }
+    std::sort(goal.ctx_vars.begin(), goal.ctx_vars.end());
+    goal.ctx_vars.erase(std::unique(goal.ctx_vars.begin(), goal.ctx_vars.end()), goal.ctx_vars.end());
+    LocalTransition reach{1, 0, {}};
+    for (const auto& [v, val] : T.goal) {
+        reach.conds.emplace_back(
+            static_cast<int>(std::lower_bound(goal.ctx_vars.begin(), goal.ctx_vars.end(), v) - goal.ctx_vars.begin()), val);
+    }
+    goal.out[0].push_back(std::move(reach));
+    return L;
+}
+
+inline int add_cost(int a, int b) {
+    return (a >= INF_COST || b >= INF_COST) ? INF_COST : a + b;
+}
+
+// --- 因果グラフヒューリスティック (h_CG) ---
+// ゴールの各事実 v = g について、v の DTG 上で現在の値から g への最短経路のコストを足し合わせる
+// 遷移の条件 u = e のコストは、経路をたどる間に更新していく u の値 (文脈) から e へのコストとして再帰的に求める
+// 番号が v 以上の変数への条件は無視するので再帰は必ず止まる (SAS の変数の順は因果グラフの上流が先)
+struct CGData {
+    const Task* T;
+    std::vector<DomainTransitionGraph> dtgs;
+    std::vector<LocalDTG> L;
+    std::vector<int> row_offset;  // 変数 v、元の値 from のコストの行は cost[row_offset[v] + from * domain]
+    std::vector<int> fact_offset; // (v, from) の行の番号 = fact_offset[v] + from
+
+    explicit CGData(const Task& task) : T(&task), dtgs(build_dtgs(task)) {
+        L = make_local_dtgs(task, dtgs, [](int v, int u) { return u < v; });
+        const int n = static_cast<int>(task.vars.size());
+        row_offset.resize(n + 1);
+        fact_offset.resize(n + 1);
+        int rows = 0, cells = 0;
+        for (int v = 0; v < n; ++v) {
+            row_offset[v] = cells;
+            fact_offset[v] = rows;
+            cells += L[v].domain * L[v].domain;
+            rows += L[v].domain;
+        }
+        row_offset[n] = cells;
+        fact_offset[n] = rows;
+    }
+};
+
+struct CGScratch {
+    std::vector<int> cost;          // 1 回の評価の中で求めた (v, from) -> to のコスト
+    std::vector<uint32_t> row_mark; // 行が今回の評価で求めたものか (評価ごとの印と比べる)
+    uint32_t mark = 0;
+    std::vector<std::vector<int>> ctx; // 変数ごとの Dijkstra の文脈 (値 x 文脈変数)
+    std::vector<std::vector<int>> dist;
+    std::vector<std::vector<char>> done;
+
+    explicit CGScratch(const CGData& d)
+        : cost(d.row_offset.back()), row_mark(d.fact_offset.back(), 0),
+          ctx(d.L.size()), dist(d.L.size()), done(d.L.size()) {
+        for (std::size_t v = 0; v < d.L.size(); ++v) {
+            ctx[v].resize(static_cast<std::size_t>(d.L[v].domain) * d.L[v].ctx_vars.size());
+            dist[v].resize(d.L[v].domain);
+            done[v].resize(d.L[v].domain);
+        }
+    }
+};
+
+// 変数 v の値 from から to へのコスト
+int cg_cost(const CGData& D, CGScratch& S, const State& s, int v, int from, int to);
+
+// 変数 v の値 from からの Dijkstra を行い、全ての値へのコストを S.cost に書く関数
+void cg_fill_row(const CGData& D, CGScratch& S, const State& s, int v, int from) {
+    const LocalDTG& l = D.L[v];
+    const int d = l.domain;
+    const std::size_t k = l.ctx_vars.size();
+    std::vector<int>& dist = S.dist[v];
+    std::vector<char>& done = S.done[v];
+    std::vector<int>& ctx = S.ctx[v];
+    std::fill(dist.begin(), dist.end(), INF_COST);
+    std::fill(done.begin(), done.end(), 0);
+
+    dist[from] = 0;
+    for (std::size_t i = 0; i < k; ++i) {
+        ctx[from * k + i] = s[l.ctx_vars[i]];
+    }
+
+    // 値の数は小さいので、最小値の取り出しは線形探索で行う
+    for (;;) {
+        int u = -1;
+        for (int x = 0; x < d; ++x) {
+            if (!done[x] && dist[x] < INF_COST && (u < 0 || dist[x] < dist[u])) {
+                u = x;
+            }
+        }
+        if (u < 0) {
+            break;
+        }
+        done[u] = 1;
+
+        for (const auto& t : l.out[u]) {
+            if (done[t.to]) {
+                continue;
+            }
+            int c = add_cost(dist[u], t.cost);
+            for (const auto& [ci, val] : t.conds) {
+                c = add_cost(c, cg_cost(D, S, s, l.ctx_vars[ci], ctx[u * k + ci], val));
+                if (c >= INF_COST) {
+                    break;
+                }
+            }
+            if (c < dist[t.to]) {
+                dist[t.to] = c;
+                std::copy(ctx.begin() + u * k, ctx.begin() + (u + 1) * k, ctx.begin() + t.to * k);
+                for (const auto& [ci, val] : t.conds) {
+                    ctx[t.to * k + ci] = val;
+                }
+            }
+        }
+    }
+
+    std::copy(dist.begin(), dist.end(), S.cost.begin() + D.row_offset[v] + from * d);
+    S.row_mark[D.fact_offset[v] + from] = S.mark;
+}
+
+int cg_cost(const CGData& D, CGScratch& S, const State& s, int v, int from, int to) {
+    if (from == to) {
+        return 0;
+    }
+    const LocalDTG& l = D.L[v];
+    if (l.leaf) { // 条件を持たない変数は、構築時に求めた最短距離をそのまま使う
+        return l.leaf_cost(from, to);
+    }
+    if (S.row_mark[D.fact_offset[v] + from] != S.mark) {
+        cg_fill_row(D, S, s, v, from);
+    }
+    return S.cost[D.row_offset[v] + from * l.domain + to];
+}
+
+double cg_compute(const CGData& D, CGScratch& S, const State& s) {
+    if (++S.mark == 0) { // 印が一周した場合は、表を消してから使い直す
+        std::fill(S.row_mark.begin(), S.row_mark.end(), 0);
+        S.mark = 1;
+    }
+    int h = 0;
+    for (const auto& [v, val] : D.T->goal) {
+        h = add_cost(h, cg_cost(D, S, s, v, s[v], val));
+        if (h >= INF_COST) {
+            return PSEUDOINF;
+        }
+    }
+    return static_cast<double>(h);
+}
+
+// --- context-enhanced additive ヒューリスティック (h_cea) ---
+// (変数 v, 開始値 d) ごとの局所問題を、1 つの優先度付きキューで必要になった分だけまとめて解く
+// 遷移の条件 u = e のコストは、遷移元のノードの文脈における u の値 e' を開始値とする局所問題の、e のノードのコスト
+// 局所問題の文脈は評価する状態の値から始まり、遷移のたびにその条件の値で上書きする
+// 条件を持たない変数の局所問題は解かずに、構築時に求めた DTG の最短距離を用いる
+struct CEAData {
+    const Task* T;
+    std::vector<DomainTransitionGraph> dtgs;
+    std::vector<LocalDTG> L;
+    std::vector<int> fact_offset; // 局所問題 (v, from) の番号 = fact_offset[v] + from (ゴール変数は最後)
+
+    explicit CEAData(const Task& task) : T(&task), dtgs(build_dtgs(task)) {
+        L = make_local_dtgs(task, dtgs, [](int, int) { return true; });
+        fact_offset.resize(L.size() + 1);
+        int rows = 0;
+        for (std::size_t v = 0; v < L.size(); ++v) {
+            fact_offset[v] = rows;
+            rows += L[v].domain;
+        }
+        fact_offset[L.size()] = rows;
+    }
+};
+
+struct CEAScratch {
+    struct Problem {
+        int var;
+        int base;     // この局所問題を必要とした時点の優先度
+        int node_off; // ノード (値) の先頭
+        int ctx_off;  // 文脈の先頭
+    };
+    // 展開したノードから出る遷移 (全ての条件のコストが分かった時点で遷移先を更新する)
+    struct PendingTransition {
+        int src;
+        const LocalTransition* t;
+        int remaining;
+        int cost;
+    };
+    struct Wait {
+        int pending;
+        int next;
+    };
+
+    std::vector<int> problem_of;    // (v, from) -> 局所問題の番号
+    std::vector<uint32_t> problem_mark;
+    uint32_t mark = 0;
+
+    std::vector<Problem> problems;
+    std::vector<int> node_cost;
+    std::vector<char> node_expanded;
+    std::vector<int> node_problem;
+    std::vector<int> wait_head;
+    std::vector<int> ctx;
+    std::vector<PendingTransition> pending;
+    std::vector<Wait> waits;
+    using Entry = std::pair<int, int>; // (優先度, ノード)
+    std::vector<Entry> heap;
+
+    explicit CEAScratch(const CEAData& d)
+        : problem_of(d.fact_offset.back(), -1), problem_mark(d.fact_offset.back(), 0) {}
+
+    void reset() {
+        if (++mark == 0) {
+            std::fill(problem_mark.begin(), problem_mark.end(), 0);
+            mark = 1;
+        }
+        problems.clear();
+        node_cost.clear();
+        node_expanded.clear();
+        node_problem.clear();
+        wait_head.clear();
+        ctx.clear();
+        pending.clear();
+        waits.clear();
+        heap.clear();
+    }
+
+    void push(int prio, int node) {
+        heap.emplace_back(prio, node);
+        std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+    }
+};
+
+class CEAEvaluator {
+public:
+    CEAEvaluator(const CEAData& D, CEAScratch& S, const State& s) : D_(D), S_(S), s_(s) {}
+
+    double run() {
+        S_.reset();
+        const int goal_var = static_cast<int>(D_.L.size()) - 1;
+        const int gp = problem(goal_var, 0, 0);
+        const int goal_node = S_.problems[gp].node_off + 1;
+
+        while (!S_.heap.empty()) {
+            std::pop_heap(S_.heap.begin(), S_.heap.end(), std::greater<CEAScratch::Entry>());
+            const auto [prio, node] = S_.heap.back();
+            S_.heap.pop_back();
+            if (S_.node_expanded[node] || prio != S_.problems[S_.node_problem[node]].base + S_.node_cost[node]) {
+                continue; // 古いエントリ
+            }
+            if (node == goal_node) {
+                return static_cast<double>(S_.node_cost[node]);
+            }
+            expand(node);
+        }
+        return PSEUDOINF;
+    }
+
+private:
+    // 局所問題 (v, from) の番号を返す関数 (まだ無ければ作り、開始ノードをキューに入れる)
+    int problem(int v, int from, int base) {
+        const int key = D_.fact_offset[v] + from;
+        if (S_.problem_mark[key] == S_.mark) {
+            return S_.problem_of[key];
+        }
+        const LocalDTG& l = D_.L[v];
+        const int p = static_cast<int>(S_.problems.size());
+        const int node_off = static_cast<int>(S_.node_cost.size());
+        const int ctx_off = static_cast<int>(S_.ctx.size());
+        const std::size_t k = l.ctx_vars.size();
+        S_.problems.push_back(CEAScratch::Problem{v, base, node_off, ctx_off});
+        S_.node_cost.resize(node_off + l.domain, INF_COST);
+        S_.node_expanded.resize(node_off + l.domain, 0);
+        S_.node_problem.resize(node_off + l.domain, p);
+        S_.wait_head.resize(node_off + l.domain, -1);
+        S_.ctx.resize(ctx_off + l.domain * k, -1);
+
+        S_.node_cost[node_off + from] = 0;
+        for (std::size_t i = 0; i < k; ++i) {
+            S_.ctx[ctx_off + from * k + i] = s_[l.ctx_vars[i]];
+        }
+        S_.push(base, node_off + from);
+
+        S_.problem_mark[key] = S_.mark;
+        S_.problem_of[key] = p;
+        return p;
+    }
+
+    void expand(int node) {
+        S_.node_expanded[node] = 1;
+        const int cost = S_.node_cost[node];
+
+        // このノードを条件として待っていた遷移
+        for (int w = S_.wait_head[node]; w >= 0; w = S_.waits[w].next) {
+            auto& pt = S_.pending[S_.waits[w].pending];
+            pt.cost = add_cost(pt.cost, cost);
+            if (--pt.remaining == 0) {
+                fire(S_.waits[w].pending);
+            }
+        }
+
+        const auto P = S_.problems[S_.node_problem[node]];
+        const LocalDTG& l = D_.L[P.var];
+        const int val = node - P.node_off;
+        const std::size_t k = l.ctx_vars.size();
+        const int prio = P.base + cost;
+
+        for (const auto& t : l.out[val]) {
+            const int pi = static_cast<int>(S_.pending.size());
+            S_.pending.push_back(CEAScratch::PendingTransition{node, &t, 0, add_cost(cost, t.cost)});
+            bool dead = false;
+            for (const auto& [ci, e] : t.conds) {
+                const int u = l.ctx_vars[ci];
+                const int cur = S_.ctx[P.ctx_off + val * k + ci];
+                if (cur == e) {
+                    continue;
+                }
+                const LocalDTG& lu = D_.L[u];
+                if (lu.leaf) {
+                    const int c = lu.leaf_cost(cur, e);
+                    if (c >= INF_COST) {
+                        dead = true;
+                        break;
+                    }
+                    S_.pending[pi].cost = add_cost(S_.pending[pi].cost, c);
+                    continue;
+                }
+                const int q = problem(u, cur, prio);
+                const int target = S_.problems[q].node_off + e;
+                if (S_.node_expanded[target]) {
+                    S_.pending[pi].cost = add_cost(S_.pending[pi].cost, S_.node_cost[target]);
+                } else {
+                    S_.waits.push_back(CEAScratch::Wait{pi, S_.wait_head[target]});
+                    S_.wait_head[target] = static_cast<int>(S_.waits.size()) - 1;
+                    ++S_.pending[pi].remaining;
+                }
+            }
+            if (dead) {
+                S_.pending[pi].remaining = -1; // 待っているノードが展開されても発火しない
+                continue;
+            }
+            if (S_.pending[pi].remaining == 0) {
+                fire(pi);
+            }
+        }
+    }
+
+    // 全ての条件のコストが分かった遷移で、遷移先のノードのコストと文脈を更新する関数
+    void fire(int pi) {
+        const auto& pt = S_.pending[pi];
+        const auto P = S_.problems[S_.node_problem[pt.src]];
+        const LocalDTG& l = D_.L[P.var];
+        const std::size_t k = l.ctx_vars.size();
+        const int target = P.node_off + pt.t->to;
+        if (S_.node_expanded[target] || pt.cost >= S_.node_cost[target]) {
+            return;
+        }
+        S_.node_cost[target] = pt.cost;
+
+        const int src_val = pt.src - P.node_off;
+        int* dst = &S_.ctx[P.ctx_off + pt.t->to * k];
+        const int* src = &S_.ctx[P.ctx_off + src_val * k];
+        std::copy(src, src + k, dst);
+        for (const auto& [ci, e] : pt.t->conds) {
+            dst[ci] = e;
+        }
+        S_.push(P.base + pt.cost, target);
+    }
+
+    const CEAData& D_;
+    CEAScratch& S_;
+    const State& s_;
+};
+
+} // anonymous namespace
+
+HeuristicFn hcg(const Task& T) {
+    PLANNER_ALLOC_PHASE(HeuristicSetup);
+    auto data = std::make_shared<CGData>(T);
+    auto pool = std::make_shared<ScratchPool<CGScratch, CGData>>(*data);
+
+    return [data, pool](const Task& /*unused*/, const State& s) -> double {
+        PLANNER_ALLOC_PHASE(Evaluation);
+        auto lease = pool->acquire();
+        return cg_compute(*data, *lease, s);
+    };
+}
+
+HeuristicFn hcea(const Task& T) {
+    PLANNER_ALLOC_PHASE(HeuristicSetup);
+    auto data = std::make_shared<CEAData>(T);
+    auto pool = std::make_shared<ScratchPool<CEAScratch, CEAData>>(*data);
+
+    return [data, pool](const Task& /*unused*/, const State& s) -> double {
+        PLANNER_ALLOC_PHASE(Evaluation);
+        auto lease = pool->acquire();
+        return CEAEvaluator(*data, *lease, s).run();
+    };
+}
+
+}} // namespace planner::sas
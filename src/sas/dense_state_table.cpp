@@ -0,0 +1,50 @@
+#include "sas/dense_state_table.hpp"
+#include <algorithm>
+#include <new>
+
+namespace planner { namespace sas {
+
+StateRanker::StateRanker(const Task& T, uint64_t max_states) {
+    const std::size_t nvars = T.vars.size();
+    dom_.resize(nvars);
+    mult_.resize(nvars);
+
+    const uint64_t limit = std::min<uint64_t>(max_states, DenseStateTable::MAX_STATES);
+    uint64_t prod = 1;
+    fits_ = (limit > 0);
+
+    for (std::size_t v = 0; v < nvars; ++v) {
+        const uint64_t d = static_cast<uint64_t>(std::max(1, T.vars[v].domain));
+        dom_[v] = d;
+        mult_[v] = prod;
+
+        if (!fits_) { // すでに上限を超えている場合は、桁の重みを計算しない
+            continue;
+        }
+        if (prod > limit / d) { // オーバーフローする前に上限との比較を行う
+            fits_ = false;
+            continue;
+        }
+        prod *= d;
+    }
+
+    num_states_ = fits_ ? prod : 0;
+}
+
+DenseStateTable::DenseStateTable(uint64_t num_states) : n_(num_states) {
+    if (n_ > MAX_STATES) {
+        throw std::bad_alloc();
+    }
+    data_ = static_cast<DenseMeta*>(arena_.ensure(static_cast<std::size_t>(n_) * sizeof(DenseMeta)));
+}
+
+std::vector<uint32_t> extract_plan_dense(const DenseStateTable& table, uint64_t goal_rank) {
+    std::vector<uint32_t> acts;
+    for (uint64_t r = goal_rank; table[r].parent != DenseMeta::NO_PARENT; r = table[r].parent) {
+        acts.push_back(table[r].op());
+    }
+    std::reverse(acts.begin(), acts.end());
+    return acts;
+}
+
+}} // namespace planner::sas
@@ -0,0 +1,1037 @@
+#include "sas/distributed_hda.hpp"
+#include "sas/search_utils.hpp"
+#include "sas/state_index.hpp"
+#include "alloc_profile.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace planner { namespace sas {
+
+namespace {
+
+constexpr int NO_BOUND = std::numeric_limits<int>::max();
+
+// メッセージの種類 (フレームは [種類 1 byte][長さ 4 byte][本体])
+enum MsgType : uint8_t {
+    MSG_STATES = 1, // 後続状態のバッチ
+    MSG_INCUMBENT,  // 暫定解のコスト
+    MSG_TOKEN,      // 終了判定のトークン
+    MSG_FINISH,     // 探索の終了 (各プロセスは MSG_RESULT を返す)
+    MSG_RESULT,     // 各プロセスの最良のゴールと統計
+    MSG_TRACE,      // プランの復元 (親のノードを持つプロセスへ順に回す)
+    MSG_PLAN,       // 復元したプラン
+    MSG_SHUTDOWN,   // 全ての処理の終了
+    MSG_ABORT,      // 打ち切り
+};
+
+void put_varint(std::vector<uint8_t>& b, uint64_t x) {
+    while (x >= 0x80) {
+        b.push_back(static_cast<uint8_t>(x) | 0x80);
+        x >>= 7;
+    }
+    b.push_back(static_cast<uint8_t>(x));
+}
+
+// メッセージ本体の読み出し
+struct Reader {
+    const uint8_t* p = nullptr;
+    const uint8_t* end = nullptr;
+
+    uint64_t varint() {
+        uint64_t x = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p == end) {
+                break;
+            }
+            const uint8_t b = *p++;
+            x |= static_cast<uint64_t>(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                return x;
+            }
+        }
+        throw std::runtime_error("hda: malformed message");
+    }
+
+    const uint8_t* bytes(std::size_t n) {
+        if (static_cast<std::size_t>(end - p) < n) {
+            throw std::runtime_error("hda: truncated message");
+        }
+        const uint8_t* q = p;
+        p += n;
+        return q;
+    }
+};
+
+// 状態を、各変数をドメインの大きさに合わせた bit 数に詰める
+class StatePacker {
+public:
+    explicit StatePacker(const Task& T) {
+        std::size_t total = 0;
+        for (const auto& v : T.vars) {
+            int b = 0;
+            while ((1 << b) < v.domain) {
+                ++b;
+            }
+            bits_.push_back(b);
+            total += b;
+        }
+        bytes_ = (total + 7) / 8;
+    }
+
+    std::size_t bytes() const { return bytes_; }
+
+    void pack(const State& s, std::vector<uint8_t>& out) const {
+        uint64_t acc = 0;
+        int nb = 0;
+        for (std::size_t v = 0; v < s.size(); ++v) {
+            acc |= static_cast<uint64_t>(s[v]) << nb;
+            nb += bits_[v];
+            while (nb >= 8) {
+                out.push_back(static_cast<uint8_t>(acc));
+                acc >>= 8;
+                nb -= 8;
+            }
+        }
+        if (nb > 0) {
+            out.push_back(static_cast<uint8_t>(acc));
+        }
+    }
+
+    void unpack(const uint8_t* in, State& s) const {
+        uint64_t acc = 0;
+        int nb = 0;
+        for (std::size_t v = 0; v < s.size(); ++v) {
+            while (nb < bits_[v]) {
+                acc |= static_cast<uint64_t>(*in++) << nb;
+                nb += 8;
+            }
+            s[v] = static_cast<int>(acc & ((uint64_t(1) << bits_[v]) - 1));
+            acc >>= bits_[v];
+            nb -= bits_[v];
+        }
+    }
+
+private:
+    std::vector<int> bits_;
+    std::size_t bytes_ = 0;
+};
+
+// 1 つの相手とのソケット (非ブロッキングで、送受信のバッファを持つ)
+struct Channel {
+    int fd = -1;
+    std::vector<uint8_t> in;
+    std::size_t in_pos = 0;
+    std::vector<uint8_t> out;
+    std::size_t out_pos = 0;
+    bool closed = false;
+
+    void frame(uint8_t type, const std::vector<uint8_t>& body) {
+        const uint32_t n = static_cast<uint32_t>(body.size());
+        out.push_back(type);
+        for (int k = 0; k < 4; ++k) {
+            out.push_back(static_cast<uint8_t>(n >> (8 * k)));
+        }
+        out.insert(out.end(), body.begin(), body.end());
+    }
+
+    bool pending() const { return out_pos < out.size(); }
+
+    // 書けるだけ書く関数 (相手が閉じていた場合は false を返す)
+    bool flush() {
+        while (out_pos < out.size()) {
+            const ssize_t k = ::send(fd, out.data() + out_pos, out.size() - out_pos, MSG_NOSIGNAL);
+            if (k > 0) {
+                out_pos += static_cast<std::size_t>(k);
+            } else if (k < 0 && errno == EINTR) {
+                continue;
+            } else if (k < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else {
+                closed = true;
+                return false;
+            }
+        }
+        if (out_pos == out.size()) {
+            out.clear();
+            out_pos = 0;
+        }
+        return true;
+    }
+
+    // 読めるだけ読む関数 (相手が閉じていた場合は false を返す)
+    bool fill() {
+        if (in_pos > 0) {
+            in.erase(in.begin(), in.begin() + static_cast<std::ptrdiff_t>(in_pos));
+            in_pos = 0;
+        }
+        uint8_t buf[1 << 16];
+        for (;;) {
+            const ssize_t k = ::recv(fd, buf, sizeof(buf), 0);
+            if (k > 0) {
+                in.insert(in.end(), buf, buf + k);
+            } else if (k < 0 && errno == EINTR) {
+                continue;
+            } else if (k < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                return true;
+            } else {
+                closed = true;
+                return false;
+            }
+        }
+    }
+
+    // 受信済みの完全なフレームを 1 つ取り出す関数
+    bool next(uint8_t& type, Reader& r) {
+        if (in.size() - in_pos < 5) {
+            return false;
+        }
+        uint32_t n = 0;
+        for (int k = 0; k < 4; ++k) {
+            n |= static_cast<uint32_t>(in[in_pos + 1 + k]) << (8 * k);
+        }
+        if (in.size() - in_pos - 5 < n) {
+            return false;
+        }
+        type = in[in_pos];
+        r = Reader{in.data() + in_pos + 5, in.data() + in_pos + 5 + n};
+        in_pos += 5 + n;
+        return true;
+    }
+};
+
+void set_nonblocking(int fd) {
+    const int fl = ::fcntl(fd, F_GETFL, 0);
+    ::fcntl(fd, F_SETFL, fl | O_NONBLOCK);
+}
+
+// 状態を担当するプロセスの番号 (ハッシュ表のスロットの位置と相関しないように、もう一度混ぜてから使う)
+int owner_of(uint64_t h, int n) {
+    h ^= h >> 29;
+    h *= 0xbf58476d1ce4e5b9ull;
+    return static_cast<int>((h >> 32) % static_cast<uint64_t>(n));
+}
+
+// --- 1 つのプロセスの探索 ---
+class HdaWorker {
+public:
+    HdaWorker(const Task& T, HeuristicFn& h, const HdaParams& hp, const Params& p, int rank, const std::vector<int>& fds)
+        : T_(T), h_(h), hp_(hp), p_(p), rank_(rank), n_(static_cast<int>(fds.size())), ch_(fds.size()),
+          packer_(T), batch_(fds.size()), batch_count_(fds.size(), 0) {
+        for (int r = 0; r < n_; ++r) {
+            ch_[r].fd = fds[r];
+            if (fds[r] >= 0) {
+                set_nonblocking(fds[r]);
+            }
+        }
+        if (std::isfinite(p.cost_bound)) { // f (整数) >= cost_bound のノードは、f >= ceil(cost_bound) のノードと同じ
+            bound_ = static_cast<int>(std::min<double>(NO_BOUND, std::ceil(p.cost_bound)));
+        }
+        check_mutex_ = should_check_mutex_runtime(T);
+    }
+
+    // 探索を行う関数 (プロセス 0 の場合は out に結果を書く)
+    void run(HdaResult* out) {
+        State s0(T_.init.begin(), T_.init.end());
+        if (owner_of(StateIndex::hash(s0), n_) == rank_) {
+            receive_state(s0, 0, -1, -1, -1);
+        }
+
+        Result R; // プロセス 0 の打ち切り判定用
+        while (!done_) {
+            const bool busy = phase_ == Phase::Search && has_work();
+            if (!pump(busy ? 0 : 5)) {
+                break; // 相手が終了した
+            }
+            if (done_) {
+                break;
+            }
+            if (phase_ != Phase::Search) {
+                continue;
+            }
+
+            if (rank_ == 0) {
+                R.stats = st_;
+                if (search_interrupted(p_, R)) {
+                    stop_ = R.stop;
+                    abort_all();
+                    break;
+                }
+            }
+
+            if (has_work()) {
+                for (int k = 0; k < hp_.expansions_per_poll && has_work(); ++k) {
+                    expand(pop());
+                }
+                if (st_.expanded > p_.max_expansions) {
+                    abort_all();
+                    break;
+                }
+            } else {
+                flush_batches();
+                passive_step();
+            }
+        }
+        flush_all_blocking();
+
+        if (out != nullptr) {
+            fill_result(*out);
+        }
+    }
+
+private:
+    enum class Phase { Search, Finishing };
+
+    struct Meta {
+        int g;
+        int h;
+        bool closed;
+        int prank; // 親のノードを持つプロセス (根は -1)
+        int pid;   // 親のノードの、そのプロセスでの ID
+        int op;
+    };
+
+    using Entry = std::tuple<int, int, int, int>; // (f, h, g, ID)
+
+    // --- ノードの管理 ---
+
+    // 状態 s を g 値 g で受け取る関数 (この プロセスが担当する状態のみ)
+    void receive_state(const State& s, int g, int prank, int pid, int op) {
+        auto state_of = [this](int id) -> const State& { return states_[id]; };
+        const uint64_t hs = StateIndex::hash(s);
+        int v = index_.find(s, hs, state_of);
+        if (v == StateIndex::EMPTY) {
+            const int hv = rounding(h_(T_, s));
+            ++st_.evaluated;
+            if (static_cast<long long>(g) + hv >= bound_) {
+                ++st_.pruned_by_bound;
+                return;
+            }
+            v = static_cast<int>(states_.size());
+            states_.push_back(s);
+            meta_.push_back(Meta{g, hv, false, prank, pid, op});
+            index_.insert(hs, v, state_of);
+        } else {
+            Meta& m = meta_[v];
+            if (g >= m.g) {
+                ++st_.duplicates;
+                return;
+            }
+            if (static_cast<long long>(g) + m.h >= bound_) {
+                ++st_.pruned_by_bound;
+                return;
+            }
+            // HDA* では、g 値の大きい順に届くことがあるので、閉じたノードも開き直す
+            m = Meta{g, m.h, false, prank, pid, op};
+        }
+        open_.emplace(g + meta_[v].h, meta_[v].h, g, v);
+    }
+
+    // 古いエントリと、f が暫定解のコスト以上のエントリを捨てて、展開できるノードがあるか返す関数
+    bool has_work() {
+        while (!open_.empty()) {
+            const auto& [f, hv, g, id] = open_.top();
+            (void)hv;
+            if (meta_[id].closed || g != meta_[id].g || f >= bound_) {
+                open_.pop();
+                continue;
+            }
+            return true;
+        }
+        return false;
+    }
+
+    int pop() {
+        const int id = std::get<3>(open_.top());
+        open_.pop();
+        return id;
+    }
+
+    void expand(int u) {
+        meta_[u].closed = true;
+        ++st_.expanded;
+        const State su = states_[u];
+        const int gu = meta_[u].g;
+
+        if (is_goal(T_, su)) {
+            if (gu < bound_) {
+                bound_ = gu;
+                best_goal_ = u;
+                std::vector<uint8_t> body;
+                put_varint(body, static_cast<uint64_t>(gu));
+                broadcast(MSG_INCUMBENT, body);
+            }
+            return;
+        }
+
+        State work;
+        Undo undo;
+        for (int a = 0; a < (int)T_.ops.size(); ++a) {
+            const auto& op = T_.ops[a];
+            if (!is_applicable(T_, su, op)) {
+                continue;
+            }
+            work = su;
+            undo.clear();
+            apply_inplace(T_, op, work, undo);
+            ++st_.generated;
+
+            // 生成状態が mutex 違反なら捨てる
+            if (check_mutex_ && violates_mutex(T_, work)) {
+                continue;
+            }
+            const int g = gu + op.cost;
+            if (g >= bound_) { // g-value だけで上界に達している場合
+                ++st_.pruned_by_bound;
+                continue;
+            }
+
+            const int dest = owner_of(StateIndex::hash(work), n_);
+            if (dest == rank_) {
+                receive_state(work, g, rank_, u, a);
+                continue;
+            }
+            auto& b = batch_[dest];
+            packer_.pack(work, b);
+            put_varint(b, static_cast<uint64_t>(g));
+            put_varint(b, static_cast<uint64_t>(u));
+            put_varint(b, static_cast<uint64_t>(a));
+            ++batch_count_[dest];
+            if (b.size() >= hp_.batch_bytes) {
+                flush_batch(dest);
+            }
+        }
+    }
+
+    // --- 送受信 ---
+
+    void send(int dest, uint8_t type, const std::vector<uint8_t>& body) {
+        ch_[dest].frame(type, body);
+        bytes_ += body.size() + 5;
+    }
+
+    void broadcast(uint8_t type, const std::vector<uint8_t>& body) {
+        for (int r = 0; r < n_; ++r) {
+            if (r != rank_) {
+                send(r, type, body);
+            }
+        }
+    }
+
+    // 宛先 dest の後続状態のバッチを送る関数 (終了判定では、バッチ 1 つを 1 つのメッセージとして数える)
+    void flush_batch(int dest) {
+        if (batch_count_[dest] == 0) {
+            return;
+        }
+        std::vector<uint8_t> body;
+        body.reserve(batch_[dest].size() + 5);
+        put_varint(body, batch_count_[dest]);
+        body.insert(body.end(), batch_[dest].begin(), batch_[dest].end());
+        send(dest, MSG_STATES, body);
+        batch_[dest].clear();
+        batch_count_[dest] = 0;
+        ++sent_;
+        ++msgs_;
+    }
+
+    void flush_batches() {
+        for (int r = 0; r < n_; ++r) {
+            if (r != rank_) {
+                flush_batch(r);
+            }
+        }
+    }
+
+    // ソケットを確認し、書けるものは書き、届いたメッセージを処理する関数 (全ての相手が閉じた場合は false を返す)
+    bool pump(int timeout_ms) {
+        std::vector<pollfd> fds;
+        std::vector<int> who;
+        for (int r = 0; r < n_; ++r) {
+            if (r == rank_ || ch_[r].closed) {
+                continue;
+            }
+            pollfd pf{};
+            pf.fd = ch_[r].fd;
+            pf.events = POLLIN | (ch_[r].pending() ? POLLOUT : 0);
+            fds.push_back(pf);
+            who.push_back(r);
+        }
+        if (fds.empty()) {
+            return n_ == 1;
+        }
+        const int k = ::poll(fds.data(), fds.size(), timeout_ms);
+        if (k < 0 && errno != EINTR) {
+            throw std::runtime_error(std::string("hda: poll failed: ") + std::strerror(errno));
+        }
+        for (std::size_t i = 0; i < fds.size() && k > 0; ++i) {
+            Channel& c = ch_[who[i]];
+            if (fds[i].revents & POLLOUT) {
+                c.flush();
+            }
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                c.fill();
+                uint8_t type = 0;
+                Reader rd;
+                while (c.next(type, rd)) {
+                    dispatch(who[i], type, rd);
+                }
+                if (c.closed && !done_) {
+                    return false; // 終了前に相手が落ちた
+                }
+            }
+        }
+        for (int r = 0; r < n_; ++r) { // 処理の中で積んだメッセージ
+            if (r != rank_ && ch_[r].pending() && !ch_[r].closed) {
+                ch_[r].flush();
+            }
+        }
+        return true;
+    }
+
+    // 終了前に、積んであるメッセージを全て送る関数
+    void flush_all_blocking() {
+        for (int r = 0; r < n_; ++r) {
+            while (r != rank_ && !ch_[r].closed && ch_[r].pending()) {
+                pollfd pf{ch_[r].fd, POLLOUT, 0};
+                if (::poll(&pf, 1, 1000) <= 0 || !ch_[r].flush()) {
+                    break;
+                }
+            }
+        }
+    }
+
+    void dispatch(int from, uint8_t type, Reader& rd) {
+        switch (type) {
+        case MSG_STATES: {
+            const uint64_t count = rd.varint();
+            State s(T_.vars.size());
+            for (uint64_t i = 0; i < count; ++i) {
+                packer_.unpack(rd.bytes(packer_.bytes()), s);
+                const int g = static_cast<int>(rd.varint());
+                const int pid = static_cast<int>(rd.varint());
+                const int op = static_cast<int>(rd.varint());
+                if (g < bound_) {
+                    receive_state(s, g, from, pid, op);
+                } else {
+                    ++st_.pruned_by_bound;
+                }
+            }
+            --sent_;       // 受け取ったメッセージは送った数から引く
+            black_ = true; // トークンが通った後に受け取った
+            break;
+        }
+        case MSG_INCUMBENT:
+            bound_ = std::min<int>(bound_, static_cast<int>(rd.varint()));
+            break;
+        case MSG_TOKEN: {
+            const uint64_t z = rd.varint();
+            tok_q_ = static_cast<int64_t>(z >> 1) ^ -static_cast<int64_t>(z & 1);
+            tok_black_ = rd.varint() != 0;
+            has_token_ = true;
+            break;
+        }
+        case MSG_FINISH: {
+            phase_ = Phase::Finishing;
+            send(0, MSG_RESULT, encode_result());
+            break;
+        }
+        case MSG_RESULT:
+            decode_result(from, rd);
+            if (++results_ == n_ - 1) {
+                start_trace();
+            }
+            break;
+        case MSG_TRACE: {
+            const int id = static_cast<int>(rd.varint());
+            std::vector<uint32_t> ops(rd.varint());
+            for (auto& a : ops) {
+                a = static_cast<uint32_t>(rd.varint());
+            }
+            trace(id, std::move(ops));
+            break;
+        }
+        case MSG_PLAN: {
+            std::vector<uint32_t> ops(rd.varint());
+            for (auto& a : ops) {
+                a = static_cast<uint32_t>(rd.varint());
+            }
+            finish_with_plan(std::move(ops));
+            break;
+        }
+        case MSG_SHUTDOWN:
+            done_ = true;
+            break;
+        case MSG_ABORT:
+            if (rank_ == 0) {
+                abort_all();
+            }
+            done_ = true;
+            break;
+        default:
+            throw std::runtime_error("hda: unknown message type");
+        }
+    }
+
+    // --- 終了判定 (Safra のトークンリング: プロセス 0 -> 1 -> ... -> n-1 -> 0) ---
+    // 各プロセスは送ったバッチの数 - 受け取ったバッチの数 (sent_) を持ち、トークンはその和を集める
+    // 1 周したトークンの和が 0 で、途中のどのプロセスもトークンが通った後にバッチを受け取っていなければ、どこにもバッチが残っていない
+    void passive_step() {
+        if (n_ == 1) {
+            begin_finish();
+            return;
+        }
+        if (rank_ != 0) {
+            if (has_token_) {
+                send_token((rank_ + 1) % n_, tok_q_ + sent_, tok_black_ || black_);
+                black_ = false;
+                has_token_ = false;
+            }
+            return;
+        }
+        if (has_token_) { // トークンが戻ってきた
+            has_token_ = false;
+            wave_ = false;
+            if (!tok_black_ && !black_ && tok_q_ + sent_ == 0) {
+                begin_finish();
+                return;
+            }
+        }
+        if (!wave_) {
+            black_ = false;
+            send_token(1, 0, false);
+            wave_ = true;
+        }
+    }
+
+    void send_token(int dest, int64_t q, bool black) {
+        std::vector<uint8_t> body;
+        put_varint(body, (static_cast<uint64_t>(q) << 1) ^ static_cast<uint64_t>(q >> 63));
+        put_varint(body, black ? 1 : 0);
+        send(dest, MSG_TOKEN, body);
+    }
+
+    // --- 終了後の処理 (プロセス 0 が各プロセスの最良のゴールを集め、最良のものからプランを復元する) ---
+
+    void begin_finish() {
+        phase_ = Phase::Finishing;
+        per_proc_.assign(n_, Stats{});
+        goal_g_.assign(n_, NO_BOUND);
+        goal_id_.assign(n_, -1);
+        per_proc_[0] = st_;
+        goal_g_[0] = best_goal_ >= 0 ? meta_[best_goal_].g : NO_BOUND;
+        goal_id_[0] = best_goal_;
+        total_msgs_ = msgs_;
+        total_bytes_ = bytes_;
+        if (n_ == 1) {
+            start_trace();
+            return;
+        }
+        broadcast(MSG_FINISH, {});
+    }
+
+    std::vector<uint8_t> encode_result() const {
+        std::vector<uint8_t> body;
+        put_varint(body, best_goal_ >= 0 ? 1 : 0);
+        put_varint(body, best_goal_ >= 0 ? static_cast<uint64_t>(meta_[best_goal_].g) : 0);
+        put_varint(body, best_goal_ >= 0 ? static_cast<uint64_t>(best_goal_) : 0);
+        for (uint64_t x : {st_.expanded, st_.generated, st_.evaluated, st_.duplicates, st_.pruned_by_bound, msgs_, bytes_}) {
+            put_varint(body, x);
+        }
+        return body;
+    }
+
+    void decode_result(int from, Reader& rd) {
+        const bool has_goal = rd.varint() != 0;
+        const int g = static_cast<int>(rd.varint());
+        const int id = static_cast<int>(rd.varint());
+        if (has_goal) {
+            goal_g_[from] = g;
+            goal_id_[from] = id;
+        }
+        Stats& s = per_proc_[from];
+        s.expanded = rd.varint();
+        s.generated = rd.varint();
+        s.evaluated = rd.varint();
+        s.duplicates = rd.varint();
+        s.pruned_by_bound = rd.varint();
+        total_msgs_ += rd.varint();
+        total_bytes_ += rd.varint();
+    }
+
+    void start_trace() {
+        int best = -1;
+        for (int r = 0; r < n_; ++r) {
+            if (goal_id_[r] >= 0 && (best < 0 || goal_g_[r] < goal_g_[best])) {
+                best = r;
+            }
+        }
+        if (best < 0) {
+            broadcast(MSG_SHUTDOWN, {});
+            done_ = true;
+            return;
+        }
+        if (best == rank_) {
+            trace(goal_id_[best], {});
+        } else {
+            std::vector<uint8_t> body;
+            put_varint(body, static_cast<uint64_t>(goal_id_[best]));
+            put_varint(body, 0);
+            send(best, MSG_TRACE, body);
+        }
+    }
+
+    // ノード id から親をたどってプランを後ろから集める関数 (親が他のプロセスにある場合はそこへ回す)
+    void trace(int id, std::vector<uint32_t> ops) {
+        for (;;) {
+            const Meta& m = meta_[id];
+            if (m.prank < 0) { // 根に着いた
+                if (rank_ == 0) {
+                    finish_with_plan(std::move(ops));
+                } else {
+                    std::vector<uint8_t> body;
+                    put_varint(body, ops.size());
+                    for (uint32_t a : ops) {
+                        put_varint(body, a);
+                    }
+                    send(0, MSG_PLAN, body);
+                }
+                return;
+            }
+            ops.push_back(static_cast<uint32_t>(m.op));
+            if (m.prank == rank_) {
+                id = m.pid;
+                continue;
+            }
+            std::vector<uint8_t> body;
+            put_varint(body, static_cast<uint64_t>(m.pid));
+            put_varint(body, ops.size());
+            for (uint32_t a : ops) {
+                put_varint(body, a);
+            }
+            send(m.prank, MSG_TRACE, body);
+            return;
+        }
+    }
+
+    void finish_with_plan(std::vector<uint32_t> ops) {
+        std::reverse(ops.begin(), ops.end());
+        plan_ = std::move(ops);
+        solved_ = true;
+        broadcast(MSG_SHUTDOWN, {});
+        done_ = true;
+    }
+
+    void abort_all() {
+        if (!aborted_) {
+            aborted_ = true;
+            broadcast(MSG_ABORT, {});
+        }
+        done_ = true;
+    }
+
+    void fill_result(HdaResult& out) const {
+        Result& R = out.result;
+        R.stop = stop_;
+        if (aborted_) { // 他のプロセスの統計は集められない
+            R.stats = st_;
+            out.per_proc.assign(1, st_);
+            out.messages = msgs_;
+            out.bytes = bytes_;
+            return;
+        }
+        out.per_proc = per_proc_;
+        for (const Stats& s : per_proc_) {
+            R.stats.expanded += s.expanded;
+            R.stats.generated += s.generated;
+            R.stats.evaluated += s.evaluated;
+            R.stats.duplicates += s.duplicates;
+            R.stats.pruned_by_bound += s.pruned_by_bound;
+        }
+        out.messages = total_msgs_;
+        out.bytes = total_bytes_;
+        if (solved_) {
+            R.solved = true;
+            R.plan = plan_;
+            R.plan_cost = eval_plan_cost(T_, R.plan);
+        } else {
+            R.bound_exhausted = std::isfinite(p_.cost_bound);
+        }
+    }
+
+    const Task& T_;
+    HeuristicFn& h_;
+    const HdaParams& hp_;
+    const Params& p_;
+    const int rank_;
+    const int n_;
+    std::vector<Channel> ch_;
+    StatePacker packer_;
+    bool check_mutex_ = true;
+
+    std::vector<State> states_;
+    std::vector<Meta> meta_;
+    StateIndex index_{1 << 15};
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open_;
+    int bound_ = NO_BOUND; // 暫定解のコスト (または cost_bound)、f がこれ以上のノードは展開しない
+    int best_goal_ = -1;
+
+    std::vector<std::vector<uint8_t>> batch_;
+    std::vector<uint64_t> batch_count_;
+    Stats st_;
+    uint64_t msgs_ = 0;
+    uint64_t bytes_ = 0;
+
+    // 終了判定
+    int64_t sent_ = 0;
+    bool black_ = false;
+    bool has_token_ = false;
+    int64_t tok_q_ = 0;
+    bool tok_black_ = false;
+    bool wave_ = false;
+
+    Phase phase_ = Phase::Search;
+    bool done_ = false;
+    bool aborted_ = false;
+    StopReason stop_ = StopReason::None;
+
+    // プロセス 0 が集める結果
+    int results_ = 0;
+    std::vector<Stats> per_proc_;
+    std::vector<int> goal_g_;
+    std::vector<int> goal_id_;
+    uint64_t total_msgs_ = 0;
+    uint64_t total_bytes_ = 0;
+    std::vector<uint32_t> plan_;
+    bool solved_ = false;
+};
+
+// --- 接続の準備 ---
+// links[r][q] はプロセス r からプロセス q へのソケット (r == q は -1)
+
+std::vector<std::vector<int>> make_unix_links(int n) {
+    std::vector<std::vector<int>> links(n, std::vector<int>(n, -1));
+    for (int r = 0; r < n; ++r) {
+        for (int q = r + 1; q < n; ++q) {
+            int sv[2];
+            if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+                throw std::runtime_error(std::string("hda: socketpair failed: ") + std::strerror(errno));
+            }
+            links[r][q] = sv[0];
+            links[q][r] = sv[1];
+        }
+    }
+    return links;
+}
+
+// TCP では、fork の前に全てのプロセスの待ち受けソケットを作っておき (ポートが決まる)、fork の後に各プロセスが番号の小さい相手へ接続する
+std::vector<int> make_tcp_listeners(int n, int base_port, std::vector<uint16_t>& ports) {
+    std::vector<int> ls(n, -1);
+    ports.assign(n, 0);
+    for (int r = 0; r < n; ++r) {
+        const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            throw std::runtime_error(std::string("hda: socket failed: ") + std::strerror(errno));
+        }
+        const int one = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(static_cast<uint16_t>(base_port > 0 ? base_port + r : 0));
+        if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, n) != 0) {
+            ::close(fd);
+            throw std::runtime_error(std::string("hda: cannot listen on TCP port: ") + std::strerror(errno));
+        }
+        socklen_t len = sizeof(addr);
+        ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+        ports[r] = ntohs(addr.sin_port);
+        ls[r] = fd;
+    }
+    return ls;
+}
+
+void write_all(int fd, const void* data, std::size_t n) {
+    const auto* p = static_cast<const uint8_t*>(data);
+    while (n > 0) {
+        const ssize_t k = ::write(fd, p, n);
+        if (k < 0 && errno == EINTR) {
+            continue;
+        }
+        if (k <= 0) {
+            throw std::runtime_error("hda: handshake failed");
+        }
+        p += k;
+        n -= static_cast<std::size_t>(k);
+    }
+}
+
+void read_all(int fd, void* data, std::size_t n) {
+    auto* p = static_cast<uint8_t*>(data);
+    while (n > 0) {
+        const ssize_t k = ::read(fd, p, n);
+        if (k < 0 && errno == EINTR) {
+            continue;
+        }
+        if (k <= 0) {
+            throw std::runtime_error("hda: handshake failed");
+        }
+        p += k;
+        n -= static_cast<std::size_t>(k);
+    }
+}
+
+// プロセス rank の TCP 接続を張る関数 (相手には最初に自分の番号を送る)
+std::vector<int> connect_tcp(int rank, int n, const std::vector<int>& listeners, const std::vector<uint16_t>& ports) {
+    std::vector<int> fds(n, -1);
+    for (int q = 0; q < rank; ++q) {
+        const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(ports[q]);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+            throw std::runtime_error(std::string("hda: connect failed: ") + std::strerror(errno));
+        }
+        const uint32_t me = static_cast<uint32_t>(rank);
+        write_all(fd, &me, sizeof(me));
+        fds[q] = fd;
+    }
+    for (int k = rank + 1; k < n; ++k) {
+        const int fd = ::accept(listeners[rank], nullptr, nullptr);
+        if (fd < 0) {
+            throw std::runtime_error(std::string("hda: accept failed: ") + std::strerror(errno));
+        }
+        uint32_t who = 0;
+        read_all(fd, &who, sizeof(who));
+        if (who <= static_cast<uint32_t>(rank) || who >= static_cast<uint32_t>(n) || fds[who] >= 0) {
+            throw std::runtime_error("hda: unexpected peer");
+        }
+        fds[who] = fd;
+    }
+    for (int fd : fds) {
+        if (fd >= 0) {
+            const int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+    }
+    return fds;
+}
+
+} // namespace
+
+HdaResult distributed_astar(const Task& T, HeuristicFn h, const HdaParams& hp, const Params& p) {
+    PLANNER_ALLOC_PHASE(Expansion);
+    if (!all_action_costs_are_integers(T)) {
+        throw std::domain_error("distributed A* requires integer action costs");
+    }
+    const int n = std::max(1, hp.num_procs);
+
+    std::vector<std::vector<int>> links;
+    std::vector<int> listeners;
+    std::vector<uint16_t> ports;
+    if (n > 1 && hp.transport == HdaTransport::Unix) {
+        links = make_unix_links(n);
+    } else if (n > 1) {
+        listeners = make_tcp_listeners(n, hp.tcp_port, ports);
+    }
+
+    std::cout.flush();
+    std::cerr.flush();
+    std::vector<pid_t> children;
+    for (int r = 1; r < n; ++r) {
+        const pid_t pid = ::fork();
+        if (pid < 0) {
+            throw std::runtime_error(std::string("hda: fork failed: ") + std::strerror(errno));
+        }
+        if (pid == 0) {
+            // 子プロセス: 自分の接続以外を閉じて探索し、そのまま終了する
+            int code = 0;
+            try {
+                std::vector<int> fds(n, -1);
+                if (!links.empty()) {
+                    for (int q = 0; q < n; ++q) {
+                        for (int k = 0; k < n; ++k) {
+                            if (q != r && links[q][k] >= 0) {
+                                ::close(links[q][k]);
+                            }
+                        }
+                    }
+                    fds = links[r];
+                } else {
+                    fds = connect_tcp(r, n, listeners, ports);
+                    for (int fd : listeners) {
+                        ::close(fd);
+                    }
+                }
+                HdaWorker w(T, h, hp, p, r, fds);
+                w.run(nullptr);
+            } catch (const std::exception& e) {
+                std::cerr << "hda worker " << r << ": " << e.what() << "\n";
+                code = 1;
+            }
+            ::_exit(code);
+        }
+        children.push_back(pid);
+    }
+
+    // プロセス 0 (呼び出し元)
+    HdaResult out;
+    std::vector<int> fds(n, -1);
+    if (!links.empty()) {
+        for (int q = 1; q < n; ++q) {
+            for (int k = 0; k < n; ++k) {
+                if (links[q][k] >= 0) {
+                    ::close(links[q][k]);
+                }
+            }
+        }
+        fds = links[0];
+    } else if (n > 1) {
+        fds = connect_tcp(0, n, listeners, ports);
+        for (int fd : listeners) {
+            ::close(fd);
+        }
+    }
+
+    try {
+        HdaWorker w(T, h, hp, p, 0, fds);
+        w.run(&out);
+    } catch (...) {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+        for (pid_t c : children) {
+            ::waitpid(c, nullptr, 0);
+        }
+        throw;
+    }
+    for (int fd : fds) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    for (pid_t c : children) {
+        ::waitpid(c, nullptr, 0);
+    }
+    return out;
+}
+
+}} // namespace planner::sas
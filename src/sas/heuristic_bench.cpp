@@ -0,0 +1,206 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <stdexcept>
+#include <sstream>
+#include <thread>
+#include <algorithm>
+
+#include "sas/sas_reader.hpp"
+#include "sas/sas_heuristic.hpp"
+#include "sas/state_corpus.hpp"
+
+using planner::sas::Task;
+using planner::sas::State;
+using planner::sas::HeuristicFn;
+
+// 記録した状態のコーパスに対して、各ヒューリスティックの 1 評価あたりの時間と値のチェックサムを求めるプログラム
+//   heuristic_bench <corpus> [--h goalcount,blind,ff,hmax,lm,lm_ucp,lm_ocp,seq,pho,oc,pot,pot_samples,cg,cea] [--repeats R] [--threads N] [--batch B]
+
+namespace {
+
+void die_usage(const char* argv0) {
+    std::cerr
+        << "usage: " << argv0 << " <corpus>\n"
+        << "       [--h goalcount,blind,ff,hmax,lm,lm_ucp,lm_ocp,seq,pho,oc,pot,pot_samples,cg,cea] # heuristics to measure (default: the one used for recording)\n"
+        << "       [--repeats R]   # timed passes over the corpus per mode (default 5)\n"
+        << "       [--threads N]   # threads of the multi-threaded mode (default hardware_concurrency)\n"
+        << "       [--batch B]     # states per call of the batched mode (default 256)\n";
+    std::exit(2);
+}
+
+// 値の列のチェックサム (double の bit 列に対する FNV-1a)
+uint64_t checksum(const std::vector<double>& vs) {
+    uint64_t h = 1469598103934665603ull;
+    for (double v : vs) {
+        uint64_t b = 0;
+        std::memcpy(&b, &v, sizeof(b));
+        for (int i = 0; i < 8; ++i) {
+            h ^= (b >> (8 * i)) & 0xffull;
+            h *= 1099511628211ull;
+        }
+    }
+    return h;
+}
+
+struct Measure {
+    double mean_ns = 0.0;   // 1 評価あたりの時間の平均
+    double stddev_ns = 0.0; // その標準偏差 (繰り返しの間のばらつき)
+    uint64_t sum = 0;       // 値のチェックサム
+};
+
+// pass を 1 回の準備運動の後に repeats 回実行し、1 評価あたりの時間を集計する関数
+template <class Pass>
+Measure measure(std::size_t n, int repeats, std::vector<double>& out, Pass&& pass) {
+    using clock = std::chrono::steady_clock;
+    pass(out);
+    std::vector<double> ns;
+    ns.reserve(static_cast<std::size_t>(repeats));
+    for (int r = 0; r < repeats; ++r) {
+        const auto t0 = clock::now();
+        pass(out);
+        const auto t1 = clock::now();
+        ns.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count() / static_cast<double>(std::max<std::size_t>(n, 1)));
+    }
+
+    Measure M;
+    for (double x : ns) {
+        M.mean_ns += x;
+    }
+    M.mean_ns /= static_cast<double>(ns.size());
+    for (double x : ns) {
+        M.stddev_ns += (x - M.mean_ns) * (x - M.mean_ns);
+    }
+    M.stddev_ns = ns.size() > 1 ? std::sqrt(M.stddev_ns / static_cast<double>(ns.size() - 1)) : 0.0;
+    M.sum = checksum(out);
+    return M;
+}
+
+void report(const std::string& name, const std::string& mode, const Measure& M) {
+    std::cout << std::left << std::setw(12) << name << std::setw(12) << mode << std::right
+              << std::fixed << std::setprecision(1)
+              << std::setw(12) << M.mean_ns << " ns/eval  +- " << std::setw(8) << M.stddev_ns
+              << "  checksum " << std::hex << std::setw(16) << std::setfill('0') << M.sum
+              << std::dec << std::setfill(' ') << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+
+    const std::string corpus_path = argv[1];
+    std::string hlist;
+    int repeats = 5;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t batch = 256;
+    for (int i = 2; i < argc; ++i) {
+        const std::string a = argv[i];
+        if (a == "--h" && i+1 < argc) {
+            hlist = argv[++i];
+        } else if (a == "--repeats" && i+1 < argc) {
+            repeats = std::max(1, std::stoi(argv[++i]));
+        } else if (a == "--threads" && i+1 < argc) {
+            threads = static_cast<unsigned>(std::max(1, std::stoi(argv[++i])));
+        } else if (a == "--batch" && i+1 < argc) {
+            batch = std::max<std::size_t>(1, std::stoull(argv[++i]));
+        } else {
+            die_usage(argv[0]);
+        }
+    }
+
+    try {
+        const planner::sas::StateCorpus C = planner::sas::read_corpus(corpus_path);
+        const Task& T = C.task;
+        const std::size_t n = C.states.size();
+        std::cout << "corpus: " << n << " states (sampled from " << C.seen << " evaluations with "
+                  << C.heuristic << "), " << T.vars.size() << " vars, " << T.ops.size() << " ops\n";
+        if (hlist.empty()) {
+            hlist = C.heuristic;
+        }
+
+        // batched モードで渡す状態のまとまりを、計測の外で作っておく
+        std::vector<std::vector<State>> chunks;
+        for (std::size_t i = 0; i < n; i += batch) {
+            chunks.emplace_back(C.states.begin() + static_cast<std::ptrdiff_t>(i),
+                                C.states.begin() + static_cast<std::ptrdiff_t>(std::min(n, i + batch)));
+        }
+
+        bool ok = true;
+        std::stringstream ss(hlist);
+        std::string name;
+        while (std::getline(ss, name, ',')) {
+            if (name.empty()) {
+                continue;
+            }
+            const HeuristicFn h = planner::sas::make_heuristic(name, T);
+            std::vector<double> out(n);
+
+            const Measure single = measure(n, repeats, out, [&](std::vector<double>& vs) {
+                for (std::size_t i = 0; i < n; ++i) {
+                    vs[i] = h(T, C.states[i]);
+                }
+            });
+            report(name, "single", single);
+
+            // 値が記録時と同じかどうか (同じヒューリスティックの場合のみ)
+            if (name == C.heuristic) {
+                std::size_t diff = 0;
+                for (std::size_t i = 0; i < n; ++i) {
+                    diff += (out[i] != C.values[i]) ? 1 : 0;
+                }
+                std::cout << std::left << std::setw(12) << name << std::setw(12) << "recorded" << std::right
+                          << (diff == 0 ? "values match" : std::to_string(diff) + " values differ") << "\n";
+                ok = ok && (diff == 0);
+            }
+
+            // hmax は fact ごとのビット列でまとめて評価し、それ以外は 1 状態ずつ呼ぶ
+            const planner::sas::BatchHeuristicFn hb = (name == "hmax") ? planner::sas::hmax_batched(T) : planner::sas::batched(h);
+            std::vector<double> part;
+            const Measure batched = measure(n, repeats, out, [&](std::vector<double>& vs) {
+                std::size_t pos = 0;
+                for (const auto& chunk : chunks) {
+                    hb(T, chunk, part);
+                    std::copy(part.begin(), part.end(), vs.begin() + static_cast<std::ptrdiff_t>(pos));
+                    pos += chunk.size();
+                }
+            });
+            report(name, "batched", batched);
+
+            // 状態を threads 個の連続した区間に分け、各スレッドが同じ HeuristicFn で評価する
+            const Measure multi = measure(n, repeats, out, [&](std::vector<double>& vs) {
+                std::vector<std::thread> pool;
+                pool.reserve(threads);
+                for (unsigned t = 0; t < threads; ++t) {
+                    const std::size_t lo = n * t / threads, hi = n * (t + 1) / threads;
+                    pool.emplace_back([&, lo, hi] {
+                        for (std::size_t i = lo; i < hi; ++i) {
+                            vs[i] = h(T, C.states[i]);
+                        }
+                    });
+                }
+                for (auto& th : pool) {
+                    th.join();
+                }
+            });
+            report(name, "threads=" + std::to_string(threads), multi);
+
+            if (batched.sum != single.sum || multi.sum != single.sum) {
+                std::cout << name << ": values differ between modes\n";
+                ok = false;
+            }
+        }
+        return ok ? 0 : 1;
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << "\n";
+        return 9;
+    }
+}
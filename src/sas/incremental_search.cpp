@@ -0,0 +1,222 @@
+#include "sas/incremental_search.hpp"
+#include "sas/search_utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace planner { namespace sas {
+
+static constexpr double INF = std::numeric_limits<double>::infinity();
+
+IncrementalPlanner::IncrementalPlanner(const Task& T, HeuristicFn h, const Params& p)
+    : T_(T), h_(std::move(h)), p_(p), index_of_(1 << 15), edges_of_op_(T.ops.size()) {
+    nodes_.emplace_back(); // 仮想ゴールノード
+
+    Stats st;
+    start_ = node_of(State(T_.init.begin(), T_.init.end()), st);
+    update_vertex(start_);
+}
+
+// キー (f, g, 順位) を求める関数
+// 仮想ゴールへの辺はコスト 0 なので、ゴール状態とキーの先頭 2 つが一致しうる、順位によってゴール状態を仮想ゴールより先に取り出す
+IncrementalPlanner::Key IncrementalPlanner::calc_key(int u) const {
+    const LNode& n = nodes_[u];
+    const double m = std::min(n.g, n.rhs);
+    return {m + n.h, m, u == GOAL ? 1 : (n.goal_state ? 0 : 2)};
+}
+
+// 状態のノード ID を返す関数 (初めて見る状態の場合はノードを作り、ヒューリスティック値を計算する)
+int IncrementalPlanner::node_of(const State& s, Stats& st) {
+    auto state_of = [this](int id) -> const State& { return nodes_[id].s; };
+    const uint64_t hs = StateIndex::hash(s);
+    const int found = index_of_.find(s, hs, state_of);
+    if (found != StateIndex::EMPTY) {
+        return found;
+    }
+    const int v = (int)nodes_.size();
+    nodes_.emplace_back();
+    nodes_[v].s = s;
+    nodes_[v].h = h_(T_, s);
+    nodes_[v].goal_state = is_goal(T_, s);
+    ++st.evaluated;
+    index_of_.insert(hs, v, state_of);
+    return v;
+}
+
+// 後続状態を生成し、辺を登録する関数 (グラフの形はコストや初期状態が変わっても変わらないので、各ノードで 1 度だけ行う)
+void IncrementalPlanner::ensure_expanded(int u, Stats& st) {
+    if (nodes_[u].expanded) {
+        return;
+    }
+    nodes_[u].expanded = true;
+    if (u == GOAL) {
+        return;
+    }
+
+    const State su = nodes_[u].s;
+    State work;
+    Undo undo;
+    batch_.clear();
+    for (int a = 0; a < (int)T_.ops.size(); ++a) {
+        const auto& op = T_.ops[a];
+        if (!is_applicable(T_, su, op)) {
+            continue;
+        }
+        work = su;
+        undo.clear();
+        apply_inplace(T_, op, work, undo);
+        ++st.generated;
+
+        // 生成状態が mutex 違反なら捨てる
+        if (should_check_mutex_runtime(T_) && violates_mutex(T_, work)) {
+            continue;
+        }
+        batch_.push(work, a);
+    }
+    batch_.hash_and_prefetch(index_of_);
+
+    for (std::size_t i = 0; i < batch_.size(); ++i) {
+        const int a = batch_.op(i);
+        const int v = node_of(batch_.state(i), st);
+        nodes_[u].succs.push_back(Edge{v, a});
+        nodes_[v].preds.push_back(Edge{u, a});
+        edges_of_op_[a].emplace_back(u, v);
+    }
+    if (nodes_[u].goal_state) {
+        nodes_[u].succs.push_back(Edge{GOAL, -1});
+        nodes_[GOAL].preds.push_back(Edge{u, -1});
+    }
+}
+
+void IncrementalPlanner::enqueue(int u) {
+    LNode& n = nodes_[u];
+    n.key = calc_key(u);
+    n.queued = true;
+    open_.emplace(n.key, u);
+}
+
+void IncrementalPlanner::dequeue(int u) {
+    LNode& n = nodes_[u];
+    if (n.queued) {
+        open_.erase({n.key, u});
+        n.queued = false;
+    }
+}
+
+// rhs 値を親から計算し直し、g 値と一致しない (局所的に非一貫な) 場合のみキューに入れる関数
+void IncrementalPlanner::update_vertex(int u) {
+    LNode& n = nodes_[u];
+    if (u == start_) {
+        n.rhs = 0.0;
+    } else {
+        double best = INF;
+        for (const Edge& e : n.preds) {
+            best = std::min(best, nodes_[e.node].g + edge_cost(e.op));
+        }
+        n.rhs = best;
+    }
+    dequeue(u);
+    if (n.g != n.rhs) {
+        enqueue(u);
+    }
+}
+
+Result IncrementalPlanner::plan() {
+    Result R;
+    Stats& st = R.stats;
+
+    while (!open_.empty() && (open_.begin()->first < calc_key(GOAL) || nodes_[GOAL].rhs != nodes_[GOAL].g)) {
+        if (search_interrupted(p_, R)) {
+            return R; // キューはそのまま残るので、次の plan() で続きから修正する
+        }
+        const int u = open_.begin()->second;
+        dequeue(u);
+
+        ++st.expanded;
+        if (st.expanded > p_.max_expansions) {
+            enqueue(u);
+            return R;
+        }
+        ensure_expanded(u, st);
+
+        if (nodes_[u].g > nodes_[u].rhs) { // 過大評価: g 値を確定させ、後続へ伝える
+            nodes_[u].g = nodes_[u].rhs;
+        } else {                           // 過小評価: g 値を無効にし、自身と後続を計算し直す
+            nodes_[u].g = INF;
+            update_vertex(u);
+        }
+        for (std::size_t i = 0; i < nodes_[u].succs.size(); ++i) {
+            update_vertex(nodes_[u].succs[i].node);
+        }
+    }
+
+    const double cost = nodes_[GOAL].g;
+    if (!std::isfinite(cost) || cost >= p_.cost_bound) {
+        R.bound_exhausted = std::isfinite(p_.cost_bound);
+        return R;
+    }
+
+    // g 値を親へ下ってプランを復元する (各ノードで g(p) + c が最小の親を選ぶ)
+    std::vector<uint32_t> acts;
+    int v = GOAL;
+    for (std::size_t guard = 0; v != start_; ++guard) {
+        if (guard > nodes_.size()) {
+            throw std::logic_error("incremental planner: plan extraction did not reach the initial state");
+        }
+        int best = -1, best_op = -1;
+        double best_val = INF;
+        for (const Edge& e : nodes_[v].preds) {
+            const double val = nodes_[e.node].g + edge_cost(e.op);
+            if (val < best_val || (val == best_val && best >= 0 && nodes_[e.node].g < nodes_[best].g)) {
+                best = e.node;
+                best_op = e.op;
+                best_val = val;
+            }
+        }
+        if (best_op >= 0) {
+            acts.push_back(static_cast<uint32_t>(best_op));
+        }
+        v = best;
+    }
+    std::reverse(acts.begin(), acts.end());
+
+    R.solved = true;
+    R.plan = std::move(acts);
+    R.plan_cost = eval_plan_cost(T_, R.plan);
+    return R;
+}
+
+void IncrementalPlanner::update_init(const std::vector<std::pair<int, int>>& changes) {
+    for (const auto& [var, val] : changes) {
+        if (var < 0 || var >= (int)T_.vars.size() || val < 0 || val >= T_.vars[var].domain) {
+            throw std::out_of_range("update_init: invalid (var, value)");
+        }
+        T_.init[var] = val;
+    }
+
+    Stats st;
+    const int old_start = start_;
+    start_ = node_of(State(T_.init.begin(), T_.init.end()), st);
+    if (start_ != old_start) {
+        update_vertex(old_start);
+        update_vertex(start_);
+    }
+}
+
+void IncrementalPlanner::update_costs(const std::vector<std::pair<int, int>>& changes) {
+    for (const auto& [op, cost] : changes) {
+        if (op < 0 || op >= (int)T_.ops.size() || cost < 0) {
+            throw std::out_of_range("update_costs: invalid (op, cost)");
+        }
+        if (T_.ops[op].cost == cost) {
+            continue;
+        }
+        T_.ops[op].cost = cost;
+        for (const auto& e : edges_of_op_[op]) { // 変わった辺の子の rhs 値のみを計算し直す
+            update_vertex(e.second);
+        }
+    }
+}
+
+}} // namespace planner::sas
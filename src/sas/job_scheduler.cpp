@@ -0,0 +1,150 @@
+#include "sas/job_scheduler.hpp"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+namespace planner { namespace sas {
+
+JobScheduler::JobScheduler(Config cfg) : cfg_(cfg) {
+    if (cfg_.num_threads == 0) {
+        cfg_.num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    cfg_.slice_expansions = std::max<uint64_t>(1, cfg_.slice_expansions);
+    threads_.reserve(cfg_.num_threads);
+    for (uint32_t t = 0; t < cfg_.num_threads; ++t) {
+        threads_.emplace_back([this] { worker(); });
+    }
+}
+
+JobScheduler::~JobScheduler() {
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        stopping_ = true;
+        for (auto& j : jobs_) {
+            j->spec.cancel.cancel(); // 残ったジョブは次の time slice の最初に Cancelled で終わる
+        }
+    }
+    cv_.notify_all();
+    for (auto& th : threads_) {
+        th.join();
+    }
+}
+
+JobHandle JobScheduler::submit(JobSpec spec) {
+    if (!spec.task) {
+        throw std::invalid_argument("JobSpec::task is null");
+    }
+    if (spec.algo != "astar" && spec.algo != "gbfs") {
+        throw std::invalid_argument("unknown algorithm for a scheduled job: " + spec.algo);
+    }
+
+    auto job = std::make_unique<Job>();
+    job->spec = std::move(spec);
+    job->spec.priority = std::max(1, job->spec.priority);
+    job->control.cancel = job->spec.cancel.flag();
+    job->control.start = std::chrono::steady_clock::now();
+    if (job->spec.time_limit_ms >= 0) {
+        job->control.deadline = job->control.start + std::chrono::milliseconds(job->spec.time_limit_ms);
+    }
+
+    JobHandle handle;
+    handle.cancel = job->spec.cancel;
+    handle.result = job->promise.get_future().share();
+    {
+        std::lock_guard<std::mutex> lk(mu_);
+        if (stopping_) {
+            throw std::runtime_error("JobScheduler is shutting down");
+        }
+        job->id = handle.id = next_id_++;
+        job->pass = vtime_; // 待っていた間の分を溜め込まないように、現在の仮想時間から始める
+        ready_.push(job.get());
+        jobs_.push_back(std::move(job));
+    }
+    cv_.notify_one();
+    return handle;
+}
+
+std::size_t JobScheduler::active() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return jobs_.size();
+}
+
+void JobScheduler::worker() {
+    for (;;) {
+        Job* job = nullptr;
+        {
+            std::unique_lock<std::mutex> lk(mu_);
+            cv_.wait(lk, [&] { return stopping_ || !ready_.empty(); });
+            if (ready_.empty()) {
+                return; // stopping_ かつ実行待ちのジョブがない
+            }
+            job = ready_.top();
+            ready_.pop();
+            vtime_ = job->pass;
+        }
+
+        bool done = true;
+        try {
+            done = run_slice(*job);
+        } catch (...) {
+            job->promise.set_exception(std::current_exception());
+        }
+
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            if (done) {
+                auto it = std::find_if(jobs_.begin(), jobs_.end(), [&](const auto& j) { return j.get() == job; });
+                jobs_.erase(it);
+            } else {
+                ready_.push(job);
+            }
+        }
+        if (!done) {
+            cv_.notify_one();
+        }
+    }
+}
+
+bool JobScheduler::run_slice(Job& job) {
+    const auto t0 = std::chrono::steady_clock::now();
+
+    if (!job.search) {
+        // 一度も実行されないまま中断されたジョブは、ヒューリスティックを構築せずに終える
+        if (job.spec.cancel.cancelled()) {
+            SolveResult out;
+            out.status = SolveStatus::Cancelled;
+            job.promise.set_value(std::move(out));
+            return true;
+        }
+        Params p = job.spec.params;
+        p.verbose = false;
+        p.control = &job.control;
+        const auto mode = (job.spec.algo == "gbfs") ? ResumableSearch::Mode::GBFS : ResumableSearch::Mode::AStar;
+        job.search = std::make_unique<ResumableSearch>(*job.spec.task, make_heuristic(job.spec.heuristic, *job.spec.task), mode, p);
+    }
+
+    job.search->step(cfg_.slice_expansions);
+
+    const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    job.search_sec += sec;
+    job.pass += sec / job.spec.priority;
+
+    if (!job.search->finished()) {
+        return false;
+    }
+
+    Result& R = job.search->result();
+    SolveResult out;
+    out.status = solve_status_of(R, job.spec.params, job.spec.heuristic);
+    out.stats = R.stats;
+    out.search_seconds = job.search_sec;
+    if (R.solved) {
+        out.plan = std::move(R.plan);
+        out.plan_cost = eval_plan_cost(*job.spec.task, out.plan);
+    }
+    job.search.reset(); // 探索のメモリは結果を渡す前に解放する
+    job.promise.set_value(std::move(out));
+    return true;
+}
+
+}} // namespace planner::sas
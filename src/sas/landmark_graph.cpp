@@ -0,0 +1,269 @@
+#include "sas/landmark_graph.hpp"
+#include "alloc_profile.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+
+namespace planner { namespace sas {
+
+namespace {
+
+// 演算子の効果 (追加する fact と、効果の条件)
+struct Effect {
+    int fact;
+    std::vector<int> conds; // fact-id (昇順)
+};
+
+// 昇順の fact-id の列の共通部分を a に残す関数
+void intersect_into(std::vector<int>& a, const std::vector<int>& b) {
+    std::vector<int> tmp;
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(tmp));
+    a.swap(tmp);
+}
+
+} // namespace
+
+LandmarkGraph::LandmarkGraph(const Task& T, std::size_t max_landmarks, std::size_t max_disjunction) {
+    PLANNER_ALLOC_PHASE(HeuristicSetup);
+
+    // fact-id の割り振り
+    const int nvars = static_cast<int>(T.vars.size());
+    std::vector<int> var_offset(nvars + 1, 0);
+    for (int v = 0; v < nvars; ++v) {
+        var_offset[v + 1] = var_offset[v] + T.vars[v].domain;
+    }
+    const int nfacts = var_offset[nvars];
+    std::vector<int> fact_var(nfacts), fact_val(nfacts);
+    for (int v = 0; v < nvars; ++v) {
+        for (int d = 0; d < T.vars[v].domain; ++d) {
+            fact_var[var_offset[v] + d] = v;
+            fact_val[var_offset[v] + d] = d;
+        }
+    }
+    auto fact_id = [&](int v, int val) { return var_offset[v] + val; };
+
+    // 各演算子の前提条件と効果
+    const std::size_t nops = T.ops.size();
+    std::vector<std::vector<int>> pre(nops);
+    std::vector<std::vector<Effect>> effs(nops);
+    for (std::size_t a = 0; a < nops; ++a) {
+        const auto& op = T.ops[a];
+        for (auto [v, val] : op.prevail) {
+            pre[a].push_back(fact_id(v, val));
+        }
+        for (const auto& [conds, var, pv, post] : op.pre_posts) {
+            if (pv >= 0) {
+                pre[a].push_back(fact_id(var, pv));
+            }
+            Effect e{fact_id(var, post), {}};
+            for (auto [cv, cval] : conds) {
+                e.conds.push_back(fact_id(cv, cval));
+            }
+            std::sort(e.conds.begin(), e.conds.end());
+            effs[a].push_back(std::move(e));
+        }
+        std::sort(pre[a].begin(), pre[a].end());
+        pre[a].erase(std::unique(pre[a].begin(), pre[a].end()), pre[a].end());
+    }
+
+    // 初期状態からの緩和到達可能性 (到達できない演算子や効果は、到達可能などの状態からも使えない)
+    std::vector<uint8_t> reached(nfacts, 0);
+    for (int v = 0; v < nvars; ++v) {
+        reached[fact_id(v, T.init[v])] = 1;
+    }
+    auto all_reached = [&](const std::vector<int>& fs) {
+        return std::all_of(fs.begin(), fs.end(), [&](int f) { return reached[f] != 0; });
+    };
+    std::vector<std::vector<uint8_t>> fired(nops);
+    for (std::size_t a = 0; a < nops; ++a) {
+        fired[a].assign(effs[a].size(), 0);
+    }
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (std::size_t a = 0; a < nops; ++a) {
+            if (!all_reached(pre[a])) {
+                continue;
+            }
+            for (std::size_t e = 0; e < effs[a].size(); ++e) {
+                if (!fired[a][e] && all_reached(effs[a][e].conds)) {
+                    fired[a][e] = 1;
+                    if (!reached[effs[a][e].fact]) {
+                        reached[effs[a][e].fact] = 1;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+
+    // fact を追加する、到達可能な (演算子, 効果) の組
+    std::vector<std::vector<std::pair<uint32_t, uint32_t>>> adders(nfacts);
+    for (std::size_t a = 0; a < nops; ++a) {
+        for (std::size_t e = 0; e < effs[a].size(); ++e) {
+            if (fired[a][e]) {
+                adders[effs[a][e].fact].emplace_back(static_cast<uint32_t>(a), static_cast<uint32_t>(e));
+            }
+        }
+    }
+
+    // landmark を fact-id の集合で引くための表
+    std::map<std::vector<int>, int> index;
+    auto find_or_add = [&](std::vector<int> key) -> int {
+        auto it = index.find(key);
+        if (it != index.end()) {
+            return it->second;
+        }
+        if (lms_.size() >= max_landmarks) {
+            return -1;
+        }
+        Landmark L;
+        for (int f : key) {
+            L.facts.emplace_back(fact_var[f], fact_val[f]);
+        }
+        const int id = static_cast<int>(lms_.size());
+        lms_.push_back(std::move(L));
+        index.emplace(std::move(key), id);
+        return id;
+    };
+
+    for (auto [v, val] : T.goal) {
+        const int id = find_or_add({fact_id(v, val)});
+        if (id >= 0 && !lms_[id].goal) {
+            lms_[id].goal = true;
+            goals_.push_back(id);
+        }
+    }
+
+    // 後ろ向きの連鎖 (lms_ は途中で伸びるので添字で回す)
+    std::vector<int> cnt(nvars, 0), last(nvars, -1);
+    std::vector<std::vector<int>> vals(nvars);
+    std::vector<int> touched;
+    for (std::size_t idx = 0; idx < lms_.size(); ++idx) {
+        std::vector<int> key;
+        for (auto [v, val] : lms_[idx].facts) {
+            key.push_back(fact_id(v, val));
+        }
+
+        // achiever ごとに、この landmark を追加するために必要な前提条件
+        // (同じ演算子の複数の効果が追加する場合は、それらの条件の共通部分)
+        std::map<uint32_t, std::vector<int>> req;
+        for (int f : key) {
+            for (auto [a, e] : adders[f]) {
+                std::vector<int> r = pre[a];
+                r.insert(r.end(), effs[a][e].conds.begin(), effs[a][e].conds.end());
+                std::sort(r.begin(), r.end());
+                r.erase(std::unique(r.begin(), r.end()), r.end());
+                auto it = req.find(a);
+                if (it == req.end()) {
+                    req.emplace(a, std::move(r));
+                } else {
+                    intersect_into(it->second, r);
+                }
+            }
+        }
+
+        std::vector<uint32_t> achievers;
+        for (const auto& [a, r] : req) {
+            achievers.push_back(a);
+        }
+        if (achievers.size() == 1) {
+            ++num_action_;
+        }
+        lms_[idx].achievers = std::move(achievers);
+        if (req.empty()) {
+            continue;
+        }
+
+        auto in_key = [&](int f) { return std::binary_search(key.begin(), key.end(), f); };
+        std::vector<int> parents;
+
+        // 全ての achiever に共通する前提条件 -> fact landmark
+        std::vector<int> inter = req.begin()->second;
+        for (const auto& [a, r] : req) {
+            intersect_into(inter, r);
+        }
+        for (int p : inter) {
+            if (in_key(p)) {
+                continue;
+            }
+            const int id = find_or_add({p});
+            if (id >= 0) {
+                parents.push_back(id);
+            }
+        }
+
+        // 全ての achiever が前提条件を持つ変数 -> その値の和集合を disjunctive fact landmark とする
+        int k = 0;
+        for (const auto& [a, r] : req) {
+            for (int f : r) {
+                const int v = fact_var[f];
+                if (last[v] != k) {
+                    if (last[v] < 0) {
+                        touched.push_back(v);
+                    }
+                    last[v] = k;
+                    ++cnt[v];
+                }
+                vals[v].push_back(f);
+            }
+            ++k;
+        }
+        for (int v : touched) {
+            auto& d = vals[v];
+            std::sort(d.begin(), d.end());
+            d.erase(std::unique(d.begin(), d.end()), d.end());
+            if (cnt[v] == k && d.size() >= 2 && d.size() <= max_disjunction &&
+                std::none_of(d.begin(), d.end(), in_key)) {
+                const int id = find_or_add(d);
+                if (id >= 0) {
+                    parents.push_back(id);
+                }
+            }
+            cnt[v] = 0;
+            last[v] = -1;
+            d.clear();
+        }
+        touched.clear();
+
+        std::sort(parents.begin(), parents.end());
+        parents.erase(std::unique(parents.begin(), parents.end()), parents.end());
+        lms_[idx].parents = std::move(parents);
+    }
+
+    for (const auto& L : lms_) {
+        num_disjunctive_ += (L.facts.size() > 1) ? 1 : 0;
+    }
+}
+
+bool LandmarkGraph::satisfied(int id, const State& s) const {
+    for (auto [v, val] : lms_[id].facts) {
+        if (s[v] == val) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void LandmarkGraph::required(const State& s, std::vector<int>& out, std::vector<uint8_t>& mark) const {
+    const std::size_t begin = out.size();
+    for (int g : goals_) {
+        if (!satisfied(g, s)) {
+            mark[g] = 1;
+            out.push_back(g);
+        }
+    }
+    for (std::size_t i = begin; i < out.size(); ++i) {
+        for (int p : lms_[out[i]].parents) {
+            if (!mark[p] && !satisfied(p, s)) {
+                mark[p] = 1;
+                out.push_back(p);
+            }
+        }
+    }
+    for (std::size_t i = begin; i < out.size(); ++i) {
+        mark[out[i]] = 0;
+    }
+}
+
+}} // namespace planner::sas
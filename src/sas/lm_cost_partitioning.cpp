@@ -0,0 +1,139 @@
+#include "sas/sas_heuristic.hpp"
+#include "sas/landmark_graph.hpp"
+#include "sas/lp_solver.hpp"
+#include "sas/scratch_pool.hpp"
+#include "alloc_profile.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <memory>
+
+namespace planner { namespace sas {
+
+namespace { // 衝突を避けるために無名名前空間を使用する
+
+constexpr double PSEUDOINF = 1 << 16; // hff と同じく、ゴールに到達できない場合の値
+
+struct LMCPData {
+    LandmarkGraph graph;
+    std::vector<double> cost;   // 演算子のコスト
+    bool integer_costs = true;  // 全ての演算子のコストが整数かどうか (その場合は h を切り上げてよい)
+    LMCostPartitioning cp;
+
+    LMCPData(const Task& T, LMCostPartitioning kind) : graph(T), cp(kind) {
+        cost.reserve(T.ops.size());
+        for (const auto& op : T.ops) {
+            cost.push_back(static_cast<double>(op.cost));
+            integer_costs = integer_costs && (std::floor(op.cost) == op.cost);
+        }
+    }
+};
+
+struct LMCPScratch {
+    std::vector<uint8_t> mark;             // LandmarkGraph::required の作業領域
+    std::vector<int> req;                  // 必要な landmark
+    std::vector<int> cnt;                  // 演算子ごとの、必要な landmark のうち達成しうるものの数
+    std::vector<std::vector<int>> cols;    // 演算子ごとの、達成しうる必要な landmark の req 上の添字 (最適分割のみ)
+    std::vector<uint32_t> touched;         // cnt が 0 でない演算子
+
+    explicit LMCPScratch(const LMCPData& d)
+        : mark(d.graph.size(), 0), cnt(d.cost.size(), 0), cols(d.cp == LMCostPartitioning::Optimal ? d.cost.size() : 0) {}
+};
+
+double lmcp_compute(const LMCPData& D, LMCPScratch& S, const State& s) {
+    const auto& lms = D.graph.landmarks();
+    S.req.clear();
+    D.graph.required(s, S.req, S.mark);
+
+    for (int id : S.req) {
+        if (lms[id].achievers.empty()) { // 達成できない landmark が残っている
+            return PSEUDOINF;
+        }
+    }
+
+    // 一様コスト分割: 演算子のコストを、それが達成しうる必要な landmark の間で等分する
+    const bool optimal = (D.cp == LMCostPartitioning::Optimal);
+    for (std::size_t j = 0; j < S.req.size(); ++j) {
+        for (uint32_t a : lms[S.req[j]].achievers) {
+            if (S.cnt[a]++ == 0) {
+                S.touched.push_back(a);
+            }
+            if (optimal) {
+                S.cols[a].push_back(static_cast<int>(j));
+            }
+        }
+    }
+    double h = 0.0;
+    for (int id : S.req) {
+        double best = std::numeric_limits<double>::infinity();
+        for (uint32_t a : lms[id].achievers) {
+            best = std::min(best, D.cost[a] / S.cnt[a]);
+        }
+        h += best;
+    }
+
+    // 最適コスト分割: maximize sum x_L s.t. 各演算子 a について sum_{L: a は L の achiever} x_L <= cost(a)
+    // 同じ landmark の集合を達成する演算子の制約は、コストが最小のもの 1 つにまとめる
+    if (optimal && !S.req.empty()) {
+        std::map<std::vector<int>, double> rows;
+        for (uint32_t a : S.touched) {
+            auto it = rows.find(S.cols[a]);
+            if (it == rows.end()) {
+                rows.emplace(S.cols[a], D.cost[a]);
+            } else {
+                it->second = std::min(it->second, D.cost[a]);
+            }
+        }
+        LinearProgram lp;
+        lp.num_cols = static_cast<int>(S.req.size());
+        lp.obj.assign(S.req.size(), 1.0);
+        for (const auto& [js, c] : rows) {
+            std::vector<std::pair<int, double>> coeffs;
+            coeffs.reserve(js.size());
+            for (int j : js) {
+                coeffs.emplace_back(j, 1.0);
+            }
+            lp.add_row(std::move(coeffs), std::max(0.0, c));
+        }
+        // 反復の上限で打ち切った場合も、その時点の解は実行可能なので値は許容的
+        h = std::max(h, solve_lp(lp).objective);
+        for (uint32_t a : S.touched) {
+            S.cols[a].clear();
+        }
+    }
+
+    for (uint32_t a : S.touched) {
+        S.cnt[a] = 0;
+    }
+    S.touched.clear();
+
+    if (D.integer_costs) {
+        h = std::ceil(h - 1e-6);
+    }
+    return h;
+}
+
+} // anonymous namespace
+
+HeuristicFn hlm_cp(const Task& T, LMCostPartitioning cp) {
+    PLANNER_ALLOC_PHASE(HeuristicSetup);
+    auto data = std::make_shared<LMCPData>(T, cp);
+    auto pool = std::make_shared<ScratchPool<LMCPScratch, LMCPData>>(*data);
+
+    return [data, pool](const Task& /*unused*/, const State& s) -> double {
+        PLANNER_ALLOC_PHASE(Evaluation);
+        auto lease = pool->acquire();
+        return lmcp_compute(*data, *lease, s);
+    };
+}
+
+HeuristicFn hlm_ucp(const Task& T) {
+    return hlm_cp(T, LMCostPartitioning::Uniform);
+}
+
+HeuristicFn hlm_ocp(const Task& T) {
+    return hlm_cp(T, LMCostPartitioning::Optimal);
+}
+
+}} // namespace planner::sas
@@ -0,0 +1,486 @@
+#include "sas/lp_solver.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace planner { namespace sas {
+
+namespace {
+
+constexpr double EPS = 1e-9;
+constexpr int DEGENERATE_SWITCH = 50; // 退化した反復がこの回数続いたら Bland の規則に切り替える
+constexpr double DUAL_TOL = 1e-7;     // 被約費用がこれより負なら、双対実行可能性が崩れたとみなす
+constexpr int REFACTOR_INTERVAL = 100; // 基底の逆行列を作り直すまでの枢軸演算の回数
+
+} // namespace
+
+LPSolution solve_lp(const LinearProgram& lp, int max_iterations) {
+    const int n = lp.num_cols;
+    const int m = static_cast<int>(lp.rows.size());
+    if (static_cast<int>(lp.obj.size()) != n || static_cast<int>(lp.rhs.size()) != m) {
+        throw std::invalid_argument("solve_lp: size mismatch");
+    }
+
+    // 辞書 x_B = b - A x_N, z = z0 + c^T x_N を縮約タブローとして持つ
+    // 列 j の非基底変数と行 i の基底変数の番号は、0..n-1 が元の変数、n..n+m-1 がスラック変数
+    std::vector<double> A(static_cast<std::size_t>(m) * n, 0.0);
+    std::vector<double> b(lp.rhs);
+    std::vector<double> c(lp.obj);
+    double z = 0.0;
+    std::vector<int> basic(m), nonbasic(n);
+    for (int i = 0; i < m; ++i) {
+        if (b[i] < 0.0) {
+            throw std::invalid_argument("solve_lp: negative right-hand side in row " + std::to_string(i));
+        }
+        for (const auto& [j, a] : lp.rows[i]) {
+            if (j < 0 || j >= n) {
+                throw std::invalid_argument("solve_lp: column out of range in row " + std::to_string(i));
+            }
+            A[static_cast<std::size_t>(i) * n + j] += a;
+        }
+        basic[i] = n + i;
+    }
+    for (int j = 0; j < n; ++j) {
+        nonbasic[j] = j;
+    }
+
+    LPSolution sol;
+    int degenerate = 0;
+    for (;;) {
+        // 入る列を選ぶ
+        const bool bland = degenerate >= DEGENERATE_SWITCH;
+        int col = -1;
+        for (int j = 0; j < n; ++j) {
+            if (c[j] <= EPS) {
+                continue;
+            }
+            if (col < 0 || (bland ? nonbasic[j] < nonbasic[col] : c[j] > c[col])) {
+                col = j;
+            }
+        }
+        if (col < 0) {
+            sol.status = LPStatus::Optimal;
+            break;
+        }
+        if (sol.iterations >= max_iterations) {
+            sol.status = LPStatus::IterationLimit;
+            break;
+        }
+
+        // 比の検定で出る行を選ぶ (同じ比の場合は、基底変数の番号が小さい方)
+        int row = -1;
+        double best = std::numeric_limits<double>::infinity();
+        for (int i = 0; i < m; ++i) {
+            const double a = A[static_cast<std::size_t>(i) * n + col];
+            if (a <= EPS) {
+                continue;
+            }
+            const double r = b[i] / a;
+            if (r < best - EPS || (r <= best + EPS && row >= 0 && basic[i] < basic[row])) {
+                best = r;
+                row = i;
+            }
+        }
+        if (row < 0) {
+            sol.status = LPStatus::Unbounded;
+            break;
+        }
+
+        // 枢軸演算
+        double* R = &A[static_cast<std::size_t>(row) * n];
+        const double p = R[col];
+        for (int j = 0; j < n; ++j) {
+            R[j] /= p;
+        }
+        R[col] = 1.0 / p;
+        b[row] /= p;
+        for (int i = 0; i < m; ++i) {
+            if (i == row) {
+                continue;
+            }
+            double* Ri = &A[static_cast<std::size_t>(i) * n];
+            const double f = Ri[col];
+            if (f == 0.0) {
+                continue;
+            }
+            for (int j = 0; j < n; ++j) {
+                Ri[j] -= f * R[j];
+            }
+            Ri[col] = -f * R[col];
+            b[i] = std::max(0.0, b[i] - f * b[row]); // 丸め誤差で負にならないようにする
+        }
+        const double f = c[col];
+        for (int j = 0; j < n; ++j) {
+            c[j] -= f * R[j];
+        }
+        c[col] = -f * R[col];
+        z += f * b[row];
+
+        degenerate = (b[row] <= EPS) ? degenerate + 1 : 0;
+        std::swap(basic[row], nonbasic[col]);
+        ++sol.iterations;
+    }
+
+    sol.objective = z;
+    sol.x.assign(n, 0.0);
+    for (int i = 0; i < m; ++i) {
+        if (basic[i] < n) {
+            sol.x[basic[i]] = b[i];
+        }
+    }
+    // スラック変数の被約費用の符号を反転したものが双対変数
+    sol.duals.assign(m, 0.0);
+    for (int j = 0; j < n; ++j) {
+        if (nonbasic[j] >= n) {
+            sol.duals[nonbasic[j] - n] = -c[j];
+        }
+    }
+    return sol;
+}
+
+SparseMatrix SparseMatrix::from_rows(int num_cols, const std::vector<std::vector<std::pair<int, double>>>& rows) {
+    SparseMatrix M;
+    M.num_rows = static_cast<int>(rows.size());
+    M.num_cols = num_cols;
+    M.row_start.reserve(rows.size() + 1);
+    std::vector<std::pair<int, double>> r;
+    for (const auto& row : rows) {
+        r = row;
+        std::sort(r.begin(), r.end());
+        for (std::size_t k = 0; k < r.size();) {
+            const int j = r[k].first;
+            if (j < 0 || j >= num_cols) {
+                throw std::invalid_argument("SparseMatrix: column out of range");
+            }
+            double v = 0.0;
+            for (; k < r.size() && r[k].first == j; ++k) {
+                v += r[k].second;
+            }
+            if (v != 0.0) {
+                M.index.push_back(j);
+                M.value.push_back(v);
+            }
+        }
+        M.row_start.push_back(static_cast<int>(M.index.size()));
+    }
+    return M;
+}
+
+SparseMatrix SparseMatrix::transpose() const {
+    SparseMatrix M;
+    M.num_rows = num_cols;
+    M.num_cols = num_rows;
+    M.row_start.assign(num_cols + 1, 0);
+    for (int j : index) {
+        ++M.row_start[j + 1];
+    }
+    for (int j = 0; j < num_cols; ++j) {
+        M.row_start[j + 1] += M.row_start[j];
+    }
+    M.index.resize(index.size());
+    M.value.resize(value.size());
+    std::vector<int> fill(M.row_start.begin(), M.row_start.end() - 1);
+    for (int i = 0; i < num_rows; ++i) {
+        for (int k = row_start[i]; k < row_start[i + 1]; ++k) {
+            const int at = fill[index[k]]++;
+            M.index[at] = i;
+            M.value[at] = value[k];
+        }
+    }
+    return M;
+}
+
+MinCostLP::MinCostLP(SparseMatrix a, std::vector<double> c) : A(std::move(a)), cost(std::move(c)) {
+    if (static_cast<int>(cost.size()) != A.num_cols) {
+        throw std::invalid_argument("MinCostLP: size mismatch");
+    }
+    for (double v : cost) {
+        if (v < 0.0) {
+            throw std::invalid_argument("MinCostLP: negative cost");
+        }
+    }
+    At = A.transpose();
+}
+
+DualSimplex::DualSimplex(std::shared_ptr<const MinCostLP> lp)
+    : lp_(std::move(lp)), m_(lp_->A.num_rows), n_(lp_->A.num_cols) {
+    reset();
+}
+
+void DualSimplex::reset() {
+    head_.resize(m_);
+    pos_.assign(static_cast<std::size_t>(n_) + m_, -1);
+    binv_.assign(static_cast<std::size_t>(m_) * m_, 0.0);
+    for (int i = 0; i < m_; ++i) {
+        head_[i] = n_ + i;
+        pos_[n_ + i] = i;
+        binv_[static_cast<std::size_t>(i) * m_ + i] = -1.0; // スラック変数の列は -e_i
+    }
+    since_refactor_ = 0;
+}
+
+// 基底の列から逆行列を作り直す関数 (部分ピボット選択つきの Gauss-Jordan 法、特異な場合はスラック変数の基底に戻す)
+void DualSimplex::refactor() {
+    const std::size_t m = static_cast<std::size_t>(m_);
+    std::vector<double> B(m * m, 0.0);
+    for (int r = 0; r < m_; ++r) {
+        const int j = head_[r];
+        if (j >= n_) {
+            B[static_cast<std::size_t>(j - n_) * m + r] = -1.0;
+        } else {
+            for (int k = lp_->At.row_start[j]; k < lp_->At.row_start[j + 1]; ++k) {
+                B[static_cast<std::size_t>(lp_->At.index[k]) * m + r] = lp_->At.value[k];
+            }
+        }
+    }
+    std::vector<double>& inv = binv_;
+    inv.assign(m * m, 0.0);
+    for (std::size_t i = 0; i < m; ++i) {
+        inv[i * m + i] = 1.0;
+    }
+    for (std::size_t c = 0; c < m; ++c) {
+        std::size_t piv = c;
+        for (std::size_t i = c + 1; i < m; ++i) {
+            if (std::fabs(B[i * m + c]) > std::fabs(B[piv * m + c])) {
+                piv = i;
+            }
+        }
+        if (std::fabs(B[piv * m + c]) < 1e-12) {
+            reset();
+            return;
+        }
+        if (piv != c) {
+            for (std::size_t k = 0; k < m; ++k) {
+                std::swap(B[piv * m + k], B[c * m + k]);
+                std::swap(inv[piv * m + k], inv[c * m + k]);
+            }
+        }
+        const double p = B[c * m + c];
+        for (std::size_t k = 0; k < m; ++k) {
+            B[c * m + k] /= p;
+            inv[c * m + k] /= p;
+        }
+        for (std::size_t i = 0; i < m; ++i) {
+            const double f = B[i * m + c];
+            if (i == c || f == 0.0) {
+                continue;
+            }
+            for (std::size_t k = 0; k < m; ++k) {
+                B[i * m + k] -= f * B[c * m + k];
+                inv[i * m + k] -= f * inv[c * m + k];
+            }
+        }
+    }
+    since_refactor_ = 0;
+}
+
+// pi = c_B^T B^-1 から被約費用を求める関数
+void DualSimplex::compute_duals() {
+    const std::size_t m = static_cast<std::size_t>(m_);
+    std::vector<double> pi(m, 0.0);
+    for (int r = 0; r < m_; ++r) {
+        const int j = head_[r];
+        const double c = (j < n_) ? lp_->cost[j] : 0.0;
+        if (c == 0.0) {
+            continue;
+        }
+        for (std::size_t i = 0; i < m; ++i) {
+            pi[i] += c * binv_[r * m + i];
+        }
+    }
+    d_.assign(static_cast<std::size_t>(n_) + m_, 0.0);
+    for (int j = 0; j < n_; ++j) {
+        double v = lp_->cost[j];
+        for (int k = lp_->At.row_start[j]; k < lp_->At.row_start[j + 1]; ++k) {
+            v -= pi[lp_->At.index[k]] * lp_->At.value[k];
+        }
+        d_[j] = v;
+    }
+    for (int i = 0; i < m_; ++i) {
+        d_[n_ + i] = pi[i];
+    }
+    for (int r = 0; r < m_; ++r) {
+        d_[head_[r]] = 0.0;
+    }
+}
+
+LPSolution DualSimplex::solve(const std::vector<double>& b, int max_iterations) {
+    if (static_cast<int>(b.size()) != m_) {
+        throw std::invalid_argument("DualSimplex: size mismatch");
+    }
+    ++num_solves_;
+    const std::size_t m = static_cast<std::size_t>(m_);
+    const int total = n_ + m_;
+
+    // 基底変数の値と被約費用を求め直し、双対実行可能性が丸め誤差で崩れていればスラック変数の基底から始める
+    auto restart = [&]() {
+        xb_.assign(m, 0.0);
+        for (std::size_t r = 0; r < m; ++r) {
+            double v = 0.0;
+            for (std::size_t i = 0; i < m; ++i) {
+                v += binv_[r * m + i] * b[i];
+            }
+            xb_[r] = v;
+        }
+        compute_duals();
+        for (int j = 0; j < total; ++j) {
+            if (d_[j] < -DUAL_TOL) {
+                return false;
+            }
+        }
+        return true;
+    };
+    if (since_refactor_ >= REFACTOR_INTERVAL) {
+        refactor();
+    }
+    if (!restart()) {
+        reset();
+        restart();
+    }
+
+    LPSolution sol;
+    alpha_.resize(static_cast<std::size_t>(total));
+    col_.resize(m);
+    for (;;) {
+        // 出る行: 値が最も負の基底変数
+        int row = -1;
+        for (int r = 0; r < m_; ++r) {
+            if (xb_[r] < -EPS && (row < 0 || xb_[r] < xb_[row])) {
+                row = r;
+            }
+        }
+        if (row < 0) {
+            sol.status = LPStatus::Optimal;
+            break;
+        }
+        if (sol.iterations >= max_iterations) {
+            sol.status = LPStatus::IterationLimit;
+            break;
+        }
+
+        // 出る行の係数 alpha_j = (B^-1 の row 行目) * (列 j)
+        const double* rho = &binv_[static_cast<std::size_t>(row) * m];
+        std::fill(alpha_.begin(), alpha_.begin() + n_, 0.0);
+        for (int i = 0; i < m_; ++i) {
+            alpha_[n_ + i] = -rho[i];
+            if (rho[i] == 0.0) {
+                continue;
+            }
+            for (int k = lp_->A.row_start[i]; k < lp_->A.row_start[i + 1]; ++k) {
+                alpha_[lp_->A.index[k]] += rho[i] * lp_->A.value[k];
+            }
+        }
+
+        // 比の検定 (同じ比の場合は |alpha| が大きい方)
+        int q = -1;
+        double best = std::numeric_limits<double>::infinity();
+        for (int j = 0; j < total; ++j) {
+            if (pos_[j] >= 0 || alpha_[j] >= -EPS) {
+                continue;
+            }
+            const double ratio = std::max(0.0, d_[j]) / -alpha_[j];
+            if (ratio < best - EPS || (ratio <= best + EPS && q >= 0 && alpha_[j] < alpha_[q])) {
+                best = ratio;
+                q = j;
+            }
+        }
+        if (q < 0) {
+            sol.status = LPStatus::Infeasible;
+            break;
+        }
+
+        // 入る列 col = B^-1 a_q
+        if (q < n_) {
+            std::fill(col_.begin(), col_.end(), 0.0);
+            for (int k = lp_->At.row_start[q]; k < lp_->At.row_start[q + 1]; ++k) {
+                const std::size_t i = static_cast<std::size_t>(lp_->At.index[k]);
+                const double a = lp_->At.value[k];
+                for (std::size_t r = 0; r < m; ++r) {
+                    col_[r] += binv_[r * m + i] * a;
+                }
+            }
+        } else {
+            const std::size_t i = static_cast<std::size_t>(q - n_);
+            for (std::size_t r = 0; r < m; ++r) {
+                col_[r] = -binv_[r * m + i];
+            }
+        }
+        const double piv = col_[row];
+        if (std::fabs(piv) < EPS) { // 数値的に不安定なので、逆行列を作り直してやり直す
+            refactor();
+            if (!restart()) {
+                reset();
+                restart();
+            }
+            ++sol.iterations;
+            continue;
+        }
+
+        // 被約費用の更新
+        const double theta_d = d_[q] / alpha_[q];
+        for (int j = 0; j < total; ++j) {
+            if (pos_[j] < 0) {
+                d_[j] -= theta_d * alpha_[j];
+            }
+        }
+        const int leaving = head_[row];
+        d_[q] = 0.0;
+        d_[leaving] = -theta_d;
+
+        // 基底変数の値の更新
+        const double theta_p = xb_[row] / piv;
+        for (std::size_t r = 0; r < m; ++r) {
+            xb_[r] -= theta_p * col_[r];
+        }
+        xb_[row] = theta_p;
+
+        // 逆行列の更新
+        double* R = &binv_[static_cast<std::size_t>(row) * m];
+        for (std::size_t i = 0; i < m; ++i) {
+            R[i] /= piv;
+        }
+        for (std::size_t r = 0; r < m; ++r) {
+            const double f = col_[r];
+            if (r == static_cast<std::size_t>(row) || f == 0.0) {
+                continue;
+            }
+            double* Rr = &binv_[r * m];
+            for (std::size_t i = 0; i < m; ++i) {
+                Rr[i] -= f * R[i];
+            }
+        }
+
+        pos_[leaving] = -1;
+        pos_[q] = row;
+        head_[row] = q;
+        ++sol.iterations;
+        if (++since_refactor_ >= REFACTOR_INTERVAL) {
+            refactor();
+            if (!restart()) {
+                reset();
+                restart();
+            }
+        }
+    }
+    total_iterations_ += static_cast<uint64_t>(sol.iterations);
+
+    sol.x.assign(static_cast<std::size_t>(n_), 0.0);
+    double z = 0.0;
+    for (int r = 0; r < m_; ++r) {
+        if (head_[r] < n_) {
+            sol.x[head_[r]] = xb_[r];
+            z += lp_->cost[head_[r]] * xb_[r];
+        }
+    }
+    sol.duals.assign(m, 0.0);
+    for (int i = 0; i < m_; ++i) {
+        sol.duals[i] = d_[n_ + i];
+    }
+    sol.objective = (sol.status == LPStatus::Infeasible) ? std::numeric_limits<double>::infinity() : z;
+    return sol;
+}
+
+}} // namespace planner::sas
@@ -11,11 +11,23 @@
 #include <functional>
 #include <fstream>
 #include <cmath>
+#include <limits>
+#include <memory>
+#include <iterator>
+#include <utility>
 
 #include "sas/sas_reader.hpp"
 #include "sas/sas_search.hpp"
 #include "sas/bi_search.hpp"
 #include "sas/sas_heuristic.hpp"
+#include "sas/state_corpus.hpp"
+#include "sas/plan_cache.hpp"
+#include "sas/two_bit_bfs.hpp"
+#include "sas/multi_goal.hpp"
+#include "sas/subgoal_search.hpp"
+#include "sas/topk_search.hpp"
+#include "sas/distributed_hda.hpp"
+#include "arena.hpp"
 
 #include "sas/parallel_SOC/parallel_search.hpp"
 
@@ -49,35 +61,67 @@ int main(int argc, char** argv) {
     // 使い方
     // planner_from_pddl <domain.pddl> <problem.pddl>
     //   [--only-search]
-    //   [--algo astar|gbfs|soc_astar|bi_search]
+    //   [--algo astar|gbfs|soc_astar|bi_search|bfs2]
     //   [--search-cpu-limit int(second)]
     //   [--search-mem-limit-mb int(MB)]
     //   [--fd containers/fast-downward.sif]
     //   [--sas-file sas/output.sas]
-    //   [--h goalcount|blind|ff|lm]
+    //   [--h goalcount|blind|ff|hmax|lm|lm_ucp|lm_ocp|seq|pho|oc|pot|pot_samples|cg|cea|table]
     //   [--keep-sas]
     //   [--plan-out plans/plan.val]
     //   [--check-mutex auto|on|off]
+    //   [--bound C]
+    //   [--dense-max-states N]
+    //   [--state-storage full|delta]
+    //   [--checkpoint-every K]
+    //   [--arena-hugepages off|thp|explicit]
+    //   [--arena-dir DIR]
+    //   [--arena-reserve-mb N]
+    //   [--dist-out FILE]
+    //   [--dist-in FILE]
+    //   [--bfs-threads N]
     //   [--val /path/to/validate]
     //   [--val-args "-v"]
     //   [--soc-threads N]
     //   [--soc-open multi|bucket]
     //   [--soc-queues Q]
     //   [--soc-k K]
+    //   [--soc-weight W]
+    //   [--soc-bucket-delta D]
+    //   [--soc-buckets-window N]
+    //   [--soc-tie-break h|g|fifo]
+    //   [--soc-shard id|abstraction]
+    //   [--soc-shard-balance B]
+    //   [--record-states FILE]
+    //   [--record-max N]
+    //   [--plan-cache DIR]
+    //   [--plan-cache-max N]
     //   [--stop-on-first-meet on|off]
     if (argc < 3) {
         std::cerr <<
             "usage: planner_sas <domain.pddl> <problem.pddl>\n"
             "       [--only-search]\n"
-            "       [--algo astar|gbfs|soc_astar|bi_search]\n"
+            "       [--algo astar|gbfs|soc_astar|bi_search|bfs2|multi_goal|subgoal|topk|hda]\n"
             "       [--search-cpu-limit int(second)]\n"
             "       [--search-mem-limit-mb int(MB)]\n"
             "       [--fd   PATH_TO_SIF]\n"
             "       [--sas-file sas/output.sas]\n"
-            "       [--h goalcount|blind|ff|lm]\n"
+            "       [--h goalcount|blind|ff|hmax|lm|lm_ucp|lm_ocp|seq|pho|oc|pot|pot_samples|cg|cea|table]\n"
             "       [--keep-sas]\n"
             "       [--plan-out plans/plan.val]\n"
             "       [--check-mutex auto|on|off]\n"
+            "       [--bound C]            # search only for plans with cost < C\n"
+            "       [--dense-max-states N] # use a rank-indexed state table when the state space has <= N states (0: off)\n"
+            "       [--state-storage full|delta] # delta: store hash-table node states as diffs against their parent\n"
+            "       [--checkpoint-every K] # delta storage keeps a full state every K steps (default 16)\n"
+            "       [--arena-hugepages off|thp|explicit] # huge pages for large search arrays (default thp)\n"
+            "       [--arena-dir DIR]      # back large search arrays with files in DIR\n"
+            "       [--arena-reserve-mb N] # initial virtual address range reserved per search array (default 2, doubled as it grows)\n"
+            "       [--dist-in FILE]       # goal-distance table used by --h table\n"
+            "       [--record-states FILE] # sample states evaluated by the heuristic into a corpus for heuristic_bench\n"
+            "       [--record-max N]       # number of sampled states (default 10000)\n"
+            "       [--plan-cache DIR]     # reuse plans of identical tasks and settings across runs (astar|gbfs|bi_search|soc_astar|hda)\n"
+            "       [--plan-cache-max N]   # entries kept in the plan cache, least recently used are evicted (default 1000)\n"
             "       [--val PATH_TO_VAL]\n"
             "       [--val-args \"...\"]\n"
             "       # parallel search (soc_astar) options\n"
@@ -85,6 +129,26 @@ int main(int argc, char** argv) {
             "       [--soc-open multi|bucket]\n"
             "       [--soc-queues Q]\n"
             "       [--soc-k K]\n"
+            "       [--soc-weight W]       # priority g + W*h (W >= 1)\n"
+            "       [--soc-bucket-delta D] # nodes whose g + W*h fall in the same width-D interval share a bucket\n"
+            "       [--soc-buckets-window N] # buckets preallocated per shard (default 256)\n"
+            "       [--soc-tie-break h|g|fifo] # order inside a bucket: smaller h, larger g, or none\n"
+            "       [--soc-shard id|abstraction] # place nodes by node ID or by a Zobrist hash of a few slowly changing variables\n"
+            "       [--soc-shard-balance B] # abstraction: at least B abstract states per shard (larger: better balance, less locality)\n"
+            "       # state-space enumeration (bfs2) options\n"
+            "       [--bfs-threads N]\n"
+            "       [--dist-out FILE]      # save the goal-distance table (1 byte per state on top of the 2-bit array; distances capped at 254)\n"
+            "       # multi-goal search (multi_goal) options\n"
+            "       [--goals FILE]         # one goal per line: var=val var=val ... (plans go to <plan-out>.<i>)\n"
+            "       # landmark subgoal search (subgoal) options\n"
+            "       [--subgoal-expansions N] # expansion limit per subproblem before it is skipped (default 100000)\n"
+            "       # top-k search (topk) options\n"
+            "       [--k K]                # number of plans (plans go to <plan-out>.<i>)\n"
+            "       [--diverse D]          # only keep plans whose operator-set Jaccard distance to every kept plan is >= D\n"
+            "       # multi-process HDA* (hda) options\n"
+            "       [--hda-procs N]        # number of processes including this one (default 2)\n"
+            "       [--hda-transport unix|tcp]\n"
+            "       [--hda-port P]         # tcp: process r listens on 127.0.0.1:P+r (0: ephemeral ports)\n"
             "       # bidirectional search (bi_search) options\n"
             "       [--stop-on-first-meet on|off]\n";
         return 1;
@@ -103,6 +167,24 @@ int main(int argc, char** argv) {
     int mutex_mode = planner::sas::MUTEX_AUTO;
     std::string val_bin;
     std::string val_args;
+    double cost_bound = std::numeric_limits<double>::infinity(); // コスト上界 (inf の場合は上界なし)
+    long long dense_max_states = -1; // 密な状態表を使う状態数の上限 (負の場合は既定値)
+    std::string state_storage = "full"; // ノードの状態の保持方法
+    int checkpoint_every = 16; // delta の場合のチェックポイントの間隔
+    planner::ArenaOptions arena_opt; // 探索用の大きな配列を置くアリーナの設定
+    std::string dist_in; // --h table で読み込むゴール距離表
+    std::string dist_out; // bfs2 で作成したゴール距離表の保存先
+    std::string goals_file; // multi_goal で用いるゴール条件の一覧
+    planner::sas::SubgoalParams subgoal; // subgoal の部分問題の設定
+    planner::sas::TopKParams topk; // topk で求めるプランの数と多様性
+    planner::sas::HdaParams hda; // hda のプロセス数と接続方法
+    std::string record_states; // 評価した状態の標本の保存先
+    std::size_t record_max = 10000; // 標本として残す状態の数
+    std::string plan_cache_dir; // プランのキャッシュのディレクトリ
+    std::size_t plan_cache_max = 1000; // キャッシュに残す項目の数
+
+    // bfs2 options
+    int bfs_threads = 0; // 0 の場合、hardware_concurrency() を利用する
 
     // cpu-time & memory audit
     double opt_search_cpu_limit_sec = -1.0; // CPU 時間上限 (negative means invalid)
@@ -113,6 +195,12 @@ int main(int argc, char** argv) {
     std::string soc_open = "bucket";
     int soc_queues = 0; // 0 の場合、スレッド数と同数のキューを用いる
     int soc_k = 2;
+    float soc_weight = 1.0f; // f = g + w·h の w
+    float soc_bucket_delta = 1.0f; // バケットの幅
+    uint32_t soc_buckets_window = 256; // あらかじめ確保するバケットの数
+    planner::sas::parallel_SOC::TieBreak soc_tie_break = planner::sas::parallel_SOC::TieBreak::HThenG;
+    std::string soc_shard = "id"; // シャードの割り当て方法
+    uint32_t soc_shard_balance = 16; // abstraction の場合の、シャードあたりの抽象状態の数の下限
 
     // bidirectional search options
     std::string stop_on_first_meet = "on";
@@ -151,6 +239,68 @@ int main(int argc, char** argv) {
             } else {
                 std::cerr << "warning: unknown --check-mutex value: " << m << " (use auto|on|off)\n";
             }
+        } else if (a == "--bound" && i+1 < argc) {
+            cost_bound = std::stod(argv[++i]);
+        } else if (a == "--dense-max-states" && i+1 < argc) {
+            dense_max_states = std::stoll(argv[++i]);
+        } else if (a == "--state-storage" && i+1 < argc) {
+            state_storage = argv[++i];
+            if (state_storage != "full" && state_storage != "delta") {
+                std::cerr << "warning: --state-storage must be full|delta (got " << state_storage << "), using full\n";
+                state_storage = "full";
+            }
+        } else if (a == "--checkpoint-every" && i+1 < argc) {
+            checkpoint_every = std::stoi(argv[++i]);
+        } else if (a == "--arena-hugepages" && i+1 < argc) {
+            std::string m = argv[++i];
+            if (m == "off") {
+                arena_opt.huge_pages = planner::ArenaOptions::HugePages::Off;
+            } else if (m == "thp") {
+                arena_opt.huge_pages = planner::ArenaOptions::HugePages::Transparent;
+            } else if (m == "explicit") {
+                arena_opt.huge_pages = planner::ArenaOptions::HugePages::Explicit;
+            } else {
+                std::cerr << "warning: unknown --arena-hugepages value: " << m << " (use off|thp|explicit)\n";
+            }
+        } else if (a == "--arena-dir" && i+1 < argc) {
+            arena_opt.backing_dir = argv[++i];
+        } else if (a == "--arena-reserve-mb" && i+1 < argc) {
+            arena_opt.initial_reserve = static_cast<std::size_t>(std::stoull(argv[++i])) << 20;
+        } else if (a == "--dist-in" && i+1 < argc) {
+            dist_in = argv[++i];
+        } else if (a == "--dist-out" && i+1 < argc) {
+            dist_out = argv[++i];
+        } else if (a == "--subgoal-expansions" && i+1 < argc) {
+            subgoal.max_sub_expansions = static_cast<uint64_t>(std::stoull(argv[++i]));
+        } else if (a == "--k" && i+1 < argc) {
+            topk.k = static_cast<std::size_t>(std::stoull(argv[++i]));
+        } else if (a == "--diverse" && i+1 < argc) {
+            topk.diversity = std::stod(argv[++i]);
+        } else if (a == "--hda-procs" && i+1 < argc) {
+            hda.num_procs = std::stoi(argv[++i]);
+        } else if (a == "--hda-transport" && i+1 < argc) {
+            const std::string t = argv[++i];
+            if (t == "unix") {
+                hda.transport = planner::sas::HdaTransport::Unix;
+            } else if (t == "tcp") {
+                hda.transport = planner::sas::HdaTransport::Tcp;
+            } else {
+                std::cerr << "warning: --hda-transport must be unix|tcp (got " << t << "), using unix\n";
+            }
+        } else if (a == "--hda-port" && i+1 < argc) {
+            hda.tcp_port = std::stoi(argv[++i]);
+        } else if (a == "--record-states" && i+1 < argc) {
+            record_states = argv[++i];
+        } else if (a == "--record-max" && i+1 < argc) {
+            record_max = static_cast<std::size_t>(std::stoull(argv[++i]));
+        } else if (a == "--plan-cache" && i+1 < argc) {
+            plan_cache_dir = argv[++i];
+        } else if (a == "--plan-cache-max" && i+1 < argc) {
+            plan_cache_max = static_cast<std::size_t>(std::stoull(argv[++i]));
+        } else if (a == "--goals" && i+1 < argc) {
+            goals_file = argv[++i];
+        } else if (a == "--bfs-threads" && i+1 < argc) {
+            bfs_threads = std::stoi(argv[++i]);
         } else if (a == "--val" && i+1 < argc) {
             val_bin = argv[++i];
         } else if (a == "--val-args" && i+1 < argc) {
@@ -171,6 +321,31 @@ int main(int argc, char** argv) {
             soc_queues = std::stoi(argv[++i]);
         } else if (a == "--soc-k" && i+1 < argc) {
             soc_k = std::stoi(argv[++i]);
+        } else if (a == "--soc-weight" && i+1 < argc) {
+            soc_weight = std::stof(argv[++i]);
+        } else if (a == "--soc-bucket-delta" && i+1 < argc) {
+            soc_bucket_delta = std::stof(argv[++i]);
+        } else if (a == "--soc-buckets-window" && i+1 < argc) {
+            soc_buckets_window = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (a == "--soc-shard" && i+1 < argc) {
+            soc_shard = argv[++i];
+            if (soc_shard != "id" && soc_shard != "abstraction") {
+                std::cerr << "warning: --soc-shard must be id|abstraction (got " << soc_shard << "), using id\n";
+                soc_shard = "id";
+            }
+        } else if (a == "--soc-shard-balance" && i+1 < argc) {
+            soc_shard_balance = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (a == "--soc-tie-break" && i+1 < argc) {
+            const std::string t = argv[++i];
+            if (t == "h") {
+                soc_tie_break = planner::sas::parallel_SOC::TieBreak::HThenG;
+            } else if (t == "g") {
+                soc_tie_break = planner::sas::parallel_SOC::TieBreak::GThenH;
+            } else if (t == "fifo") {
+                soc_tie_break = planner::sas::parallel_SOC::TieBreak::FIFO;
+            } else {
+                std::cerr << "warning: --soc-tie-break must be h|g|fifo (got " << t << "), using h\n";
+            }
         } else if (a == "--stop-on-first-meet" && i+1 < argc) {
             stop_on_first_meet = argv[++i];
         } else {
@@ -232,7 +407,12 @@ int main(int argc, char** argv) {
         }
 
         // SAS読込 → A*/GBFS
+        const auto t_read_begin = clock::now();
         planner::sas::Task T = planner::sas::read_file(sas_path);
+        {
+            const auto rd_s = std::chrono::duration<double>(clock::now() - t_read_begin).count();
+            std::cout << std::fixed << std::setprecision(3) << "Read Time: " << rd_s << " s\n";
+        }
 
         // タスクのチェックを行う
         {
@@ -286,18 +466,73 @@ int main(int argc, char** argv) {
         } else {
             P.stop_on_first_meet = false;
         }
+        P.cost_bound = cost_bound;
+        if (dense_max_states >= 0) {
+            P.dense_max_states = static_cast<uint64_t>(dense_max_states);
+        }
+        P.state_storage = (state_storage == "delta") ? planner::sas::StateStorage::Delta : planner::sas::StateStorage::Full;
+        P.checkpoint_interval = std::max(1, checkpoint_every);
+        planner::arena_options() = arena_opt;
 
-        bool h_is_integer = true;
+        // コストが整数のタスクでは、全てのヒューリスティックが整数を返す (LP に基づくものは切り上げる)
+        // コストが整数でないタスクでは、探索エンジンの側で実数の探索に切り替える
+        const bool h_is_integer = true;
+
+        // 許容的なヒューリスティック (上界未満のプランがないことの証明と、最適なプランのキャッシュに用いる)
+        const bool h_admissible = planner::sas::heuristic_is_admissible(hname);
+
+        // ゴール距離表をヒューリスティックとして用いる場合は、探索の前に読み込む
+        planner::sas::HeuristicFn h_table;
+        if (hname == "table") {
+            if (dist_in.empty()) {
+                throw std::runtime_error("--h table requires --dist-in FILE");
+            }
+            h_table = planner::sas::distance_table_heuristic(planner::sas::GoalDistanceTable::load(T, dist_in));
+        }
 
         {
             using namespace planner::sas;
             g_mutex_mode = mutex_mode;
         }
 
+        // --record-states の場合、ヒューリスティックを包んで評価した状態を標本として残す (astar, gbfs, bi_search, topk)
+        std::unique_ptr<planner::sas::StateRecorder> recorder;
+        if (!record_states.empty()) {
+            recorder = std::make_unique<planner::sas::StateRecorder>(record_max);
+        }
+        auto record = [&](planner::sas::HeuristicFn h) {
+            return recorder ? recorder->wrap(std::move(h)) : h;
+        };
+
+        // --h の名前からヒューリスティックを作る関数 (全ての探索エンジンで共有する)
+        // async の場合は前計算を別のスレッドで始め、探索の準備と重ねる (最初の評価で完成を待つ)
+        auto make_h = [&](const bool async) {
+            if (hname == "table") {
+                return h_table;
+            }
+            return async ? planner::sas::make_heuristic_async(hname, T) : planner::sas::make_heuristic(hname, T);
+        };
+
+        // ゴールや初期状態を差し替えたタスクごとにヒューリスティックを作る関数 (multi_goal, subgoal、blind の場合は空)
+        auto heuristic_factory = [&hname](const std::string& algo_name) {
+            planner::sas::HeuristicFactory make_factory;
+            if (hname == "table") {
+                throw std::runtime_error(hname + " is not supported by " + algo_name + ".");
+            } else if (hname != "blind") {
+                make_factory = [name = hname](const planner::sas::Task& G) { return planner::sas::make_heuristic(name, G); };
+            }
+            return make_factory;
+        };
+
         planner::sas::Result R;
+        planner::sas::MultiGoalResult MG; // multi_goal の結果
+        planner::sas::TopKResult TK; // topk の結果
         bool solved = false; // 探索して解を発見できたかどうか
+        bool bound_exhausted = false; // 上界未満の探索空間を網羅したかどうか (h が許容的な場合のみ、プランが存在しないことの証明になる)
+        bool soc_proved_optimal = false; // soc_astar の下界がプランのコストに達し、最適性を示せたかどうか
         std::vector<uint32_t> plan_ops_out; // 出力プラン
         int plan_cost_out = -1; // 出力プランにおけるコスト
+        bool timed_out = false; // CPU 時間の制限により探索を打ち切ったかどうか
 
         // メモリ制限
     #if defined(__linux__)
@@ -323,111 +558,155 @@ int main(int argc, char** argv) {
         planner::sas::g_cpu_budget_enabled = true;
         planner::sas::set_search_cpu_budget(opt_search_cpu_limit_sec);
 
-        const auto t_search_begin = clock::now();
+        // 同じタスクと設定のプランがキャッシュにあれば、検証した上で探索せずに用いる
+        // 最適性が示されたプランは、上界を満たす限り設定によらず用いる
+        std::unique_ptr<planner::sas::PlanCache> plan_cache;
+        std::string cache_config;
+        bool cache_hit = false;
+        const bool cacheable = (algo == "astar" || algo == "gbfs" || algo == "bi_search" || algo == "soc_astar" || algo == "hda");
+        if (!plan_cache_dir.empty() && cacheable) {
+            std::ostringstream cfg;
+            cfg << std::setprecision(17); // 上界や重みが丸めで同じ文字列にならないよう、double を区別できる桁数で書く
+            cfg << "algo=" << algo << " h=" << hname << " bound=" << cost_bound;
+            if (algo == "soc_astar") {
+                // 重み、バケットの幅、タイブレーク、シャードの割り当てによって、見つかるプランが変わる
+                using planner::sas::parallel_SOC::TieBreak;
+                cfg << " w=" << soc_weight << " delta=" << soc_bucket_delta << " tie="
+                    << (soc_tie_break == TieBreak::HThenG ? "h" : soc_tie_break == TieBreak::GThenH ? "g" : "fifo")
+                    << " shard=" << soc_shard;
+                if (soc_shard == "abstraction") {
+                    cfg << " balance=" << soc_shard_balance;
+                }
+            } else if (algo == "bi_search") {
+                cfg << " first_meet=" << stop_on_first_meet;
+            }
+            cache_config = cfg.str();
+            plan_cache = std::make_unique<planner::sas::PlanCache>(plan_cache_dir, plan_cache_max);
 
-        if (algo == "astar") {
-            if (hname == "goalcount") {
-                R = planner::sas::astar(T, planner::sas::goalcount(), h_is_integer, P);
-            } else if (hname == "blind") {
-                R = planner::sas::astar(T, planner::sas::blind(), h_is_integer, P);
-            } else if (hname == "ff") {
-                R = planner::sas::astar(T, planner::sas::hff(T), h_is_integer, P);
-            } else if (hname == "lm") {
-                // std::cout << "using landmark heuristic" << "\n"; // デバッグ用
-                R = planner::sas::astar(T, planner::sas::hlm(T), h_is_integer, P);
-            } else {
-                throw std::runtime_error(hname + std::string(" is not defined."));
+            const auto t_cache_begin = clock::now();
+            auto hit = plan_cache->lookup(T, cache_config);
+            if (!hit) {
+                hit = plan_cache->lookup(T, "optimal");
+            }
+            if (hit && !(hit->cost < cost_bound)) {
+                hit.reset(); // 上界を満たさないプランは、どちらの鍵で引いたものでも用いない
             }
+            if (hit) {
+                cache_hit = true;
+                solved = true;
+                plan_ops_out = hit->plan;
+                plan_cost_out = static_cast<int>(std::lround(hit->cost));
+                const auto us = std::chrono::duration<double, std::micro>(clock::now() - t_cache_begin).count();
+                std::cout << "[CACHE] hit (" << (hit->optimal ? "optimal" : "not proven optimal") << ", cost " << hit->cost
+                          << ") in " << us << " us\n";
+            }
+        }
+
+        const auto t_search_begin = clock::now();
+
+        if (cache_hit) {
+            // キャッシュのプランを用いるので探索しない
+        } else if (algo == "astar") {
+            R = planner::sas::astar(T, record(make_h(true)), h_is_integer, P);
             
             solved = R.solved;
+            bound_exhausted = R.bound_exhausted;
+            timed_out = (R.stop == planner::sas::StopReason::Timeout);
             if (solved) {
                 plan_ops_out = R.plan;
                 plan_cost_out = static_cast<int>(std::lround(planner::sas::eval_plan_cost(T, R.plan)));
             }
 
         } else if (algo == "gbfs") {
-            if (hname == "goalcount") {
-                R = planner::sas::gbfs(T, planner::sas::goalcount(), h_is_integer, P);
-            } else if (hname == "blind") {
-                R = planner::sas::gbfs(T, planner::sas::blind(), h_is_integer, P);
-            } else if (hname == "ff") {
-                R = planner::sas::gbfs(T, planner::sas::hff(T), h_is_integer, P);
-            } else if (hname == "lm") {
-                R = planner::sas::gbfs(T, planner::sas::hlm(T), h_is_integer, P);
+            if (hname == "hmax" && !recorder) {
+                // 状態を記録しない場合は、展開ごとの後続状態をビットスライスでまとめて評価する
+                R = planner::sas::gbfs_batched(T, planner::sas::hmax_batched(T), h_is_integer, P);
             } else {
-                throw std::runtime_error(hname + std::string(" is not defined."));
+                R = planner::sas::gbfs(T, record(make_h(true)), h_is_integer, P);
             }
 
             solved = R.solved;
+            bound_exhausted = R.bound_exhausted;
+            timed_out = (R.stop == planner::sas::StopReason::Timeout);
             if (solved) {
                 plan_ops_out = R.plan;
                 plan_cost_out = static_cast<int>(std::lround(planner::sas::eval_plan_cost(T, R.plan)));
             }
 
         } else if (algo == "bi_search") {
-            if (hname == "goalcount") {
-                R = planner::sas::bidir_astar(T, planner::sas::goalcount(), h_is_integer, P);
-            } else if (hname == "blind") {
-                R = planner::sas::bidir_astar(T, planner::sas::blind(), h_is_integer, P);
-            } else if (hname == "ff") {
-                R = planner::sas::bidir_astar(T, planner::sas::hff(T), h_is_integer, P);
-            } else if (hname == "lm") {
-                R = planner::sas::bidir_astar(T, planner::sas::hlm(T), h_is_integer, P);
-            } else {
-                throw std::runtime_error(hname + std::string(" is not defined."));
-            }
+            R = planner::sas::bidir_astar(T, record(make_h(true)), h_is_integer, P);
 
             solved = R.solved;
+            bound_exhausted = R.bound_exhausted;
+            timed_out = (R.stop == planner::sas::StopReason::Timeout);
             if (solved) {
                 plan_ops_out = R.plan;
                 plan_cost_out = static_cast<int>(std::lround(planner::sas::eval_plan_cost(T, R.plan)));
             }
 
         } else if (algo == "soc_astar") {
-            using planner::sas::parallel_SOC::SearchParams;
-            using planner::sas::parallel_SOC::SharedOpen;
+            using planner::sas::parallel_SOC::Params;
+            using planner::sas::parallel_SOC::QueueKind;
             using planner::sas::soc::GlobalStats;
 
-            SearchParams sp;
+            Params sp;
 
-            // ヒューリスティック関数の調整
-            if (hname == "blind") {
-                sp.heuristic_kind = 0;
-                std::cout << "using blind heuristic" << "\n";
-            } else if (hname == "goalcount") {
-                sp.heuristic_kind = 1;
-                std::cout << "using goalcount heuristic" << "\n";
-            } else if (hname == "ff") {
-                sp.heuristic_kind = 2;
-                std::cout << "using ff heuristic" << "\n";
-            } else if (hname == "lm") {
-                sp.heuristic_kind = 3;
-                std::cout << "using landmark heuristic" << "\n";
+            // ヒューリスティック関数の調整 (並列探索は専用の実装を heuristic_kind で選ぶので、make_h は用いない)
+            static const std::pair<const char*, uint32_t> soc_kinds[] = {
+                {"blind", 0}, {"goalcount", 1}, {"ff", 2}, {"lm", 3}, {"hmax", 4}, {"pot", 5}, {"pot_samples", 6},
+            };
+            std::string soc_hname = "goalcount"; // 未対応の名前は goalcount で探索する
+            const auto kind_it = std::find_if(std::begin(soc_kinds), std::end(soc_kinds),
+                                              [&hname](const auto& k) { return hname == k.first; });
+            if (kind_it != std::end(soc_kinds)) {
+                soc_hname = hname;
+                sp.heuristic_kind = kind_it->second;
             } else {
                 std::cerr << "not defined heuristic name" << "\n";
+                sp.heuristic_kind = 1;
             }
+            std::cout << "using " << soc_hname << " heuristic" << "\n";
 
             // スレッド数の調整 (負ならば、使用しているハードウェアのスレッド数に合わせる)
             sp.num_threads = (soc_threads > 0) ? (uint32_t)soc_threads : std::max(1u, std::thread::hardware_concurrency());
 
             // オープンリストの種類の調整
-            sp.open_kind = (soc_open == "multi") ? SharedOpen::Kind::MultiQueue : SharedOpen::Kind::TwoLevelBucket;
+            sp.queue_kind = (soc_open == "multi") ? QueueKind::MultiQueue : QueueKind::BucketPQ;
 
             // キューの数の調整
             sp.num_queues = (soc_queues > 0) ? (uint32_t)soc_queues : sp.num_threads;
 
             // ランダム k-choice の調整
-            sp.num_k_select = (soc_k > 0) ? (uint32_t)soc_queues : 2;
+            sp.bucket_select_k = (soc_k > 0) ? (uint32_t)soc_k : 2;
+
+            // 重み付きの f-value とバケットの幅
+            sp.weight = soc_weight;
+            sp.bucket_delta = soc_bucket_delta;
+            sp.buckets_window = soc_buckets_window;
+            sp.tie_break = soc_tie_break;
+
+            // シャードの割り当て
+            sp.shard_mode = (soc_shard == "abstraction") ? planner::sas::parallel_SOC::ShardMode::Abstraction
+                                                         : planner::sas::parallel_SOC::ShardMode::NodeId;
+            sp.shard_balance = soc_shard_balance;
 
             // CPU リミットの調整 (ただし、並列探索の time_limit_ms に合うように 1000 を掛ける)
             sp.time_limit_ms = (opt_search_cpu_limit_sec > 0) ? (int)std::llround(opt_search_cpu_limit_sec * 1000.0) : -1;
 
+            // コスト上界
+            sp.cost_bound = cost_bound;
+
             GlobalStats GS; // 統計保存用の struct
 
             // 実際の探索の箇所
             auto RS = planner::sas::parallel_SOC::astar_soc(T, sp, &GS);
 
             solved = RS.solved;
+            bound_exhausted = RS.bound_exhausted;
+            // 重みやバケットの幅、スレッド間の競合によらず、許容的な h で下界がコストに達した場合のみ最適性が示される
+            // (未対応の名前は goalcount で探索するので、実際に用いたヒューリスティックで判定する)
+            const bool soc_h_admissible = planner::sas::heuristic_is_admissible(soc_hname);
+            soc_proved_optimal = solved && soc_h_admissible && RS.lower_bound >= RS.cost;
             if (solved) {
                 plan_ops_out = RS.plan_ops; 
                 plan_cost_out = RS.cost; 
@@ -437,17 +716,31 @@ int main(int argc, char** argv) {
             auto total = GS.sum();
             std::cout << "===SOC===" << "\n";
             std::cout << "Threads: " << sp.num_threads << "\n";
-            std::cout << " Open=" << (sp.open_kind==SharedOpen::Kind::TwoLevelBucket?"TwoLevelBucket":"MultiQueue") << "\n";
+            std::cout << " Open=" << (sp.queue_kind==QueueKind::BucketPQ?"TwoLevelBucket":"MultiQueue") << "\n";
             std::cout << " Queues/Shards: " << sp.num_queues << "\n";
             std::cout << "k: " << soc_k << "\n";
+            std::cout << "Weight: " << soc_weight << ", bucket delta: " << soc_bucket_delta << "\n";
+            if (solved) {
+                // 下界は h が許容的な場合のみ意味を持つ
+                std::cout << "Lower bound: " << RS.lower_bound << "\n";
+                if (RS.lower_bound > 0) {
+                    std::cout << "Suboptimality bound: " << (RS.cost / RS.lower_bound) << "\n";
+                }
+            }
             std::cout << "Expanded: " << total.expanded << "\n";
             std::cout << "Generated: " << total.generated << "\n";
             std::cout << "Evaluated: " << total.evaluated << "\n";
             std::cout << "Reopened: " << total.reopened << "\n";
             std::cout << "Pruned: " << total.duplicates_pruned << "\n";
+            if (std::isfinite(cost_bound)) {
+                std::cout << "Pruned by bound: " << total.pruned_by_bound << "\n";
+            }
             std::cout << "Pushes: " << total.pushes << "\n";
             std::cout << "Pops: " << total.pops << "\n";
             std::cout << "Steals: " << total.steals << "\n";
+            std::cout << "Remote pushes: " << total.remote_pushes << " ("
+                      << (total.expanded ? static_cast<double>(total.remote_pushes) / static_cast<double>(total.expanded) : 0.0)
+                      << " per expansion)\n";
             std::cout << "Bucket empty probes: " << total.bucket_pop_empty_probes << "\n";
             {
                 using namespace std::chrono;
@@ -477,12 +770,122 @@ int main(int argc, char** argv) {
                 std::cout << "Max open size: "  << GS.per_thread[i].max_open_size_seen << "\n";
                 std::cout << "\n";
             }
+        } else if (algo == "multi_goal") {
+            if (goals_file.empty()) {
+                throw std::runtime_error("--algo multi_goal requires --goals FILE");
+            }
+            const auto goals = planner::sas::read_goals_file(T, goals_file);
+
+            MG = planner::sas::multi_goal_search(T, goals, heuristic_factory("multi_goal"), P);
+            R.stats = MG.stats;
+            R.stop = MG.stop;
+            timed_out = (MG.stop == planner::sas::StopReason::Timeout);
+            solved = !goals.empty() && MG.num_solved() == goals.size();
+            bound_exhausted = MG.bound_exhausted;
+
+        } else if (algo == "subgoal") {
+            const auto SG = planner::sas::subgoal_search(T, heuristic_factory("subgoal"), h_is_integer, subgoal, P);
+            R = SG.result;
+            std::cout << "Landmarks: " << SG.num_landmarks << ", subgoals solved: " << SG.subgoals_solved
+                      << ", skipped: " << SG.subgoals_failed << ", backtracks: " << SG.backtracks
+                      << (SG.fell_back ? " (fell back to gbfs)" : "") << "\n";
+
+            solved = R.solved;
+            timed_out = (R.stop == planner::sas::StopReason::Timeout);
+            if (solved) {
+                plan_ops_out = R.plan;
+                plan_cost_out = static_cast<int>(std::lround(planner::sas::eval_plan_cost(T, R.plan)));
+            }
+
+        } else if (algo == "topk") {
+            TK = planner::sas::topk_search(T, record(make_h(true)), topk, P);
+            R.stats = TK.stats;
+            R.stop = TK.stop;
+            timed_out = (TK.stop == planner::sas::StopReason::Timeout);
+            solved = !TK.plans.empty();
+            bound_exhausted = TK.exhausted && std::isfinite(cost_bound);
+
+        } else if (algo == "hda") {
+            const planner::sas::HdaResult H = planner::sas::distributed_astar(T, make_h(false), hda, P);
+            R = H.result;
+            solved = R.solved;
+            bound_exhausted = R.bound_exhausted;
+            timed_out = (R.stop == planner::sas::StopReason::Timeout);
+            if (solved) {
+                plan_ops_out = R.plan;
+                plan_cost_out = static_cast<int>(std::lround(planner::sas::eval_plan_cost(T, R.plan)));
+            }
+            for (std::size_t r = 0; r < H.per_proc.size(); ++r) {
+                std::cout << "[HDA " << r << "] expanded " << H.per_proc[r].expanded
+                          << ", generated " << H.per_proc[r].generated << "\n";
+            }
+            std::cout << "[HDA] messages " << H.messages << ", bytes " << H.bytes << "\n";
+
+        } else if (algo == "bfs2") {
+            planner::sas::Bfs2Params bp;
+            bp.num_threads = (bfs_threads > 0) ? static_cast<uint32_t>(bfs_threads) : 0;
+            if (dense_max_states > 0) {
+                bp.max_states = static_cast<uint64_t>(dense_max_states);
+            }
+
+            auto B = planner::sas::two_bit_bfs(T, bp);
+            if (!B.fits) {
+                throw std::runtime_error("state space is too large for bfs2");
+            }
+            timed_out = B.timed_out;
+
+            if (!timed_out) { // 統計値の表示
+                std::cout << "===BFS2===" << "\n";
+                std::cout << "States: " << B.num_states << "\n";
+                std::cout << "Reachable: " << B.reachable << "\n";
+                std::cout << "Goal states: " << B.goal_states << "\n";
+                std::cout << "Layers:";
+                for (auto n : B.layer_sizes) {
+                    std::cout << " " << n;
+                }
+                std::cout << "\n";
+                std::cout << "Init goal distance: " << B.init_distance << "\n";
+                if (B.table->truncated()) {
+                    std::cout << "Distances truncated at " << static_cast<int>(planner::sas::GoalDistanceTable::MAX_DIST) << "\n";
+                }
+                std::cout << "\n";
+
+                if (!dist_out.empty()) {
+                    B.table->save(dist_out);
+                    std::cout << "[DIST] wrote: " << dist_out << "\n";
+                }
+
+                solved = (B.init_distance >= 0) && (B.plan.size() == static_cast<std::size_t>(B.init_distance));
+                if (solved) {
+                    plan_ops_out = B.plan;
+                    plan_cost_out = static_cast<int>(std::lround(planner::sas::eval_plan_cost(T, B.plan)));
+                }
+            }
+
         } else {
             throw std::runtime_error(algo + std::string(" is not defined."));
         }
 
         const auto t_search_end = clock::now();
 
+        if (plan_cache && !cache_hit && solved) {
+            // 許容的なヒューリスティックで、最適性を保つ探索をした場合か、探索が最適性を示した場合のみ最適として残す
+            const bool optimal = (h_admissible && (algo == "astar" || algo == "hda")) ||
+                (algo == "soc_astar" && soc_proved_optimal);
+            const planner::sas::CachedPlan cp{plan_ops_out, planner::sas::eval_plan_cost(T, plan_ops_out), optimal};
+            plan_cache->store(T, cache_config, cp);
+            if (optimal) {
+                plan_cache->store(T, "optimal", cp);
+            }
+            std::cout << "[CACHE] stored (" << plan_cache->size() << " / " << plan_cache->max_entries() << " entries)\n";
+        }
+
+        if (recorder) {
+            recorder->write(record_states, T, hname);
+            std::cout << "[CORPUS] wrote " << recorder->size() << " of " << recorder->seen()
+                      << " evaluated states: " << record_states << "\n";
+        }
+
         // CPU バジェットの解除
         planner::sas::set_search_cpu_budget(-1.0);
 
@@ -498,15 +901,74 @@ int main(int argc, char** argv) {
         }
     #endif
 
-        if (solved) {
+        if (timed_out) {
+            std::cerr << "error: CPU time limit exceeded (" << opt_search_cpu_limit_sec << " sec)\n";
+            return 101;
+        }
+
+        if (algo == "multi_goal") {
+            std::cout << "Goals solved: " << MG.num_solved() << " / " << MG.goals.size() << "\n";
+            std::cout << "Expanded: " << MG.stats.expanded << " state(s)" << "\n";
+            std::cout << "Generated: " << MG.stats.generated << " state(s)" << "\n";
+            std::cout << "Evaluated: " << MG.stats.evaluated << " state(s)" << "\n";
+            for (std::size_t i = 0; i < MG.goals.size(); ++i) {
+                const auto& gp = MG.goals[i];
+                if (!gp.solved) {
+                    std::cout << "[GOAL " << i << "] " << (MG.bound_exhausted && h_admissible ? "no plan under the bound" : "no plan") << "\n";
+                    continue;
+                }
+                std::cout << "[GOAL " << i << "] cost " << gp.plan_cost << ", length " << gp.plan.size()
+                          << ", found after " << gp.expanded_at << " expansion(s)\n";
+                const std::string plan_txt = planner::sas::plan_to_val(T, gp.plan);
+                if (!plan_out.empty()) {
+                    const std::string path = plan_out + "." + std::to_string(i);
+                    std::ofstream ofs(path, std::ios::binary);
+                    ofs << plan_txt;
+                    if (!ofs) {
+                        throw std::runtime_error("failed to write plan file: " + path);
+                    }
+                } else {
+                    std::cout << plan_txt << std::endl;
+                }
+            }
+            if (!plan_out.empty() && MG.num_solved() > 0) {
+                std::cout << "[PLAN] wrote: " << plan_out << ".<goal index>\n";
+            }
+        } else if (algo == "topk") {
+            std::cout << "Plans found: " << TK.plans.size() << " / " << topk.k
+                      << (TK.exhausted && TK.plans.size() < topk.k ? " (no more plans exist)" : "") << "\n";
+            std::cout << "Expanded: " << TK.stats.expanded << " state(s)" << "\n";
+            std::cout << "Generated: " << TK.stats.generated << " state(s)" << "\n";
+            std::cout << "Evaluated: " << TK.stats.evaluated << " state(s)" << "\n";
+            for (std::size_t i = 0; i < TK.plans.size(); ++i) {
+                std::cout << "[PLAN " << i << "] cost " << TK.costs[i] << ", length " << TK.plans[i].size() << "\n";
+                const std::string plan_txt = planner::sas::plan_to_val(T, TK.plans[i]);
+                if (!plan_out.empty()) {
+                    const std::string path = plan_out + "." + std::to_string(i);
+                    std::ofstream ofs(path, std::ios::binary);
+                    ofs << plan_txt;
+                    if (!ofs) {
+                        throw std::runtime_error("failed to write plan file: " + path);
+                    }
+                } else {
+                    std::cout << plan_txt << std::endl;
+                }
+            }
+            if (!plan_out.empty() && !TK.plans.empty()) {
+                std::cout << "[PLAN] wrote: " << plan_out << ".<rank>\n";
+            }
+        } else if (solved) {
             std::cout << "Solution found.\n";
-            if (algo != "soc_astar") {
+            if (algo != "soc_astar" && algo != "bfs2" && !cache_hit) {
                 std::cout << "Expanded: " << R.stats.expanded << " state(s)" << "\n";
                 std::cout << "Generated: " << R.stats.generated << " state(s)" << "\n";
                 std::cout << "Evaluated: " << R.stats.evaluated << " state(s)" << "\n";
+                if (std::isfinite(cost_bound)) {
+                    std::cout << "Pruned by bound: " << R.stats.pruned_by_bound << " state(s)" << "\n";
+                }
             }
 
-            if (algo == "bi_search") {
+            if (algo == "bi_search" && !cache_hit) {
                 std::cout << "Have metting: " << R.meet << "\n";
                 std::cout << "Plan length: " << R.plan.size() << "\n";
 
@@ -562,6 +1024,16 @@ int main(int argc, char** argv) {
                     std::cout << "[VAL] Validation failed (exit=" << vrc << ")\n";
                 }
             }
+        } else if (bound_exhausted && h_admissible) {
+            std::cout << "No plan with cost < " << cost_bound << " exists.\n";
+            if (algo != "soc_astar") {
+                std::cout << "Expanded: " << R.stats.expanded << " state(s)" << "\n";
+                std::cout << "Pruned by bound: " << R.stats.pruned_by_bound << " state(s)" << "\n";
+            }
+        } else if (bound_exhausted) {
+            // 許容的でないヒューリスティックで g+h の枝刈りをしたので、上界未満のプランがないことは示せていない
+            std::cout << "No plan with cost < " << cost_bound << " found (--h " << hname
+                      << " is not admissible, so this is not a proof).\n";
         } else {
             std::cout << "No solution.\n";
         }
@@ -578,7 +1050,13 @@ int main(int argc, char** argv) {
             std::error_code ec;
             fs::remove(sas_path, ec);
         }
-        return solved ? 0 : 3;
+        if (solved) {
+            return 0;
+        }
+        return (bound_exhausted && h_admissible) ? 4 : 3; // 4: 上界未満のプランが存在しないことを証明した場合
+    } catch (const std::domain_error& e) { // 探索エンジンが対応していないタスク
+        std::cerr << "error: " << e.what() << "\n";
+        return 201;
     } catch (const std::bad_alloc&) {
         std::cerr << "fatal: memory limit exceeded (bad_alloc)\n";
         return 102; // memory limit
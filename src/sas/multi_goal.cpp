@@ -0,0 +1,269 @@
+#include "sas/multi_goal.hpp"
+#include "sas/search_utils.hpp"
+#include "sas/state_index.hpp"
+#include "arena.hpp"
+#include "alloc_profile.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+
+namespace planner { namespace sas {
+
+std::size_t MultiGoalResult::num_solved() const {
+    return static_cast<std::size_t>(std::count_if(goals.begin(), goals.end(), [](const GoalPlan& g) { return g.solved; }));
+}
+
+// ノード→プラン復元
+static std::vector<uint32_t> extract_plan(const std::vector<Node>& nodes, int goal_id) {
+    std::vector<uint32_t> acts;
+    for (int v = goal_id; v >= 0 && nodes[v].parent >= 0; v = nodes[v].parent) {
+        acts.push_back(nodes[v].act_id);
+    }
+    std::reverse(acts.begin(), acts.end());
+    return acts;
+}
+
+static bool satisfies(const GoalCondition& g, const State& s) {
+    for (const auto& [v, val] : g) {
+        if (s[v] != val) {
+            return false;
+        }
+    }
+    return true;
+}
+
+MultiGoalResult multi_goal_search(const Task& T, const std::vector<GoalCondition>& goals,
+                                  const HeuristicFactory& make_h, const Params& p) {
+    PLANNER_ALLOC_PHASE(Expansion);
+    MultiGoalResult out;
+    out.goals.resize(goals.size());
+    Result R; // 探索ノードと統計 (search_interrupted() に渡す)
+
+    // ゴールごとのヒューリスティックは、ゴールを差し替えたタスクに対して作る
+    std::vector<Task> goal_tasks;
+    std::vector<HeuristicFn> hs;
+    if (make_h) {
+        goal_tasks.reserve(goals.size());
+        for (const auto& g : goals) {
+            goal_tasks.push_back(T);
+            goal_tasks.back().goal = g;
+        }
+        for (const auto& gt : goal_tasks) {
+            hs.push_back(make_h(gt));
+        }
+    }
+
+    std::vector<int> open_goals(goals.size()); // 未到達のゴールの番号
+    for (std::size_t i = 0; i < goals.size(); ++i) {
+        open_goals[i] = static_cast<int>(i);
+    }
+
+    // 未到達のゴールに対するヒューリスティック値の最小値を返す関数
+    auto h_min = [&](const State& s) -> double {
+        if (hs.empty()) {
+            return 0.0;
+        }
+        ++R.stats.evaluated;
+        double best = std::numeric_limits<double>::infinity();
+        for (int i : open_goals) {
+            best = std::min(best, hs[i](goal_tasks[i], s));
+        }
+        return best;
+    };
+
+    // 展開した状態が満たす未到達のゴールを記録する関数 (全て到達した場合は true を返す)
+    auto record_goals = [&](int u) -> bool {
+        const State& s = R.nodes[u].s;
+        bool hit = false;
+        for (int i : open_goals) {
+            if (satisfies(goals[i], s)) {
+                GoalPlan& gp = out.goals[i];
+                gp.solved = true;
+                gp.plan = extract_plan(R.nodes, u);
+                gp.plan_cost = eval_plan_cost(T, gp.plan);
+                gp.expanded_at = R.stats.expanded;
+                hit = true;
+            }
+        }
+        if (hit) {
+            open_goals.erase(std::remove_if(open_goals.begin(), open_goals.end(),
+                                            [&](int i) { return out.goals[i].solved; }), open_goals.end());
+        }
+        return open_goals.empty();
+    };
+
+    auto finish = [&]() {
+        out.stats = R.stats;
+        out.stop = R.stop;
+        return out;
+    };
+
+    State s0(T.init.begin(), T.init.end());
+    R.nodes.push_back(Node{s0, -1, -1});
+    if (goals.empty() || record_goals(0)) {
+        return finish();
+    }
+
+    struct Meta { double g; double h; bool closed; };
+    ArenaVector<Meta> meta(1, Meta{0.0, h_min(s0), false});
+
+    // (f, h, g, ノード ID) の最小ヒープ、g がノードの現在の g 値と異なるエントリは古いものとして捨てる
+    using Entry = std::tuple<double, double, double, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    if (meta[0].h < p.cost_bound) {
+        open.emplace(meta[0].h, meta[0].h, 0.0, 0);
+    } else {
+        ++R.stats.pruned_by_bound;
+    }
+
+    auto state_of = [&R](int id) -> const State& { return R.nodes[id].s; };
+    StateIndex index_of(1 << 15);
+    SuccessorBatch batch;
+    index_of.insert(StateIndex::hash(s0), 0, state_of);
+
+    const bool check_mutex = should_check_mutex_runtime(T);
+    State work;
+    Undo undo;
+
+    while (!open.empty()) {
+        if (search_interrupted(p, R)) {
+            return finish();
+        }
+
+        const auto [f, hu_key, gu_key, u] = open.top();
+        open.pop();
+        (void)f;
+        (void)hu_key;
+        if (gu_key != meta[u].g || meta[u].closed) {
+            continue;
+        }
+        meta[u].closed = true;
+
+        // ゴール判定は展開時に行う (この時点の g 値が、満たすゴールへの最適コスト)
+        if (record_goals(u)) {
+            return finish();
+        }
+
+        ++R.stats.expanded;
+        if (R.stats.expanded > p.max_expansions) {
+            return finish();
+        }
+
+        const State su = R.nodes[u].s;
+        batch.clear();
+        for (int a = 0; a < (int)T.ops.size(); ++a) {
+            const auto& op = T.ops[a];
+            if (!is_applicable(T, su, op)) {
+                continue;
+            }
+            work = su;
+            undo.clear();
+            apply_inplace(T, op, work, undo);
+            ++R.stats.generated;
+
+            // 生成状態が mutex 違反なら捨てる
+            if (check_mutex && violates_mutex(T, work)) {
+                continue;
+            }
+            if (meta[u].g + op.cost >= p.cost_bound) { // g-value だけで上界に達している場合
+                ++R.stats.pruned_by_bound;
+                continue;
+            }
+            batch.push(work, a);
+        }
+        batch.hash_and_prefetch(index_of);
+
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            const State& succ = batch.state(i);
+            const int a = batch.op(i);
+            const double g = meta[u].g + T.ops[a].cost;
+
+            int v = index_of.find(succ, batch.hash(i), state_of);
+            if (v == StateIndex::EMPTY) {
+                const double hv = h_min(succ);
+                if (g + hv >= p.cost_bound) {
+                    ++R.stats.pruned_by_bound;
+                    continue;
+                }
+                v = (int)R.nodes.size();
+                R.nodes.push_back(Node{succ, u, a});
+                index_of.insert(batch.hash(i), v, state_of);
+                meta.push_back(Meta{g, hv, false});
+            } else {
+                if (g >= meta[v].g || (meta[v].closed && !p.reopen_closed)) {
+                    ++R.stats.duplicates;
+                    continue;
+                }
+                if (g + meta[v].h >= p.cost_bound) {
+                    ++R.stats.pruned_by_bound;
+                    continue;
+                }
+                meta[v].g = g;
+                meta[v].closed = false; // 到達したゴールが減ると h が変わり consistent でなくなりうるので、再展開を許す
+                R.nodes[v].parent = u;
+                R.nodes[v].act_id = a;
+            }
+            open.emplace(g + meta[v].h, meta[v].h, g, v);
+        }
+    }
+
+    out.bound_exhausted = std::isfinite(p.cost_bound);
+    return finish();
+}
+
+std::vector<GoalCondition> read_goals_file(const Task& T, const std::string& path) {
+    std::ifstream ifs(path);
+    if (!ifs) {
+        throw std::runtime_error("failed to open goals file: " + path);
+    }
+
+    // 変数の名前 -> 番号
+    auto var_of = [&](const std::string& name) -> int {
+        for (std::size_t v = 0; v < T.vars.size(); ++v) {
+            if (T.vars[v].name == name) {
+                return static_cast<int>(v);
+            }
+        }
+        if (!name.empty() && std::all_of(name.begin(), name.end(), [](unsigned char c) { return std::isdigit(c); })) {
+            return std::stoi(name);
+        }
+        return -1;
+    };
+
+    std::vector<GoalCondition> goals;
+    std::string line;
+    int lineno = 0;
+    while (std::getline(ifs, line)) {
+        ++lineno;
+        std::istringstream iss(line);
+        std::string tok;
+        GoalCondition g;
+        while (iss >> tok) {
+            if (tok[0] == '#') {
+                break;
+            }
+            const auto eq = tok.find('=');
+            const int v = (eq == std::string::npos) ? -1 : var_of(tok.substr(0, eq));
+            if (v < 0 || v >= (int)T.vars.size()) {
+                throw std::runtime_error(path + ":" + std::to_string(lineno) + ": bad goal fact: " + tok);
+            }
+            const int val = std::stoi(tok.substr(eq + 1));
+            if (val < 0 || val >= T.vars[v].domain) {
+                throw std::runtime_error(path + ":" + std::to_string(lineno) + ": value out of range: " + tok);
+            }
+            g.emplace_back(v, val);
+        }
+        if (!g.empty()) {
+            goals.push_back(std::move(g));
+        }
+    }
+    return goals;
+}
+
+}} // namespace planner::sas
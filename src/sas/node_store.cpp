@@ -0,0 +1,126 @@
+#include "sas/node_store.hpp"
+#include <algorithm>
+#include <bit>
+
+namespace planner { namespace sas {
+
+NodeStateStore::NodeStateStore(const Task& T, int checkpoint_interval, std::size_t cache_slots)
+    : nvars_(T.vars.size()), interval_(std::clamp(checkpoint_interval, 1, 0xffff)) {
+    fits_ = (nvars_ <= 0xffff);
+    for (const auto& v : T.vars) {
+        if (v.domain > 0xffff) {
+            fits_ = false;
+        }
+    }
+
+    // 各変数を、word をまたがないように先頭から順に詰める
+    word_of_.resize(nvars_);
+    shift_of_.resize(nvars_);
+    mask_of_.resize(nvars_);
+    uint32_t word = 0, used = 0;
+    for (std::size_t v = 0; v < nvars_; ++v) {
+        const uint32_t d = static_cast<uint32_t>(std::max(2, T.vars[v].domain));
+        const uint32_t bits = static_cast<uint32_t>(std::bit_width(d - 1));
+        if (used + bits > 64) {
+            ++word;
+            used = 0;
+        }
+        word_of_[v] = word;
+        shift_of_[v] = used;
+        mask_of_[v] = (bits == 64) ? ~0ull : ((1ull << bits) - 1);
+        used += bits;
+    }
+    words_per_state_ = nvars_ ? word + 1 : 0;
+
+    std::size_t n = 1;
+    while (n < cache_slots) {
+        n <<= 1;
+    }
+    cache_.resize(n);
+}
+
+void NodeStateStore::pack(const State& s) {
+    const std::size_t off = full_.size();
+    full_.resize(off + words_per_state_, 0);
+    for (std::size_t v = 0; v < nvars_; ++v) {
+        full_[off + word_of_[v]] |= (static_cast<uint64_t>(s[v]) & mask_of_[v]) << shift_of_[v];
+    }
+}
+
+void NodeStateStore::unpack(uint64_t offset, State& out) const {
+    out.resize(nvars_);
+    for (std::size_t v = 0; v < nvars_; ++v) {
+        out[v] = static_cast<int>((full_[offset + word_of_[v]] >> shift_of_[v]) & mask_of_[v]);
+    }
+}
+
+void NodeStateStore::push_root(const State& s) {
+    entries_.push_back(Entry{full_.size(), -1, 0, 0});
+    links_.push_back(Link{-1, -1});
+    pack(s);
+}
+
+void NodeStateStore::push(const State& s, int parent, int op, const State& parent_state) {
+    links_.push_back(Link{parent, op});
+    const Entry& pe = entries_[parent];
+    const int depth = pe.depth + 1;
+
+    // 差分を数え、チェックポイントの間隔に達した場合や、差分が詰めた状態より大きくなる場合は完全な状態を保存する
+    std::size_t diff = 0;
+    for (std::size_t v = 0; v < nvars_; ++v) {
+        diff += (s[v] != parent_state[v]);
+    }
+    if (depth >= interval_ || diff > 0xffff || diff >= words_per_state_ * 2) {
+        entries_.push_back(Entry{full_.size(), -1, 0, 0});
+        pack(s);
+        return;
+    }
+
+    entries_.push_back(Entry{deltas_.size(), parent, static_cast<uint16_t>(diff), static_cast<uint16_t>(depth)});
+    for (std::size_t v = 0; v < nvars_; ++v) {
+        if (s[v] != parent_state[v]) {
+            deltas_.push_back(static_cast<uint32_t>(v) << 16 | static_cast<uint32_t>(s[v]));
+        }
+    }
+}
+
+const State& NodeStateStore::get(int id) {
+    const std::size_t mask = cache_.size() - 1;
+    CacheSlot& slot = cache_[static_cast<std::size_t>(id) & mask];
+    if (slot.id == id) {
+        return slot.s;
+    }
+
+    // キャッシュにある祖先か、チェックポイントまでさかのぼる
+    chain_.clear();
+    int cur = id;
+    while (entries_[cur].base >= 0 && cache_[static_cast<std::size_t>(cur) & mask].id != cur) {
+        chain_.push_back(cur);
+        cur = entries_[cur].base;
+    }
+
+    const CacheSlot& start = cache_[static_cast<std::size_t>(cur) & mask];
+    if (start.id == cur) {
+        if (&start != &slot) {
+            slot.s = start.s;
+        }
+    } else {
+        unpack(entries_[cur].offset, slot.s);
+    }
+
+    for (auto it = chain_.rbegin(); it != chain_.rend(); ++it) {
+        const Entry& e = entries_[*it];
+        for (uint64_t i = e.offset; i < e.offset + e.len; ++i) {
+            const uint32_t d = deltas_[i];
+            slot.s[d >> 16] = static_cast<int>(d & 0xffff);
+        }
+    }
+    slot.id = id;
+    return slot.s;
+}
+
+std::size_t NodeStateStore::bytes() const noexcept {
+    return entries_.size() * (sizeof(Entry) + sizeof(Link)) + full_.size() * sizeof(uint64_t) + deltas_.size() * sizeof(uint32_t);
+}
+
+}} // namespace planner::sas
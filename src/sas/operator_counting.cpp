@@ -0,0 +1,225 @@
+#include "sas/sas_heuristic.hpp"
+#include "sas/causal_graph.hpp"
+#include "sas/landmark_graph.hpp"
+#include "sas/lp_solver.hpp"
+#include "sas/scratch_pool.hpp"
+#include "alloc_profile.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <utility>
+
+namespace planner { namespace sas {
+
+namespace { // 衝突を避けるために無名名前空間を使用する
+
+constexpr double PSEUDOINF = 1 << 16; // hff と同じく、ゴールに到達できない場合の値
+
+// 右辺の求め方ごとの制約の種類
+enum class RowKind : uint8_t {
+    Fact,     // 状態方程式: fact (var, val) の生成回数 - 消費回数 >= [ゴール] - [s で真]
+    Landmark, // landmark: s から先で必要なら achiever の実行回数の和 >= 1
+    Posthoc,  // 事後最適化: var を変える演算子のコストの和 >= var への射影の上での最短距離
+};
+
+struct Row {
+    RowKind kind;
+    int var = -1;   // Fact, Posthoc
+    int val = -1;   // Fact (Posthoc の場合はゴールの値)
+    int lm = -1;    // Landmark
+    bool goal = false;
+};
+
+// 行列 A と演算子のコストは状態によらないので、構築時に 1 度だけ作り、全てのスレッドで共有する
+struct OCData {
+    std::shared_ptr<const MinCostLP> lp;
+    std::vector<Row> rows;
+    std::unique_ptr<LandmarkGraph> graph;     // landmark の制約を使う場合のみ
+    std::vector<DomainTransitionGraph> dtgs;  // 事後最適化の制約を使う場合のみ
+    bool integer_costs = true;
+
+    OCData(const Task& T, const OperatorCountingOptions& opts) {
+        const int n = static_cast<int>(T.ops.size());
+        std::vector<int> goal_val(T.vars.size(), -1);
+        for (auto [v, val] : T.goal) {
+            goal_val[v] = val;
+        }
+        for (const auto& op : T.ops) {
+            integer_costs = integer_costs && (std::floor(op.cost) == op.cost);
+        }
+
+        std::vector<std::vector<std::pair<int, double>>> coeffs;
+
+        if (opts.state_equation) {
+            // fact ごとの (演算子, 係数)
+            std::vector<std::vector<std::vector<std::pair<int, double>>>> fact(T.vars.size());
+            for (std::size_t v = 0; v < T.vars.size(); ++v) {
+                fact[v].resize(T.vars[v].domain);
+            }
+            for (int a = 0; a < n; ++a) {
+                const auto& op = T.ops[a];
+                for (const auto& [conds, v, pre, post] : op.pre_posts) {
+                    // 条件つきの効果を持つ変数は、実際に値が変わるか分からないので生成だけを数える
+                    bool conditional = false;
+                    for (const auto& e : op.pre_posts) {
+                        conditional = conditional || (std::get<1>(e) == v && !std::get<0>(e).empty());
+                    }
+                    if (pre == post) {
+                        continue;
+                    }
+                    auto& prod = fact[v][post];
+                    if (prod.empty() || prod.back().first != a) { // 1 つの演算子の生成は 1 回まで
+                        prod.emplace_back(a, 1.0);
+                    }
+                    if (pre >= 0 && !conditional) {
+                        fact[v][pre].emplace_back(a, -1.0);
+                    }
+                }
+            }
+            // 消費する演算子がなく、ゴールでもない fact の制約は常に満たされるので省く
+            for (std::size_t v = 0; v < T.vars.size(); ++v) {
+                for (int d = 0; d < T.vars[v].domain; ++d) {
+                    const bool goal = (goal_val[v] == d);
+                    bool consumed = false;
+                    for (auto [a, c] : fact[v][d]) {
+                        consumed = consumed || c < 0.0;
+                    }
+                    if (!goal && !consumed) {
+                        continue;
+                    }
+                    rows.push_back(Row{RowKind::Fact, static_cast<int>(v), d, -1, goal});
+                    coeffs.push_back(std::move(fact[v][d]));
+                }
+            }
+        }
+
+        if (opts.landmarks) {
+            graph = std::make_unique<LandmarkGraph>(T);
+            const auto& lms = graph->landmarks();
+            for (std::size_t id = 0; id < lms.size(); ++id) {
+                std::vector<std::pair<int, double>> c;
+                c.reserve(lms[id].achievers.size());
+                for (uint32_t a : lms[id].achievers) {
+                    c.emplace_back(static_cast<int>(a), 1.0);
+                }
+                rows.push_back(Row{RowKind::Landmark, -1, -1, static_cast<int>(id), false});
+                coeffs.push_back(std::move(c));
+            }
+        }
+
+        if (opts.posthoc) {
+            // ゴールの変数ごとの原子的な射影: 射影した問題の最適コストは、その変数の DTG 上の最短距離
+            dtgs = build_dtgs(T);
+            for (auto [v, val] : T.goal) {
+                std::vector<std::pair<int, double>> c;
+                for (const auto& ts : dtgs[v].out) {
+                    for (const auto& t : ts) {
+                        c.emplace_back(t.op, static_cast<double>(T.ops[t.op].cost));
+                    }
+                }
+                // 同じ演算子は 1 つにまとめる (from_rows は係数を足し合わせるため)
+                std::sort(c.begin(), c.end());
+                c.erase(std::unique(c.begin(), c.end()), c.end());
+                rows.push_back(Row{RowKind::Posthoc, v, val, -1, true});
+                coeffs.push_back(std::move(c));
+            }
+        }
+
+        std::vector<double> cost;
+        cost.reserve(T.ops.size());
+        for (const auto& op : T.ops) {
+            cost.push_back(static_cast<double>(op.cost));
+        }
+        lp = std::make_shared<const MinCostLP>(SparseMatrix::from_rows(n, coeffs), std::move(cost));
+    }
+};
+
+// スレッドごとの作業領域 (双対単体法の基底は、同じスレッドで直前に解いた状態から引き継ぐ)
+struct OCScratch {
+    DualSimplex simplex;
+    std::vector<double> b;
+    std::vector<int> req;
+    std::vector<uint8_t> mark;
+    std::vector<uint8_t> required;
+
+    explicit OCScratch(const OCData& d)
+        : simplex(d.lp), b(d.rows.size(), 0.0),
+          mark(d.graph ? d.graph->size() : 0, 0), required(d.graph ? d.graph->size() : 0, 0) {}
+};
+
+double oc_compute(const OCData& D, OCScratch& S, const State& s) {
+    if (D.graph) {
+        S.req.clear();
+        D.graph->required(s, S.req, S.mark);
+        for (int id : S.req) {
+            if (D.graph->landmarks()[id].achievers.empty()) { // 達成できない landmark が残っている
+                return PSEUDOINF;
+            }
+            S.required[id] = 1;
+        }
+    }
+
+    bool dead = false;
+    for (std::size_t i = 0; i < D.rows.size(); ++i) {
+        const Row& r = D.rows[i];
+        switch (r.kind) {
+        case RowKind::Fact:
+            S.b[i] = (r.goal ? 1.0 : 0.0) - (s[r.var] == r.val ? 1.0 : 0.0);
+            break;
+        case RowKind::Landmark:
+            S.b[i] = S.required[r.lm] ? 1.0 : 0.0;
+            break;
+        case RowKind::Posthoc: {
+            const int d = D.dtgs[r.var].distance(s[r.var], r.val);
+            dead = dead || (d == DomainTransitionGraph::UNREACHABLE);
+            S.b[i] = dead ? 0.0 : static_cast<double>(d);
+            break;
+        }
+        }
+    }
+    for (int id : S.req) {
+        S.required[id] = 0;
+    }
+    if (dead) {
+        return PSEUDOINF;
+    }
+
+    const LPSolution sol = S.simplex.solve(S.b);
+    if (sol.status == LPStatus::Infeasible) {
+        return PSEUDOINF;
+    }
+    // 反復の上限で打ち切った場合も、双対実行可能な基底の目的関数値なので許容的
+    double h = std::max(0.0, sol.objective);
+    if (D.integer_costs) {
+        h = std::ceil(h - 1e-6);
+    }
+    return std::min(h, PSEUDOINF);
+}
+
+} // anonymous namespace
+
+HeuristicFn hopcount(const Task& T, const OperatorCountingOptions& opts) {
+    PLANNER_ALLOC_PHASE(HeuristicSetup);
+    auto data = std::make_shared<OCData>(T, opts);
+    auto pool = std::make_shared<ScratchPool<OCScratch, OCData>>(*data);
+
+    return [data, pool](const Task& /*unused*/, const State& s) -> double {
+        PLANNER_ALLOC_PHASE(Evaluation);
+        auto lease = pool->acquire();
+        return oc_compute(*data, *lease, s);
+    };
+}
+
+HeuristicFn hseq(const Task& T) {
+    return hopcount(T, OperatorCountingOptions{true, false, false});
+}
+
+HeuristicFn hpho(const Task& T) {
+    return hopcount(T, OperatorCountingOptions{false, false, true});
+}
+
+HeuristicFn hoc(const Task& T) {
+    return hopcount(T, OperatorCountingOptions{});
+}
+
+}} // namespace planner::sas
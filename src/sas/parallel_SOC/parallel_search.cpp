@@ -1,4 +1,6 @@
 #include "sas/parallel_SOC/parallel_search.hpp"
+#include "sas/parallel_SOC/shard_hasher.hpp"
+#include "alloc_profile.hpp"
 #include <thread>
 #include <atomic>
 #include <limits>
@@ -91,21 +93,53 @@ static std::vector<uint32_t> reconstruct_plan(const ParentStore& parents, uint64
 }
 
 
+// ノードの優先度 (バケットの番号とタイブレーク値) を計算する関数
+static void set_priority(Node& n, const Params& P) {
+    // g + w·h を bucket_delta の幅で区切る (w = 1, delta = 1 の場合は f-value そのもの)
+    const double fw = static_cast<double>(n.g) + static_cast<double>(P.weight) * n.h;
+    const double b = std::floor(fw / P.bucket_delta + 1e-9);
+    n.key = static_cast<uint32_t>(std::min<double>(b, H_MASK)); // 二段バケットのキーは 16bit に収める
+
+    switch (P.tie_break) {
+        case TieBreak::HThenG: n.tie = static_cast<uint32_t>(std::min<int>(n.h, H_MASK)); break; // h-value が小さい方を優先する
+        case TieBreak::GThenH: n.tie = H_MASK - static_cast<uint32_t>(std::min<int>(n.g, H_MASK)); break; // g-value が大きい方を優先する
+        case TieBreak::FIFO:   n.tie = 0; break; // バケット内の順序のみに任せる
+    }
+}
+
 // A* 探索の主要部分
-SearchResult astar_soc(const sas::Task& T, const SearchParams& P, planner::sas::soc::GlobalStats* stats_out) {
+SearchResult astar_soc(const sas::Task& T, const Params& params, planner::sas::soc::GlobalStats* stats_out) {
+    PLANNER_ALLOC_PHASE(Expansion);
+    Params P = params;
+    P.sanitize();
     planner::sas::soc::g_run_seed = (P.random_seed ? P.random_seed : 634u);
 
-    const uint32_t N = P.num_threads ? P.num_threads : 1; // スレッドの数
-    const uint32_t Q = P.num_queues ? P.num_queues : N; // Queue の数、なければスレッド数と一致させる
-    const uint32_t Sh = N*4; // スレッド数の 4 倍に設定する
-    const uint32_t K = P.num_k_select ? P.num_k_select : 2; // 二段バケットの k-choice の選択数パラメタ
+    const uint32_t N = P.num_threads; // スレッドの数
+    const uint32_t Q = params.num_queues ? params.num_queues : N; // Queue の数、なければスレッド数と一致させる
+    const uint32_t Sh = params.bucket_shards ? params.bucket_shards : N*4; // 指定がなければスレッド数の 4 倍に設定する
+    const uint32_t K = P.bucket_select_k; // 二段バケットの k-choice の選択数パラメタ
+    const auto kind = (P.queue_kind == QueueKind::MultiQueue) ? SharedOpen::Kind::MultiQueue : SharedOpen::Kind::TwoLevelBucket;
 
     IdAllocator ids; // ID 生成器
     Heuristic hfn = Heuristic::goalcount(); // ヒューリスティック関数
     ClosedTable closed(std::max<uint32_t>(1024, N*64)); // クローズドリスト
-    SharedOpen open(P.open_kind, Q, Sh, K); // オープンリスト
+    SharedOpen open(kind, Q, Sh, K, P.buckets_window); // オープンリスト
     Termination term(P.time_limit_ms); // 時間制限
 
+    // 抽象化 Zobrist ハッシュによるシャードの割り当て (後続状態を親と同じシャード・ストライプに置く)
+    const bool by_abstraction = (P.shard_mode == ShardMode::Abstraction);
+    ShardHasher zh;
+    if (by_abstraction) {
+        zh = ShardHasher(T, kind == SharedOpen::Kind::MultiQueue ? Q : Sh, P.shard_balance);
+        open.set_shard_by_abstraction(true);
+    }
+    auto closed_get = [&](const sas::State& s, const Node& n) {
+        return by_abstraction ? closed.get(s, n.shard) : closed.get(s);
+    };
+    auto closed_update = [&](const sas::State& s, const Node& n) {
+        return by_abstraction ? closed.prune_or_update(s, n.g, n.id, n.shard) : closed.prune_or_update(s, n.g, n.id);
+    };
+
     // ヒューリスティック関数
     if (P.heuristic_kind == 0) {
         hfn = Heuristic::blind();
@@ -115,6 +149,12 @@ SearchResult astar_soc(const sas::Task& T, const SearchParams& P, planner::sas::
         hfn = Heuristic::hff(T);
     } else if (P.heuristic_kind == 3) {
         hfn = Heuristic::hlm(T);
+    } else if (P.heuristic_kind == 4) {
+        hfn = Heuristic::hmax(T);
+    } else if (P.heuristic_kind == 5) {
+        hfn = Heuristic::hpot(T);
+    } else if (P.heuristic_kind == 6) {
+        hfn = Heuristic::hpot_samples(T);
     } else {
         std::cerr << "not defined heuristic function" << "\n";
     }
@@ -148,9 +188,24 @@ SearchResult astar_soc(const sas::Task& T, const SearchParams& P, planner::sas::
 
     parents.initialize(); // ベクタのサイズの初期化
     parents.set(root.id, root.parent, root.op_id); // ParentStore に登録する
+    set_priority(root, P);
+    root.shard = by_abstraction ? zh(T.init) : 0;
+
+    // ルートノードの f-value が上界以上の場合は、スレッドを起動せずに終了する
+    if (root.g + root.h >= P.cost_bound) {
+        SearchResult R;
+        R.bound_exhausted = true;
+        if (stats_out) {
+            GS.per_thread[0].evaluated += 1;
+            GS.per_thread[0].pruned_by_bound += 1;
+            GS.per_thread[0].relax_eval_ns += first_relax_eval_ns;
+            *stats_out = GS;
+        }
+        return R;
+    }
 
     store.put(root.id, T.init); // ルートノードの ID と state をマップに挿入する
-    closed.prune_or_update(T.init, root.g, root.id);
+    closed_update(T.init, root);
 
     // critical section (ノード記録表に登録)
     {
@@ -161,17 +216,41 @@ SearchResult astar_soc(const sas::Task& T, const SearchParams& P, planner::sas::
     open.push(std::move(root)); // オープンリストに push する
 
     std::atomic<bool> done{false}; // 探索が終了しているか表すフラグ、複数のスレッドに共有するので、std::atomic を使用する
+    std::atomic<bool> timed_out{false}; // 時間制限によって終了したかどうか (上界の網羅と区別するため)
     std::atomic<uint64_t> goal_node{UINT64_MAX}; // goal node の ID を記録するための atomic 変数
 
     std::atomic<uint32_t> active_workrs{0};
 
     auto worker = [&](uint32_t tid){
         planner::sas::soc::set_current_thread_index(tid); // 現在のスレッドの ID を登録する
+        PLANNER_ALLOC_PHASE(Expansion); // 作業スレッドは呼び出し元の段階を引き継がない
         sas::State cur_state; // 現在の state
         auto& S = GS.per_thread[tid]; // 各スレッドごとの統計値を取得する
 
         bool is_active = false; // 各スレッドが、仕事を持っている状態かを表す変数
 
+        // まとめて評価する後続ノードとその状態 (hfn.has_batch() の場合のみ使う)
+        std::vector<Node> pending;
+        std::vector<sas::State> pending_states;
+        std::vector<double> pending_h;
+
+        // 評価済みの後続ノードをオープンリストに入れる関数
+        auto admit = [&](Node&& nxt, const sas::State& succ) {
+            // f-value が上界以上の場合は、状態を保存せずに捨てる
+            if (nxt.g + nxt.h >= P.cost_bound) {
+                S.pruned_by_bound++;
+                return;
+            }
+
+            set_priority(nxt, P);
+            store.put(nxt.id, succ); // state のコピーの作成
+
+            parents.set(nxt.id, nxt.parent, nxt.op_id); // ParentStore に state の情報を登録する
+
+            // オープンリストに挿入
+            open.push(std::move(nxt));
+        };
+
         auto become_active = [&]() {
             if (!is_active) {
                 is_active = true;
@@ -192,6 +271,7 @@ SearchResult astar_soc(const sas::Task& T, const SearchParams& P, planner::sas::
             }
 
             if (unlikely(term.timed_out())) { // 時間制限を超えてしまった場合
+                timed_out.store(true, std::memory_order_release);
                 done.store(true);
                 break;
             }
@@ -257,10 +337,18 @@ SearchResult astar_soc(const sas::Task& T, const SearchParams& P, planner::sas::
                     
                     S.generated++;
 
+                    // g-value だけで上界に達している場合は、クローズドリストを引く前に枝刈りする
+                    if (nxt.g >= P.cost_bound) {
+                        S.pruned_by_bound++;
+                        return;
+                    }
+
+                    nxt.shard = by_abstraction ? zh(succ) : 0;
+
                     // reopen 判定のために事前にクローズリストにノードが含まれているか確認する
-                    auto prev = closed.get(succ);
+                    auto prev = closed_get(succ, nxt);
 
-                    if (closed.prune_or_update(succ, nxt.g, nxt.id)) { // g-value が悪化または同じである場合は、枝狩りを行う
+                    if (closed_update(succ, nxt)) { // g-value が悪化または同じである場合は、枝狩りを行う
                         S.duplicates_pruned++; // 枝狩りできたので、その統計値を 1 インクリメントする
                         return;
                     }
@@ -270,6 +358,12 @@ SearchResult astar_soc(const sas::Task& T, const SearchParams& P, planner::sas::
                         S.reopened++;
                     }
 
+                    if (hfn.has_batch()) { // 展開が終わってからまとめて評価する
+                        pending.push_back(nxt);
+                        pending_states.push_back(succ);
+                        return;
+                    }
+
                     // h-value の計算時間を測定しつつ算出する
                     S.relax_eval_ns += planner::sas::soc::measure_ns_and_run([&](){
                         nxt.h = static_cast<int>(std::lround(hfn(T, succ)));
@@ -277,19 +371,22 @@ SearchResult astar_soc(const sas::Task& T, const SearchParams& P, planner::sas::
 
                     S.evaluated++; 
 
-                    store.put(nxt.id, succ); // state のコピーの作成
-
-                    parents.set(nxt.id, nxt.parent, nxt.op_id); // ParentStore に state の情報を登録する
-
-                    {
-                        // planner::sas::soc::ScopedLock<planner::sas::soc::TicketLock> lg(reg_mtx); // ロックをかける
-                        // registry.emplace(nxt.id, nxt); // ノードの登録
-                    }
-
-                    // オープンリストに挿入
-                    open.push(std::move(nxt));
+                    admit(std::move(nxt), succ);
                 }
             );
+
+            if (!pending.empty()) {
+                S.relax_eval_ns += planner::sas::soc::measure_ns_and_run([&](){
+                    hfn.eval_batch(T, pending_states, pending_h);
+                });
+                S.evaluated += pending.size();
+                for (std::size_t i = 0; i < pending.size(); ++i) {
+                    pending[i].h = static_cast<int>(std::lround(pending_h[i]));
+                    admit(std::move(pending[i]), pending_states[i]);
+                }
+                pending.clear();
+                pending_states.clear();
+            }
         }
 
         // ループ脱出時に、active である場合、それを解除しておく
@@ -334,6 +431,15 @@ SearchResult astar_soc(const sas::Task& T, const SearchParams& P, planner::sas::
             cost += T.ops[oi].cost;
         }
         R.cost = cost;
+
+        // 下界: 全スレッドが展開を終えた時点で、最適なプラン上のノードのいずれかが最適な g-value でオープンリストに残っている
+        // (g-value が改善したノードは必ず開き直すため) ので、残ったノードの g + h の最小値は最適コスト以下になる
+        R.lower_bound = cost;
+        while (auto n = open.pop()) {
+            R.lower_bound = std::min<double>(R.lower_bound, n->g + n->h);
+        }
+    } else if (std::isfinite(P.cost_bound) && !timed_out.load(std::memory_order_acquire)) { // 時間制限ではなくオープンリストを使い切って終了した場合
+        R.bound_exhausted = true;
     }
 
     return R;
@@ -0,0 +1,85 @@
+#include "sas/parallel_SOC/shard_hasher.hpp"
+#include "sas/causal_graph.hpp"
+#include <cmath>
+
+namespace planner {
+namespace sas {
+namespace parallel_SOC {
+
+ShardHasher::ShardHasher(const Task& T, uint32_t num_shards, uint32_t balance) {
+    const std::size_t n = T.vars.size();
+
+    // 各演算子が変更する変数
+    std::vector<std::vector<int>> changed_by(T.ops.size());
+    std::vector<std::vector<int>> ops_of(n);
+    for (std::size_t a = 0; a < T.ops.size(); ++a) {
+        for (const auto& pp : T.ops[a].pre_posts) {
+            const int v = std::get<1>(pp);
+            changed_by[a].push_back(v);
+            ops_of[v].push_back(static_cast<int>(a));
+        }
+    }
+
+    // 因果グラフで祖先に近い変数ほど、他の変数の値を決める (同じコストの候補の中では先に選ぶ)
+    const CausalGraph cg(T);
+
+    // 抽象化変数を変更する演算子を「移動する演算子」と呼び、追加する変数が新たに増やす移動する演算子の数 / log2(ドメイン) が最小の変数を選ぶ
+    std::vector<char> moving(T.ops.size(), 0);
+    std::vector<char> chosen(n, 0);
+    std::size_t num_moving = 0;
+    const double target = std::log2(static_cast<double>(num_shards) * std::max<uint32_t>(balance, 1u));
+    double abstract_bits = 0.0;
+
+    while (abstract_bits < target) {
+        int best = -1;
+        double best_cost = 0.0;
+        for (std::size_t v = 0; v < n; ++v) {
+            if (chosen[v] || T.vars[v].domain < 2 || ops_of[v].empty()) { // 変化しない変数は負荷の分散に役立たない
+                continue;
+            }
+            std::size_t added = 0;
+            for (int a : ops_of[v]) {
+                added += moving[a] ? 0 : 1;
+            }
+            const double cost = static_cast<double>(added) / std::log2(static_cast<double>(T.vars[v].domain));
+            if (best < 0 || cost < best_cost ||
+                (cost == best_cost && cg.predecessors[v].size() < cg.predecessors[best].size())) {
+                best = static_cast<int>(v);
+                best_cost = cost;
+            }
+        }
+        if (best < 0) { // 全ての変数を選んだ (通常の Zobrist ハッシュと同じ)
+            break;
+        }
+        chosen[best] = 1;
+        vars_.push_back(best);
+        abstract_bits += std::log2(static_cast<double>(T.vars[best].domain));
+        for (int a : ops_of[best]) {
+            if (!moving[a]) {
+                moving[a] = 1;
+                ++num_moving;
+            }
+        }
+    }
+    moving_op_ratio_ = T.ops.empty() ? 0.0 : static_cast<double>(num_moving) / static_cast<double>(T.ops.size());
+
+    // Zobrist の乱数表 (splitmix64)
+    offset_.assign(n, 0);
+    uint32_t total = 0;
+    for (std::size_t v = 0; v < n; ++v) {
+        offset_[v] = total;
+        total += static_cast<uint32_t>(T.vars[v].domain);
+    }
+    table_.resize(total);
+    uint64_t x = 0x9e3779b97f4a7c15ull;
+    for (auto& r : table_) {
+        uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        r = z ^ (z >> 31);
+    }
+}
+
+} // namespace parallel_SOC
+} // namespace sas
+} // namespace planner
@@ -0,0 +1,208 @@
+#include "sas/plan_cache.hpp"
+#include "sas/search_utils.hpp"
+#include "sas/sas_search.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <cerrno>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace planner { namespace sas {
+
+namespace {
+
+constexpr char CACHE_MAGIC[8] = {'P', 'L', 'N', 'C', 'A', 'C', 'H', '1'};
+constexpr const char* ENTRY_EXT = ".plan";
+
+uint64_t fnv_string(uint64_t h, const std::string& s) {
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// ディレクトリのロックファイルを flock() で保持する RAII
+class DirLock {
+public:
+    DirLock(const std::string& dir, int op) {
+        fd_ = ::open((dir + "/.lock").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            throw std::runtime_error("plan cache: cannot open lock file in " + dir);
+        }
+        while (::flock(fd_, op) != 0) {
+            if (errno != EINTR) {
+                ::close(fd_);
+                throw std::runtime_error("plan cache: cannot lock " + dir);
+            }
+        }
+    }
+    ~DirLock() {
+        ::flock(fd_, LOCK_UN);
+        ::close(fd_);
+    }
+
+    DirLock(const DirLock&) = delete;
+    DirLock& operator=(const DirLock&) = delete;
+
+private:
+    int fd_ = -1;
+};
+
+// プランをタスク上で実行し、ゴールに達するか確かめる関数
+bool plan_reaches_goal(const Task& T, const std::vector<uint32_t>& plan) {
+    State s = T.init;
+    Undo undo;
+    for (uint32_t a : plan) {
+        if (a >= T.ops.size() || !is_applicable(T, s, T.ops[a])) {
+            return false;
+        }
+        apply_inplace(T, T.ops[a], s, undo);
+        undo.clear();
+    }
+    return is_goal(T, s);
+}
+
+} // namespace
+
+PlanCache::PlanCache(std::string dir, std::size_t max_entries)
+    : dir_(std::move(dir)), max_entries_(std::max<std::size_t>(1, max_entries)) {
+    fs::create_directories(dir_);
+}
+
+std::string PlanCache::entry_path(uint64_t fp, const std::string& config) const {
+    const uint64_t key = fnv_string(fp ^ 1469598103934665603ull, config);
+    char name[17];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+    return dir_ + "/" + name + ENTRY_EXT;
+}
+
+std::optional<CachedPlan> PlanCache::lookup(const Task& T, const std::string& config) {
+    const uint64_t fp = task_fingerprint(T);
+    const std::string path = entry_path(fp, config);
+
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) {
+        return std::nullopt;
+    }
+
+    char magic[sizeof(CACHE_MAGIC)];
+    uint64_t efp = 0, clen = 0, n = 0;
+    uint8_t opt = 0;
+    double cost = 0.0;
+    ifs.read(magic, sizeof(magic));
+    ifs.read(reinterpret_cast<char*>(&efp), sizeof(efp));
+    ifs.read(reinterpret_cast<char*>(&clen), sizeof(clen));
+    if (!ifs || std::memcmp(magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || efp != fp || clen != config.size()) {
+        return std::nullopt; // 別の項目とファイル名が衝突した場合もここで外れる
+    }
+    std::string cfg(clen, '\0');
+    ifs.read(cfg.data(), static_cast<std::streamsize>(clen));
+    ifs.read(reinterpret_cast<char*>(&opt), sizeof(opt));
+    ifs.read(reinterpret_cast<char*>(&cost), sizeof(cost));
+    ifs.read(reinterpret_cast<char*>(&n), sizeof(n));
+    if (!ifs || cfg != config || n > (uint64_t(1) << 32)) {
+        return std::nullopt;
+    }
+    CachedPlan p;
+    p.plan.resize(static_cast<std::size_t>(n));
+    ifs.read(reinterpret_cast<char*>(p.plan.data()), static_cast<std::streamsize>(n * sizeof(uint32_t)));
+    if (!ifs) {
+        return std::nullopt;
+    }
+    ifs.close();
+    p.cost = cost;
+    p.optimal = (opt != 0);
+
+    // 実行できないプランや、コストが記録と異なるプランは返さずに消す
+    if (!plan_reaches_goal(T, p.plan) || std::fabs(eval_plan_cost(T, p.plan) - p.cost) > 1e-6) {
+        DirLock lk(dir_, LOCK_EX);
+        std::error_code ec;
+        fs::remove(path, ec);
+        return std::nullopt;
+    }
+
+    // 使った時刻を LRU の順序として残す
+    (void)::utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+    return p;
+}
+
+void PlanCache::store(const Task& T, const std::string& config, const CachedPlan& p) {
+    const uint64_t fp = task_fingerprint(T);
+    const std::string path = entry_path(fp, config);
+    static std::atomic<uint64_t> seq{0};
+    const std::string tmp = path + ".tmp." + std::to_string(::getpid()) + "." + std::to_string(seq.fetch_add(1));
+
+    {
+        std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+        if (!ofs) {
+            throw std::runtime_error("plan cache: cannot write " + tmp);
+        }
+        const uint64_t clen = config.size(), n = p.plan.size();
+        const uint8_t opt = p.optimal ? 1 : 0;
+        ofs.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+        ofs.write(reinterpret_cast<const char*>(&fp), sizeof(fp));
+        ofs.write(reinterpret_cast<const char*>(&clen), sizeof(clen));
+        ofs.write(config.data(), static_cast<std::streamsize>(clen));
+        ofs.write(reinterpret_cast<const char*>(&opt), sizeof(opt));
+        ofs.write(reinterpret_cast<const char*>(&p.cost), sizeof(p.cost));
+        ofs.write(reinterpret_cast<const char*>(&n), sizeof(n));
+        ofs.write(reinterpret_cast<const char*>(p.plan.data()), static_cast<std::streamsize>(n * sizeof(uint32_t)));
+        ofs.flush();
+        if (!ofs) {
+            std::error_code ec;
+            fs::remove(tmp, ec);
+            throw std::runtime_error("plan cache: cannot write " + tmp);
+        }
+    }
+
+    DirLock lk(dir_, LOCK_EX);
+    fs::rename(tmp, path); // 読み手は古い内容か新しい内容のどちらかを見る
+    evict();
+}
+
+std::size_t PlanCache::size() const {
+    std::size_t n = 0;
+    for (const auto& e : fs::directory_iterator(dir_)) {
+        n += (e.path().extension() == ENTRY_EXT) ? 1 : 0;
+    }
+    return n;
+}
+
+// 項目の数が上限を超えている分だけ、最後に使われた時刻が古い項目を消す関数 (ロックを保持して呼ぶ)
+void PlanCache::evict() {
+    std::vector<std::pair<fs::file_time_type, fs::path>> entries;
+    std::error_code ec;
+    for (const auto& e : fs::directory_iterator(dir_, ec)) {
+        if (e.path().extension() != ENTRY_EXT) {
+            continue;
+        }
+        const auto t = fs::last_write_time(e.path(), ec);
+        if (!ec) {
+            entries.emplace_back(t, e.path());
+        }
+    }
+    if (entries.size() <= max_entries_) {
+        return;
+    }
+    const std::size_t excess = entries.size() - max_entries_;
+    std::nth_element(entries.begin(), entries.begin() + static_cast<std::ptrdiff_t>(excess), entries.end());
+    for (std::size_t i = 0; i < excess; ++i) {
+        fs::remove(entries[i].second, ec);
+    }
+}
+
+}} // namespace planner::sas
@@ -0,0 +1,108 @@
+#include "sas/planner_session.hpp"
+#include "sas/bi_search.hpp"
+#include <chrono>
+#include <stdexcept>
+
+namespace planner { namespace sas {
+
+const char* to_string(SolveStatus s) {
+    switch (s) {
+        case SolveStatus::Solved:         return "solved";
+        case SolveStatus::Unsolvable:     return "unsolvable";
+        case SolveStatus::BoundExhausted: return "bound_exhausted";
+        case SolveStatus::NotFound:       return "not_found";
+        case SolveStatus::ExpansionLimit: return "expansion_limit";
+        case SolveStatus::Timeout:        return "timeout";
+        case SolveStatus::Cancelled:      return "cancelled";
+        case SolveStatus::MemoryLimit:    return "memory_limit";
+    }
+    return "unknown";
+}
+
+SolveStatus solve_status_of(const Result& R, const Params& p, const std::string& heuristic) {
+    if (R.solved) {
+        return SolveStatus::Solved;
+    }
+    switch (R.stop) {
+        case StopReason::Timeout:     return SolveStatus::Timeout;
+        case StopReason::Cancelled:   return SolveStatus::Cancelled;
+        case StopReason::MemoryLimit: return SolveStatus::MemoryLimit;
+        case StopReason::None:        break;
+    }
+    if (R.stats.expanded > p.max_expansions) {
+        return SolveStatus::ExpansionLimit;
+    }
+    if (R.bound_exhausted) {
+        // 許容的でないヒューリスティックで g+h の枝刈りをした場合は、上界未満のプランがないことは示せていない
+        return heuristic_is_admissible(heuristic) ? SolveStatus::BoundExhausted : SolveStatus::NotFound;
+    }
+    return SolveStatus::Unsolvable;
+}
+
+PlannerSession::PlannerSession(Task T) : task_(std::move(T)) {}
+
+std::unique_ptr<PlannerSession> PlannerSession::from_sas_file(const std::string& path) {
+    return std::make_unique<PlannerSession>(read_file(path));
+}
+
+const HeuristicFn& PlannerSession::heuristic(const std::string& name) {
+    auto it = heuristics_.find(name);
+    if (it != heuristics_.end()) {
+        return it->second;
+    }
+    return heuristics_.emplace(name, make_heuristic(name, task_)).first->second;
+}
+
+void PlannerSession::prepare_heuristic(const std::string& name) {
+    std::lock_guard<std::mutex> lk(mu_);
+    (void)heuristic(name);
+}
+
+SolveResult PlannerSession::solve(const SolveOptions& opt) {
+    std::lock_guard<std::mutex> lk(mu_);
+    const HeuristicFn& h = heuristic(opt.heuristic);
+
+    SearchControl ctl;
+    ctl.cancel = opt.cancel.flag();
+    ctl.start = std::chrono::steady_clock::now();
+    if (opt.time_limit_ms >= 0) {
+        ctl.deadline = ctl.start + std::chrono::milliseconds(opt.time_limit_ms);
+    }
+    ctl.memory_budget_bytes = opt.memory_budget_mb * 1024 * 1024;
+    ctl.on_progress = opt.on_progress;
+    ctl.progress_interval = opt.progress_interval;
+
+    Params P = opt.params;
+    P.cost_bound = opt.cost_bound;
+    P.verbose = false;
+    P.control = &ctl;
+
+    Result R;
+    if (opt.algo == "astar") {
+        R = astar(task_, h, true, P);
+    } else if (opt.algo == "gbfs") {
+        R = gbfs(task_, h, true, P);
+    } else if (opt.algo == "bi_search") {
+        R = bidir_astar(task_, h, true, P);
+    } else {
+        throw std::invalid_argument("unknown algorithm: " + opt.algo);
+    }
+
+    SolveResult out;
+    out.stats = R.stats;
+    out.search_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - ctl.start).count();
+    if (R.solved) {
+        out.status = SolveStatus::Solved;
+        out.plan = std::move(R.plan);
+        out.plan_cost = eval_plan_cost(task_, out.plan);
+        return out;
+    }
+    out.status = solve_status_of(R, P, opt.heuristic);
+    return out;
+}
+
+std::string PlannerSession::plan_to_val(const std::vector<uint32_t>& plan) const {
+    return planner::sas::plan_to_val(task_, plan);
+}
+
+}} // namespace planner::sas
@@ -0,0 +1,199 @@
+#include "sas/sas_heuristic.hpp"
+#include "sas/lp_solver.hpp"
+#include "sas/search_utils.hpp"
+#include "alloc_profile.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <utility>
+
+namespace planner { namespace sas {
+
+namespace { // 衝突を避けるために無名名前空間を使用する
+
+// 変数 v の値 d の fact の番号は offset[v] + d
+std::vector<int> fact_offsets(const Task& T) {
+    std::vector<int> offset(T.vars.size() + 1, 0);
+    for (std::size_t v = 0; v < T.vars.size(); ++v) {
+        offset[v + 1] = offset[v] + T.vars[v].domain;
+    }
+    return offset;
+}
+
+// 演算子ごとの、fact の重み Q についての整合性の制約 sum_f coef_f Q_f <= cost(o) の係数を作る関数
+// h(s) = base - sum_v Q(v, s[v]) とすると、演算子 o を適用した時の h の減少量は
+//   前提条件の値 p を持つ効果では Q(post) - Q(p)、それ以外 (p = -1 や条件つきの効果) では高々 Q(post) (Q >= 0 より)
+std::vector<std::vector<std::pair<int, double>>> consistency_rows(const Task& T, const std::vector<int>& offset) {
+    std::vector<std::vector<std::pair<int, double>>> rows(T.ops.size());
+    for (std::size_t a = 0; a < T.ops.size(); ++a) {
+        const auto& op = T.ops[a];
+        for (const auto& [conds, v, pre, post] : op.pre_posts) {
+            bool conditional = false;
+            for (const auto& e : op.pre_posts) {
+                conditional = conditional || (std::get<1>(e) == v && !std::get<0>(e).empty());
+            }
+            if (pre == post) {
+                continue;
+            }
+            rows[a].emplace_back(offset[v] + post, 1.0);
+            if (pre >= 0 && !conditional) {
+                rows[a].emplace_back(offset[v] + pre, -1.0);
+            }
+        }
+    }
+    return rows;
+}
+
+// 初期状態からのランダムウォークの終点を集める関数 (歩数は 0 以上 max_len 以下で一様)
+std::vector<State> random_walks(const Task& T, int n, int max_len, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<State> out;
+    out.reserve(static_cast<std::size_t>(n));
+    std::vector<int> app;
+    Undo undo;
+    for (int i = 0; i < n; ++i) {
+        State s = T.init;
+        const int len = static_cast<int>(rng() % static_cast<uint32_t>(max_len + 1));
+        for (int k = 0; k < len; ++k) {
+            app.clear();
+            for (int a = 0; a < static_cast<int>(T.ops.size()); ++a) {
+                if (is_applicable(T, s, T.ops[a])) {
+                    app.push_back(a);
+                }
+            }
+            if (app.empty()) {
+                break;
+            }
+            apply_inplace(T, T.ops[app[rng() % app.size()]], s, undo);
+            undo.clear();
+        }
+        out.push_back(std::move(s));
+    }
+    return out;
+}
+
+} // anonymous namespace
+
+// --- 重みを求める LP ---
+// maximize sum_{f in goal} Q_f - sum_f w_f Q_f  s.t. 整合性の制約、Q >= 0
+// (w_f は最適化の対象の状態で f が真である割合) を、その双対
+// minimize sum cost(o) Y_o  s.t. 各 fact f について (Y の生成回数 - 消費回数) >= [f in goal] - w_f,  Y >= 0
+// として DualSimplex で解き、最適基底の双対変数を Q とする (初期状態に対する値は状態方程式の LP の値と一致する)
+PotentialFunction::PotentialFunction(const Task& T, const PotentialOptions& opts) {
+    PLANNER_ALLOC_PHASE(HeuristicSetup);
+    const std::vector<int> offset = fact_offsets(T);
+    const int num_facts = offset.back();
+    std::vector<double> cost;
+    cost.reserve(T.ops.size());
+    for (const auto& op : T.ops) {
+        cost.push_back(static_cast<double>(op.cost));
+        integer_costs_ = integer_costs_ && (std::floor(op.cost) == op.cost);
+    }
+    const SparseMatrix C = SparseMatrix::from_rows(num_facts, consistency_rows(T, offset));
+    auto lp = std::make_shared<const MinCostLP>(C.transpose(), std::move(cost));
+    DualSimplex simplex(lp);
+
+    std::vector<double> goal_part(static_cast<std::size_t>(num_facts), 0.0);
+    for (auto [v, val] : T.goal) {
+        goal_part[offset[v] + val] = 1.0;
+    }
+
+    // states の各 fact の割合を w として解き、最適なら Q を返す関数
+    std::vector<double> Q;
+    auto solve_for = [&](const std::vector<State>& states) {
+        std::vector<double> b = goal_part;
+        const double inc = 1.0 / static_cast<double>(states.size());
+        for (const State& s : states) {
+            for (std::size_t v = 0; v < T.vars.size(); ++v) {
+                b[offset[v] + s[v]] -= inc;
+            }
+        }
+        const LPSolution sol = simplex.solve(b, 100000);
+        if (sol.status != LPStatus::Optimal) { // 実行不可能 (重みを無限に大きくできる) か、打ち切り
+            return false;
+        }
+        Q.resize(sol.duals.size());
+        for (std::size_t f = 0; f < Q.size(); ++f) {
+            Q[f] = std::max(0.0, sol.duals[f]); // 丸め誤差で負になったものは 0 にする
+        }
+        return true;
+    };
+
+    // 初期状態に対して最適化する (失敗した場合は重みを 0 のままにし、h は常に 0 になる)
+    const bool init_ok = solve_for({T.init});
+    if (init_ok && opts.objective == PotentialObjective::Samples && opts.num_samples > 0) {
+        // 初期状態の値を平均コストで割った歩数の 2 倍までのランダムウォークで状態を集め、その平均を最適化する
+        double h0 = 0.0;
+        for (auto [v, val] : T.goal) {
+            h0 += Q[offset[v] + val];
+        }
+        for (std::size_t v = 0; v < T.vars.size(); ++v) {
+            h0 -= Q[offset[v] + T.init[v]];
+        }
+        double avg = 0.0;
+        for (const auto& op : T.ops) {
+            avg += op.cost;
+        }
+        avg = T.ops.empty() ? 1.0 : std::max(1.0, avg / static_cast<double>(T.ops.size()));
+        const int max_len = std::max(1, static_cast<int>(std::ceil(2.0 * std::max(0.0, h0) / avg)));
+        const std::vector<double> init_Q = Q;
+        if (!solve_for(random_walks(T, opts.num_samples, max_len, opts.seed))) {
+            Q = init_Q;
+        }
+    }
+
+    // 重みが全て 0 の変数は評価で読まなくてよいので、残りの変数だけを詰めて持つ
+    base_ = 0.0;
+    if (init_ok) {
+        for (auto [v, val] : T.goal) {
+            base_ += Q[offset[v] + val];
+        }
+    }
+    for (std::size_t v = 0; v < T.vars.size(); ++v) {
+        bool nonzero = false;
+        for (int d = 0; init_ok && d < T.vars[v].domain; ++d) {
+            nonzero = nonzero || Q[offset[v] + d] > 0.0;
+        }
+        if (!nonzero) {
+            continue;
+        }
+        vars_.push_back(static_cast<int>(v));
+        offset_.push_back(static_cast<int>(weight_.size()));
+        for (int d = 0; d < T.vars[v].domain; ++d) {
+            weight_.push_back(Q[offset[v] + d]);
+        }
+    }
+}
+
+double PotentialFunction::operator()(const State& s) const {
+    double h = base_;
+    const std::size_t k = vars_.size();
+    for (std::size_t i = 0; i < k; ++i) {
+        h -= weight_[offset_[i] + s[vars_[i]]];
+    }
+    h = std::max(0.0, h);
+    if (integer_costs_) {
+        h = std::ceil(h - 1e-6);
+    }
+    return h;
+}
+
+HeuristicFn hpot(const Task& T, const PotentialOptions& opts) {
+    auto pot = std::make_shared<const PotentialFunction>(T, opts);
+    return [pot](const Task& /*unused*/, const State& s) -> double {
+        return (*pot)(s);
+    };
+}
+
+HeuristicFn hpot_init(const Task& T) {
+    return hpot(T, PotentialOptions{});
+}
+
+HeuristicFn hpot_samples(const Task& T) {
+    PotentialOptions opts;
+    opts.objective = PotentialObjective::Samples;
+    return hpot(T, opts);
+}
+
+}} // namespace planner::sas
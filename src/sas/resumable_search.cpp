@@ -0,0 +1,33 @@
+#include "sas/resumable_search.hpp"
+#include <limits>
+
+namespace planner { namespace sas {
+
+ResumableSearch::ResumableSearch(const Task& T, HeuristicFn h, Mode mode, const Params& p)
+    : h_(std::move(h)), p_(p) {
+    steps_ = (mode == Mode::AStar) ? astar_steps(T, h_, true, p_, R_) : gbfs_steps(T, h_, true, p_, R_);
+}
+
+StepStatus ResumableSearch::step(uint64_t n) {
+    if (finished()) {
+        return status_;
+    }
+    const uint64_t done = R_.stats.expanded;
+    const uint64_t stop_at = (n > std::numeric_limits<uint64_t>::max() - done) ? std::numeric_limits<uint64_t>::max() : done + n;
+    if (!steps_.run_until(stop_at)) {
+        return status_;
+    }
+
+    if (R_.solved) {
+        status_ = StepStatus::Solved;
+    } else if (R_.stop != StopReason::None) {
+        status_ = StepStatus::Stopped;
+    } else if (R_.stats.expanded > p_.max_expansions) {
+        status_ = StepStatus::ExpansionLimit;
+    } else {
+        status_ = StepStatus::Exhausted;
+    }
+    return status_;
+}
+
+}} // namespace planner::sas
@@ -1,9 +1,13 @@
 #include "sas/sas_heuristic.hpp"
+#include "alloc_profile.hpp"
 #include <memory>
+#include <future>
 #include <algorithm>
 #include <limits>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <stdexcept>
 
 namespace planner { namespace sas {
 
@@ -273,6 +277,114 @@ struct FFData {
     }
 };
 
+// --- 単位コストの h^max をビットスライスで計算するためのデータ構造 ---
+// FFData の fact と緩和演算子の並びをそのまま使い、fact ごとに「その fact に到達した状態」のビット列 (レーン) を持つ
+// 1 層ごとに、各演算子の前提条件のビット列の AND を追加効果の fact に OR するので、LANES 個の状態を 1 回の走査で進められる
+#if defined(__AVX2__)
+constexpr int LANE_WORDS = 4; // 256 レーン (4 語の AND/OR はコンパイラが AVX2 の命令にまとめる)
+#else
+constexpr int LANE_WORDS = 1; // 64 レーン
+#endif
+constexpr std::size_t LANES = 64 * LANE_WORDS;
+
+struct Lanes {
+    uint64_t w[LANE_WORDS];
+};
+
+struct HmaxData {
+    FFData ff;
+    std::vector<int> goal_facts;
+    double layer_cost = 1.0; // 1 層あたりのコスト (最も安い演算子のコスト)
+
+    explicit HmaxData(const Task& task) : ff(task) {
+        for (auto [v, val] : task.goal) {
+            goal_facts.push_back(ff.var_offset[v] + val);
+        }
+        // 各層で少なくとも 1 つの演算子を適用するので、層の数に最も安い演算子のコストを掛けても許容的 (単位コストでは層の数そのもの)
+        if (!task.ops.empty()) {
+            int c = task.ops[0].cost;
+            for (const auto& op : task.ops) {
+                c = std::min(c, op.cost);
+            }
+            layer_cost = std::max(c, 0);
+        }
+    }
+
+    // states[0..n) (n <= LANES) の h^max を out[0..n) に書く関数 (ゴールに到達できない状態は 2^16)
+    void compute(const State* const* states, std::size_t n, double* out) const {
+        const double PSEUDOINF = 1 << 16;
+        const int nfacts = ff.nfacts;
+
+        Lanes active{};
+        for (std::size_t i = 0; i < n; ++i) {
+            active.w[i / 64] |= uint64_t(1) << (i % 64);
+        }
+
+        std::vector<Lanes> reached(nfacts, Lanes{});
+        for (std::size_t i = 0; i < n; ++i) {
+            const State& s = *states[i];
+            for (int v = 0; v < ff.nvars; ++v) {
+                reached[ff.var_offset[v] + s[v]].w[i / 64] |= uint64_t(1) << (i % 64);
+            }
+        }
+        std::vector<Lanes> next = reached;
+
+        Lanes done{};
+        // 全てのゴールに到達したレーンに、現在の層の番号を書く関数 (全てのレーンが終わったかどうかを返す)
+        auto finish_layer = [&](int layer) {
+            Lanes g = active;
+            for (int f : goal_facts) {
+                for (int k = 0; k < LANE_WORDS; ++k) {
+                    g.w[k] &= reached[f].w[k];
+                }
+            }
+            bool all = true;
+            for (int k = 0; k < LANE_WORDS; ++k) {
+                uint64_t fresh = g.w[k] & ~done.w[k];
+                done.w[k] |= fresh;
+                while (fresh != 0) {
+                    const int b = __builtin_ctzll(fresh);
+                    out[k * 64 + b] = static_cast<double>(layer) * layer_cost;
+                    fresh &= fresh - 1;
+                }
+                all = all && (done.w[k] == active.w[k]);
+            }
+            return all;
+        };
+
+        bool all_done = finish_layer(0);
+        for (int layer = 1; !all_done; ++layer) {
+            bool changed = false;
+            for (const auto& act : ff.actions) {
+                Lanes app = active;
+                for (int p : act.pre) {
+                    for (int k = 0; k < LANE_WORDS; ++k) {
+                        app.w[k] &= reached[p].w[k];
+                    }
+                }
+                for (int q : act.add) {
+                    for (int k = 0; k < LANE_WORDS; ++k) {
+                        const uint64_t add = app.w[k] & ~next[q].w[k];
+                        next[q].w[k] |= add;
+                        changed = changed || (add != 0);
+                    }
+                }
+            }
+            if (!changed) {
+                break;
+            }
+            reached = next;
+            all_done = finish_layer(layer);
+        }
+
+        for (std::size_t i = 0; i < n; ++i) {
+            if (!((done.w[i / 64] >> (i % 64)) & 1)) {
+                out[i] = PSEUDOINF;
+            }
+        }
+    }
+};
+
 } // anonymous namespace
 
 // ランドマークヒューリスティック用のデータ構造
@@ -488,19 +600,146 @@ struct LMData {
 
 
 HeuristicFn hff(const Task& T) {
+    PLANNER_ALLOC_PHASE(HeuristicSetup);
     // Task ごとに FFData を構築する
     auto data = std::make_shared<FFData>(T);
 
     return [data](const Task& /*unused*/, const State& s) -> double {
+        PLANNER_ALLOC_PHASE(Evaluation);
         return data->compute(s);
     };
 }
 
+HeuristicFn hmax(const Task& T) {
+    PLANNER_ALLOC_PHASE(HeuristicSetup);
+    auto data = std::make_shared<HmaxData>(T);
+
+    return [data](const Task& /*unused*/, const State& s) -> double {
+        PLANNER_ALLOC_PHASE(Evaluation);
+        const State* one = &s;
+        double h = 0.0;
+        data->compute(&one, 1, &h);
+        return h;
+    };
+}
+
+BatchHeuristicFn hmax_batched(const Task& T) {
+    PLANNER_ALLOC_PHASE(HeuristicSetup);
+    auto data = std::make_shared<HmaxData>(T);
+
+    return [data](const Task& /*unused*/, const std::vector<State>& states, std::vector<double>& out) {
+        PLANNER_ALLOC_PHASE(Evaluation);
+        out.resize(states.size());
+        std::vector<const State*> ptrs(LANES);
+        for (std::size_t lo = 0; lo < states.size(); lo += LANES) {
+            const std::size_t n = std::min(LANES, states.size() - lo);
+            for (std::size_t i = 0; i < n; ++i) {
+                ptrs[i] = &states[lo + i];
+            }
+            data->compute(ptrs.data(), n, out.data() + lo);
+        }
+    };
+}
+
+std::size_t hmax_batch_lanes() noexcept {
+    return LANES;
+}
+
+BatchHeuristicFn batched(HeuristicFn h) {
+    return [h = std::move(h)](const Task& T, const std::vector<State>& states, std::vector<double>& out) {
+        out.resize(states.size());
+        for (std::size_t i = 0; i < states.size(); ++i) {
+            out[i] = h(T, states[i]);
+        }
+    };
+}
+
+namespace {
+// async_heuristic が返す関数の本体 (resolve_async() が型で見分けるため、名前のある型にする)
+struct AsyncHeuristic {
+    std::shared_future<HeuristicFn> ready;
+
+    // resolve_async() を経ずに呼ばれた場合 (他の関数で包まれた場合など) は、評価ごとに完成を待つ
+    double operator()(const Task& T, const State& s) const {
+        return ready.get()(T, s);
+    }
+};
+} // namespace
+
+HeuristicFn async_heuristic(std::function<HeuristicFn()> build) {
+    return AsyncHeuristic{std::async(std::launch::async, std::move(build)).share()};
+}
+
+void resolve_async(HeuristicFn& h) {
+    if (const auto* a = h.target<AsyncHeuristic>()) {
+        HeuristicFn built = a->ready.get(); // h を置き換える前に完成した関数を取り出す (a は h と共に破棄される)
+        h = std::move(built);
+    }
+}
+
+bool heuristic_is_admissible(const std::string& name) {
+    // table は読み込んだゴール距離表 (距離 × 最小演算子コストで、MAX_DIST での打ち切りも下界になる)
+    return name == "blind" || name == "lm_ucp" || name == "lm_ocp" ||
+           name == "seq" || name == "pho" || name == "oc" ||
+           name == "pot" || name == "pot_samples" || name == "hmax" || name == "table";
+}
+
+namespace {
+using HeuristicBuilder = HeuristicFn (*)(const Task&);
+
+// --h の名前に対応する構築関数 (未知の名前は nullptr)
+HeuristicBuilder find_heuristic(const std::string& name) {
+    static const std::pair<const char*, HeuristicBuilder> builders[] = {
+        {"goalcount", [](const Task&) { return goalcount(); }},
+        {"blind", [](const Task&) { return blind(); }},
+        {"ff", hff},
+        {"hmax", hmax},
+        {"lm", hlm},
+        {"lm_ucp", hlm_ucp},
+        {"lm_ocp", hlm_ocp},
+        {"seq", hseq},
+        {"pho", hpho},
+        {"oc", hoc},
+        {"pot", hpot_init},
+        {"pot_samples", hpot_samples},
+        {"cg", hcg},
+        {"cea", hcea},
+    };
+    for (const auto& [n, build] : builders) {
+        if (name == n) {
+            return build;
+        }
+    }
+    return nullptr;
+}
+} // namespace
+
+HeuristicFn make_heuristic(const std::string& name, const Task& T) {
+    const HeuristicBuilder build = find_heuristic(name);
+    if (build == nullptr) {
+        throw std::invalid_argument("unknown heuristic: " + name);
+    }
+    return build(T);
+}
+
+HeuristicFn make_heuristic_async(const std::string& name, const Task& T) {
+    const HeuristicBuilder build = find_heuristic(name);
+    if (build == nullptr) {
+        throw std::invalid_argument("unknown heuristic: " + name);
+    }
+    if (name == "goalcount" || name == "blind") {
+        return build(T); // 前計算がないので、スレッドを起こすまでもない
+    }
+    return async_heuristic([build, &T] { return build(T); });
+}
+
 HeuristicFn hlm(const Task& T) {
+    PLANNER_ALLOC_PHASE(HeuristicSetup);
     // Task ごとに landmark fact に関するデータを生成する
     auto data = std::make_shared<LMData>(T);
 
     return [data](const Task& /*unused*/, const State& s) -> double {
+        PLANNER_ALLOC_PHASE(Evaluation);
         return data->compute(s);
     };
 }
@@ -1,8 +1,15 @@
 #include "sas/sas_reader.hpp"
+#include "alloc_profile.hpp"
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
 #include <cctype>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
 
 namespace planner { namespace sas {
 
@@ -23,188 +30,52 @@ static std::string trim(const std::string& s) {
     return s.substr(a,b-a);
 }
 
-// SAS 形式ファイルを読み取る関数
-Task read_file(const std::string& path) {
-    std::ifstream fin(path);
-    if (!fin) throw std::runtime_error("cannot open SAS file: " + path);
+// 行を 1 つずつ読み、前後の空白を取り除いて返すクラス (1 行先読みできる)
+// ファイル全体を行の配列に読み込まずに済むので、読み込みと解析を並行して進められる
+class LineReader {
+public:
+    explicit LineReader(std::istream& in) : in_(in) { fill(); }
 
-    // 全て読み込んで行ポインタで進める
-    std::vector<std::string> L;
-    L.reserve(200000);
-    for (std::string line; std::getline(fin, line); ) {
-        L.push_back(trim(line)); // 空白を取り除いた行を L に積んでいく
-    }
+    bool eof() const { return !has_; }
+    const std::string& peek() const { return cur_; }
+    std::size_t line() const { return line_; } // 次に返す行の番号 (0 始まり)
 
-    // 予想した文字列と比較する関数
-    auto expect = [&](size_t& i, const std::string& key){
-        if (i>=L.size() || L[i] != key) {
-            throw std::runtime_error("SAS parse error: expect '" + key + "' at line " + std::to_string(i));
+    // 次の行を取り出す関数 (ファイルの末尾の場合は what を含む例外を投げる)
+    std::string take(const char* what) {
+        if (!has_) {
+            throw std::runtime_error(std::string("unexpected EOF ") + what);
         }
-        ++i; // 行を一つ進める
-    };
-
-    // 最初の行からファイルを読み進めていく
-    size_t i=0;
-    Task T;
-    expect(i, "begin_version"); // 最初はバージョン情報
-    if (i>=L.size()) { // もし、ファイルが begin_version の直後で終わってしまっている場合
-        throw std::runtime_error("unexpected EOF after begin_version");
-    }
-    T.version = to_int(L[i++]); // version 情報を整数型に変換し、その後タスク情報に挿入する 3(str) -> 3(int)
-    expect(i, "end_version"); // end_version であることを確かめる
-
-    expect(i, "begin_metric");
-    if (i>=L.size()) {
-        throw std::runtime_error("unexpected EOF after begin_metric");
-    }
-    T.metric = to_int(L[i++]);
-    expect(i, "end_metric");
-
-    // 変数は "N" の後に N 回 "begin_variable ... end_variable" が続く
-    if (i>=L.size()) {
-        throw std::runtime_error("unexpected EOF reading variable count");
+        std::string s = std::move(cur_);
+        ++line_;
+        fill();
+        return s;
     }
-    int nvars = to_int(L[i++]);
-    T.vars.reserve(nvars);
-
-    // 変数の読み取り
-    for (int v=0; v<nvars; ++v) {
 
-        // structure example
-        // begin_variable
-        // var0 (variable name)
-        // -1 (invalid value)
-        // 2 (number of possible domain values)
-        // Atom clear(pos-8-6)
-        // NegatedAtom clear(pos-8-6)
-        // end_variable
-
-        expect(i, "begin_variable");
-        if (i>=L.size()) {
-            throw std::runtime_error("unexpected EOF in variable block");
-        }
-        Variable V;
-        V.name = L[i++];
-        if (i>=L.size()) {
-            throw std::runtime_error("unexpected EOF in variable block");
-        }
-        to_int(L[i++]); // 無効値の箇所を文字列型から整数型へ変換する -1(str) -> -1(int)
-        if (i>=L.size()) {
-            throw std::runtime_error("unexpected EOF in variable block");
-        }
-        V.domain = to_int(L[i++]); // ドメインサイズを読み取る
-
-        // ドメイン個数分の Atom/NegatedAtom のラベル行を読み飛ばす
-        for (int k=0;k<V.domain;++k) {
-            if (i>=L.size()) {
-                throw std::runtime_error("unexpected EOF in variable atoms");
-            }
-            ++i;
+    // 次の行が key であることを確かめて読み飛ばす関数
+    void expect(const std::string& key) {
+        if (!has_ || cur_ != key) {
+            throw std::runtime_error("SAS parse error: expect '" + key + "' at line " + std::to_string(line_));
         }
-        expect(i, "end_variable");
-        T.vars.push_back(V);
+        ++line_;
+        fill();
     }
 
-    // 排他グループの読み取り
-    auto parse_mutex_group = [&](size_t& i2){
-
-        // Structure example
-        // begin_mutex_group
-        // 3 (グループに含まれるリテラルの数)
-        // 24 3
-        // 25 3 (var_id & domain_value)
-        // 7 0
-        // end_mutex_group
-
-        expect(i2, "begin_mutex_group");
-        if (i2>=L.size()) {
-            throw std::runtime_error("unexpected EOF in mutex group");
-        }
-        int k = to_int(L[i2++]); // グループ内のリテラルの個数
-        MutexGroup G;
-        G.lits.reserve(k);
-        for (int t=0; t<k; ++t) {
-            if (i2>=L.size()) {
-                throw std::runtime_error("unexpected EOF in mutex rows");
-            }
-            std::istringstream iss(L[i2++]);
-            int var, val;
-            if (!(iss>>var>>val)) { // 文字列ストリームから、二つの整数値を抽出できなかった場合
-                throw std::runtime_error("bad mutex row");
-            }
-            G.lits.emplace_back(var,val);
-        }
-        expect(i2, "end_mutex_group");
-        T.mutexes.push_back(std::move(G)); // タスクに排他グループの情報を挿入する
-    };
-
-    // 件数が明示されている場合
-    if (i < L.size() && L[i] != "begin_state") {
-        bool consumed_count = false;
-        try {
-            int mcount = to_int(L[i]); // 数なら件数とみなす
-            ++i;
-            consumed_count = true;
-            T.mutexes.reserve(mcount);
-            for (int m=0; m<mcount; ++m) {
-                parse_mutex_group(i);
-            }
-        } catch (...) { /* 数でなければスルー */ }
-        // 件数なしで連続している場合
-        while (i < L.size() && L[i] == "begin_mutex_group") {
-            parse_mutex_group(i);
-        }
-    }    
-
-    // 初期状態の読み取り
-
-    // Sturucture example
-    // begin_state
-    // 1
-    // 0       (各変数の初期値)
-    // 2
-    // :
-    //end_state
-
-    expect(i, "begin_state");
-    T.init.resize(nvars);
-    for (int v=0; v<nvars; ++v) {
-        if (i>=L.size()) {
-            throw std::runtime_error("unexpected EOF in begin_state");
-        }
-        T.init[v] = to_int(L[i++]); // 0..domain-1
+private:
+    void fill() {
+        std::string raw;
+        has_ = static_cast<bool>(std::getline(in_, raw));
+        cur_ = has_ ? trim(raw) : std::string();
     }
-    expect(i, "end_state");
 
-    // ゴール状態の読み取り
+    std::istream& in_;
+    std::string cur_;
+    bool has_ = false;
+    std::size_t line_ = 0;
+};
 
-    // Structure example
-    // begin_goal
-    // 2      (ゴール条件の数)
-    // 0 0    (変数 0 が 0)
-    // 1 1    (変数 1 が 1) 
-    // end_goal
-
-    expect(i, "begin_goal");
-    if (i>=L.size()) {
-        throw std::runtime_error("unexpected EOF in begin_goal");
-    }
-    int g = to_int(L[i++]);
-    T.goal.reserve(g);
-    for (int t=0;t<g;++t) {
-        if (i>=L.size()) {
-            throw std::runtime_error("unexpected EOF in goal rows");
-        }
-        std::istringstream iss(L[i++]);
-        int var,val;
-        if (!(iss>>var>>val)) {
-            throw std::runtime_error("bad goal row");
-        }
-        T.goal.emplace_back(var,val);
-    }
-    expect(i, "end_goal");
-
-    // 残りの演算子部分の読み取り (ファイル末尾に数字 (0) あり)
+// 演算子の並び (begin_operator ... end_operator の繰り返し) の行 L を解析し、out に追加する関数
+static void parse_operators(const std::vector<std::string>& L, std::vector<Operator>& out) {
+    std::size_t i = 0;
 
     // Structure example
     // begin_operator
@@ -292,13 +163,289 @@ Task read_file(const std::string& path) {
             }
             ++i;
 
-            T.ops.push_back(std::move(op));
-        } else if (L[i].empty()) { // 空の行の場合
-            ++i; // 行を一つ読み飛ばす
-        } else { // 余白や末尾の数字などの場合
+            out.push_back(std::move(op));
+        } else { // 空の行や、演算子の数、末尾の数字などの場合
             ++i;
         }
     }
+}
+
+// --- 演算子の解析の並列化 ---
+// 読み込み側のスレッドが演算子の行を OPS_PER_CHUNK 個ずつの塊に切り出して渡し、作業スレッドが塊ごとに解析する
+// 塊が 1 つしかない (小さなタスクの) 場合はスレッドを作らず、呼び出し元で解析する
+class OperatorPipeline {
+public:
+    static constexpr std::size_t OPS_PER_CHUNK = 256;
+
+    explicit OperatorPipeline(unsigned threads) : threads_(threads) {}
+
+    ~OperatorPipeline() {
+        close();
+    }
+
+    void submit(std::vector<std::string>&& lines) {
+        if (threads_ == 0) {
+            parse_operators(lines, results_.emplace_back());
+            return;
+        }
+        if (workers_.empty()) {
+            if (!has_pending_) { // 最初の塊は、2 つ目の塊が来るまで保留する
+                pending_ = std::move(lines);
+                has_pending_ = true;
+                return;
+            }
+            for (unsigned t = 0; t < threads_; ++t) {
+                workers_.emplace_back([this] { work(); });
+            }
+            push(std::move(pending_));
+            has_pending_ = false;
+        }
+        push(std::move(lines));
+    }
+
+    // 全ての塊の解析を待ち、演算子を元の順に out へ移す関数 (解析中の例外はここで投げ直す)
+    void finish(std::vector<Operator>& out) {
+        if (has_pending_) {
+            parse_operators(pending_, results_.emplace_back());
+            has_pending_ = false;
+        }
+        close();
+        if (err_) {
+            std::rethrow_exception(err_);
+        }
+        std::size_t n = 0;
+        for (const auto& r : results_) {
+            n += r.size();
+        }
+        out.reserve(out.size() + n);
+        for (auto& r : results_) {
+            for (auto& op : r) {
+                out.push_back(std::move(op));
+            }
+        }
+    }
+
+private:
+    struct Job {
+        std::vector<std::string> lines;
+        std::vector<Operator>* out;
+    };
+
+    void push(std::vector<std::string>&& lines) {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            jobs_.push_back(Job{std::move(lines), &results_.emplace_back()}); // deque なので既存の要素は移動しない
+        }
+        cv_.notify_one();
+    }
+
+    void work() {
+        PLANNER_ALLOC_PHASE(Parse);
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lk(mu_);
+                cv_.wait(lk, [this] { return closed_ || !jobs_.empty(); });
+                if (jobs_.empty()) {
+                    return;
+                }
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            try {
+                parse_operators(job.lines, *job.out);
+            } catch (...) {
+                std::lock_guard<std::mutex> lk(mu_);
+                if (!err_) {
+                    err_ = std::current_exception();
+                }
+            }
+        }
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            closed_ = true;
+        }
+        cv_.notify_all();
+        for (auto& w : workers_) {
+            w.join();
+        }
+        workers_.clear();
+    }
+
+    unsigned threads_;
+    bool has_pending_ = false;
+    std::vector<std::string> pending_;
+    std::deque<std::vector<Operator>> results_; // 塊ごとの解析結果 (塊の順)
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<Job> jobs_;
+    bool closed_ = false;
+    std::exception_ptr err_;
+    std::vector<std::thread> workers_;
+};
+
+// SAS 形式ファイルを読み取る関数
+Task read_file(const std::string& path, int parse_threads) {
+    std::ifstream fin(path);
+    if (!fin) throw std::runtime_error("cannot open SAS file: " + path);
+    return read_stream(fin, parse_threads);
+}
+
+// SAS 形式のテキストをストリームから読み取る関数
+Task read_stream(std::istream& fin, int parse_threads) {
+    PLANNER_ALLOC_PHASE(Parse);
+    LineReader R(fin);
+
+    Task T;
+    R.expect("begin_version"); // 最初はバージョン情報
+    T.version = to_int(R.take("after begin_version")); // version 情報を整数型に変換し、その後タスク情報に挿入する 3(str) -> 3(int)
+    R.expect("end_version"); // end_version であることを確かめる
+
+    R.expect("begin_metric");
+    T.metric = to_int(R.take("after begin_metric"));
+    R.expect("end_metric");
+
+    // 変数は "N" の後に N 回 "begin_variable ... end_variable" が続く
+    int nvars = to_int(R.take("reading variable count"));
+    T.vars.reserve(nvars);
+
+    // 変数の読み取り
+    for (int v=0; v<nvars; ++v) {
+
+        // structure example
+        // begin_variable
+        // var0 (variable name)
+        // -1 (invalid value)
+        // 2 (number of possible domain values)
+        // Atom clear(pos-8-6)
+        // NegatedAtom clear(pos-8-6)
+        // end_variable
+
+        R.expect("begin_variable");
+        Variable V;
+        V.name = R.take("in variable block");
+        to_int(R.take("in variable block")); // 無効値の箇所を文字列型から整数型へ変換する -1(str) -> -1(int)
+        V.domain = to_int(R.take("in variable block")); // ドメインサイズを読み取る
+
+        // ドメイン個数分の Atom/NegatedAtom のラベル行を読み飛ばす
+        for (int k=0;k<V.domain;++k) {
+            R.take("in variable atoms");
+        }
+        R.expect("end_variable");
+        T.vars.push_back(V);
+    }
+
+    // 排他グループの読み取り
+    auto parse_mutex_group = [&](){
+
+        // Structure example
+        // begin_mutex_group
+        // 3 (グループに含まれるリテラルの数)
+        // 24 3
+        // 25 3 (var_id & domain_value)
+        // 7 0
+        // end_mutex_group
+
+        R.expect("begin_mutex_group");
+        int k = to_int(R.take("in mutex group")); // グループ内のリテラルの個数
+        MutexGroup G;
+        G.lits.reserve(k);
+        for (int t=0; t<k; ++t) {
+            std::istringstream iss(R.take("in mutex rows"));
+            int var, val;
+            if (!(iss>>var>>val)) { // 文字列ストリームから、二つの整数値を抽出できなかった場合
+                throw std::runtime_error("bad mutex row");
+            }
+            G.lits.emplace_back(var,val);
+        }
+        R.expect("end_mutex_group");
+        T.mutexes.push_back(std::move(G)); // タスクに排他グループの情報を挿入する
+    };
+
+    // 件数が明示されている場合
+    if (!R.eof() && R.peek() != "begin_state") {
+        try {
+            int mcount = to_int(R.peek()); // 数なら件数とみなす
+            R.take("reading mutex count");
+            T.mutexes.reserve(mcount);
+            for (int m=0; m<mcount; ++m) {
+                parse_mutex_group();
+            }
+        } catch (...) { /* 数でなければスルー */ }
+        // 件数なしで連続している場合
+        while (!R.eof() && R.peek() == "begin_mutex_group") {
+            parse_mutex_group();
+        }
+    }    
+
+    // 初期状態の読み取り
+
+    // Sturucture example
+    // begin_state
+    // 1
+    // 0       (各変数の初期値)
+    // 2
+    // :
+    //end_state
+
+    R.expect("begin_state");
+    T.init.resize(nvars);
+    for (int v=0; v<nvars; ++v) {
+        T.init[v] = to_int(R.take("in begin_state")); // 0..domain-1
+    }
+    R.expect("end_state");
+
+    // ゴール状態の読み取り
+
+    // Structure example
+    // begin_goal
+    // 2      (ゴール条件の数)
+    // 0 0    (変数 0 が 0)
+    // 1 1    (変数 1 が 1) 
+    // end_goal
+
+    R.expect("begin_goal");
+    int g = to_int(R.take("in begin_goal"));
+    T.goal.reserve(g);
+    for (int t=0;t<g;++t) {
+        std::istringstream iss(R.take("in goal rows"));
+        int var,val;
+        if (!(iss>>var>>val)) {
+            throw std::runtime_error("bad goal row");
+        }
+        T.goal.emplace_back(var,val);
+    }
+    R.expect("end_goal");
+
+    // 残りの演算子部分 (ファイル末尾に数字 (0) あり) は、塊に切り出しながら並行して解析する
+    if (parse_threads < 0) {
+        const unsigned hc = std::thread::hardware_concurrency();
+        parse_threads = static_cast<int>(std::min(4u, hc > 1 ? hc - 1 : 0u));
+    }
+    OperatorPipeline pipe(static_cast<unsigned>(parse_threads));
+    std::vector<std::string> chunk;
+    std::size_t ops_in_chunk = 0;
+    bool in_op = false;
+    while (!R.eof()) {
+        std::string line = R.take("in operators");
+        if (!in_op && line != "begin_operator") {
+            continue; // 演算子の数や axiom の数などの行
+        }
+        in_op = (line != "end_operator");
+        chunk.push_back(std::move(line));
+        if (!in_op && ++ops_in_chunk == OperatorPipeline::OPS_PER_CHUNK) {
+            pipe.submit(std::move(chunk));
+            chunk.clear();
+            ops_in_chunk = 0;
+        }
+    }
+    if (!chunk.empty()) {
+        pipe.submit(std::move(chunk));
+    }
+    pipe.finish(T.ops);
     return T;
 }
 
@@ -306,6 +453,55 @@ Task read_file(const std::string& path) {
 
 namespace planner { namespace sas {
 
+// タスクを SAS 形式で書き出す関数 (read_file で読み戻せる。原子命題の名前は保持していないので "Atom v<変数>=<値>" とする)
+void write_sas(const Task& T, std::ostream& out) {
+    out << "begin_version\n" << T.version << "\nend_version\n";
+    out << "begin_metric\n" << T.metric << "\nend_metric\n";
+    out << T.vars.size() << "\n";
+    for (std::size_t v = 0; v < T.vars.size(); ++v) {
+        out << "begin_variable\n" << T.vars[v].name << "\n-1\n" << T.vars[v].domain << "\n";
+        for (int d = 0; d < T.vars[v].domain; ++d) {
+            out << "Atom v" << v << "=" << d << "\n";
+        }
+        out << "end_variable\n";
+    }
+    out << T.mutexes.size() << "\n";
+    for (const auto& G : T.mutexes) {
+        out << "begin_mutex_group\n" << G.lits.size() << "\n";
+        for (auto [var, val] : G.lits) {
+            out << var << " " << val << "\n";
+        }
+        out << "end_mutex_group\n";
+    }
+    out << "begin_state\n";
+    for (int x : T.init) {
+        out << x << "\n";
+    }
+    out << "end_state\n";
+    out << "begin_goal\n" << T.goal.size() << "\n";
+    for (auto [var, val] : T.goal) {
+        out << var << " " << val << "\n";
+    }
+    out << "end_goal\n";
+    out << T.ops.size() << "\n";
+    for (const auto& op : T.ops) {
+        out << "begin_operator\n" << op.name << "\n" << op.prevail.size() << "\n";
+        for (auto [var, val] : op.prevail) {
+            out << var << " " << val << "\n";
+        }
+        out << op.pre_posts.size() << "\n";
+        for (const auto& [conds, var, pre, post] : op.pre_posts) {
+            out << conds.size();
+            for (auto [cv, cval] : conds) {
+                out << " " << cv << " " << cval;
+            }
+            out << " " << var << " " << pre << " " << post << "\n";
+        }
+        out << op.cost << "\nend_operator\n";
+    }
+    out << "0\n"; // axiom の数
+}
+
 // 排他グループに反しているかどうか判定する関数
 bool violates_mutex(const Task& T, const State& s) {
     for (const auto& G : T.mutexes) {
@@ -1,11 +1,21 @@
 #include "sas/sas_search.hpp"
+#include "sas/search_utils.hpp"
+#include "sas/dense_state_table.hpp"
+#include "sas/state_index.hpp"
+#include "sas/node_store.hpp"
 #include "bucket_pq.hpp"
-#include <robin_hood.h>
+#include "alloc_profile.hpp"
+#include <algorithm>
 #include <atomic>
+#include <memory>
+#include <type_traits>
 #include <queue>
-#include <unordered_map>
 #include <cmath>
 #include <sstream>
+#include <fstream>
+#if defined(__linux__)
+#include <unistd.h>
+#endif
 #include <iomanip>
 #include <limits>
 #include <cassert>
@@ -17,39 +27,6 @@ using Task = planner::sas::Task;
 using Operator = planner::sas::Operator;
 
 int g_mutex_mode = 0;
-enum { MUTEX_AUTO=0, MUTEX_ON=1, MUTEX_OFF=2 };
-
-static inline bool should_check_mutex_runtime(const Task& T) {
-    using namespace planner::sas;
-    if (g_mutex_mode == MUTEX_OFF) {
-        return false;
-    }
-    if (g_mutex_mode == MUTEX_ON)  {
-        return true;
-    }
-    return !T.mutexes.empty();
-}
-
-// ハッシュ／比較
-struct VecHash {
-    std::size_t operator()(const State& v) const noexcept {
-        // シンプルな 64-bit mix
-        std::size_t h = 1469598103934665603ull;
-        for (int x : v) {
-            std::size_t y = static_cast<std::size_t>(x) + 0x9e3779b97f4a7c15ull;
-            h ^= y;
-            h *= 1099511628211ull;
-        }
-        return h;
-    }
-};
-
-struct VecEq {
-    bool operator()(const State& a, const State& b) const noexcept {
-        return a == b;
-    }
-};
-
 // プラン評価/表示
 double eval_plan_cost(const Task& T, const std::vector<uint32_t>& plan) {
     double c = 0.0;
@@ -81,401 +58,903 @@ std::string plan_to_val(const Task& T, const std::vector<uint32_t>& plan) {
 }
 
 
-// ゴール判定
-static inline bool is_goal(const Task& T, const State& s) {
-    for (auto [v,val] : T.goal) {
-        if (s[v] != val) {
-            return false;
+// ノード→プラン復元
+static std::vector<uint32_t> extract_plan(const std::vector<Node>& nodes, int goal_id) {
+    std::vector<uint32_t> acts;
+    for (int v = goal_id; v >= 0 && nodes[v].parent >= 0; v = nodes[v].parent) {
+        acts.push_back(nodes[v].act_id);
+    }
+    std::reverse(acts.begin(), acts.end());
+    return acts;
+}
+
+// コスト上界が指定されているかどうか判定する関数
+static inline bool bound_enabled(const Params& p) {
+    return std::isfinite(p.cost_bound);
+}
+
+// CPU 時間の audit の設定
+std::atomic<bool> g_search_timed_out{false};
+bool g_cpu_budget_enabled = false; // set_search_cpu_budget() で有効にするまでは確認しない
+double g_cpu_limit_sec = -1.0;
+double g_cpu_start_sec = 0.0;
+
+// 現在の常駐メモリ (RSS) をバイト単位で返す関数 (取得できない環境では 0 を返す)
+static std::size_t current_rss_bytes() {
+#if defined(__linux__)
+    std::ifstream ifs("/proc/self/statm");
+    std::size_t pages_total = 0, pages_resident = 0;
+    if (ifs >> pages_total >> pages_resident) {
+        return pages_resident * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    }
+#endif
+    return 0;
+}
+
+bool search_interrupted(const Params& p, Result& R) {
+    if (planner::sas::time_exceeded_cpu()) {
+        R.stop = StopReason::Timeout;
+        return true;
+    }
+
+    const SearchControl* c = p.control;
+    if (c == nullptr) {
+        return false;
+    }
+    if (c->cancel != nullptr && c->cancel->load(std::memory_order_relaxed)) {
+        R.stop = StopReason::Cancelled;
+        return true;
+    }
+
+    const uint64_t n = R.stats.expanded;
+    if ((n & 255) == 0) { // 時刻の確認は 256 展開ごと
+        if (std::chrono::steady_clock::now() >= c->deadline) {
+            R.stop = StopReason::Timeout;
+            return true;
         }
+        if (c->memory_budget_bytes > 0 && (n & 4095) == 0 && current_rss_bytes() > c->memory_budget_bytes) { // /proc の読み込みは 4096 展開ごと
+            R.stop = StopReason::MemoryLimit;
+            return true;
+        }
+    }
+    if (c->on_progress && c->progress_interval > 0 && n >= c->next_progress) {
+        c->next_progress = n + c->progress_interval;
+        const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - c->start).count();
+        c->on_progress(Progress{R.stats, elapsed});
     }
-    return true;
+    return false;
+}
+
+std::ostream& note_out(const Params& p) {
+    // バッファを持たないストリームへの出力は捨てられる (書き込みのたびに状態フラグを書き換えるので、スレッドごとに持つ)
+    thread_local std::ostream null_out(nullptr);
+    return p.verbose ? std::cout : null_out;
 }
 
-// 適用判定
-static inline bool is_applicable(const Task& T, const State& s, const Operator& op) {
-    (void)T; // 現状では未使用
-    // prevail 条件
-    for (auto [v,val] : op.prevail) {
-        if (s[v] != val) {
-            return false;
+// --- 整数コストの A* のコストモデル ---
+// 全ての演算子のコストが 1 の場合は UnitCost で特殊化し、コストの読み出しと加算を定数にする
+// UnitCost では、ゴール判定を後続状態の生成時に行い、オープンリストを f の層ごとの FIFO バケットにする
+struct IntegerCost {
+    static constexpr bool unit = false;
+    static int cost(const Operator& op) { return rounding(op.cost); }
+};
+
+struct UnitCost {
+    static constexpr bool unit = true;
+    static constexpr int cost(const Operator&) { return 1; }
+};
+
+// 単位コストの探索で、生成時に見つけたゴールのうち g 値が最小のもの
+// オープンリストの f の最小値が g 値に達した時点で、このゴールへのプランが最適になる (ヒューリスティックは許容的とする)
+template <class Id>
+struct GeneratedGoal {
+    Id id{};
+    int g = std::numeric_limits<int>::max();
+
+    bool found() const { return g != std::numeric_limits<int>::max(); }
+
+    void offer(Id v, int gv) {
+        if (gv < g) {
+            id = v;
+            g = gv;
         }
     }
+};
 
-    // 条件付き効果の条件
-    for (const auto& pp : op.pre_posts) {
-        const auto& conds = std::get<0>(pp);
-        for (auto [cv,cval] : conds) {
-            if (s[cv] != cval) {
-                return false;
-            }
+// --- 密な状態表を用いた整数 A* / GBFS ---
+// 状態空間がランク付けできる大きさの場合に用いる、状態の重複判定は表への 1 回のアクセスで済む
+// 状態そのものは保存せず、展開時にランクから復元する
+
+template <class CM>
+static SearchSteps astar_dense(const Task& T, HeuristicFn& h, const Params& p, const StateRanker ranker, Result& R) {
+    {
+        const bool do_mutex = should_check_mutex_runtime(T);
+        if (do_mutex) {
+            note_out(p) << "Mutex check: ON\n";
+        } else {
+            note_out(p) << "Mutex check: OFF\n";
         }
     }
 
-    // pre_post の pre チェック（-1 は don't care）
-    for (const auto& pp : op.pre_posts) {
-        int var = std::get<1>(pp);
-        int pre = std::get<2>(pp);
-        if (pre >= 0 && s[var] != pre) {
-            return false;
+    if constexpr (CM::unit) {
+        note_out(p) << "Note: all action costs are 1; using unit-cost A* + FIFO buckets over a dense state table ("
+                  << ranker.num_states() << " states).\n";
+    } else {
+        note_out(p) << "Note: all action costs are integers; using integer A* + BucketPQ over a dense state table ("
+                  << ranker.num_states() << " states).\n";
+    }
+
+    DenseStateTable meta(ranker.num_states());
+    std::conditional_t<CM::unit, FifoBucketQueue<uint32_t>, LazyBucketQueue<uint32_t>> open;
+    GeneratedGoal<uint64_t> gen_goal;
+
+    const State& s0 = R.nodes[0].s;
+    const uint64_t r0 = ranker.rank(s0);
+
+    resolve_async(h); // 非同期に作ったヒューリスティックは、ここで完成を待つ
+    const int h0 = rounding(h(T, s0));
+    ++R.stats.evaluated;
+    if (h0 >= p.cost_bound) {
+        ++R.stats.pruned_by_bound;
+        R.bound_exhausted = true;
+        co_return;
+    }
+    meta[r0].set(0, DenseMeta::NO_PARENT, 0);
+    meta[r0].set_h(h0);
+    open.insert(static_cast<uint32_t>(r0), pack_fh_asc(h0, h0));
+
+    auto solved_at = [&](uint64_t r) {
+        R.solved = true;
+        R.plan = extract_plan_dense(meta, r);
+        R.plan_cost = eval_plan_cost(T, R.plan);
+    };
+
+    State su;
+    State work;
+    Undo undo;
+
+    while (!open.empty()) {
+        co_yield R.stats.expanded; // 展開数が上限に達していれば、ここで中断する
+        if (search_interrupted(p, R)) {
+            co_return;
+        }
+
+        auto [ru32, key] = open.extract_min();
+        const uint64_t ru = ru32;
+        const int fu = unpack_f(key);
+        const int hu = unpack_h(key);
+
+        // 古いエントリの読み捨て (h は状態ごとに不変なので、g+h が f と一致しなければ古い)
+        DenseMeta& mu = meta[ru];
+        if (mu.closed() || mu.g() + hu != fu) continue;
+
+        if constexpr (CM::unit) {
+            if (gen_goal.found() && fu >= gen_goal.g) {
+                solved_at(gen_goal.id);
+                co_return;
+            }
+        }
+
+        ranker.unrank(ru, su);
+
+        if (is_goal(T, su)) {
+            solved_at(ru);
+            co_return;
+        }
+
+        mu.close();
+        const int gu = mu.g();
+
+        ++R.stats.expanded;
+        if (R.stats.expanded > p.max_expansions) co_return;
+
+        for (int a=0; a<(int)T.ops.size(); ++a) {
+            const auto& op = T.ops[a];
+            if (!is_applicable(T, su, op)) continue;
+
+            work = su;
+            undo.clear();
+            const std::size_t mark = undo_mark(undo);
+
+            UndoGuard ug{work, undo, mark};
+
+            apply_inplace(T, op, work, undo);
+            ++R.stats.generated;
+
+            // 生成状態が mutex 違反なら捨てる
+            if (should_check_mutex_runtime(T)) {
+                if (planner::sas::violates_mutex(T, work)) {
+                    continue;
+                }
+            }
+
+            const int tentative_g = gu + CM::cost(op);
+
+            // g-value だけで上界に達している場合は、表を引く前に枝刈りする
+            if (tentative_g >= p.cost_bound) {
+                ++R.stats.pruned_by_bound;
+                continue;
+            }
+
+            const uint64_t rv = ranker.rank_after(ru, su, work, undo, mark);
+            DenseMeta& mv = meta[rv];
+
+            if (!mv.seen()) {
+                const int hv = rounding(h(T, work));
+                ++R.stats.evaluated;
+
+                // g+h が上界以上の場合は、ノードを登録せずに捨てる
+                if (tentative_g + hv >= p.cost_bound) {
+                    ++R.stats.pruned_by_bound;
+                    continue;
+                }
+
+                mv.set(tentative_g, static_cast<uint32_t>(ru), static_cast<uint32_t>(a));
+                mv.set_h(hv);
+                if constexpr (CM::unit) {
+                    // g 値が f の最小値以下のゴールは、これ以上展開しなくても最適
+                    if (is_goal(T, work)) {
+                        if (tentative_g <= fu) {
+                            solved_at(rv);
+                            co_return;
+                        }
+                        gen_goal.offer(rv, tentative_g);
+                    }
+                }
+                open.insert(static_cast<uint32_t>(rv), pack_fh_asc(tentative_g + hv, hv));
+            } else if (tentative_g < mv.g()) {
+                // h は登録時に表へ保存した値をそのまま使う
+                const int hv = mv.h();
+                if (tentative_g + hv >= p.cost_bound) { // 改善後も上界に達する場合
+                    ++R.stats.pruned_by_bound;
+                    continue;
+                }
+
+                const bool was_closed = mv.closed();
+                mv.set(tentative_g, static_cast<uint32_t>(ru), static_cast<uint32_t>(a));
+                if constexpr (CM::unit) {
+                    if (is_goal(T, work)) {
+                        gen_goal.offer(rv, tentative_g);
+                    }
+                }
+
+                if (was_closed && !p.reopen_closed) {
+                    mv.close();
+                    ++R.stats.duplicates;
+                    continue;
+                }
+                // 古いエントリは取り出し時に読み捨てられるので、新しいキーで挿入し直すだけでよい
+                open.insert(static_cast<uint32_t>(rv), pack_fh_asc(tentative_g + hv, hv));
+            } else {
+                ++R.stats.duplicates;
+            }
         }
     }
-    return true;
+    R.bound_exhausted = bound_enabled(p) && open.empty() && !gen_goal.found();
 }
 
-// 差分適用（Undo 付き）
-using Undo = std::vector<std::pair<int,int>>; // (var, old_value)
+// hb が nullptr でない場合は、展開ごとに新しい後続状態をまとめて hb で評価する
+static SearchSteps gbfs_dense(const Task& T, HeuristicFn& h, const BatchHeuristicFn* hb, const Params& p, const StateRanker ranker,
+                              Result& R) {
+    {
+        const bool do_mutex = should_check_mutex_runtime(T);
+        if (do_mutex) {
+            note_out(p) << "Mutex check: ON\n";
+        } else {
+            note_out(p) << "Mutex check: OFF\n";
+        }
+    }
+
+    note_out(p) << "Note: all action costs and heuristic are integer; using BucketPQ GBFS over a dense state table ("
+              << ranker.num_states() << " states).\n";
+
+    DenseStateTable meta(ranker.num_states());
+    LazyBucketQueue<uint32_t> open_pref; // preferred
+    LazyBucketQueue<uint32_t> open_norm; // not-preferred
 
-static inline std::size_t undo_mark(const Undo& u) { return u.size(); }
+    const State& s0 = R.nodes[0].s;
+    const uint64_t r0 = ranker.rank(s0);
 
-static inline void undo_to(State& s, Undo& u, std::size_t mark) {
-    for (std::size_t i = u.size(); i-- > mark; ) {
-        const auto [var, oldv] = u[i];
-        s[var] = oldv;
+    resolve_async(h); // 非同期に作ったヒューリスティックは、ここで完成を待つ
+    const int h0 = rounding(h(T, s0));
+    ++R.stats.evaluated;
+    if (h0 >= p.cost_bound) {
+        ++R.stats.pruned_by_bound;
+        R.bound_exhausted = true;
+        co_return;
     }
-    u.resize(mark);
-}
+    meta[r0].set(0, DenseMeta::NO_PARENT, 0);
+    meta[r0].set_h(h0);
+    open_norm.insert(static_cast<uint32_t>(r0), pack_fh_asc(h0, 0)); // pack_fh means pack_hg here
+
+    State su;
+    State work;
+    Undo undo;
+
+    // まとめて評価する後続状態 (ランク, g, 演算子) と、その状態と h
+    struct Pending { uint64_t rank; int g; int op; };
+    std::vector<Pending> pending;
+    std::vector<State> pending_states;
+    std::vector<double> pending_h;
+
+    // 評価済みの後続状態を登録する関数
+    auto admit = [&](uint64_t ru, int hu, uint64_t rv, int gv, int a, int hv) {
+        // g+h が上界以上の場合は、ノードを登録せずに捨てる
+        if (gv + hv >= p.cost_bound) {
+            ++R.stats.pruned_by_bound;
+            return;
+        }
+        meta[rv].set(gv, static_cast<uint32_t>(ru), static_cast<uint32_t>(a));
+        meta[rv].set_h(hv);
+        if (hv < hu) {
+            open_pref.insert(static_cast<uint32_t>(rv), pack_fh_asc(hv, gv));
+        } else {
+            open_norm.insert(static_cast<uint32_t>(rv), pack_fh_asc(hv, gv));
+        }
+    };
+
+    while (!open_pref.empty() || !open_norm.empty()) {
+        co_yield R.stats.expanded; // 展開数が上限に達していれば、ここで中断する
+        if (search_interrupted(p, R)) {
+            co_return;
+        }
+
+        auto [ru32, key] = !open_pref.empty() ? open_pref.extract_min() : open_norm.extract_min();
+        const uint64_t ru = ru32;
+        const int hu = unpack_f(key); // GBFS では上位 16bit が h
+
+        DenseMeta& mu = meta[ru];
+        if (mu.closed()) continue;
+
+        ranker.unrank(ru, su);
+
+        if (is_goal(T, su)) {
+            R.solved = true;
+            R.plan = extract_plan_dense(meta, ru);
+            R.plan_cost = eval_plan_cost(T, R.plan);
+            co_return;
+        }
+
+        mu.close();
+        const int gu = mu.g();
+
+        ++R.stats.expanded;
+        if (R.stats.expanded > p.max_expansions) {
+            co_return;
+        }
+
+        for (int a=0; a<(int)T.ops.size(); ++a) {
+            const auto& op = T.ops[a];
+            if (!is_applicable(T, su, op)) {
+                continue;
+            }
+
+            work = su; undo.clear();
+            const std::size_t mark = undo_mark(undo);
+
+            UndoGuard ug{work, undo, mark};
+
+            apply_inplace(T, op, work, undo);
+            ++R.stats.generated;
+
+            // 生成状態が mutex 違反なら捨てる
+            if (should_check_mutex_runtime(T)) {
+                if (planner::sas::violates_mutex(T, work)) {
+                    continue;
+                }
+            }
+
+            const int gv = gu + rounding(op.cost);
+
+            // g-value だけで上界に達している場合は、表を引く前に枝刈りする
+            if (gv >= p.cost_bound) {
+                ++R.stats.pruned_by_bound;
+                continue;
+            }
+
+            const uint64_t rv = ranker.rank_after(ru, su, work, undo, mark);
+            DenseMeta& mv = meta[rv];
+            if (mv.seen()) {
+                // 上界がある場合は、g-value が改善した状態を開き直す (そうしないと上界未満のプランを見落とす)
+                if (bound_enabled(p) && gv < mv.g()) {
+                    const int hv = mv.h();
+                    if (gv + hv >= p.cost_bound) { // 改善後も上界に達する場合
+                        ++R.stats.pruned_by_bound;
+                        continue;
+                    }
+                    mv.set(gv, static_cast<uint32_t>(ru), static_cast<uint32_t>(a)); // closed も外れる
+                    // 古いエントリは、取り出した時に表の g-value で展開されるか、closed として読み捨てられる
+                    if (hv < hu) {
+                        open_pref.insert(static_cast<uint32_t>(rv), pack_fh_asc(hv, gv));
+                    } else {
+                        open_norm.insert(static_cast<uint32_t>(rv), pack_fh_asc(hv, gv));
+                    }
+                    continue;
+                }
+                ++R.stats.duplicates;
+                continue;
+            }
+
+            if (hb) {
+                // 同じ展開で既に生成した状態は重複として扱い、g-value の小さい方を残す (上界での枝刈りで安い方を失わないため)
+                const auto dup = std::find_if(pending.begin(), pending.end(), [rv](const Pending& q) { return q.rank == rv; });
+                if (dup != pending.end()) {
+                    if (gv < dup->g) {
+                        dup->g = gv;
+                        dup->op = a;
+                    }
+                    ++R.stats.duplicates;
+                    continue;
+                }
+                pending.push_back(Pending{rv, gv, a});
+                pending_states.push_back(work);
+                continue;
+            }
 
-static inline void apply_inplace(const Task& T, const Operator& op, State& s, Undo& u) {
-    (void)T; // 現状では未使用
-    // 代入効果：var := post
-    for (const auto& pp : op.pre_posts) {
-        int var  = std::get<1>(pp);
-        int post = std::get<3>(pp);
-        if (s[var] != post) {
-            u.emplace_back(var, s[var]);
-            s[var] = post;
+            const int hv = rounding(h(T, work));
+            ++R.stats.evaluated;
+            admit(ru, hu, rv, gv, a, hv);
+        }
+
+        if (!pending.empty()) {
+            (*hb)(T, pending_states, pending_h);
+            R.stats.evaluated += pending.size();
+            for (std::size_t i = 0; i < pending.size(); ++i) {
+                admit(ru, hu, pending[i].rank, pending[i].g, pending[i].op, rounding(pending_h[i]));
+            }
+            pending.clear();
+            pending_states.clear();
         }
     }
+    R.bound_exhausted = bound_enabled(p) && open_pref.empty() && open_norm.empty();
 }
 
-// ノード→プラン復元
-static std::vector<uint32_t> extract_plan(const std::vector<Node>& nodes, int goal_id) {
-    std::vector<uint32_t> acts;
-    for (int v = goal_id; v >= 0 && nodes[v].parent >= 0; v = nodes[v].parent) {
-        acts.push_back(nodes[v].act_id);
+// A* search
+// ハッシュ表を用いる探索でのノードの置き場所
+// Full では R.nodes に状態・親・演算子を置き、Delta では NodeStateStore に全てを置く (この場合、R.nodes は根のみを持つ)
+class NodeStates {
+public:
+    NodeStates(const Task& T, const Params& p, Result& R) : R_(R) {
+        if (p.state_storage != StateStorage::Delta) {
+            return;
+        }
+        auto store = std::make_unique<NodeStateStore>(T, p.checkpoint_interval);
+        if (!store->fits()) {
+            note_out(p) << "Note: task is too large for delta state storage; storing full states.\n";
+            return;
+        }
+        note_out(p) << "Note: storing node states as parent deltas (checkpoint every " << p.checkpoint_interval << " steps).\n";
+        store->push_root(R.nodes[0].s);
+        delta_ = std::move(store);
+    }
+
+    int size() const {
+        return static_cast<int>(delta_ ? delta_->size() : R_.nodes.size());
+    }
+
+    const State& get(int id) {
+        return delta_ ? delta_->get(id) : R_.nodes[id].s;
     }
-    std::reverse(acts.begin(), acts.end());
-    return acts;
-}
 
-// 整数判定／丸め
-static bool all_action_costs_are_integers(const Task& T, double eps = 1e-12) {
-    for (const auto& op : T.ops) {
-        if (!std::isfinite(op.cost)) {
-            return false;
+    // 後続状態 s を新しいノードとして登録し、その ID を返す関数 (parent_state は親ノードの状態)
+    int add(const State& s, int parent, int act, const State& parent_state) {
+        PLANNER_ALLOC_PHASE(Closed);
+        const int id = size();
+        if (delta_) {
+            delta_->push(s, parent, act, parent_state);
+        } else {
+            R_.nodes.push_back(Node{s, parent, act});
         }
-        double nearest = std::round(op.cost);
-        if (std::fabs(op.cost - nearest) > eps) {
-            return false;
+        return id;
+    }
+
+    // g-value の改善時に、ノード id の親と演算子を付け替える関数
+    void set_parent(int id, int parent, int act) {
+        if (delta_) {
+            delta_->set_parent(id, parent, act);
+        } else {
+            R_.nodes[id].parent = parent;
+            R_.nodes[id].act_id = act;
         }
     }
-    return true;
-}
 
-static int rounding(double v) {
-    long long k = std::llround(v);
-    if (k < 0) {
-        throw std::runtime_error("negative value not supported");
+    // 根からノード id までの演算子の列を返す関数
+    std::vector<uint32_t> extract_plan(int id) const {
+        if (!delta_) {
+            return planner::sas::extract_plan(R_.nodes, id);
+        }
+        std::vector<uint32_t> acts;
+        for (int v = id; v >= 0 && delta_->parent(v) >= 0; v = delta_->parent(v)) {
+            acts.push_back(static_cast<uint32_t>(delta_->op(v)));
+        }
+        std::reverse(acts.begin(), acts.end());
+        return acts;
     }
-    return static_cast<int>(k);
-}
 
-// RAII で必ず巻き戻すためのガード
-struct UndoGuard {
-    State& work;
-    Undo& undo;
-    std::size_t mark;
-    ~UndoGuard() { undo_to(work, undo, mark); }
+private:
+    Result& R_;
+    std::unique_ptr<NodeStateStore> delta_;
 };
 
-// CPU 時間の audit の設定
-std::atomic<bool> g_search_timed_out{false};
-bool g_cpu_budget_enabled = true;
-double g_cpu_limit_sec = -1.0;
-double g_cpu_start_sec = 0.0;
+// ハッシュ表を用いる整数 A* (コストモデル CM で特殊化する)
+// IntegerCost では decrease_key を持つ TwoLevelBucketPQ を、UnitCost では FIFO バケットに重複挿入して古いエントリを読み捨てる
+template <class CM>
+static SearchSteps astar_int(const Task& T, HeuristicFn& h, const Params& p, Result& R) {
+    // 状態 -> ノード ID の表 (状態そのものは NodeStates に置き、表には ID のみを持つ)
+    NodeStates states(T, p, R);
+    auto state_of = [&states](int id) -> const State& { return states.get(id); };
+    StateIndex index_of(1<<15);
+    SuccessorBatch batch;
+    const State& s0 = R.nodes[0].s;
+    index_of.insert(StateIndex::hash(s0), 0, state_of);
+
+    // 実際のモード表示
+    {
+        const bool do_mutex = should_check_mutex_runtime(T);
+        if (do_mutex) {
+            note_out(p) << "Mutex check: ON\n";
+        } else {
+            note_out(p) << "Mutex check: OFF\n";
+        }
+    }
 
-// A* search
-Result astar(const Task& T, HeuristicFn h, const bool h_int, const Params& p) {
-    Result R;
+    if constexpr (CM::unit) {
+        note_out(p) << "Note: all action costs are 1; using unit-cost A* + FIFO buckets.\n";
+    } else {
+        note_out(p) << "Note: all action costs are integers; using integer A* + BucketPQ.\n";
+    }
 
-    // 初期ノード
-    State s0(T.vars.size());
-    for (int v=0; v<(int)T.vars.size(); ++v) {
-        s0[v] = T.init[v];
+    struct MetaI { int g; int h; bool closed; };
+    ArenaVector<MetaI> meta(1, MetaI{0,0,false});
+
+    std::conditional_t<CM::unit, FifoBucketQueue<uint32_t>, TwoLevelBucketPQ> open;
+    GeneratedGoal<int> gen_goal;
+    resolve_async(h); // 非同期に作ったヒューリスティックは、ここで完成を待つ
+    const int h0 = rounding(h(T, s0));
+    ++R.stats.evaluated;
+    meta[0] = MetaI{0, h0, false};
+
+    // 初期状態の f-value が上界以上の場合は、探索せずに終了する
+    if (h0 >= p.cost_bound) {
+        ++R.stats.pruned_by_bound;
+        R.bound_exhausted = true;
+        co_return;
     }
-    R.nodes.push_back(Node{ s0, -1, -1 });
+    open.insert(0, pack_fh_asc(h0, h0));
 
-    if (is_goal(T, s0)) {
+    auto solved_at = [&](int v) {
         R.solved = true;
-        R.plan_cost = 0.0;
-        R.plan.clear();
-        return R;
-    }
+        R.plan = states.extract_plan(v);
+        R.plan_cost = eval_plan_cost(T, R.plan);
+    };
+
+    State work;
+    Undo undo;
+    work = s0;
+    undo.clear();
+
+    while (!open.empty()) {
+        co_yield R.stats.expanded; // 展開数が上限に達していれば、ここで中断する
+        if (search_interrupted(p, R)) {
+            co_return;
+        }
 
-#if defined(USE_ROBIN_HOOD)
-    robin_hood::unordered_map<State, int, VecHash, VecEq> index_of;
-#else
-    std::unordered_map<State, int, VecHash, VecEq> index_of;
-    index_of.max_load_factor(0.50f);
-#endif
-    index_of.reserve(1<<15);
-    index_of.emplace(R.nodes[0].s, 0);
+        auto [u32, key] = open.extract_min();
+        const int u = static_cast<int>(u32);
+        const int fu = unpack_f(key);
+        const int hu = unpack_h(key);
 
-    if (all_action_costs_are_integers(T) && h_int) {
-        // 実際のモード表示
-        {
-            const bool do_mutex = should_check_mutex_runtime(T);
-            if (do_mutex) {
-                std::cout << "Mutex check: ON\n";
-            } else {
-                std::cout << "Mutex check: OFF\n";
+        const int fu_now = meta[u].g + meta[u].h;
+        if (fu != fu_now || hu != meta[u].h) continue;
+
+        if constexpr (CM::unit) {
+            if (meta[u].closed) continue; // 同じ g 値で重複して挿入されたエントリ
+            if (gen_goal.found() && fu >= gen_goal.g) {
+                solved_at(gen_goal.id);
+                co_return;
             }
         }
 
-        std::cout << "Note: all action costs are integers; using integer A* + BucketPQ.\n";
+        const State su = states.get(u);
 
-        struct MetaI { int g; int h; bool closed; };
-        std::vector<MetaI> meta(1, MetaI{0,0,false});
+        if (is_goal(T, su)) {
+            solved_at(u);
+            co_return;
+        }
 
-        TwoLevelBucketPQ open;
-        const int h0 = rounding(h(T, s0));
-        ++R.stats.evaluated;
-        meta[0] = MetaI{0, h0, false};
-        open.insert(0, pack_fh_asc(h0, h0));
+        meta[u].closed = true;
 
-        State work;
-        Undo undo;
-        work = s0;
-        undo.clear();
+        ++R.stats.expanded;
+        if (R.stats.expanded > p.max_expansions) co_return;
 
-        while (!open.empty()) {
-            if (planner::sas::time_exceeded_cpu()) {
-                std::cerr << "error: CPU time limit exceeded (" << planner::sas::g_cpu_limit_sec << " sec)\n";
-                std::exit(101);
-            }
+        // 後続状態をまとめて生成し、ハッシュ値の計算とスロットの先読みを済ませてから重複検出を行う
+        batch.clear();
+        for (int a=0; a<(int)T.ops.size(); ++a) {
+            const auto& op = T.ops[a];
+            if (!is_applicable(T, su, op)) continue;
 
-            auto [u32, key] = open.extract_min();
-            const int u = static_cast<int>(u32);
-            const int fu = unpack_f(key);
-            const int hu = unpack_h(key);
+            work = su;
+            undo.clear();
+            const std::size_t mark = undo_mark(undo);
 
-            const int fu_now = meta[u].g + meta[u].h;
-            if (fu != fu_now || hu != meta[u].h) continue;
+            UndoGuard ug{work, undo, mark};
 
-            const State su = R.nodes[u].s;
+            apply_inplace(T, op, work, undo);
+            ++R.stats.generated;
 
-            if (is_goal(T, su)) {
-                R.solved = true;
-                R.plan = extract_plan(R.nodes, u);
-                R.plan_cost = eval_plan_cost(T, R.plan);
-                return R;
+            // 生成状態が mutex 違反なら捨てる
+            if (should_check_mutex_runtime(T)) {
+                if (planner::sas::violates_mutex(T, work)) {
+                    continue;
+                }
             }
 
-            meta[u].closed = true;
-
-            ++R.stats.expanded;
-            if (R.stats.expanded > p.max_expansions) break;
+            const int tentative_g = meta[u].g + CM::cost(op);
 
-            for (int a=0; a<(int)T.ops.size(); ++a) {
-                const auto& op = T.ops[a];
-                if (!is_applicable(T, su, op)) continue;
+            // g-value だけで上界に達している場合は、ハッシュ表を引く前に枝刈りする
+            if (tentative_g >= p.cost_bound) {
+                ++R.stats.pruned_by_bound;
+                continue;
+            }
 
-                work = su;
-                undo.clear();
-                const std::size_t mark = undo_mark(undo);
+            batch.push(work, a);
+        }
+        batch.hash_and_prefetch(index_of);
 
-                UndoGuard ug{work, undo, mark};
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            const State& succ = batch.state(i);
+            const int a = batch.op(i);
+            const int tentative_g = meta[u].g + CM::cost(T.ops[a]);
 
-                apply_inplace(T, op, work, undo);
-                ++R.stats.generated;
+            const int found = index_of.find(succ, batch.hash(i), state_of);
+            if (found == StateIndex::EMPTY) {
+                const int hv = rounding(h(T, succ));
+                ++R.stats.evaluated;
 
-                // 生成状態が mutex 違反なら捨てる
-                if (should_check_mutex_runtime(T)) {
-                    if (planner::sas::violates_mutex(T, work)) {
-                        continue;
-                    }
+                // g+h が上界以上の場合は、ノードを登録せずに捨てる
+                if (tentative_g + hv >= p.cost_bound) {
+                    ++R.stats.pruned_by_bound;
+                    continue;
                 }
 
-                const int w = rounding(op.cost);
-                const int tentative_g = meta[u].g + w;
+                const int v = states.add(succ, u, a, su);
+                index_of.insert(batch.hash(i), v, state_of);
 
-                auto it = index_of.find(work);
-                if (it == index_of.end()) {
-                    const int v = (int)R.nodes.size();
-                    R.nodes.push_back(Node{work, u, a});
-                    index_of.emplace(R.nodes[v].s, v);
+                if ((int)meta.size() <= v) meta.resize(v+1);
+                meta[v] = MetaI{tentative_g, hv, false};
 
-                    const int hv = rounding(h(T, R.nodes[v].s));
-                    ++R.stats.evaluated;
-                    if ((int)meta.size() <= v) meta.resize(v+1);
-                    meta[v] = MetaI{tentative_g, hv, false};
+                if constexpr (CM::unit) {
+                    // g 値が f の最小値以下のゴールは、これ以上展開しなくても最適
+                    if (is_goal(T, succ)) {
+                        if (tentative_g <= fu) {
+                            solved_at(v);
+                            co_return;
+                        }
+                        gen_goal.offer(v, tentative_g);
+                    }
+                }
 
-                    open.insert(static_cast<BucketPQ::Value>(v), pack_fh_asc(tentative_g + hv, hv));
-                } else {
-                    const int v = it->second;
-                    if (tentative_g < meta[v].g) {
-                        meta[v].g = tentative_g;
-                        R.nodes[v].parent = u;
-                        R.nodes[v].act_id = a;
+                open.insert(static_cast<BucketPQ::Value>(v), pack_fh_asc(tentative_g + hv, hv));
+            } else {
+                const int v = found;
+                if (tentative_g < meta[v].g) {
+                    if (tentative_g + meta[v].h >= p.cost_bound) { // 改善後も上界に達する場合
+                        ++R.stats.pruned_by_bound;
+                        continue;
+                    }
+                    meta[v].g = tentative_g;
+                    states.set_parent(v, u, a);
 
-                        meta[v].h = rounding(h(T, R.nodes[v].s));
-                        ++R.stats.evaluated;
-                        const UKey new_key = pack_fh_asc(meta[v].g + meta[v].h, meta[v].h);
+                    // h は状態のみで決まるので、登録時の値をそのまま使う
+                    const UKey new_key = pack_fh_asc(meta[v].g + meta[v].h, meta[v].h);
 
+                    if constexpr (CM::unit) {
+                        // consistent なヒューリスティックでは閉じたノードの g 値は改善しないので、再オープンは非 consistent な場合のみ起こる
+                        if (is_goal(T, succ)) {
+                            gen_goal.offer(v, tentative_g);
+                        }
                         if (meta[v].closed) {
                             if (!p.reopen_closed) {
                                 ++R.stats.duplicates;
                                 continue;
                             }
                             meta[v].closed = false;
-                            open.insert(static_cast<BucketPQ::Value>(v), new_key);
-                        } else {
-                            if (open.contains(static_cast<BucketPQ::Value>(v))) {
-                                const auto cur_key = open.key_of(static_cast<BucketPQ::Value>(v));
-                                if (new_key < cur_key) {
-                                    open.decrease_key(static_cast<BucketPQ::Value>(v), new_key);
-                                } else if (new_key > cur_key) {
-                                    open.increase_key(static_cast<BucketPQ::Value>(v), new_key);
-                                }
-                            } else {
-                                open.insert(static_cast<BucketPQ::Value>(v), new_key);
-                            }
                         }
-                    } else {
-                        ++R.stats.duplicates;
-                        if (meta[v].closed && !p.reopen_closed) {
+                        open.insert(static_cast<BucketPQ::Value>(v), new_key); // 古いエントリは取り出し時に読み捨てる
+                    } else if (meta[v].closed) {
+                        if (!p.reopen_closed) {
+                            ++R.stats.duplicates;
                             continue;
                         }
+                        meta[v].closed = false;
+                        open.insert(static_cast<BucketPQ::Value>(v), new_key);
+                    } else {
+                        if (open.contains(static_cast<BucketPQ::Value>(v))) {
+                            const auto cur_key = open.key_of(static_cast<BucketPQ::Value>(v));
+                            if (new_key < cur_key) {
+                                open.decrease_key(static_cast<BucketPQ::Value>(v), new_key);
+                            } else if (new_key > cur_key) {
+                                open.increase_key(static_cast<BucketPQ::Value>(v), new_key);
+                            }
+                        } else {
+                            open.insert(static_cast<BucketPQ::Value>(v), new_key);
+                        }
+                    }
+                } else {
+                    ++R.stats.duplicates;
+                    if (meta[v].closed && !p.reopen_closed) {
+                        continue;
                     }
                 }
             }
         }
-        return R;
+    }
+    R.bound_exhausted = bound_enabled(p) && open.empty() && !gen_goal.found();
+}
 
-    } else {
-        {
-            const bool do_mutex = should_check_mutex_runtime(T);
-            if (do_mutex) {
-                std::cout << "Mutex check: ON\n";
-            } else {
-                std::cout << "Mutex check: OFF\n";
-            }
+// ハッシュ表を用いる実数コストの A*
+static SearchSteps astar_real(const Task& T, HeuristicFn& h, const Params& p, Result& R) {
+    // 状態 -> ノード ID の表 (状態そのものは NodeStates に置き、表には ID のみを持つ)
+    NodeStates states(T, p, R);
+    auto state_of = [&states](int id) -> const State& { return states.get(id); };
+    StateIndex index_of(1<<15);
+    SuccessorBatch batch;
+    const State& s0 = R.nodes[0].s;
+    index_of.insert(StateIndex::hash(s0), 0, state_of);
+
+    {
+        const bool do_mutex = should_check_mutex_runtime(T);
+        if (do_mutex) {
+            note_out(p) << "Mutex check: ON\n";
+        } else {
+            note_out(p) << "Mutex check: OFF\n";
+        }
+    }
+
+    note_out(p) << "Note: action costs are not all integers; using non-integer A*.\n";
+
+    struct MetaD { double g; double h; bool closed; };
+    ArenaVector<MetaD> meta(1, MetaD{0.0, 0.0, false});
+
+    struct QEl { double f; double h; int id; };
+    auto cmp = [](const QEl& a, const QEl& b){
+        if (a.f != b.f) return a.f > b.f;
+        return a.h > b.h;
+    };
+    std::priority_queue<QEl, std::vector<QEl>, decltype(cmp)> open(cmp);
+
+    resolve_async(h); // 非同期に作ったヒューリスティックは、ここで完成を待つ
+    meta[0] = MetaD{0.0, h(T, s0), false};
+    ++R.stats.evaluated;
+    if (meta[0].h >= p.cost_bound) {
+        ++R.stats.pruned_by_bound;
+        R.bound_exhausted = true;
+        co_return;
+    }
+    open.push({ meta[0].g + meta[0].h, meta[0].h, 0 });
+
+    State work;
+    Undo undo;
+    work = s0;
+    undo.clear();
+    constexpr double EPS = 1e-12;
+
+    while (!open.empty()) {
+        co_yield R.stats.expanded; // 展開数が上限に達していれば、ここで中断する
+        if (search_interrupted(p, R)) {
+            co_return;
         }
+        QEl cur = open.top(); open.pop();
+        const int u = cur.id;
 
-        std::cout << "Note: action costs are not all integers; using non-integer A*.\n";
+        const double fu_now = meta[u].g + meta[u].h;
+        if (std::fabs(cur.f - fu_now) > EPS) continue;
 
-        struct MetaD { double g; double h; bool closed; };
-        std::vector<MetaD> meta(1, MetaD{0.0, 0.0, false});
+        const State su = states.get(u);
 
-        struct QEl { double f; double h; int id; };
-        auto cmp = [](const QEl& a, const QEl& b){
-            if (a.f != b.f) return a.f > b.f;
-            return a.h > b.h;
-        };
-        std::priority_queue<QEl, std::vector<QEl>, decltype(cmp)> open(cmp);
-
-        meta[0] = MetaD{0.0, h(T, s0), false};
-        ++R.stats.evaluated;
-        open.push({ meta[0].g + meta[0].h, meta[0].h, 0 });
-
-        State work;
-        Undo undo;
-        work = s0;
-        undo.clear();
-        constexpr double EPS = 1e-12;
-
-        while (!open.empty()) {
-            if (planner::sas::time_exceeded_cpu()) {
-                std::cerr << "error: CPU time limit exceeded (" << planner::sas::g_cpu_limit_sec << " sec)\n";
-                std::exit(101);
-            }
-            QEl cur = open.top(); open.pop();
-            const int u = cur.id;
+        if (is_goal(T, su)) {
+            R.solved = true;
+            R.plan = states.extract_plan(u);
+            R.plan_cost = eval_plan_cost(T, R.plan);
+            co_return;
+        }
 
-            const double fu_now = meta[u].g + meta[u].h;
-            if (std::fabs(cur.f - fu_now) > EPS) continue;
+        meta[u].closed = true;
 
-            const State su = R.nodes[u].s;
+        ++R.stats.expanded;
+        if (R.stats.expanded > p.max_expansions) {
+            co_return;
+        }
 
-            if (is_goal(T, su)) {
-                R.solved = true;
-                R.plan = extract_plan(R.nodes, u);
-                R.plan_cost = eval_plan_cost(T, R.plan);
-                return R;
+        // 後続状態をまとめて生成し、ハッシュ値の計算とスロットの先読みを済ませてから重複検出を行う
+        batch.clear();
+        for (int a=0; a<(int)T.ops.size(); ++a) {
+            const auto& op = T.ops[a];
+            if (!is_applicable(T, su, op)) {
+                continue;
             }
 
-            meta[u].closed = true;
+            work = su; undo.clear();
+            const std::size_t mark = undo_mark(undo);
 
-            ++R.stats.expanded;
-            if (R.stats.expanded > p.max_expansions) {
-                break;
-            }
+            UndoGuard ug{work, undo, mark};
+
+            apply_inplace(T, op, work, undo);
+            ++R.stats.generated;
 
-            for (int a=0; a<(int)T.ops.size(); ++a) {
-                const auto& op = T.ops[a];
-                if (!is_applicable(T, su, op)) {
+            // 生成状態が mutex 違反なら捨てる
+            if (should_check_mutex_runtime(T)) {
+                if (planner::sas::violates_mutex(T, work)) {
                     continue;
                 }
+            }
 
-                work = su; undo.clear();
-                const std::size_t mark = undo_mark(undo);
-
-                UndoGuard ug{work, undo, mark};
+            const double tentative_g = meta[u].g + op.cost;
 
-                apply_inplace(T, op, work, undo);
-                ++R.stats.generated;
+            // g-value だけで上界に達している場合は、ハッシュ表を引く前に枝刈りする
+            if (tentative_g >= p.cost_bound) {
+                ++R.stats.pruned_by_bound;
+                continue;
+            }
 
-                // 生成状態が mutex 違反なら捨てる
-                if (should_check_mutex_runtime(T)) {
-                    if (planner::sas::violates_mutex(T, work)) {
-                        continue;
-                    }
+            batch.push(work, a);
+        }
+        batch.hash_and_prefetch(index_of);
+
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            const State& succ = batch.state(i);
+            const int a = batch.op(i);
+            const auto& op = T.ops[a];
+            const double tentative_g = meta[u].g + op.cost;
+
+            const int found = index_of.find(succ, batch.hash(i), state_of);
+            if (found == StateIndex::EMPTY) {
+                const double hv = h(T, succ);
+                ++R.stats.evaluated;
+
+                // g+h が上界以上の場合は、ノードを登録せずに捨てる
+                if (tentative_g + hv >= p.cost_bound) {
+                    ++R.stats.pruned_by_bound;
+                    continue;
                 }
 
-                const double tentative_g = meta[u].g + op.cost;
+                const int v = states.add(succ, u, a, su);
+                index_of.insert(batch.hash(i), v, state_of);
 
-                auto it = index_of.find(work);
-                if (it == index_of.end()) {
-                    const int v = (int)R.nodes.size();
-                    R.nodes.push_back(Node{work, u, a});
-                    index_of.emplace(R.nodes[v].s, v);
+                if ((int)meta.size() <= v) {
+                    meta.resize(v+1);
+                }
+                meta[v] = MetaD{tentative_g, hv, false};
+                open.push({ tentative_g + hv, hv, v });
+            } else {
+                const int v = found;
+                if (tentative_g + EPS < meta[v].g) {
+                    if (tentative_g + meta[v].h >= p.cost_bound) { // 改善後も上界に達する場合
+                        ++R.stats.pruned_by_bound;
+                        continue;
+                    }
+                    meta[v].g   = tentative_g;
+                    states.set_parent(v, u, a);
 
-                    const double hv = h(T, R.nodes[v].s);
+                    meta[v].h = h(T, states.get(v));
                     ++R.stats.evaluated;
-                    if ((int)meta.size() <= v) {
-                        meta.resize(v+1);
-                    }
-                    meta[v] = MetaD{tentative_g, hv, false};
-                    open.push({ tentative_g + hv, hv, v });
-                } else {
-                    const int v = it->second;
-                    if (tentative_g + EPS < meta[v].g) {
-                        meta[v].g   = tentative_g;
-                        R.nodes[v].parent = u;
-                        R.nodes[v].act_id = a;
-
-                        meta[v].h = h(T, R.nodes[v].s);
-                        ++R.stats.evaluated;
-                        if (meta[v].closed && !p.reopen_closed) {
-                            ++R.stats.duplicates;
-                            continue;
-                        }
-                        open.push({ meta[v].g + meta[v].h, meta[v].h, v });
-                    } else {
+                    if (meta[v].closed && !p.reopen_closed) {
                         ++R.stats.duplicates;
-                        if (meta[v].closed && !p.reopen_closed) continue;
+                        continue;
                     }
+                    open.push({ meta[v].g + meta[v].h, meta[v].h, v });
+                } else {
+                    ++R.stats.duplicates;
+                    if (meta[v].closed && !p.reopen_closed) continue;
                 }
             }
         }
-        return R;
     }
+    R.bound_exhausted = bound_enabled(p) && open.empty();
 }
 
-// GBFS
-Result gbfs(const Task& T, HeuristicFn h, const bool h_int, const Params& p) {
-    Result R;
-
+SearchSteps astar_steps(const Task& T, HeuristicFn& h, const bool h_int, const Params& p, Result& R) {
+    // 初期ノード
     State s0(T.vars.size());
     for (int v=0; v<(int)T.vars.size(); ++v) {
         s0[v] = T.init[v];
@@ -483,233 +962,477 @@ Result gbfs(const Task& T, HeuristicFn h, const bool h_int, const Params& p) {
     R.nodes.push_back(Node{ s0, -1, -1 });
 
     if (is_goal(T, s0)) {
-        R.solved = true; R.plan_cost = 0.0; R.plan.clear();
-        return R;
+        if (0.0 >= p.cost_bound) { // 空のプランでさえ上界以上の場合
+            R.bound_exhausted = true;
+            return {};
+        }
+        R.solved = true;
+        R.plan_cost = 0.0;
+        R.plan.clear();
+        return {};
     }
 
-#if defined(USE_ROBIN_HOOD)
-    robin_hood::unordered_map<State, int, VecHash, VecEq> index_of;
-#else
-    std::unordered_map<State, int, VecHash, VecEq> index_of;
-    index_of.max_load_factor(0.50f);
-#endif
-    index_of.reserve(1<<15);
-    index_of.emplace(s0, 0);
+    // 状態空間が十分に小さい場合は、ハッシュ表の代わりに密な状態表を用いる
+    if (p.dense_max_states > 0 && all_action_costs_are_integers(T) && h_int) {
+        const StateRanker ranker(T, p.dense_max_states);
+        if (ranker.fits()) {
+            if (all_action_costs_are_unit(T)) {
+                return astar_dense<UnitCost>(T, h, p, ranker, R);
+            }
+            return astar_dense<IntegerCost>(T, h, p, ranker, R);
+        }
+    }
 
-    const bool integer_mode = (all_action_costs_are_integers(T) && h_int);
+    if (all_action_costs_are_integers(T) && h_int) {
+        if (all_action_costs_are_unit(T)) {
+            return astar_int<UnitCost>(T, h, p, R);
+        }
+        return astar_int<IntegerCost>(T, h, p, R);
+    }
+    return astar_real(T, h, p, R);
+}
+
+Result astar(const Task& T, HeuristicFn h, const bool h_int, const Params& p) {
+    PLANNER_ALLOC_PHASE(Expansion); // 探索中の確保は、以下で切り替えない限り展開に計上する
+    Result R;
+    astar_steps(T, h, h_int, p, R).run();
+    return R;
+}
+
+// ハッシュ表を用いる整数 GBFS (hb が nullptr でない場合は、展開ごとに新しい後続状態をまとめて hb で評価する)
+static SearchSteps gbfs_int(const Task& T, HeuristicFn& h, const BatchHeuristicFn* hb, const Params& p, Result& R) {
+    // 状態 -> ノード ID の表 (状態そのものは NodeStates に置き、表には ID のみを持つ)
+    NodeStates states(T, p, R);
+    auto state_of = [&states](int id) -> const State& { return states.get(id); };
+    StateIndex index_of(1<<15);
+    SuccessorBatch batch;
+    const State& s0 = R.nodes[0].s;
+    index_of.insert(StateIndex::hash(s0), 0, state_of);
 
     {
-            const bool do_mutex = should_check_mutex_runtime(T);
-            if (do_mutex) {
-                std::cout << "Mutex check: ON\n";
-            } else {
-                std::cout << "Mutex check: OFF\n";
-            }
+        const bool do_mutex = should_check_mutex_runtime(T);
+        if (do_mutex) {
+            note_out(p) << "Mutex check: ON\n";
+        } else {
+            note_out(p) << "Mutex check: OFF\n";
+        }
     }
 
-    if (integer_mode) {
-        std::cout << "Note: all action costs and heuristic are integer; using BucketPQ GBFS.\n";
+    note_out(p) << "Note: all action costs and heuristic are integer; using BucketPQ GBFS.\n";
+
+    struct MetaI { int g; int h; bool closed; };
+    ArenaVector<MetaI> meta(1, MetaI{0, 0, false});
 
-        struct MetaI { int g; int h; bool closed; };
-        std::vector<MetaI> meta(1, MetaI{0, 0, false});
+    TwoLevelBucketPQ open_pref; // preferred
+    TwoLevelBucketPQ open_norm; // not-preferred
 
-        TwoLevelBucketPQ open_pref; // preferred
-        TwoLevelBucketPQ open_norm; // not-preferred
+    resolve_async(h); // 非同期に作ったヒューリスティックは、ここで完成を待つ
+    const int h0 = rounding(h(T, s0));
+    ++R.stats.evaluated;
+    meta[0] = MetaI{0, h0, false};
+    if (h0 >= p.cost_bound) {
+        ++R.stats.pruned_by_bound;
+        R.bound_exhausted = true;
+        co_return;
+    }
+    open_norm.insert(0, pack_fh_asc(h0, 0)); // pack_fh means pack_hg here, 初期状態では、not-preferred 
+
+    State work;
+    Undo undo;
+    work = s0;
+    undo.clear();
+
+    // まとめて評価する後続状態 (batch の添字) と、その状態と h
+    std::vector<std::size_t> pending;
+    std::vector<State> pending_states;
+    std::vector<double> pending_h;
+
+    // 評価済みの後続状態 batch[i] を、ノード u の子として登録する関数
+    auto admit = [&](int u, const State& su, std::size_t i, int hv) {
+        const int a = batch.op(i);
+        const int gv = meta[u].g + rounding(T.ops[a].cost);
+
+        // g+h が上界以上の場合は、ノードを登録せずに捨てる
+        if (gv + hv >= p.cost_bound) {
+            ++R.stats.pruned_by_bound;
+            return;
+        }
+        const bool is_preferred = (hv < meta[u].h);
 
-        const int h0 = rounding(h(T, s0));
-        ++R.stats.evaluated;
-        meta[0] = MetaI{0, h0, false};
-        open_norm.insert(0, pack_fh_asc(h0, 0)); // pack_fh means pack_hg here, 初期状態では、not-preferred 
+        const int v = states.add(batch.state(i), u, a, su);
+        index_of.insert(batch.hash(i), v, state_of);
 
-        State work;
-        Undo undo;
-        work = s0;
-        undo.clear();
+        if ((int)meta.size() <= v) {
+            meta.resize(v<<1);
+        }
+        meta[v] = MetaI{gv, hv, false};
+        if (is_preferred) {
+            open_pref.insert(static_cast<uint32_t>(v), pack_fh_asc(hv, gv));
+        } else {
+            open_norm.insert(static_cast<uint32_t>(v), pack_fh_asc(hv, gv));
+        }
+    };
 
-        while (!open_pref.empty() || !open_norm.empty()) {
-            if (planner::sas::time_exceeded_cpu()) {
-                std::cerr << "error: CPU time limit exceeded (" << planner::sas::g_cpu_limit_sec << " sec)\n";
-                std::exit(101);
+    while (!open_pref.empty() || !open_norm.empty()) {
+        co_yield R.stats.expanded; // 展開数が上限に達していれば、ここで中断する
+        if (search_interrupted(p, R)) {
+            co_return;
+        }
+
+        // open_pref があればそこから pop() し、なければ open_norm から pop() する関数
+        auto pick = [&]() {
+            if (!open_pref.empty()) {
+                return open_pref.extract_min();
             }
+            return open_norm.extract_min();
+        };
 
-            // open_pref があればそこから pop() し、なければ open_norm から pop() する関数
-            auto pick = [&]() {
-                if (!open_pref.empty()) {
-                    return open_pref.extract_min();
-                }
-                return open_norm.extract_min();
-            };
+        auto picked = pick();
+        const int u = static_cast<int>(picked.first);
 
-            auto picked = pick();
-            const int u = static_cast<int>(picked.first);
+        const State su = states.get(u);
 
-            const State su = R.nodes[u].s;
+        if (is_goal(T, su)) {
+            R.solved = true;
+            R.plan = states.extract_plan(u);
+            R.plan_cost = eval_plan_cost(T, R.plan);
+            co_return;
+        }
 
-            if (is_goal(T, su)) {
-                R.solved = true;
-                R.plan = extract_plan(R.nodes, u);
-                R.plan_cost = eval_plan_cost(T, R.plan);
-                return R;
-            }
+        meta[u].closed = true;
 
-            meta[u].closed = true;
+        ++R.stats.expanded;
+        if (R.stats.expanded > p.max_expansions) {
+            co_return;
+        }
 
-            ++R.stats.expanded;
-            if (R.stats.expanded > p.max_expansions) {
-                break;
+        // 後続状態をまとめて生成し、ハッシュ値の計算とスロットの先読みを済ませてから重複検出を行う
+        batch.clear();
+        for (int a=0; a<(int)T.ops.size(); ++a) {
+            const auto& op = T.ops[a];
+            if (!is_applicable(T, su, op)) {
+                continue;
             }
 
-            for (int a=0; a<(int)T.ops.size(); ++a) {
-                const auto& op = T.ops[a];
-                if (!is_applicable(T, su, op)) {
-                    continue;
-                }
-
-                work = su; undo.clear();
-                const std::size_t mark = undo_mark(undo);
+            work = su; undo.clear();
+            const std::size_t mark = undo_mark(undo);
 
-                UndoGuard ug{work, undo, mark};
+            UndoGuard ug{work, undo, mark};
 
-                apply_inplace(T, op, work, undo);
-                ++R.stats.generated;
+            apply_inplace(T, op, work, undo);
+            ++R.stats.generated;
 
-                // 生成状態が mutex 違反なら捨てる
-                if (should_check_mutex_runtime(T)) {
-                    if (planner::sas::violates_mutex(T, work)) {
-                        continue;
-                    }
+            // 生成状態が mutex 違反なら捨てる
+            if (should_check_mutex_runtime(T)) {
+                if (planner::sas::violates_mutex(T, work)) {
+                    continue;
                 }
+            }
 
-                auto it = index_of.find(work);
-                if (it == index_of.end()) {
-                    const int hv = rounding(h(T, work));
-                    ++R.stats.evaluated;
-                    const bool is_preferred = (hv < meta[u].h);
-
-                    const int v = (int)R.nodes.size();
-                    R.nodes.push_back(Node{work, u, a});
-                    index_of.emplace(R.nodes[v].s, v);
+            const int gv = meta[u].g + rounding(op.cost);
 
+            // g-value だけで上界に達している場合は、ハッシュ表を引く前に枝刈りする
+            if (gv >= p.cost_bound) {
+                ++R.stats.pruned_by_bound;
+                continue;
+            }
 
-                    if ((int)meta.size() <= v) {
-                        meta.resize(v<<1);
+            batch.push(work, a);
+        }
+        batch.hash_and_prefetch(index_of);
+
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            const State& succ = batch.state(i);
+
+            const int found = index_of.find(succ, batch.hash(i), state_of);
+            if (found != StateIndex::EMPTY) {
+                const int v = found;
+                const int a = batch.op(i);
+                const int gv = meta[u].g + rounding(T.ops[a].cost);
+                // 上界がある場合は、g-value が改善した状態を開き直す (そうしないと上界未満のプランを見落とす)
+                if (bound_enabled(p) && gv < meta[v].g) {
+                    if (gv + meta[v].h >= p.cost_bound) { // 改善後も上界に達する場合
+                        ++R.stats.pruned_by_bound;
+                        continue;
                     }
-                    const int gv = meta[u].g + rounding(op.cost);
-                    meta[v] = MetaI{gv, hv, false};
-                    if (is_preferred) {
-                        open_pref.insert(static_cast<uint32_t>(v), pack_fh_asc(hv, gv));
+                    meta[v].g = gv;
+                    meta[v].closed = false;
+                    states.set_parent(v, u, a);
+                    const UKey new_key = pack_fh_asc(meta[v].h, gv);
+                    if (open_pref.contains(static_cast<uint32_t>(v))) {
+                        open_pref.decrease_key(static_cast<uint32_t>(v), new_key);
+                    } else if (open_norm.contains(static_cast<uint32_t>(v))) {
+                        open_norm.decrease_key(static_cast<uint32_t>(v), new_key);
+                    } else if (meta[v].h < meta[u].h) {
+                        open_pref.insert(static_cast<uint32_t>(v), new_key);
                     } else {
-                        open_norm.insert(static_cast<uint32_t>(v), pack_fh_asc(hv, gv));
+                        open_norm.insert(static_cast<uint32_t>(v), new_key);
+                    }
+                    continue;
+                }
+                ++R.stats.duplicates;
+                continue;
+            }
+
+            if (hb) {
+                // 同じ展開で既に生成した状態は重複として扱い、g-value の小さい方を残す (上界での枝刈りで安い方を失わないため)
+                const auto dup = std::find_if(pending.begin(), pending.end(), [&](std::size_t j) {
+                    return batch.hash(j) == batch.hash(i) && batch.state(j) == succ;
+                });
+                if (dup != pending.end()) {
+                    if (T.ops[batch.op(i)].cost < T.ops[batch.op(*dup)].cost) {
+                        *dup = i;
                     }
-                } else {
                     ++R.stats.duplicates;
                     continue;
                 }
+                pending.push_back(i);
+                pending_states.push_back(succ);
+                continue;
             }
+
+            const int hv = rounding(h(T, succ));
+            ++R.stats.evaluated;
+            admit(u, su, i, hv);
         }
-        return R;
 
-    } else {
-        std::cout << "Note: heuristic or costs are non-integer; using std::priority_queue GBFS.\n";
+        if (!pending.empty()) {
+            (*hb)(T, pending_states, pending_h);
+            R.stats.evaluated += pending.size();
+            for (std::size_t k = 0; k < pending.size(); ++k) {
+                admit(u, su, pending[k], rounding(pending_h[k]));
+            }
+            pending.clear();
+            pending_states.clear();
+        }
+    }
+    R.bound_exhausted = bound_enabled(p) && open_pref.empty() && open_norm.empty();
+}
 
-        struct MetaD { double h; double g; bool closed; };
-        std::vector<MetaD> meta(1, MetaD{0.0, 0.0, false});
+// ハッシュ表を用いる実数コスト・実数ヒューリスティックの GBFS
+static SearchSteps gbfs_real(const Task& T, HeuristicFn& h, const Params& p, Result& R) {
+    // 状態 -> ノード ID の表 (状態そのものは NodeStates に置き、表には ID のみを持つ)
+    NodeStates states(T, p, R);
+    auto state_of = [&states](int id) -> const State& { return states.get(id); };
+    StateIndex index_of(1<<15);
+    SuccessorBatch batch;
+    const State& s0 = R.nodes[0].s;
+    index_of.insert(StateIndex::hash(s0), 0, state_of);
 
-        struct QEl { double h; double g; int id; };
-        auto cmp = [](const QEl& a, const QEl& b){
-            if (a.h != b.h) {
-                return a.h > b.h;
-            }
-            return a.g > b.g;
-        };
+    {
+        const bool do_mutex = should_check_mutex_runtime(T);
+        if (do_mutex) {
+            note_out(p) << "Mutex check: ON\n";
+        } else {
+            note_out(p) << "Mutex check: OFF\n";
+        }
+    }
 
-        std::priority_queue<QEl, std::vector<QEl>, decltype(cmp)> open_pref(cmp);
-        std::priority_queue<QEl, std::vector<QEl>, decltype(cmp)> open_norm(cmp);
+    note_out(p) << "Note: heuristic or costs are non-integer; using std::priority_queue GBFS.\n";
 
-        meta[0] = MetaD{ h(T,s0), 0.0, false };
-        ++R.stats.evaluated;
-        open_norm.push({ meta[0].h, meta[0].g, 0 });
+    struct MetaD { double h; double g; bool closed; };
+    ArenaVector<MetaD> meta(1, MetaD{0.0, 0.0, false});
 
-        State work; Undo undo; work = s0; undo.clear();
+    struct QEl { double h; double g; int id; };
+    auto cmp = [](const QEl& a, const QEl& b){
+        if (a.h != b.h) {
+            return a.h > b.h;
+        }
+        return a.g > b.g;
+    };
+
+    std::priority_queue<QEl, std::vector<QEl>, decltype(cmp)> open_pref(cmp);
+    std::priority_queue<QEl, std::vector<QEl>, decltype(cmp)> open_norm(cmp);
+
+    resolve_async(h); // 非同期に作ったヒューリスティックは、ここで完成を待つ
+    meta[0] = MetaD{ h(T,s0), 0.0, false };
+    ++R.stats.evaluated;
+    if (meta[0].h >= p.cost_bound) {
+        ++R.stats.pruned_by_bound;
+        R.bound_exhausted = true;
+        co_return;
+    }
+    open_norm.push({ meta[0].h, meta[0].g, 0 });
 
-        while (!open_pref.empty() || !open_norm.empty()) {
-            if (planner::sas::time_exceeded_cpu()) {
-                std::cerr << "error: CPU time limit exceeded (" << planner::sas::g_cpu_limit_sec << " sec)\n";
-                std::exit(101);
-            }
-            QEl cur;
+    State work; Undo undo; work = s0; undo.clear();
 
-            if (!open_pref.empty()) {
-                cur = open_pref.top();
-                open_pref.pop();
-            } else {
-                cur = open_norm.top();
-                open_norm.pop();
-            }
+    while (!open_pref.empty() || !open_norm.empty()) {
+        co_yield R.stats.expanded; // 展開数が上限に達していれば、ここで中断する
+        if (search_interrupted(p, R)) {
+            co_return;
+        }
+        QEl cur;
+
+        if (!open_pref.empty()) {
+            cur = open_pref.top();
+            open_pref.pop();
+        } else {
+            cur = open_norm.top();
+            open_norm.pop();
+        }
 
-            const int u = cur.id;
-            const State su = R.nodes[u].s;
+        const int u = cur.id;
+        if (meta[u].closed || cur.g != meta[u].g) { // 開き直す前の古いエントリ
+            continue;
+        }
+        const State su = states.get(u);
+
+        if (is_goal(T, su)) {
+            R.solved = true;
+            R.plan = states.extract_plan(u);
+            R.plan_cost = eval_plan_cost(T, R.plan);
+            co_return;
+        }
+
+        meta[u].closed = true;
 
-            if (is_goal(T, su)) {
-                R.solved = true;
-                R.plan = extract_plan(R.nodes, u);
-                R.plan_cost = eval_plan_cost(T, R.plan);
-                return R;
+        ++R.stats.expanded;
+        if (R.stats.expanded > p.max_expansions) co_return;
+
+        // 後続状態をまとめて生成し、ハッシュ値の計算とスロットの先読みを済ませてから重複検出を行う
+        batch.clear();
+        for (int a=0; a<(int)T.ops.size(); ++a) {
+            const auto& op = T.ops[a];
+            if (!is_applicable(T, su, op)) {
+                continue;
             }
 
-            meta[u].closed = true;
+            work = su; undo.clear();
+            const std::size_t mark = undo_mark(undo);
+
+            UndoGuard ug{work, undo, mark};
 
-            ++R.stats.expanded;
-            if (R.stats.expanded > p.max_expansions) break;
+            apply_inplace(T, op, work, undo);
+            ++R.stats.generated;
 
-            for (int a=0; a<(int)T.ops.size(); ++a) {
-                const auto& op = T.ops[a];
-                if (!is_applicable(T, su, op)) {
+            if (should_check_mutex_runtime(T)) {
+                if (planner::sas::violates_mutex(T, work)) {
                     continue;
                 }
+            }
 
-                work = su; undo.clear();
-                const std::size_t mark = undo_mark(undo);
-
-                UndoGuard ug{work, undo, mark};
+            const double gv = meta[u].g + op.cost;
 
-                apply_inplace(T, op, work, undo);
-                ++R.stats.generated;
+            // g-value だけで上界に達している場合は、ハッシュ表を引く前に枝刈りする
+            if (gv >= p.cost_bound) {
+                ++R.stats.pruned_by_bound;
+                continue;
+            }
 
-                if (should_check_mutex_runtime(T)) {
-                    if (planner::sas::violates_mutex(T, work)) {
-                        continue;
-                    }
+            batch.push(work, a);
+        }
+        batch.hash_and_prefetch(index_of);
+
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            const State& succ = batch.state(i);
+            const int a = batch.op(i);
+            const auto& op = T.ops[a];
+            const double gv = meta[u].g + op.cost;
+
+            const int found = index_of.find(succ, batch.hash(i), state_of);
+            if (found == StateIndex::EMPTY) {
+                const double hv = h(T, succ);
+                ++R.stats.evaluated;
+
+                // g+h が上界以上の場合は、ノードを登録せずに捨てる
+                if (gv + hv >= p.cost_bound) {
+                    ++R.stats.pruned_by_bound;
+                    continue;
                 }
+                const bool is_preferred = (hv < meta[u].h);
 
-                auto it = index_of.find(work);
-                if (it == index_of.end()) {
-                    const int v = (int)R.nodes.size();
-                    R.nodes.push_back(Node{work, u, a});
-                    index_of.emplace(R.nodes[v].s, v);
+                const int v = states.add(succ, u, a, su);
+                index_of.insert(batch.hash(i), v, state_of);
 
-                    const double hv = h(T, R.nodes[v].s);
-                    ++R.stats.evaluated;
-                    const bool is_preferred = (hv < meta[u].h);
-
-                    if ((int)meta.size() <= v) {
-                        meta.resize(v<<1);
+                if ((int)meta.size() <= v) {
+                    meta.resize(v<<1);
+                }
+                meta[v] = MetaD{hv, gv, false};
+                if (is_preferred) {
+                    open_pref.push({ hv, gv, v });
+                } else {
+                    open_norm.push({ hv, gv, v });
+                }
+            } else {
+                const int v = found;
+                // 上界がある場合は、g-value が改善した状態を開き直す (そうしないと上界未満のプランを見落とす)
+                if (bound_enabled(p) && gv < meta[v].g) {
+                    if (gv + meta[v].h >= p.cost_bound) { // 改善後も上界に達する場合
+                        ++R.stats.pruned_by_bound;
+                        continue;
                     }
-                    const double gv = meta[u].g + op.cost;
-                    meta[v] = MetaD{hv, gv, false};
-                    if (is_preferred) {
-                        open_pref.push({ hv, gv, v });
+                    meta[v].g = gv;
+                    meta[v].closed = false;
+                    states.set_parent(v, u, a);
+                    if (meta[v].h < meta[u].h) {
+                        open_pref.push({ meta[v].h, gv, v });
                     } else {
-                        open_norm.push({ hv, gv, v });
+                        open_norm.push({ meta[v].h, gv, v });
                     }
-                } else {
-                    ++R.stats.duplicates;
                     continue;
                 }
+                ++R.stats.duplicates;
+                continue;
             }
         }
-        return R;
     }
+    R.bound_exhausted = bound_enabled(p) && open_pref.empty() && open_norm.empty();
+}
+
+// GBFS (hb が nullptr でない場合は、展開ごとに新しい後続状態をまとめて hb で評価する)
+static SearchSteps gbfs_impl(const Task& T, HeuristicFn& h, const BatchHeuristicFn* hb, const bool h_int, const Params& p,
+                             Result& R) {
+
+    State s0(T.vars.size());
+    for (int v=0; v<(int)T.vars.size(); ++v) {
+        s0[v] = T.init[v];
+    }
+    R.nodes.push_back(Node{ s0, -1, -1 });
+
+    if (is_goal(T, s0)) {
+        if (0.0 >= p.cost_bound) { // 空のプランでさえ上界以上の場合
+            R.bound_exhausted = true;
+            return {};
+        }
+        R.solved = true; R.plan_cost = 0.0; R.plan.clear();
+        return {};
+    }
+
+    // 状態空間が十分に小さい場合は、ハッシュ表の代わりに密な状態表を用いる
+    if (p.dense_max_states > 0 && all_action_costs_are_integers(T) && h_int) {
+        const StateRanker ranker(T, p.dense_max_states);
+        if (ranker.fits()) {
+            return gbfs_dense(T, h, hb, p, ranker, R);
+        }
+    }
+
+    if (all_action_costs_are_integers(T) && h_int) {
+        return gbfs_int(T, h, hb, p, R);
+    }
+    return gbfs_real(T, h, p, R);
+}
+
+SearchSteps gbfs_steps(const Task& T, HeuristicFn& h, const bool h_int, const Params& p, Result& R) {
+    return gbfs_impl(T, h, nullptr, h_int, p, R);
+}
+
+Result gbfs(const Task& T, HeuristicFn h, const bool h_int, const Params& p) {
+    PLANNER_ALLOC_PHASE(Expansion);
+    Result R;
+    gbfs_impl(T, h, nullptr, h_int, p, R).run();
+    return R;
+}
+
+Result gbfs_batched(const Task& T, BatchHeuristicFn hb, const bool h_int, const Params& p) {
+    // 初期状態と、コストが整数でない場合の探索では 1 状態ずつ評価する
+    HeuristicFn h = [hb, out = std::vector<double>()](const Task& task, const State& s) mutable -> double {
+        hb(task, std::vector<State>{s}, out);
+        return out[0];
+    };
+    PLANNER_ALLOC_PHASE(Expansion);
+    Result R;
+    gbfs_impl(T, h, &hb, h_int, p, R).run();
+    return R;
 }
 
 }} // namespace planner::sas
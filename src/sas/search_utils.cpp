@@ -0,0 +1,63 @@
+#include "sas/search_utils.hpp"
+
+namespace planner { namespace sas {
+
+// FNV-1a で 64-bit 整数を 1 つずつ混ぜ込むための補助関数
+static inline void fnv_mix(uint64_t& h, uint64_t x) {
+    for (int i = 0; i < 8; ++i) {
+        h ^= (x >> (8 * i)) & 0xffull;
+        h *= 1099511628211ull;
+    }
+}
+
+uint64_t task_fingerprint(const Task& T) {
+    uint64_t h = 1469598103934665603ull;
+
+    fnv_mix(h, T.vars.size());
+    for (const auto& var : T.vars) {
+        fnv_mix(h, static_cast<uint64_t>(var.domain));
+    }
+    for (int v : T.init) {
+        fnv_mix(h, static_cast<uint64_t>(v));
+    }
+
+    fnv_mix(h, T.goal.size());
+    for (auto [v, val] : T.goal) {
+        fnv_mix(h, static_cast<uint64_t>(v));
+        fnv_mix(h, static_cast<uint64_t>(val));
+    }
+
+    fnv_mix(h, T.ops.size());
+    for (const auto& op : T.ops) {
+        fnv_mix(h, static_cast<uint64_t>(op.cost));
+        fnv_mix(h, op.prevail.size());
+        for (auto [v, val] : op.prevail) {
+            fnv_mix(h, static_cast<uint64_t>(v));
+            fnv_mix(h, static_cast<uint64_t>(val));
+        }
+        fnv_mix(h, op.pre_posts.size());
+        for (const auto& pp : op.pre_posts) {
+            const auto& conds = std::get<0>(pp);
+            fnv_mix(h, conds.size());
+            for (auto [cv, cval] : conds) {
+                fnv_mix(h, static_cast<uint64_t>(cv));
+                fnv_mix(h, static_cast<uint64_t>(cval));
+            }
+            fnv_mix(h, static_cast<uint64_t>(std::get<1>(pp)));
+            fnv_mix(h, static_cast<uint64_t>(static_cast<int64_t>(std::get<2>(pp)))); // pre は -1 を取りうる
+            fnv_mix(h, static_cast<uint64_t>(std::get<3>(pp)));
+        }
+    }
+
+    fnv_mix(h, T.mutexes.size());
+    for (const auto& m : T.mutexes) {
+        fnv_mix(h, m.lits.size());
+        for (auto [v, val] : m.lits) {
+            fnv_mix(h, static_cast<uint64_t>(v));
+            fnv_mix(h, static_cast<uint64_t>(val));
+        }
+    }
+    return h;
+}
+
+}} // namespace planner::sas
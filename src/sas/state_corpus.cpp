@@ -0,0 +1,216 @@
+#include "sas/state_corpus.hpp"
+#include "sas/search_utils.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <cstring>
+
+namespace planner { namespace sas {
+
+namespace {
+
+constexpr char CORPUS_MAGIC[8] = {'P', 'L', 'N', 'C', 'O', 'R', 'P', '1'};
+
+// ドメインの大きさ d の変数を表すのに必要な bit 数
+uint32_t bits_for(int d) {
+    uint32_t b = 0;
+    while (b < 31 && (1ll << b) < d) {
+        ++b;
+    }
+    return b;
+}
+
+// 状態を各変数の bit 数に詰めて並べる (状態ごとに 64bit 境界から始める)
+class BitPacker {
+public:
+    explicit BitPacker(const Task& T) {
+        bits_.reserve(T.vars.size());
+        for (const auto& var : T.vars) {
+            bits_.push_back(bits_for(var.domain));
+            total_ += bits_.back();
+        }
+    }
+
+    std::size_t words() const { return (total_ + 63) / 64; }
+
+    void pack(const State& s, uint64_t* out) const {
+        std::memset(out, 0, words() * sizeof(uint64_t));
+        std::size_t pos = 0;
+        for (std::size_t v = 0; v < bits_.size(); ++v) {
+            const uint64_t x = static_cast<uint32_t>(s[v]);
+            for (uint32_t b = 0; b < bits_[v]; ++b, ++pos) {
+                out[pos / 64] |= ((x >> b) & 1ull) << (pos % 64);
+            }
+        }
+    }
+
+    void unpack(const uint64_t* in, State& s) const {
+        s.assign(bits_.size(), 0);
+        std::size_t pos = 0;
+        for (std::size_t v = 0; v < bits_.size(); ++v) {
+            uint32_t x = 0;
+            for (uint32_t b = 0; b < bits_[v]; ++b, ++pos) {
+                x |= static_cast<uint32_t>((in[pos / 64] >> (pos % 64)) & 1ull) << b;
+            }
+            s[v] = static_cast<int>(x);
+        }
+    }
+
+private:
+    std::vector<uint32_t> bits_;
+    std::size_t total_ = 0;
+};
+
+template <class X>
+void write_pod(std::ostream& os, const X& x) {
+    os.write(reinterpret_cast<const char*>(&x), sizeof(X));
+}
+
+template <class X>
+void read_pod(std::istream& is, X& x) {
+    is.read(reinterpret_cast<char*>(&x), sizeof(X));
+}
+
+void write_string(std::ostream& os, const std::string& s) {
+    const uint64_t n = s.size();
+    write_pod(os, n);
+    os.write(s.data(), static_cast<std::streamsize>(n));
+}
+
+std::string read_string(std::istream& is, const std::string& path) {
+    uint64_t n = 0;
+    read_pod(is, n);
+    if (!is || n > (1ull << 32)) {
+        throw std::runtime_error("truncated state corpus: " + path);
+    }
+    std::string s(static_cast<std::size_t>(n), '\0');
+    is.read(s.data(), static_cast<std::streamsize>(n));
+    return s;
+}
+
+} // namespace
+
+StateRecorder::StateRecorder(std::size_t capacity, uint64_t seed)
+    : capacity_(capacity), rng_(seed) {
+    states_.reserve(capacity_);
+    values_.reserve(capacity_);
+}
+
+void StateRecorder::offer(const State& s, double h) {
+    std::lock_guard<std::mutex> lk(mu_);
+    ++seen_;
+    if (states_.size() < capacity_) {
+        states_.push_back(s);
+        values_.push_back(h);
+        return;
+    }
+    // Algorithm R: seen_ 番目の状態を capacity_ / seen_ の確率で、ランダムに選んだ 1 つと入れ替える
+    const uint64_t j = std::uniform_int_distribution<uint64_t>(0, seen_ - 1)(rng_);
+    if (j < capacity_) {
+        states_[j] = s;
+        values_[j] = h;
+    }
+}
+
+HeuristicFn StateRecorder::wrap(HeuristicFn h) {
+    return [this, h = std::move(h)](const Task& T, const State& s) {
+        const double v = h(T, s);
+        offer(s, v);
+        return v;
+    };
+}
+
+uint64_t StateRecorder::seen() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return seen_;
+}
+
+std::size_t StateRecorder::size() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return states_.size();
+}
+
+void StateRecorder::write(const std::string& path, const Task& T, const std::string& heuristic) const {
+    std::ofstream ofs(path, std::ios::binary);
+    if (!ofs) {
+        throw std::runtime_error("failed to open state corpus for write: " + path);
+    }
+
+    std::ostringstream sas;
+    write_sas(T, sas);
+
+    std::lock_guard<std::mutex> lk(mu_);
+    const BitPacker packer(T);
+    const uint64_t fp = task_fingerprint(T);
+    const uint64_t n = states_.size();
+    const uint64_t words = packer.words();
+
+    ofs.write(CORPUS_MAGIC, sizeof(CORPUS_MAGIC));
+    write_pod(ofs, fp);
+    write_string(ofs, heuristic);
+    write_string(ofs, sas.str());
+    write_pod(ofs, n);
+    write_pod(ofs, seen_);
+    write_pod(ofs, words);
+
+    std::vector<uint64_t> buf(packer.words());
+    for (std::size_t i = 0; i < states_.size(); ++i) {
+        packer.pack(states_[i], buf.data());
+        ofs.write(reinterpret_cast<const char*>(buf.data()), static_cast<std::streamsize>(buf.size() * sizeof(uint64_t)));
+    }
+    ofs.write(reinterpret_cast<const char*>(values_.data()), static_cast<std::streamsize>(values_.size() * sizeof(double)));
+    ofs.flush();
+    if (!ofs) {
+        throw std::runtime_error("failed to write state corpus: " + path);
+    }
+}
+
+StateCorpus read_corpus(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) {
+        throw std::runtime_error("cannot open state corpus: " + path);
+    }
+
+    char magic[sizeof(CORPUS_MAGIC)];
+    uint64_t fp = 0;
+    ifs.read(magic, sizeof(magic));
+    read_pod(ifs, fp);
+    if (!ifs || std::memcmp(magic, CORPUS_MAGIC, sizeof(CORPUS_MAGIC)) != 0) {
+        throw std::runtime_error("not a state corpus file: " + path);
+    }
+
+    StateCorpus C;
+    C.heuristic = read_string(ifs, path);
+    {
+        std::istringstream sas(read_string(ifs, path));
+        C.task = read_stream(sas);
+    }
+    if (task_fingerprint(C.task) != fp) {
+        throw std::runtime_error("state corpus task does not match its fingerprint: " + path);
+    }
+
+    uint64_t n = 0, words = 0;
+    read_pod(ifs, n);
+    read_pod(ifs, C.seen);
+    read_pod(ifs, words);
+    const BitPacker packer(C.task);
+    if (!ifs || words != packer.words()) {
+        throw std::runtime_error("state corpus layout does not match its task: " + path);
+    }
+
+    std::vector<uint64_t> buf(packer.words());
+    C.states.resize(static_cast<std::size_t>(n));
+    for (auto& s : C.states) {
+        ifs.read(reinterpret_cast<char*>(buf.data()), static_cast<std::streamsize>(buf.size() * sizeof(uint64_t)));
+        packer.unpack(buf.data(), s);
+    }
+    C.values.resize(static_cast<std::size_t>(n));
+    ifs.read(reinterpret_cast<char*>(C.values.data()), static_cast<std::streamsize>(C.values.size() * sizeof(double)));
+    if (!ifs) {
+        throw std::runtime_error("truncated state corpus: " + path);
+    }
+    return C;
+}
+
+}} // namespace planner::sas
@@ -0,0 +1,22 @@
+#include "sas/state_index.hpp"
+
+namespace planner { namespace sas {
+
+StateIndex::StateIndex(std::size_t initial_capacity) {
+    std::size_t cap = 16;
+    while (cap < initial_capacity * 2) { // 負荷率 1/2 以下で initial_capacity 個を保持できる 2 の冪
+        cap <<= 1;
+    }
+    slots_.assign(cap, Slot{0, EMPTY});
+    mask_ = cap - 1;
+}
+
+void StateIndex::place(uint64_t h, int id) noexcept {
+    std::size_t i = h & mask_;
+    while (slots_[i].id != EMPTY) { // 線形探査
+        i = (i + 1) & mask_;
+    }
+    slots_[i] = Slot{static_cast<uint32_t>(h >> 32), static_cast<int32_t>(id)};
+}
+
+}} // namespace planner::sas
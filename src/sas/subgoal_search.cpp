@@ -0,0 +1,199 @@
+#include "sas/subgoal_search.hpp"
+#include "sas/causal_graph.hpp"
+#include "sas/landmark_graph.hpp"
+#include "sas/search_utils.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace planner { namespace sas {
+
+namespace { // 衝突を避けるために無名名前空間を使用する
+
+void add_stats(Stats& to, const Stats& from) {
+    to.expanded += from.expanded;
+    to.generated += from.generated;
+    to.evaluated += from.evaluated;
+    to.duplicates += from.duplicates;
+    to.pruned_by_bound += from.pruned_by_bound;
+}
+
+// 部分問題の途中経過 (最後のゴールへの探索が失敗した場合に遡る先)
+struct Checkpoint {
+    State state;
+    std::size_t plan_len = 0;
+};
+
+} // anonymous namespace
+
+SubgoalResult subgoal_search(const Task& T, const HeuristicFactory& make_h, bool h_is_integer,
+                             const SubgoalParams& sp, const Params& p) {
+    SubgoalResult out;
+    Result& R = out.result;
+
+    const LandmarkGraph G(T);
+    const auto& lms = G.landmarks();
+    const auto dtgs = build_dtgs(T);
+    out.num_landmarks = G.size();
+
+    // 必要順序の子と、未処理の親の数
+    std::vector<std::vector<int>> children(G.size());
+    std::vector<int> pending(G.size(), 0);
+    for (std::size_t id = 0; id < G.size(); ++id) {
+        pending[id] = static_cast<int>(lms[id].parents.size());
+        for (int q : lms[id].parents) {
+            children[q].push_back(static_cast<int>(id));
+        }
+    }
+    std::vector<uint8_t> done(G.size(), 0);
+    std::vector<int> available; // 親が全て処理済みで、まだ処理していない landmark
+    for (std::size_t id = 0; id < G.size(); ++id) {
+        if (pending[id] == 0) {
+            available.push_back(static_cast<int>(id));
+        }
+    }
+    auto finish = [&](int id) {
+        done[id] = 1;
+        for (int c : children[id]) {
+            if (--pending[c] == 0) {
+                available.push_back(c);
+            }
+        }
+    };
+
+    // 部分問題は小さいので、状態数に比例する密な状態表は確保せずにハッシュ表を使う
+    Params subp = p;
+    subp.verbose = false;
+    subp.dense_max_states = 0;
+    subp.cost_bound = std::numeric_limits<double>::infinity();
+    uint64_t budget = p.max_expansions;
+
+    Task sub = T; // 初期状態とゴールだけを差し替えて使い回す
+    auto solve_sub = [&](const State& from, const GoalCondition& goal, Result& res) {
+        if (budget == 0) {
+            return false;
+        }
+        sub.init = from;
+        sub.goal = goal;
+        subp.max_expansions = std::min(sp.max_sub_expansions, budget);
+        res = gbfs(sub, make_h ? make_h(sub) : blind(), h_is_integer, subp);
+        add_stats(R.stats, res.stats);
+        budget -= std::min(budget, res.stats.expanded);
+        R.stop = res.stop;
+        return res.solved;
+    };
+
+    State s = T.init;
+    Undo undo;
+    std::vector<Checkpoint> checkpoints;
+    Result res;
+    for (;;) {
+        // 現在の状態で満たされている landmark は達成済みとする
+        for (bool changed = true; changed;) {
+            changed = false;
+            for (std::size_t i = 0; i < available.size(); ++i) {
+                const int id = available[i];
+                if (!done[id] && G.satisfied(id, s)) {
+                    finish(id);
+                    changed = true;
+                }
+            }
+            available.erase(std::remove_if(available.begin(), available.end(), [&](int id) { return done[id] != 0; }),
+                            available.end());
+        }
+
+        // 次の部分ゴール: ゴール以外の landmark を優先し、その中で DTG 上の距離が最も近い fact
+        int best_id = -1;
+        std::pair<int, int> best_fact{-1, -1};
+        long long best_key = std::numeric_limits<long long>::max();
+        for (int id : available) {
+            for (auto [v, val] : lms[id].facts) {
+                const int d = dtgs[v].distance(s[v], val);
+                if (d == DomainTransitionGraph::UNREACHABLE) {
+                    continue;
+                }
+                const long long key = (lms[id].goal ? (1ll << 40) : 0ll) + d;
+                if (key < best_key) {
+                    best_key = key;
+                    best_id = id;
+                    best_fact = {v, val};
+                }
+            }
+        }
+        if (best_id < 0) {
+            if (available.empty()) {
+                break;
+            }
+            for (int id : available) { // DTG 上で到達できない landmark は飛ばす
+                ++out.subgoals_failed;
+                finish(id);
+            }
+            available.erase(std::remove_if(available.begin(), available.end(), [&](int id) { return done[id] != 0; }),
+                            available.end());
+            continue;
+        }
+
+        if (solve_sub(s, {best_fact}, res)) {
+            for (uint32_t a : res.plan) {
+                apply_inplace(T, T.ops[a], s, undo);
+                R.plan.push_back(a);
+            }
+            undo.clear();
+            checkpoints.push_back(Checkpoint{s, R.plan.size()});
+            ++out.subgoals_solved;
+        } else if (R.stop != StopReason::None) {
+            return out;
+        } else {
+            ++out.subgoals_failed;
+        }
+        finish(best_id);
+        available.erase(std::remove(available.begin(), available.end(), best_id), available.end());
+    }
+
+    // 元のゴールへ (失敗した場合はチェックポイントを遡る)
+    auto accept = [&]() {
+        for (uint32_t a : res.plan) {
+            R.plan.push_back(a);
+        }
+        R.plan_cost = eval_plan_cost(T, R.plan);
+        R.solved = (R.plan_cost < p.cost_bound);
+        return R.solved;
+    };
+    if (solve_sub(s, T.goal, res) && accept()) {
+        return out;
+    }
+    if (R.stop != StopReason::None) {
+        return out;
+    }
+    checkpoints.insert(checkpoints.begin(), Checkpoint{T.init, 0});
+    checkpoints.pop_back(); // s と同じ状態
+    for (int k = 0; k < sp.max_backtracks && !checkpoints.empty(); ++k) {
+        const Checkpoint c = checkpoints.back();
+        checkpoints.pop_back();
+        ++out.backtracks;
+        R.plan.resize(c.plan_len);
+        if (solve_sub(c.state, T.goal, res) && accept()) {
+            return out;
+        }
+        if (R.stop != StopReason::None) {
+            return out;
+        }
+    }
+
+    // 分解をあきらめて、元のタスクを解く
+    R.plan.clear();
+    R.plan_cost = 0.0;
+    R.solved = false;
+    if (!sp.fallback || budget == 0) {
+        return out;
+    }
+    note_out(p) << "subgoal decomposition failed, falling back to gbfs\n";
+    out.fell_back = true;
+    Params fp = p;
+    fp.max_expansions = budget;
+    Result F = gbfs(T, make_h ? make_h(T) : blind(), h_is_integer, fp);
+    add_stats(F.stats, R.stats);
+    R = std::move(F);
+    return out;
+}
+
+}} // namespace planner::sas
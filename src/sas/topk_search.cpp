@@ -0,0 +1,335 @@
+#include "sas/topk_search.hpp"
+#include "sas/search_utils.hpp"
+#include "sas/state_index.hpp"
+#include "arena.hpp"
+#include "alloc_profile.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <tuple>
+
+namespace planner { namespace sas {
+
+namespace {
+
+constexpr double INF = std::numeric_limits<double>::infinity();
+
+// 展開済みの状態の間の辺 (u --op--> 辺を持つノード)
+struct InEdge {
+    int from;
+    int op;
+};
+
+// 探索で得たグラフから、sidetrack の列としてプランを列挙するための構造
+// ノード ID VGOAL は仮想ゴールで、展開したゴール状態からコスト 0 の辺が入る
+class PathEnumerator {
+public:
+    static constexpr int VGOAL = -1;
+
+    PathEnumerator(const Task& T, const std::vector<Node>& nodes, const std::vector<double>& g,
+                   const std::vector<std::vector<InEdge>>& in, const std::vector<int>& goal_nodes)
+        : T_(T), nodes_(nodes), g_(g), in_(in), goals_(goal_nodes) {
+        best_goal_ = *std::min_element(goals_.begin(), goals_.end(), [&](int a, int b) { return g_[a] < g_[b]; });
+    }
+
+    // コストが limit 以下のプランを小さい順に取り出し、accept() が true を返したものを out に積む関数
+    // out が k 個になるか、候補が尽きるか、max_candidates 個を取り出したら終了し、取り出した候補の数を返す
+    template <class Accept>
+    uint64_t run(double limit, std::size_t k, uint64_t max_candidates, const Accept& accept,
+                 std::vector<std::vector<uint32_t>>& out, std::vector<double>& costs) {
+        cands_.clear();
+        std::priority_queue<std::pair<double, int>, std::vector<std::pair<double, int>>, std::greater<>> pq;
+        cands_.push_back(Cand{g_[best_goal_], VGOAL, -1, 0, -1});
+        pq.emplace(cands_[0].cost, 0);
+
+        uint64_t popped = 0;
+        std::vector<uint32_t> plan;
+        while (!pq.empty() && out.size() < k && popped < max_candidates) {
+            const int ci = pq.top().second;
+            pq.pop();
+            ++popped;
+
+            build_plan(ci, plan);
+            if (accept(plan)) {
+                out.push_back(plan);
+                costs.push_back(cands_[ci].cost);
+            }
+
+            // 先頭ノードから根までの最短経路木の経路上にある、全ての sidetrack で 1 つずつ延ばす
+            const double base = cands_[ci].cost;
+            for (int w = cands_[ci].head; ; w = tree_parent(w)) {
+                if (w == VGOAL) {
+                    for (int t : goals_) {
+                        if (t != best_goal_) {
+                            push_child(pq, ci, base + (g_[t] - g_[best_goal_]), t, VGOAL, -1, limit);
+                        }
+                    }
+                } else {
+                    for (const InEdge& e : in_[w]) {
+                        if (e.from == nodes_[w].parent && e.op == nodes_[w].act_id) {
+                            continue; // 木の辺
+                        }
+                        const double delta = g_[e.from] + T_.ops[e.op].cost - g_[w];
+                        push_child(pq, ci, base + std::max(0.0, delta), e.from, w, e.op, limit);
+                    }
+                }
+                if (w != VGOAL && nodes_[w].parent < 0) {
+                    break;
+                }
+            }
+        }
+        return popped;
+    }
+
+private:
+    // 候補: 親の候補の sidetrack の列に、(from --op--> to) を 1 つ加えたもの (head = from)
+    struct Cand {
+        double cost;
+        int head;
+        int prev;
+        int to;
+        int op;
+    };
+
+    int tree_parent(int w) const { return w == VGOAL ? best_goal_ : nodes_[w].parent; }
+
+    template <class PQ>
+    void push_child(PQ& pq, int prev, double cost, int from, int to, int op, double limit) {
+        if (cost > limit) {
+            return;
+        }
+        cands_.push_back(Cand{cost, from, prev, to, op});
+        pq.emplace(cost, (int)cands_.size() - 1);
+    }
+
+    // 仮想ゴールから逆向きに、木の経路と sidetrack を交互にたどってプランを作る関数
+    void build_plan(int ci, std::vector<uint32_t>& plan) const {
+        chain_.clear();
+        for (int c = ci; cands_[c].prev >= 0; c = cands_[c].prev) {
+            chain_.push_back(c);
+        }
+        plan.clear();
+        int cur = VGOAL;
+        for (auto it = chain_.rbegin(); it != chain_.rend(); ++it) {
+            const Cand& c = cands_[*it];
+            for (; cur != c.to; cur = tree_parent(cur)) {
+                if (cur != VGOAL) {
+                    plan.push_back(static_cast<uint32_t>(nodes_[cur].act_id));
+                }
+            }
+            if (c.op >= 0) {
+                plan.push_back(static_cast<uint32_t>(c.op));
+            }
+            cur = c.head;
+        }
+        for (; cur == VGOAL || nodes_[cur].parent >= 0; cur = tree_parent(cur)) {
+            if (cur != VGOAL) {
+                plan.push_back(static_cast<uint32_t>(nodes_[cur].act_id));
+            }
+        }
+        std::reverse(plan.begin(), plan.end());
+    }
+
+    const Task& T_;
+    const std::vector<Node>& nodes_;
+    const std::vector<double>& g_;
+    const std::vector<std::vector<InEdge>>& in_;
+    const std::vector<int>& goals_;
+    int best_goal_ = 0;
+    std::vector<Cand> cands_;
+    mutable std::vector<int> chain_;
+};
+
+// 演算子集合の Jaccard 距離
+double jaccard_distance(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+    std::vector<uint32_t> x(a), y(b);
+    std::sort(x.begin(), x.end());
+    x.erase(std::unique(x.begin(), x.end()), x.end());
+    std::sort(y.begin(), y.end());
+    y.erase(std::unique(y.begin(), y.end()), y.end());
+    std::vector<uint32_t> common;
+    std::set_intersection(x.begin(), x.end(), y.begin(), y.end(), std::back_inserter(common));
+    const double uni = static_cast<double>(x.size() + y.size() - common.size());
+    return uni == 0.0 ? 0.0 : 1.0 - static_cast<double>(common.size()) / uni;
+}
+
+} // namespace
+
+TopKResult topk_search(const Task& T, HeuristicFn h, const TopKParams& kp, const Params& p) {
+    PLANNER_ALLOC_PHASE(Expansion);
+    TopKResult out;
+    Result R; // 探索ノードと統計 (search_interrupted() に渡す)
+    if (kp.k == 0) {
+        return out;
+    }
+
+    std::vector<double> g;
+    std::vector<double> hv;
+    std::vector<char> closed;
+    std::vector<std::vector<InEdge>> in;
+    std::vector<int> goal_nodes;
+
+    State s0(T.init.begin(), T.init.end());
+    R.nodes.push_back(Node{s0, -1, -1});
+    g.push_back(0.0);
+    resolve_async(h); // 非同期に作ったヒューリスティックは、ここで完成を待つ
+    hv.push_back(h(T, s0));
+    ++R.stats.evaluated;
+    closed.push_back(0);
+    in.emplace_back();
+
+    // (f, h, g, ノード ID) の最小ヒープ
+    using Entry = std::tuple<double, double, double, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    open.emplace(hv[0], hv[0], 0.0, 0);
+
+    auto state_of = [&R](int id) -> const State& { return R.nodes[id].s; };
+    StateIndex index_of(1 << 15);
+    SuccessorBatch batch;
+    index_of.insert(StateIndex::hash(s0), 0, state_of);
+
+    // 選んだプランと、既に選んだプランとの多様性の判定
+    auto accept = [&](const std::vector<uint32_t>& plan, const std::vector<std::vector<uint32_t>>& chosen) {
+        if (kp.diversity <= 0.0) {
+            return true;
+        }
+        for (const auto& q : chosen) {
+            if (jaccard_distance(plan, q) < kp.diversity) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // コストが limit 以下のプランを列挙し、k 個揃った場合は true を返す関数
+    // 既知の状態への辺は上界を確かめずに残すので、上界以上のコストのプランはここで除く
+    const double max_cost = std::nextafter(p.cost_bound, -INF);
+    uint64_t last_work = 0;
+    auto extract = [&](double limit) -> bool {
+        if (goal_nodes.empty()) {
+            return false;
+        }
+        std::vector<std::vector<uint32_t>> plans;
+        std::vector<double> costs;
+        PathEnumerator pe(T, R.nodes, g, in, goal_nodes);
+        last_work = pe.run(std::min(limit, max_cost), kp.k, kp.max_candidates,
+                           [&](const std::vector<uint32_t>& plan) { return accept(plan, plans); }, plans, costs);
+        out.plans = std::move(plans);
+        out.costs = std::move(costs);
+        return out.plans.size() >= kp.k;
+    };
+
+    auto finish = [&]() {
+        out.stats = R.stats;
+        out.stop = R.stop;
+        return out;
+    };
+
+    const bool check_mutex = should_check_mutex_runtime(T);
+    State work;
+    Undo undo;
+    double last_f = -INF;
+    uint64_t expanded_at_check = 0;
+
+    while (!open.empty()) {
+        if (search_interrupted(p, R)) {
+            extract(last_f); // 確定している範囲のプランを返す
+            return finish();
+        }
+
+        const auto [f, hu, gu, u] = open.top();
+        (void)hu;
+        if (gu != g[u] || closed[u]) {
+            open.pop();
+            continue;
+        }
+
+        // f が増えた時点で、それ未満のコストのプランは全て展開済みの状態のみを通る
+        // 列挙の手間が展開の手間を上回らないように、前回の列挙で取り出した候補数だけ展開してから次の列挙を行う
+        if (f > last_f) {
+            last_f = f;
+            if (R.stats.expanded - expanded_at_check >= last_work) {
+                expanded_at_check = R.stats.expanded;
+                if (extract(f)) {
+                    return finish();
+                }
+            }
+        }
+        open.pop();
+        closed[u] = 1;
+        if (is_goal(T, R.nodes[u].s)) {
+            goal_nodes.push_back(u);
+        }
+
+        ++R.stats.expanded;
+        if (R.stats.expanded > p.max_expansions) {
+            extract(f);
+            return finish();
+        }
+
+        // ゴール状態からも展開を続ける (ゴールを通り抜けるプランも数える)
+        const State su = R.nodes[u].s;
+        batch.clear();
+        for (int a = 0; a < (int)T.ops.size(); ++a) {
+            const auto& op = T.ops[a];
+            if (!is_applicable(T, su, op)) {
+                continue;
+            }
+            work = su;
+            undo.clear();
+            apply_inplace(T, op, work, undo);
+            ++R.stats.generated;
+
+            // 生成状態が mutex 違反なら捨てる
+            if (check_mutex && violates_mutex(T, work)) {
+                continue;
+            }
+            if (g[u] + op.cost >= p.cost_bound) { // g-value だけで上界に達している場合
+                ++R.stats.pruned_by_bound;
+                continue;
+            }
+            batch.push(work, a);
+        }
+        batch.hash_and_prefetch(index_of);
+
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            const State& succ = batch.state(i);
+            const int a = batch.op(i);
+            const double gv = g[u] + T.ops[a].cost;
+
+            int v = index_of.find(succ, batch.hash(i), state_of);
+            if (v == StateIndex::EMPTY) {
+                const double h_succ = h(T, succ);
+                ++R.stats.evaluated;
+                if (gv + h_succ >= p.cost_bound) {
+                    ++R.stats.pruned_by_bound;
+                    continue;
+                }
+                v = (int)R.nodes.size();
+                R.nodes.push_back(Node{succ, u, a});
+                index_of.insert(batch.hash(i), v, state_of);
+                g.push_back(gv);
+                hv.push_back(h_succ);
+                closed.push_back(0);
+                in.emplace_back();
+                open.emplace(gv + h_succ, h_succ, gv, v);
+            } else if (gv < g[v] && !closed[v]) {
+                g[v] = gv;
+                R.nodes[v].parent = u;
+                R.nodes[v].act_id = a;
+                open.emplace(gv + hv[v], hv[v], gv, v);
+            } else {
+                ++R.stats.duplicates;
+            }
+            in[v].push_back(InEdge{u, a}); // 全ての辺を残す (閉じたノードへの辺は sidetrack になる)
+        }
+    }
+
+    // 探索空間を網羅した場合は、全てのプランが展開済みの状態のみを通る
+    out.exhausted = true;
+    extract(INF);
+    return finish();
+}
+
+}} // namespace planner::sas
@@ -0,0 +1,533 @@
+#include "sas/two_bit_bfs.hpp"
+#include "sas/search_utils.hpp"
+#include "sas/sas_search.hpp"
+
+#include <atomic>
+#include <thread>
+#include <fstream>
+#include <algorithm>
+#include <limits>
+#include <cstring>
+#include <functional>
+
+namespace planner { namespace sas {
+
+namespace {
+
+// --- 2bit/状態 の配列 ---
+// 1 word (64bit) に 32 状態分のコードを詰める、状態 r のコードは word[r/32] の (r%32)*2 bit 目から 2bit
+enum : uint64_t {
+    CODE_UNSEEN = 0, // 未到達
+    CODE_OPEN   = 1, // 現在の層 (展開待ち)
+    CODE_CLOSED = 2, // 展開済み
+    CODE_NEXT   = 3, // 次の層
+};
+
+constexpr uint64_t LO_BITS = 0x5555555555555555ull; // 各コードの下位 bit
+constexpr uint64_t CHUNK_WORDS = 1ull << 12; // スレッドが一度に走査する word 数 (= 131072 状態)
+
+class TwoBitArray {
+public:
+    explicit TwoBitArray(uint64_t n)
+        : words_((n + 31) / 32), data_(std::make_unique<std::atomic<uint64_t>[]>(words_)) {} // 値初期化でゼロ (UNSEEN) になる
+
+    uint64_t words() const noexcept { return words_; }
+
+    uint64_t word(uint64_t i) const noexcept {
+        return data_[i].load(std::memory_order_relaxed);
+    }
+
+    void store_word(uint64_t i, uint64_t w) noexcept {
+        data_[i].store(w, std::memory_order_relaxed);
+    }
+
+    void set(uint64_t r, uint64_t code) noexcept {
+        const uint64_t sh = (r & 31) * 2;
+        const uint64_t w = word(r >> 5);
+        store_word(r >> 5, (w & ~(3ull << sh)) | (code << sh));
+    }
+
+    // 未到達の状態を NEXT にする関数、他のスレッドと競合した場合は先に書いた方が勝つ
+    bool try_mark_next(uint64_t r) noexcept {
+        const uint64_t sh = (r & 31) * 2;
+        std::atomic<uint64_t>& a = data_[r >> 5];
+        uint64_t w = a.load(std::memory_order_relaxed);
+        while (true) {
+            if (((w >> sh) & 3ull) != CODE_UNSEEN) {
+                return false;
+            }
+            if (a.compare_exchange_weak(w, w | (CODE_NEXT << sh), std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+    }
+
+private:
+    uint64_t words_;
+    std::unique_ptr<std::atomic<uint64_t>[]> data_;
+};
+
+// word 内で指定のコードを持つ状態の bit (各コードの下位 bit の位置) を返す関数
+inline uint64_t code_mask(uint64_t w, uint64_t code) noexcept {
+    const uint64_t lo = w & LO_BITS;
+    const uint64_t hi = (w >> 1) & LO_BITS;
+    switch (code) {
+        case CODE_UNSEEN: return ~lo & ~hi & LO_BITS;
+        case CODE_OPEN:   return lo & ~hi;
+        case CODE_CLOSED: return ~lo & hi;
+        default:          return lo & hi;
+    }
+}
+
+// 配列を CHUNK_WORDS ごとのセグメントに分け、スレッドが動的に取り合って fn(tid, word_begin, word_end) を実行する関数
+void parallel_segments(uint32_t num_threads, uint64_t words,
+                       const std::function<void(uint32_t, uint64_t, uint64_t)>& fn) {
+    std::atomic<uint64_t> next_chunk{0};
+    const uint64_t num_chunks = (words + CHUNK_WORDS - 1) / CHUNK_WORDS;
+
+    auto worker = [&](uint32_t tid) {
+        while (true) {
+            const uint64_t c = next_chunk.fetch_add(1, std::memory_order_relaxed);
+            if (c >= num_chunks) {
+                break;
+            }
+            const uint64_t b = c * CHUNK_WORDS;
+            fn(tid, b, std::min(words, b + CHUNK_WORDS));
+        }
+    };
+
+    if (num_threads <= 1) {
+        worker(0);
+        return;
+    }
+    std::vector<std::thread> th;
+    th.reserve(num_threads);
+    for (uint32_t t = 0; t < num_threads; ++t) {
+        th.emplace_back(worker, t);
+    }
+    for (auto& x : th) {
+        x.join();
+    }
+}
+
+// スレッドごとの作業領域
+struct Scratch {
+    State su;
+    State work;
+    Undo undo;
+};
+
+// 後ろ向き (regression) 展開用の演算子
+struct RegressionOp {
+    std::vector<std::pair<int,int>> prevail; // (var, val)
+    std::vector<std::tuple<int,int,int>> effects; // (var, pre, post)、pre = -1 は任意の値
+    std::vector<std::pair<int,int>> free_vars; // pre = -1 の効果の (var, post)
+};
+
+// 全ての演算子が条件付き効果を持たず、同じ変数を 2 度書き換えない場合のみ、後ろ向き展開で前状態を列挙できる
+bool build_regression_ops(const Task& T, std::vector<RegressionOp>& out) {
+    out.clear();
+    out.reserve(T.ops.size());
+    std::vector<int> touched(T.vars.size(), -1);
+    for (int a = 0; a < (int)T.ops.size(); ++a) {
+        const auto& op = T.ops[a];
+        RegressionOp ro;
+        for (auto [v, val] : op.prevail) {
+            if (touched[v] == a) {
+                return false;
+            }
+            touched[v] = a;
+            ro.prevail.emplace_back(v, val);
+        }
+        for (const auto& pp : op.pre_posts) {
+            const int var = std::get<1>(pp);
+            if (!std::get<0>(pp).empty() || touched[var] == a) {
+                return false;
+            }
+            touched[var] = a;
+            ro.effects.emplace_back(var, std::get<2>(pp), std::get<3>(pp));
+            if (std::get<2>(pp) < 0) {
+                ro.free_vars.emplace_back(var, std::get<3>(pp));
+            }
+        }
+        out.push_back(std::move(ro));
+    }
+    return true;
+}
+
+// pre = -1 の変数 free_vars[k..] の値を全て列挙し、前状態のランクそれぞれについて fn(rank) を呼ぶ関数
+template <class Fn>
+void for_each_free_assignment(const Task& T, const StateRanker& ranker, const RegressionOp& ro,
+                              std::size_t k, uint64_t r, Fn& fn) {
+    if (k == ro.free_vars.size()) {
+        fn(r);
+        return;
+    }
+    const auto [var, post] = ro.free_vars[k];
+    for (int val = 0; val < T.vars[var].domain; ++val) {
+        for_each_free_assignment(T, ranker, ro, k + 1, ranker.rerank(r, var, post, val), fn);
+    }
+}
+
+constexpr char DIST_MAGIC[8] = {'P', '2', 'B', 'F', 'S', 'D', '0', '1'};
+
+} // namespace
+
+// --- GoalDistanceTable ---
+GoalDistanceTable::GoalDistanceTable(const Task& T, uint64_t max_states)
+    : ranker_(T, max_states), fingerprint_(task_fingerprint(T)) {
+    if (ranker_.fits()) {
+        dist_.assign(ranker_.num_states(), UNREACHABLE);
+    }
+    min_cost_ = std::numeric_limits<int>::max();
+    for (const auto& op : T.ops) {
+        min_cost_ = std::min(min_cost_, op.cost);
+    }
+    if (T.ops.empty()) {
+        min_cost_ = 0;
+    }
+}
+
+void GoalDistanceTable::save(const std::string& path) const {
+    std::ofstream ofs(path, std::ios::binary);
+    if (!ofs) {
+        throw std::runtime_error("failed to open distance table for write: " + path);
+    }
+    const uint64_t n = dist_.size();
+    const int32_t mc = min_cost_;
+    const uint8_t tr = truncated_ ? 1 : 0;
+    ofs.write(DIST_MAGIC, sizeof(DIST_MAGIC));
+    ofs.write(reinterpret_cast<const char*>(&fingerprint_), sizeof(fingerprint_));
+    ofs.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    ofs.write(reinterpret_cast<const char*>(&mc), sizeof(mc));
+    ofs.write(reinterpret_cast<const char*>(&tr), sizeof(tr));
+    ofs.write(reinterpret_cast<const char*>(dist_.data()), static_cast<std::streamsize>(n));
+    ofs.flush();
+    if (!ofs) {
+        throw std::runtime_error("failed to write distance table: " + path);
+    }
+}
+
+std::shared_ptr<GoalDistanceTable> GoalDistanceTable::load(const Task& T, const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs) {
+        throw std::runtime_error("cannot open distance table: " + path);
+    }
+
+    char magic[sizeof(DIST_MAGIC)];
+    uint64_t fp = 0, n = 0;
+    int32_t mc = 0;
+    uint8_t tr = 0;
+    ifs.read(magic, sizeof(magic));
+    ifs.read(reinterpret_cast<char*>(&fp), sizeof(fp));
+    ifs.read(reinterpret_cast<char*>(&n), sizeof(n));
+    ifs.read(reinterpret_cast<char*>(&mc), sizeof(mc));
+    ifs.read(reinterpret_cast<char*>(&tr), sizeof(tr));
+    if (!ifs || std::memcmp(magic, DIST_MAGIC, sizeof(DIST_MAGIC)) != 0) {
+        throw std::runtime_error("not a distance table file: " + path);
+    }
+
+    auto table = std::make_shared<GoalDistanceTable>(T, n);
+    if (fp != table->fingerprint_) {
+        throw std::runtime_error("distance table was built for a different task: " + path);
+    }
+    if (!table->fits() || table->ranker_.num_states() != n) {
+        throw std::runtime_error("distance table size does not match the task: " + path);
+    }
+
+    ifs.read(reinterpret_cast<char*>(table->dist_.data()), static_cast<std::streamsize>(n));
+    if (!ifs) {
+        throw std::runtime_error("truncated distance table: " + path);
+    }
+    table->min_cost_ = mc;
+    table->truncated_ = (tr != 0);
+    return table;
+}
+
+HeuristicFn distance_table_heuristic(std::shared_ptr<const GoalDistanceTable> table) {
+    return [table](const Task&, const State& s) -> double {
+        const double PSEUDOINF = 1 << 16; // hff と同様に、ゴールに到達できない状態は疑似的な INF とする
+        const uint8_t d = table->distance(s);
+        if (d == GoalDistanceTable::UNREACHABLE) {
+            return PSEUDOINF;
+        }
+        return static_cast<double>(d) * static_cast<double>(table->min_cost());
+    };
+}
+
+// --- 2-bit BFS ---
+Bfs2Result two_bit_bfs(const Task& T, const Bfs2Params& p) {
+    Bfs2Result R;
+
+    const StateRanker ranker(T, p.max_states);
+    R.fits = ranker.fits();
+    if (!R.fits) {
+        return R;
+    }
+    R.num_states = ranker.num_states();
+
+    const uint32_t N = p.num_threads ? p.num_threads : std::max(1u, std::thread::hardware_concurrency());
+    const bool do_mutex = should_check_mutex_runtime(T);
+
+    TwoBitArray codes(R.num_states);
+    if (p.compute_goal_distance) {
+        R.table = std::make_shared<GoalDistanceTable>(T, p.max_states);
+    }
+    uint8_t* dist = p.compute_goal_distance ? R.table->data().data() : nullptr;
+
+    std::vector<Scratch> scratch(N);
+    std::atomic<bool> timed_out{false};
+
+    // 状態 su (ランク ru) の後続状態それぞれについて fn(op_id, rv) を呼ぶ関数
+    auto for_each_successor = [&](Scratch& S, uint64_t ru, auto&& fn) {
+        for (int a = 0; a < (int)T.ops.size(); ++a) {
+            const auto& op = T.ops[a];
+            if (!is_applicable(T, S.su, op)) {
+                continue;
+            }
+
+            S.work = S.su;
+            S.undo.clear();
+            const std::size_t mark = undo_mark(S.undo);
+            UndoGuard ug{S.work, S.undo, mark};
+
+            apply_inplace(T, op, S.work, S.undo);
+
+            if (do_mutex && planner::sas::violates_mutex(T, S.work)) {
+                continue;
+            }
+            if (fn(a, ranker.rank_after(ru, S.su, S.work, S.undo, mark))) {
+                break;
+            }
+        }
+    };
+
+    // --- 前向きの層ごとの列挙 ---
+    const uint64_t r0 = ranker.rank(State(T.init.begin(), T.init.end()));
+    codes.set(r0, CODE_OPEN);
+    R.layer_sizes.push_back(1);
+    R.reachable = 1;
+
+    std::atomic<uint64_t> goal_states{0};
+
+    while (true) {
+        // OPEN の状態を展開し、未到達の後続状態を NEXT にする
+        parallel_segments(N, codes.words(), [&](uint32_t tid, uint64_t wb, uint64_t we) {
+            Scratch& S = scratch[tid];
+            uint64_t local_goals = 0;
+
+            if (planner::sas::time_exceeded_cpu()) {
+                timed_out.store(true, std::memory_order_relaxed);
+                return;
+            }
+
+            for (uint64_t i = wb; i < we; ++i) {
+                uint64_t m = code_mask(codes.word(i), CODE_OPEN);
+                while (m) {
+                    const uint64_t ru = i * 32 + static_cast<uint64_t>(__builtin_ctzll(m)) / 2;
+                    m &= m - 1;
+
+                    ranker.unrank(ru, S.su);
+                    if (is_goal(T, S.su)) {
+                        ++local_goals;
+                        if (dist) {
+                            dist[ru] = 0; // ゴール状態は各層で 1 度だけ、そのセグメントを担当するスレッドが書く
+                        }
+                    }
+
+                    for_each_successor(S, ru, [&](int, uint64_t rv) {
+                        codes.try_mark_next(rv);
+                        return false;
+                    });
+                }
+            }
+            goal_states.fetch_add(local_goals, std::memory_order_relaxed);
+        });
+        if (timed_out.load(std::memory_order_relaxed)) { // CPU 時間の制限を超えた場合は途中で打ち切る
+            R.timed_out = true;
+            return R;
+        }
+
+        // OPEN -> CLOSED, NEXT -> OPEN の一括変換を行い、次の層の状態数を数える
+        std::atomic<uint64_t> next_count{0};
+        parallel_segments(N, codes.words(), [&](uint32_t, uint64_t wb, uint64_t we) {
+            uint64_t local = 0;
+            for (uint64_t i = wb; i < we; ++i) {
+                const uint64_t w = codes.word(i);
+                const uint64_t open = code_mask(w, CODE_OPEN);
+                const uint64_t next = code_mask(w, CODE_NEXT);
+                if (open | next) {
+                    codes.store_word(i, w ^ (open | (open << 1)) ^ (next << 1)); // 01 -> 10, 11 -> 01
+                    local += static_cast<uint64_t>(__builtin_popcountll(next));
+                }
+            }
+            next_count.fetch_add(local, std::memory_order_relaxed);
+        });
+
+        const uint64_t n_next = next_count.load();
+        if (n_next == 0) {
+            break;
+        }
+        R.layer_sizes.push_back(n_next);
+        R.reachable += n_next;
+    }
+    R.goal_states = goal_states.load();
+
+    if (!dist) {
+        return R;
+    }
+
+    // --- ゴール距離の計算 (ゴール状態からの後ろ向きの層付け) ---
+    // 距離 d-1 の状態の前状態のうち、未確定の到達可能状態に距離 d を付ける
+    // 後ろ向き展開ができないタスク (条件付き効果など) では、未確定の状態を前向きに展開して距離 d-1 の後続状態を探す
+    // 同じ層で書き込む値 d と読み出す値 d-1 は異なるので、atomic_ref による relaxed アクセスで十分
+    std::vector<RegressionOp> reg_ops;
+    const bool regressable = build_regression_ops(T, reg_ops);
+    const uint64_t n_states = R.num_states;
+
+    bool truncated = false;
+    for (int d = 1; R.goal_states > 0; ++d) {
+        if (d > GoalDistanceTable::MAX_DIST) { // 距離の上限に達した場合、残りの状態は MAX_DIST として許容的な下界を与える
+            truncated = true;
+            for (uint64_t i = 0; i < codes.words(); ++i) {
+                uint64_t m = code_mask(codes.word(i), CODE_CLOSED);
+                while (m) {
+                    const uint64_t r = i * 32 + static_cast<uint64_t>(__builtin_ctzll(m)) / 2;
+                    m &= m - 1;
+                    if (dist[r] == GoalDistanceTable::UNREACHABLE) {
+                        dist[r] = GoalDistanceTable::MAX_DIST;
+                    }
+                }
+            }
+            break;
+        }
+
+        const uint8_t want = static_cast<uint8_t>(d - 1);
+        const uint8_t put = static_cast<uint8_t>(d);
+        std::atomic<uint64_t> assigned{0};
+
+        parallel_segments(N, codes.words(), [&](uint32_t tid, uint64_t wb, uint64_t we) {
+            Scratch& S = scratch[tid];
+            uint64_t local = 0;
+
+            if (planner::sas::time_exceeded_cpu()) {
+                timed_out.store(true, std::memory_order_relaxed);
+                return;
+            }
+
+            // 到達可能で距離が未確定の前状態に距離 d を付ける
+            auto visit = [&](uint64_t rp) {
+                if (((codes.word(rp >> 5) >> ((rp & 31) * 2)) & 3ull) != CODE_CLOSED) {
+                    return;
+                }
+                uint8_t expected = GoalDistanceTable::UNREACHABLE;
+                if (std::atomic_ref<uint8_t>(dist[rp]).compare_exchange_strong(expected, put, std::memory_order_relaxed)) {
+                    ++local;
+                }
+            };
+
+            for (uint64_t i = wb; regressable && i < we; ++i) {
+                const uint64_t rb = i * 32;
+                const uint64_t re = std::min(n_states, rb + 32);
+                for (uint64_t rv = rb; rv < re; ++rv) {
+                    if (std::atomic_ref<uint8_t>(dist[rv]).load(std::memory_order_relaxed) != want) {
+                        continue;
+                    }
+                    ranker.unrank(rv, S.su);
+                    for (const auto& ro : reg_ops) {
+                        bool ok = true;
+                        for (auto [v, val] : ro.prevail) {
+                            if (S.su[v] != val) {
+                                ok = false;
+                                break;
+                            }
+                        }
+                        for (std::size_t e = 0; ok && e < ro.effects.size(); ++e) {
+                            ok = (S.su[std::get<0>(ro.effects[e])] == std::get<2>(ro.effects[e]));
+                        }
+                        if (!ok) {
+                            continue;
+                        }
+                        uint64_t rp = rv;
+                        for (auto [var, pre, post] : ro.effects) {
+                            if (pre >= 0) {
+                                rp = ranker.rerank(rp, var, post, pre);
+                            }
+                        }
+                        for_each_free_assignment(T, ranker, ro, 0, rp, visit);
+                    }
+                }
+            }
+
+            for (uint64_t i = wb; !regressable && i < we; ++i) {
+                uint64_t m = code_mask(codes.word(i), CODE_CLOSED);
+                while (m) {
+                    const uint64_t ru = i * 32 + static_cast<uint64_t>(__builtin_ctzll(m)) / 2;
+                    m &= m - 1;
+
+                    std::atomic_ref<uint8_t> du(dist[ru]);
+                    if (du.load(std::memory_order_relaxed) != GoalDistanceTable::UNREACHABLE) {
+                        continue;
+                    }
+
+                    ranker.unrank(ru, S.su);
+                    bool found = false;
+                    for_each_successor(S, ru, [&](int, uint64_t rv) {
+                        found = (std::atomic_ref<uint8_t>(dist[rv]).load(std::memory_order_relaxed) == want);
+                        return found;
+                    });
+                    if (found) {
+                        du.store(put, std::memory_order_relaxed);
+                        ++local;
+                    }
+                }
+            }
+            assigned.fetch_add(local, std::memory_order_relaxed);
+        });
+        if (timed_out.load(std::memory_order_relaxed)) { // CPU 時間の制限を超えた場合は途中で打ち切る
+            R.timed_out = true;
+            return R;
+        }
+
+        if (assigned.load() == 0) {
+            break;
+        }
+    }
+    R.table->set_truncated(truncated);
+
+    // --- 距離表を下ってプランを復元する ---
+    const uint8_t d0 = dist[r0];
+    if (d0 == GoalDistanceTable::UNREACHABLE) {
+        return R;
+    }
+    R.init_distance = d0;
+    if (truncated && d0 == GoalDistanceTable::MAX_DIST) { // 打ち切られた距離からは復元できない
+        return R;
+    }
+
+    Scratch& S = scratch[0];
+    uint64_t ru = r0;
+    ranker.unrank(ru, S.su);
+    for (uint8_t d = d0; d > 0; --d) {
+        int chosen = -1;
+        uint64_t rnext = 0;
+        for_each_successor(S, ru, [&](int a, uint64_t rv) {
+            if (dist[rv] == d - 1) {
+                chosen = a;
+                rnext = rv;
+                return true;
+            }
+            return false;
+        });
+        if (chosen < 0) { // 通常は起こらない
+            R.plan.clear();
+            return R;
+        }
+        R.plan.push_back(static_cast<uint32_t>(chosen));
+        ru = rnext;
+        ranker.unrank(ru, S.su);
+    }
+    return R;
+}
+
+}} // namespace planner::sas
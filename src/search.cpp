@@ -1,5 +1,6 @@
 #include "search.hpp"
 #include "bucket_pq.hpp"
+#include "alloc_profile.hpp"
 #include <algorithm>
 #include <cmath>
 #include <iomanip>
@@ -81,6 +82,7 @@ int rounding(double v) {
 // --- A* Search ---
 
 SearchResult astar(const StripsTask& st, HeuristicFn h, const bool h_int, const SearchParams& p) {
+    PLANNER_ALLOC_PHASE(Expansion);
     SearchResult R; // 結果を格納する用の R
 
     // 巻き戻しを RAII で保証する番兵の Structure
@@ -97,6 +99,10 @@ SearchResult astar(const StripsTask& st, HeuristicFn h, const bool h_int, const
 
     // 既にゴール
     if (is_goal(st, s0)) { 
+        if (0.0 >= p.cost_bound) { // 空のプランでさえ上界以上の場合
+            R.bound_exhausted = true;
+            return R;
+        }
         R.solved = true;
         R.plan.clear();
         R.plan_cost = 0.0;
@@ -139,6 +145,11 @@ SearchResult astar(const StripsTask& st, HeuristicFn h, const bool h_int, const
         // 初期ノードの登録
         const int h0 = rounding(h(st, s0)); 
         meta[0] = MetaI{0, h0, false};
+        if (h0 >= p.cost_bound) { // 初期ノードの f 値が上界以上の場合
+            ++R.stats.pruned_by_bound;
+            R.bound_exhausted = true;
+            return R;
+        }
         open.insert(0, pack_fh_asc(h0, h0));
 
         StripsState work; // 1 コピー
@@ -190,13 +201,24 @@ SearchResult astar(const StripsTask& st, HeuristicFn h, const bool h_int, const
                 const int w = rounding(act.cost);
                 const int tentative_g = meta[u].g + w;
 
+                // g 値だけで上界に達する場合は、ハッシュ表を引く前に枝刈りする
+                if (tentative_g >= p.cost_bound) {
+                    ++R.stats.pruned_by_bound;
+                    continue;
+                }
+
                 auto it = index_of.find(work);
                 if (it == index_of.end()) { // 新規ノードの場合
+                    const int hv = rounding(h(st, work));
+                    if (tentative_g + hv >= p.cost_bound) { // f 値が上界以上の場合は、ノードを登録しない
+                        ++R.stats.pruned_by_bound;
+                        continue;
+                    }
+
                     const int v = (int)R.nodes.size();
                     R.nodes.push_back(Node{work, u, a});
                     index_of.emplace(R.nodes[v].s, v);
 
-                    const int hv = rounding(h(st, R.nodes[v].s));
                     if ((int)meta.size() <= v) {
                         meta.resize(v+1);
                     }
@@ -208,6 +230,10 @@ SearchResult astar(const StripsTask& st, HeuristicFn h, const bool h_int, const
                     const int v = it->second;
 
                     if (tentative_g < meta[v].g) { // g 値が改善される場合
+                        if (tentative_g + meta[v].h >= p.cost_bound) { // 改善後も上界に達する場合
+                            ++R.stats.pruned_by_bound;
+                            continue;
+                        }
                         meta[v].g = tentative_g;
                         R.nodes[v].parent = u;
                         R.nodes[v].act_id = a;
@@ -244,6 +270,7 @@ SearchResult astar(const StripsTask& st, HeuristicFn h, const bool h_int, const
                 }
             }
         }
+        R.bound_exhausted = std::isfinite(p.cost_bound) && open.empty();
         return R;
 
     } else { // コストが浮動小数点を含む場合
@@ -273,6 +300,11 @@ SearchResult astar(const StripsTask& st, HeuristicFn h, const bool h_int, const
 
         // 初期ノード
         meta[0] = MetaD{0.0, h(st, s0), false};
+        if (meta[0].h >= p.cost_bound) { // 初期ノードの f 値が上界以上の場合
+            ++R.stats.pruned_by_bound;
+            R.bound_exhausted = true;
+            return R;
+        }
         open.push({ meta[0].g + meta[0].h, meta[0].h, 0 });
 
         StripsState work;
@@ -320,13 +352,24 @@ SearchResult astar(const StripsTask& st, HeuristicFn h, const bool h_int, const
 
                 const double tentative_g = meta[u].g + act.cost;
 
+                // g 値だけで上界に達する場合は、ハッシュ表を引く前に枝刈りする
+                if (tentative_g >= p.cost_bound) {
+                    ++R.stats.pruned_by_bound;
+                    continue;
+                }
+
                 auto it = index_of.find(work);
                 if (it == index_of.end()) { // 新規ノードの場合
+                    const double hv = h(st, work);
+                    if (tentative_g + hv >= p.cost_bound) { // f 値が上界以上の場合は、ノードを登録しない
+                        ++R.stats.pruned_by_bound;
+                        continue;
+                    }
+
                     const int v = (int)R.nodes.size(); // 新しい id の生成
                     R.nodes.push_back(Node{work, u, a});
                     index_of.emplace(R.nodes[v].s, v);
 
-                    const double hv = h(st, R.nodes[v].s);
                     if ((int)meta.size() <= v) {
                         meta.resize(v+1);
                     }
@@ -337,6 +380,10 @@ SearchResult astar(const StripsTask& st, HeuristicFn h, const bool h_int, const
 
                     // g 値が改善できたら更新する
                     if (tentative_g + EPS < meta[v].g) {
+                        if (tentative_g + meta[v].h >= p.cost_bound) { // 改善後も上界に達する場合
+                            ++R.stats.pruned_by_bound;
+                            continue;
+                        }
                         meta[v].g = tentative_g;
                         R.nodes[v].parent = u;
                         R.nodes[v].act_id = a;
@@ -363,6 +410,7 @@ SearchResult astar(const StripsTask& st, HeuristicFn h, const bool h_int, const
                 }
             }
         }
+        R.bound_exhausted = std::isfinite(p.cost_bound) && open.empty();
         return R;
     }
 
@@ -371,6 +419,7 @@ SearchResult astar(const StripsTask& st, HeuristicFn h, const bool h_int, const
 // --- GBFS ---
 
 SearchResult gbfs(const StripsTask& st, HeuristicFn h, const bool h_int, const SearchParams& p) {
+    PLANNER_ALLOC_PHASE(Expansion);
     SearchResult R;
 
     struct UndoGuard {
@@ -386,6 +435,10 @@ SearchResult gbfs(const StripsTask& st, HeuristicFn h, const bool h_int, const S
 
     // 初期ノードがゴールの場合
     if (is_goal(st, s0)) {
+        if (0.0 >= p.cost_bound) { // 空のプランでさえ上界以上の場合
+            R.bound_exhausted = true;
+            return R;
+        }
         R.solved = true;
         R.plan.clear();
         R.plan_cost = 0.0;
@@ -415,10 +468,10 @@ SearchResult gbfs(const StripsTask& st, HeuristicFn h, const bool h_int, const S
         index_of.reserve(1 << 15);
 
         // ノード情報 (open or close) を保存する用のベクター
-        struct MetaI {int h; bool closed;};
+        struct MetaI {int g; int h; bool closed;}; // g はコスト上界による枝刈りにのみ使用する
         std::vector<MetaI> meta;
         meta.reserve(1 << 15);
-        meta.emplace_back(MetaI{0, false});
+        meta.emplace_back(MetaI{0, 0, false});
 
         // Open List
         BucketPQ open;
@@ -426,8 +479,13 @@ SearchResult gbfs(const StripsTask& st, HeuristicFn h, const bool h_int, const S
         // 初期ノードの登録
         const int h0 = rounding(h(st, s0));
         index_of.emplace(s0, 0);
+        meta[0] = MetaI{0, h0, false};
+        if (h0 >= p.cost_bound) { // 初期ノードの g+h が上界以上の場合
+            ++R.stats.pruned_by_bound;
+            R.bound_exhausted = true;
+            return R;
+        }
         open.insert(0, h0);
-        meta[0] = MetaI{h0, false};
 
         StripsState work;
         Undo undo;
@@ -468,25 +526,36 @@ SearchResult gbfs(const StripsTask& st, HeuristicFn h, const bool h_int, const S
                 apply_inplace(st, act, work, undo);
                 ++R.stats.generated;
 
+                const int gv = meta[id].g + rounding(act.cost);
+                if (gv >= p.cost_bound) { // g 値だけで上界に達する場合
+                    ++R.stats.pruned_by_bound;
+                    continue;
+                }
+
                 auto it = index_of.find(work);
                 if (it == index_of.end()) { // 新規ノードの場合
+                    const int hv = rounding(h(st, work));
+                    if (gv + hv >= p.cost_bound) { // g+h が上界以上の場合は、ノードを登録しない
+                        ++R.stats.pruned_by_bound;
+                        continue;
+                    }
+
                     const int v = (int)R.nodes.size();
                     R.nodes.push_back(Node{work, id, a});
                     index_of.emplace(R.nodes[v].s, v);
 
-                    const int hv = rounding(h(st, R.nodes[v].s));
-
                     if  ((int)meta.size() <= v) {
                         meta.resize(v << 1);
                     }
 
-                    meta[v] = MetaI{hv, false};
+                    meta[v] = MetaI{gv, hv, false};
                     open.insert(static_cast<uint32_t>(v), static_cast<uint32_t>(hv));
                 } else { // 既存ノードの場合, 基本的にノードで h value は不変なので、スキップする, h value を動的にする場合追加
                     ++R.stats.duplicates;
                 }
             }
         }
+        R.bound_exhausted = std::isfinite(p.cost_bound) && open.empty();
         return R;
 
     } else { // 浮動小数点を含む場合
@@ -502,12 +571,13 @@ SearchResult gbfs(const StripsTask& st, HeuristicFn h, const bool h_int, const S
         index_of.emplace(s0, 0);
 
         struct MetaD{
+            double g; // コスト上界による枝刈りにのみ使用する
             double h;
             bool closed;
         };
         std::vector<MetaD> meta;
         meta.reserve(1 << 15);
-        meta.emplace_back(MetaD{0.0, false});
+        meta.emplace_back(MetaD{0.0, 0.0, false});
 
         // open list (優先度付きキュー)
         struct QEl { // Queue Element Structure
@@ -523,7 +593,12 @@ SearchResult gbfs(const StripsTask& st, HeuristicFn h, const bool h_int, const S
 
         std::priority_queue<QEl, std::vector<QEl>, decltype(cmp)> open(cmp);
 
-        meta[0] = MetaD{h(st, s0), false};
+        meta[0] = MetaD{0.0, h(st, s0), false};
+        if (meta[0].h >= p.cost_bound) { // 初期ノードの g+h が上界以上の場合
+            ++R.stats.pruned_by_bound;
+            R.bound_exhausted = true;
+            return R;
+        }
         open.push({meta[0].h, 0});
 
         StripsState work;
@@ -567,25 +642,36 @@ SearchResult gbfs(const StripsTask& st, HeuristicFn h, const bool h_int, const S
                 apply_inplace(st, act, work, undo);
                 ++R.stats.generated;
 
+                const double gv = meta[u].g + act.cost;
+                if (gv >= p.cost_bound) { // g 値だけで上界に達する場合
+                    ++R.stats.pruned_by_bound;
+                    continue;
+                }
+
                 auto it = index_of.find(work);
                 if (it == index_of.end()) {
+                    const double hv = h(st, work);
+                    if (gv + hv >= p.cost_bound) { // g+h が上界以上の場合は、ノードを登録しない
+                        ++R.stats.pruned_by_bound;
+                        continue;
+                    }
+
                     const int v = (int)R.nodes.size();
                     R.nodes.push_back(Node{work, u, a});
                     index_of.emplace(R.nodes[v].s, v);
 
-                    const double hv = h(st, R.nodes[v].s);
-
                     if ((int)meta.size() <= v) {
                         meta.resize(v << 1);
                     }
 
-                    meta[v] = MetaD{hv, false};
+                    meta[v] = MetaD{gv, hv, false};
                     open.push({hv, v});
                 } else {
                     ++R.stats.duplicates;
                 }
             }
         }
+        R.bound_exhausted = std::isfinite(p.cost_bound) && open.empty();
         return R;
     }
 
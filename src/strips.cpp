@@ -1,4 +1,5 @@
 #include "strips.hpp"
+#include "alloc_profile.hpp"
 #include <unordered_set>
 #include <sstream>
 #include <queue>
@@ -59,6 +60,7 @@ static int intern_fact(StripsTask& st, const GroundAtom& ga, const GroundTask& g
 
 // GroundTask を STRIPSTask に変換する関数
 StripsTask compile_to_strips(const GroundTask& gt) {
+    PLANNER_ALLOC_PHASE(Ground);
     StripsTask st; // STRIPS Task
 
     // 各 GroundAtom を 事実集合に入れるラムダ関数 (intern_fact 関数を流用した実装)
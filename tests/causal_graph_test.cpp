@@ -0,0 +1,146 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <sas/sas_reader.hpp>
+#include <sas/sas_search.hpp>
+#include <sas/sas_heuristic.hpp>
+#include <sas/search_utils.hpp>
+#include <sas/causal_graph.hpp>
+
+using planner::sas::Task;
+using planner::sas::State;
+using planner::sas::read_file;
+
+static void die_usage(const char* argv0) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << argv0 << " <path/to/output.sas>\n\n"
+        << "Builds the causal graph and the domain transition graphs, checks them against the operators,\n"
+        << "and solves the task with GBFS using h_CG and h_cea. Returns non-zero on failure.\n";
+    std::exit(2);
+}
+
+// --- helpers ---
+
+static void expect(bool cond, const std::string& what) {
+    if (!cond) {
+        throw std::runtime_error(what);
+    }
+}
+
+// DTG の各遷移が、演算子を実際に適用した時の変化と一致するか確認する関数
+static void check_dtgs(const Task& T, const std::vector<planner::sas::DomainTransitionGraph>& dtgs) {
+    expect(dtgs.size() == T.vars.size(), "one DTG per variable");
+    for (const auto& g : dtgs) {
+        for (int from = 0; from < g.domain; ++from) {
+            expect(g.distance(from, from) == 0, "distance to itself is not 0");
+            for (const auto& t : g.out[from]) {
+                expect(t.from == from && t.to != from, "bad transition endpoints");
+                expect(t.cost == T.ops[t.op].cost, "transition cost differs from operator cost");
+                expect(g.distance(from, t.to) <= t.cost, "distance exceeds a direct transition");
+
+                bool found = false;
+                for (const auto& [conds, v, pre, post] : T.ops[t.op].pre_posts) {
+                    found = found || (v == g.var && post == t.to && (pre < 0 || pre == from));
+                }
+                expect(found, "transition has no matching effect");
+                for (const auto& [u, val] : t.conds) {
+                    expect(u != g.var, "condition on the DTG's own variable");
+                }
+            }
+        }
+    }
+}
+
+// 因果グラフの辺が、DTG の条件と演算子の効果から作られているか確認する関数
+static void check_causal_graph(const Task& T, const planner::sas::CausalGraph& cg,
+                               const std::vector<planner::sas::DomainTransitionGraph>& dtgs) {
+    auto has = [](const std::vector<int>& xs, int x) {
+        for (int y : xs) {
+            if (y == x) {
+                return true;
+            }
+        }
+        return false;
+    };
+    for (const auto& g : dtgs) {
+        for (const auto& ts : g.out) {
+            for (const auto& t : ts) {
+                for (const auto& [u, val] : t.conds) {
+                    expect(has(cg.pre_to_eff[u], g.var), "missing pre -> eff arc");
+                    expect(has(cg.successors[u], g.var) && has(cg.predecessors[g.var], u), "missing causal graph arc");
+                }
+            }
+        }
+    }
+    for (const auto& op : T.ops) {
+        for (const auto& a : op.pre_posts) {
+            for (const auto& b : op.pre_posts) {
+                if (std::get<1>(a) != std::get<1>(b)) {
+                    expect(has(cg.eff_to_eff[std::get<1>(a)], std::get<1>(b)), "missing eff -- eff arc");
+                }
+            }
+        }
+    }
+}
+
+// プランが実行可能でゴールに達するか確認する関数
+static void check_plan(const Task& T, const std::vector<uint32_t>& plan, const std::string& what) {
+    State s(T.init.begin(), T.init.end());
+    for (uint32_t a : plan) {
+        expect(planner::sas::is_applicable(T, s, T.ops[a]), what + ": operator not applicable");
+        planner::sas::Undo undo;
+        planner::sas::apply_inplace(T, T.ops[a], s, undo);
+    }
+    expect(planner::sas::is_goal(T, s), what + ": plan does not reach the goal");
+}
+
+static void check_heuristic(const Task& T, const std::string& name, const planner::sas::HeuristicFn& h) {
+    const State s0(T.init.begin(), T.init.end());
+    const double h0 = h(T, s0);
+    expect(h0 >= 0.0, name + ": negative value");
+
+    planner::sas::Params P;
+    P.verbose = false;
+    const auto R = planner::sas::gbfs(T, h, true, P);
+    expect(R.solved, name + ": GBFS did not find a plan");
+    check_plan(T, R.plan, name);
+
+    // プランに沿った状態で値を求め、ゴール状態では 0 になることを確認する
+    State s = s0;
+    for (uint32_t a : R.plan) {
+        planner::sas::Undo undo;
+        planner::sas::apply_inplace(T, T.ops[a], s, undo);
+    }
+    expect(h(T, s) == 0.0, name + ": value at the goal is not 0");
+
+    std::cout << name << ": h(init) = " << h0 << ", GBFS plan cost " << R.plan_cost
+              << " with " << R.stats.expanded << " expansions\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+
+    try {
+        const Task T = read_file(argv[1]);
+        const planner::sas::CausalGraph cg(T);
+        const auto dtgs = planner::sas::build_dtgs(T);
+        check_dtgs(T, dtgs);
+        check_causal_graph(T, cg, dtgs);
+        std::cout << "causal graph: " << (cg.is_acyclic() ? "acyclic" : "cyclic") << "\n";
+
+        check_heuristic(T, "cg", planner::sas::hcg(T));
+        check_heuristic(T, "cea", planner::sas::hcea(T));
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
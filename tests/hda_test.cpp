@@ -0,0 +1,106 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cmath>
+#include <stdexcept>
+
+#include <sas/sas_reader.hpp>
+#include <sas/sas_search.hpp>
+#include <sas/sas_heuristic.hpp>
+#include <sas/search_utils.hpp>
+#include <sas/distributed_hda.hpp>
+
+using planner::sas::Task;
+using planner::sas::State;
+using planner::sas::read_file;
+
+static void die_usage(const char* argv0) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << argv0 << " <path/to/output.sas>\n\n"
+        << "Solves the task with multi-process HDA* (1-4 processes, unix and tcp transports)\n"
+        << "and checks the plan cost against A*. Returns non-zero on failure.\n";
+    std::exit(2);
+}
+
+// --- helpers ---
+
+static void expect(bool cond, const std::string& what) {
+    if (!cond) {
+        throw std::runtime_error(what);
+    }
+}
+
+// プランが実行可能でゴールに達するか確認する関数
+static void check_plan(const Task& T, const std::vector<uint32_t>& plan, const std::string& what) {
+    State s(T.init.begin(), T.init.end());
+    for (uint32_t a : plan) {
+        expect(planner::sas::is_applicable(T, s, T.ops[a]), what + ": operator not applicable");
+        planner::sas::Undo undo;
+        planner::sas::apply_inplace(T, T.ops[a], s, undo);
+    }
+    expect(planner::sas::is_goal(T, s), what + ": plan does not reach the goal");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+
+    try {
+        const Task T = read_file(argv[1]);
+        if (!planner::sas::all_action_costs_are_integers(T)) {
+            std::cout << "skipped: non-integer action costs\n";
+            return 0;
+        }
+
+        planner::sas::Params P;
+        P.verbose = false;
+        const auto ref = planner::sas::astar(T, planner::sas::goalcount(), true, P);
+        std::cout << "astar: " << (ref.solved ? "cost " + std::to_string((long long)ref.plan_cost) : "no solution") << "\n";
+
+        for (auto transport : {planner::sas::HdaTransport::Unix, planner::sas::HdaTransport::Tcp}) {
+            for (int n = 1; n <= 4; ++n) {
+                planner::sas::HdaParams hp;
+                hp.num_procs = n;
+                hp.transport = transport;
+                hp.batch_bytes = 256; // 小さいバッチで送受信を多く起こす
+                const std::string what = std::string(transport == planner::sas::HdaTransport::Unix ? "unix" : "tcp")
+                                       + " x" + std::to_string(n);
+
+                const auto H = planner::sas::distributed_astar(T, planner::sas::goalcount(), hp, P);
+                const auto& R = H.result;
+                expect(R.solved == ref.solved, what + ": solvability differs from A*");
+                expect(H.per_proc.size() == static_cast<std::size_t>(n), what + ": missing per-process stats");
+                if (R.solved) {
+                    check_plan(T, R.plan, what);
+                    expect(std::fabs(R.plan_cost - ref.plan_cost) < 1e-9, what + ": plan cost differs from A*");
+                }
+                uint64_t expanded = 0;
+                for (const auto& st : H.per_proc) {
+                    expanded += st.expanded;
+                }
+                expect(expanded == R.stats.expanded, what + ": per-process stats do not add up");
+                std::cout << what << ": cost " << R.plan_cost << ", expanded " << R.stats.expanded
+                          << ", messages " << H.messages << ", bytes " << H.bytes << "\n";
+            }
+        }
+
+        // コスト上界: 最適コストを上界にすると、上界未満のプランが存在しないことを示す
+        if (ref.solved) {
+            planner::sas::Params PB = P;
+            PB.cost_bound = ref.plan_cost;
+            planner::sas::HdaParams hp;
+            hp.num_procs = 3;
+            const auto H = planner::sas::distributed_astar(T, planner::sas::goalcount(), hp, PB);
+            expect(!H.result.solved && H.result.bound_exhausted, "bound: a plan below the optimal cost was reported");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
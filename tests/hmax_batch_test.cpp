@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <sas/sas_reader.hpp>
+#include <sas/sas_search.hpp>
+#include <sas/sas_heuristic.hpp>
+#include <sas/search_utils.hpp>
+
+using planner::sas::Task;
+using planner::sas::State;
+using planner::sas::read_file;
+
+static void die_usage(const char* argv0) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << argv0 << " <path/to/output.sas>\n\n"
+        << "Compares the bit-sliced h^max (single and batched, across lane boundaries) with a scalar\n"
+        << "reference on states from random walks, checks that it is admissible at the initial state (also with\n"
+        << "every cost set to 0), and checks that gbfs_batched expands the same nodes as gbfs and keeps the cheaper\n"
+        << "of two operators reaching the same state in one expansion under a cost bound.\n"
+        << "Returns non-zero on failure.\n";
+    std::exit(2);
+}
+
+// --- helpers ---
+
+static void expect(bool cond, const std::string& what) {
+    if (!cond) {
+        throw std::runtime_error(what);
+    }
+}
+
+// 1 層ずつ緩和到達可能性を広げ、全てのゴールに到達した層の番号に最も安い演算子のコストを掛けて返す関数 (比較用の素朴な実装)
+static double reference_hmax(const Task& T, const State& s) {
+    double layer_cost = 1.0;
+    if (!T.ops.empty()) {
+        layer_cost = T.ops[0].cost;
+        for (const auto& op : T.ops) {
+            layer_cost = std::min<double>(layer_cost, op.cost);
+        }
+    }
+    std::vector<std::vector<char>> reached(T.vars.size());
+    for (std::size_t v = 0; v < T.vars.size(); ++v) {
+        reached[v].assign(T.vars[v].domain, 0);
+        reached[v][s[v]] = 1;
+    }
+    auto goal_reached = [&] {
+        for (auto [v, val] : T.goal) {
+            if (!reached[v][val]) {
+                return false;
+            }
+        }
+        return true;
+    };
+    for (int layer = 0;; ++layer) {
+        if (goal_reached()) {
+            return layer * layer_cost;
+        }
+        auto next = reached;
+        bool changed = false;
+        for (const auto& op : T.ops) {
+            bool app = true;
+            for (auto [v, val] : op.prevail) {
+                app = app && reached[v][val];
+            }
+            for (const auto& [conds, var, pre, post] : op.pre_posts) {
+                for (auto [cv, cval] : conds) {
+                    app = app && reached[cv][cval];
+                }
+                app = app && (pre < 0 || reached[var][pre]);
+            }
+            if (!app) {
+                continue;
+            }
+            for (const auto& [conds, var, pre, post] : op.pre_posts) {
+                changed = changed || !next[var][post];
+                next[var][post] = 1;
+            }
+        }
+        if (!changed) {
+            return 1 << 16;
+        }
+        reached.swap(next);
+    }
+}
+
+// 同じ状態に至る高い演算子と安い演算子 (この順に並ぶ) と、ゴールに至る演算子からなるタスク (最適コスト 2)
+static Task two_operator_task() {
+    Task T;
+    T.metric = 1;
+    T.vars = {{"v0", 2}, {"v1", 2}};
+    T.init = {0, 0};
+    T.goal = {{1, 1}};
+    planner::sas::Operator expensive, cheap, finish;
+    expensive.name = "expensive";
+    expensive.pre_posts.emplace_back(std::vector<planner::sas::Operator::Cond>{}, 0, 0, 1);
+    expensive.cost = 2;
+    cheap.name = "cheap";
+    cheap.pre_posts.emplace_back(std::vector<planner::sas::Operator::Cond>{}, 0, 0, 1);
+    cheap.cost = 1;
+    finish.name = "finish";
+    finish.prevail.emplace_back(0, 1);
+    finish.pre_posts.emplace_back(std::vector<planner::sas::Operator::Cond>{}, 1, 0, 1);
+    finish.cost = 1;
+    T.ops = {expensive, cheap, finish};
+    return T;
+}
+
+// 初期状態からのランダムウォークで状態を集める関数
+static std::vector<State> sample_states(const Task& T, std::size_t n) {
+    std::mt19937 rng(12345);
+    std::vector<State> out;
+    State s = T.init;
+    planner::sas::Undo undo;
+    while (out.size() < n) {
+        out.push_back(s);
+        std::vector<int> app;
+        for (int a = 0; a < (int)T.ops.size(); ++a) {
+            if (planner::sas::is_applicable(T, s, T.ops[a])) {
+                app.push_back(a);
+            }
+        }
+        if (app.empty() || rng() % 16 == 0) {
+            s = T.init;
+            continue;
+        }
+        planner::sas::apply_inplace(T, T.ops[app[rng() % app.size()]], s, undo);
+        undo.clear();
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+
+    try {
+        const Task T = read_file(argv[1]);
+        const std::size_t lanes = planner::sas::hmax_batch_lanes();
+        const auto states = sample_states(T, 2 * lanes + 3);
+
+        std::vector<double> ref(states.size());
+        for (std::size_t i = 0; i < states.size(); ++i) {
+            ref[i] = reference_hmax(T, states[i]);
+        }
+
+        auto h = planner::sas::hmax(T);
+        for (std::size_t i = 0; i < states.size(); ++i) {
+            expect(h(T, states[i]) == ref[i], "hmax differs from the reference at state " + std::to_string(i));
+        }
+
+        // レーン数の前後で区切ったまとまりで評価しても同じ値になる
+        auto hb = planner::sas::hmax_batched(T);
+        for (std::size_t len : {std::size_t(1), lanes - 1, lanes, lanes + 1, states.size()}) {
+            for (std::size_t lo = 0; lo < states.size(); lo += len) {
+                const std::size_t hi = std::min(states.size(), lo + len);
+                const std::vector<State> chunk(states.begin() + (std::ptrdiff_t)lo, states.begin() + (std::ptrdiff_t)hi);
+                std::vector<double> out;
+                hb(T, chunk, out);
+                expect(out.size() == chunk.size(), "batch output size");
+                for (std::size_t i = 0; i < chunk.size(); ++i) {
+                    expect(out[i] == ref[lo + i], "batched hmax differs at state " + std::to_string(lo + i) +
+                                                  " (batch size " + std::to_string(len) + ")");
+                }
+            }
+        }
+
+        // 許容的: 初期状態の値は最適コスト以下で、コストが 0 の演算子があれば 0 になる
+        {
+            planner::sas::Params P;
+            P.verbose = false;
+            const auto A = planner::sas::astar(T, planner::sas::blind(), true, P);
+            expect(!A.solved || ref[0] <= A.plan_cost, "hmax(init) " + std::to_string(ref[0]) + " exceeds the optimal cost " +
+                                                       std::to_string(A.plan_cost));
+            Task Tz = T;
+            for (auto& op : Tz.ops) {
+                op.cost = 0;
+            }
+            expect(!A.solved || planner::sas::hmax(Tz)(Tz, Tz.init) == 0.0, "hmax(init) is not 0 when every cost is 0");
+        }
+
+        // まとめて評価しても GBFS の展開は変わらない (密な状態表とハッシュ表の両方)
+        for (uint64_t dense : {uint64_t(1) << 26, uint64_t(0)}) {
+            planner::sas::Params P;
+            P.verbose = false;
+            P.dense_max_states = dense;
+            const auto R1 = planner::sas::gbfs(T, planner::sas::hmax(T), true, P);
+            const auto R2 = planner::sas::gbfs_batched(T, planner::sas::hmax_batched(T), true, P);
+            expect(R1.solved == R2.solved && R1.plan == R2.plan, "gbfs_batched found a different plan");
+            expect(R1.stats.expanded == R2.stats.expanded && R1.stats.evaluated == R2.stats.evaluated &&
+                   R1.stats.duplicates == R2.stats.duplicates, "gbfs_batched expanded differently");
+            std::cout << (dense ? "dense" : "hash") << ": expanded " << R2.stats.expanded
+                      << ", evaluated " << R2.stats.evaluated << ", plan cost " << R2.plan_cost << "\n";
+        }
+        std::cout << "h^max(init) " << ref[0] << ", " << lanes << " lanes\n";
+
+        // 1 回の展開で同じ状態を 2 つの演算子で生成した場合、まとめて評価する前に安い方を残す
+        // (高い方を残すと g + h が上界 3 に達して捨てられ、上界未満のプランがないと誤って示してしまう)
+        const Task Tc = two_operator_task();
+        for (uint64_t dense : {uint64_t(1) << 26, uint64_t(0)}) {
+            planner::sas::Params P;
+            P.verbose = false;
+            P.dense_max_states = dense;
+            P.cost_bound = 3.0;
+            const auto R = planner::sas::gbfs_batched(Tc, planner::sas::hmax_batched(Tc), true, P);
+            const std::string name = std::string(dense ? "dense" : "hash") + " two operators";
+            expect(R.solved && !R.bound_exhausted, name + ": no plan found under the bound");
+            expect(R.plan_cost == 2.0, name + ": plan cost " + std::to_string(R.plan_cost) + ", expected 2");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <sas/sas_reader.hpp>
+#include <sas/sas_search.hpp>
+#include <sas/incremental_search.hpp>
+
+using planner::sas::Task;
+using planner::sas::State;
+using planner::sas::IncrementalPlanner;
+using planner::sas::read_file;
+
+static void die_usage(const char* argv0) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << argv0 << " <path/to/output.sas>\n\n"
+        << "Replans after changing the initial state and operator costs, and checks that\n"
+        << "each repaired plan is as cheap as a fresh A* on the changed task. Returns non-zero on failure.\n";
+    std::exit(2);
+}
+
+// --- helpers ---
+
+static void expect(bool cond, const std::string& what) {
+    if (!cond) {
+        throw std::runtime_error(what);
+    }
+}
+
+// 変更後のタスクを一から A* で解いた時のコストを返す関数 (解けない場合は -1)
+static double fresh_cost(const Task& T, uint64_t& expanded) {
+    planner::sas::Params P;
+    P.verbose = false;
+    P.dense_max_states = 0;
+    const auto R = planner::sas::astar(T, planner::sas::blind(), true, P);
+    expanded = R.stats.expanded;
+    return R.solved ? R.plan_cost : -1.0;
+}
+
+// プランが変更後のタスクで実行可能でゴールに達し、報告されたコストと一致するか確認する関数
+static void check_plan(const Task& T, const planner::sas::Result& R, const std::string& what) {
+    State s(T.init.begin(), T.init.end());
+    for (uint32_t a : R.plan) {
+        const auto& op = T.ops[a];
+        for (const auto& [v, val] : op.prevail) {
+            expect(s[v] == val, what + ": prevail violated");
+        }
+        for (const auto& [conds, v, pre, post] : op.pre_posts) {
+            expect(pre < 0 || s[v] == pre, what + ": precondition violated");
+            bool fire = true;
+            for (const auto& [cv, cval] : conds) {
+                fire = fire && (s[cv] == cval);
+            }
+            if (fire) {
+                s[v] = post;
+            }
+        }
+    }
+    for (const auto& [v, val] : T.goal) {
+        expect(s[v] == val, what + ": plan does not reach the goal");
+    }
+    expect(R.plan_cost == planner::sas::eval_plan_cost(T, R.plan), what + ": plan cost mismatch");
+}
+
+static void compare(IncrementalPlanner& ip, const std::string& what) {
+    const auto R = ip.plan();
+    uint64_t fresh_expanded = 0;
+    const double want = fresh_cost(ip.task(), fresh_expanded);
+    expect(R.solved == (want >= 0.0), what + ": solvability differs from A*");
+    if (R.solved) {
+        check_plan(ip.task(), R, what);
+        expect(R.plan_cost == want, what + ": cost " + std::to_string(R.plan_cost) + " != A* cost " + std::to_string(want));
+    }
+    std::cout << what << ": cost " << R.plan_cost << ", repaired with " << R.stats.expanded
+              << " expansions (A* from scratch: " << fresh_expanded << ")\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+
+    try {
+        const Task T = read_file(argv[1]);
+        planner::sas::Params P;
+        P.verbose = false;
+        IncrementalPlanner ip(T, planner::sas::blind(), P);
+        compare(ip, "initial");
+
+        // 変更がなければ展開は起こらない
+        const auto again = ip.plan();
+        expect(again.stats.expanded == 0, "replanning without changes expanded nodes");
+
+        // 最初の演算子を実行した後の状態を新しい初期状態とする
+        const auto first = ip.plan();
+        if (!first.plan.empty()) {
+            const auto& op = ip.task().ops[first.plan[0]];
+            std::vector<std::pair<int, int>> changes;
+            for (const auto& pp : op.pre_posts) {
+                changes.emplace_back(std::get<1>(pp), std::get<3>(pp));
+            }
+            ip.update_init(changes);
+            compare(ip, "init advanced");
+
+            // プラン中の演算子のコストを上げる
+            const auto cur = ip.plan();
+            std::vector<std::pair<int, int>> costs;
+            for (uint32_t a : cur.plan) {
+                costs.emplace_back(static_cast<int>(a), ip.task().ops[a].cost + 3);
+            }
+            ip.update_costs(costs);
+            compare(ip, "costs raised");
+
+            // 元に戻す
+            std::vector<std::pair<int, int>> restore;
+            for (const auto& [a, c] : costs) {
+                restore.emplace_back(a, T.ops[a].cost);
+            }
+            ip.update_costs(restore);
+            std::vector<std::pair<int, int>> init_back;
+            for (std::size_t v = 0; v < T.init.size(); ++v) {
+                init_back.emplace_back(static_cast<int>(v), T.init[v]);
+            }
+            ip.update_init(init_back);
+            compare(ip, "restored");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
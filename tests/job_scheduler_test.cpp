@@ -0,0 +1,103 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+
+#include <sas/job_scheduler.hpp>
+#include <sas/resumable_search.hpp>
+
+using planner::sas::Task;
+using planner::sas::JobScheduler;
+using planner::sas::JobSpec;
+using planner::sas::JobHandle;
+using planner::sas::ResumableSearch;
+using planner::sas::SolveStatus;
+using planner::sas::StepStatus;
+
+static void die_usage(const char* argv0) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << argv0 << " <path/to/output.sas>\n\n"
+        << "Checks that a search advanced one expansion at a time finds the same plan cost\n"
+        << "as plain A*, and that many jobs interleaved by JobScheduler all finish correctly.\n"
+        << "Returns non-zero on failure.\n";
+    std::exit(2);
+}
+
+// --- helpers ---
+
+static void expect(bool cond, const std::string& what) {
+    if (!cond) {
+        throw std::runtime_error(what);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+
+    try {
+        auto task = std::make_shared<const Task>(planner::sas::read_file(argv[1]));
+
+        // 基準となるコスト (一度に最後まで探索する A*)
+        planner::sas::Params P;
+        P.verbose = false;
+        P.dense_max_states = 0;
+        const auto ref = planner::sas::astar(*task, planner::sas::blind(), true, P);
+        expect(ref.solved, "reference astar did not solve the task");
+
+        // 1 ノードずつ展開しても同じコストのプランが得られること
+        ResumableSearch rs(*task, planner::sas::blind(), ResumableSearch::Mode::AStar, P);
+        uint64_t steps = 0;
+        while (rs.step(1) == StepStatus::Running) {
+            ++steps;
+        }
+        expect(rs.status() == StepStatus::Solved, "resumable astar did not solve the task");
+        expect(rs.result().plan_cost == ref.plan_cost, "resumable astar cost differs from astar");
+        expect(rs.result().stats.expanded == ref.stats.expanded, "resumable astar expanded a different number of nodes");
+        std::cout << "resumable: cost " << rs.result().plan_cost << " in " << steps << " steps\n";
+
+        // 多数のジョブを 2 スレッドで交互に進める
+        JobScheduler::Config cfg;
+        cfg.num_threads = 2;
+        cfg.slice_expansions = 64;
+        JobScheduler sched(cfg);
+
+        std::vector<JobHandle> astar_jobs, gbfs_jobs;
+        for (int i = 0; i < 24; ++i) {
+            JobSpec js;
+            js.task = task;
+            js.heuristic = "blind";
+            js.priority = 1 + (i % 4);
+            js.params.dense_max_states = 0;
+            js.algo = (i % 3 == 0) ? "gbfs" : "astar";
+            (js.algo == "gbfs" ? gbfs_jobs : astar_jobs).push_back(sched.submit(std::move(js)));
+        }
+
+        JobSpec cancelled;
+        cancelled.task = task;
+        cancelled.cancel.cancel();
+        const JobHandle hc = sched.submit(std::move(cancelled));
+
+        for (auto& h : astar_jobs) {
+            const auto& r = h.result.get();
+            expect(r.status == SolveStatus::Solved, "astar job " + std::to_string(h.id) + ": " + to_string(r.status));
+            expect(r.plan_cost == ref.plan_cost, "astar job " + std::to_string(h.id) + ": cost differs");
+        }
+        for (auto& h : gbfs_jobs) {
+            const auto& r = h.result.get();
+            expect(r.status == SolveStatus::Solved, "gbfs job " + std::to_string(h.id) + ": " + to_string(r.status));
+            expect(r.plan_cost == planner::sas::eval_plan_cost(*task, r.plan), "gbfs job: cost mismatch");
+        }
+        expect(hc.result.get().status == SolveStatus::Cancelled, "pre-cancelled job was not cancelled");
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
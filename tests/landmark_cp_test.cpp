@@ -0,0 +1,168 @@
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <sas/sas_reader.hpp>
+#include <sas/sas_search.hpp>
+#include <sas/sas_heuristic.hpp>
+#include <sas/search_utils.hpp>
+#include <sas/landmark_graph.hpp>
+#include <sas/lp_solver.hpp>
+
+using planner::sas::Task;
+using planner::sas::State;
+using planner::sas::read_file;
+using planner::sas::LinearProgram;
+using planner::sas::LPStatus;
+
+static void die_usage(const char* argv0) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << argv0 << " <path/to/output.sas>\n\n"
+        << "Checks the simplex solver on small LPs, builds the landmark graph, and checks that the uniform and\n"
+        << "optimal cost-partitioned landmark heuristics never exceed the remaining cost along an optimal plan.\n"
+        << "Returns non-zero on failure.\n";
+    std::exit(2);
+}
+
+// --- helpers ---
+
+static void expect(bool cond, const std::string& what) {
+    if (!cond) {
+        throw std::runtime_error(what);
+    }
+}
+
+static bool near(double a, double b) {
+    return std::fabs(a - b) < 1e-6;
+}
+
+// 解が分かっている小さな LP で単体法を確認する関数
+static void check_lp() {
+    {
+        // max x + y  s.t.  x + 2y <= 4, 3x + y <= 6  ->  (1.6, 1.2), 双対 (0.4, 0.2)
+        LinearProgram lp;
+        lp.num_cols = 2;
+        lp.obj = {1.0, 1.0};
+        lp.add_row({{0, 1.0}, {1, 2.0}}, 4.0);
+        lp.add_row({{0, 3.0}, {1, 1.0}}, 6.0);
+        const auto sol = planner::sas::solve_lp(lp);
+        expect(sol.status == LPStatus::Optimal, "LP 1 not optimal");
+        expect(near(sol.objective, 2.8) && near(sol.x[0], 1.6) && near(sol.x[1], 1.2), "LP 1 wrong solution");
+        expect(near(sol.duals[0], 0.4) && near(sol.duals[1], 0.2), "LP 1 wrong duals");
+    }
+    {
+        // 3 つの landmark を 2 つずつ達成する演算子 (コスト 1): 最適分割は 1.5、一様分割も 1.5
+        LinearProgram lp;
+        lp.num_cols = 3;
+        lp.obj = {1.0, 1.0, 1.0};
+        lp.add_row({{0, 1.0}, {1, 1.0}}, 1.0);
+        lp.add_row({{1, 1.0}, {2, 1.0}}, 1.0);
+        lp.add_row({{0, 1.0}, {2, 1.0}}, 1.0);
+        lp.add_row({{0, 1.0}}, 0.0); // 退化した制約
+        const auto sol = planner::sas::solve_lp(lp);
+        expect(sol.status == LPStatus::Optimal && near(sol.objective, 1.0), "LP 2 wrong objective");
+    }
+    {
+        LinearProgram lp;
+        lp.num_cols = 2;
+        lp.obj = {1.0, 0.0};
+        lp.add_row({{0, -1.0}, {1, 1.0}}, 1.0);
+        expect(planner::sas::solve_lp(lp).status == LPStatus::Unbounded, "LP 3 not unbounded");
+    }
+    {
+        LinearProgram lp;
+        lp.num_cols = 1;
+        lp.obj = {1.0};
+        lp.add_row({{0, 1.0}}, -1.0);
+        bool threw = false;
+        try {
+            (void)planner::sas::solve_lp(lp);
+        } catch (const std::invalid_argument&) {
+            threw = true;
+        }
+        expect(threw, "negative right-hand side accepted");
+    }
+}
+
+// landmark の achiever が本当にその facts のいずれかを追加するか確認する関数
+static void check_graph(const Task& T, const planner::sas::LandmarkGraph& G) {
+    for (const auto& L : G.landmarks()) {
+        expect(!L.facts.empty(), "empty landmark");
+        for (uint32_t a : L.achievers) {
+            bool adds = false;
+            for (const auto& [conds, v, pre, post] : T.ops[a].pre_posts) {
+                for (auto [lv, lval] : L.facts) {
+                    adds = adds || (v == lv && post == lval);
+                }
+            }
+            expect(adds, "achiever does not add the landmark");
+        }
+        for (int p : L.parents) {
+            expect(0 <= p && p < (int)G.size(), "parent out of range");
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+
+    try {
+        check_lp();
+
+        const Task T = read_file(argv[1]);
+        const planner::sas::LandmarkGraph G(T);
+        check_graph(T, G);
+        std::cout << "landmarks " << G.size() << " (disjunctive " << G.num_disjunctive()
+                  << ", single achiever " << G.num_action() << ")\n";
+
+        planner::sas::Params P;
+        P.verbose = false;
+        const auto R = planner::sas::astar(T, planner::sas::blind(), true, P);
+        expect(R.solved, "A* did not find a plan");
+
+        auto ucp = planner::sas::hlm_ucp(T);
+        auto ocp = planner::sas::hlm_ocp(T);
+
+        // 最適なプランに沿った各状態で、h が残りのコスト以下であること (許容性) を確かめる
+        State s = T.init;
+        double remaining = R.plan_cost;
+        for (std::size_t i = 0; i <= R.plan.size(); ++i) {
+            const double hu = ucp(T, s);
+            const double ho = ocp(T, s);
+            if (i == 0) {
+                std::cout << "h_ucp(init) " << hu << ", h_ocp(init) " << ho << ", optimal cost " << R.plan_cost << "\n";
+            }
+            expect(hu <= remaining + 1e-6, "h_ucp exceeds the remaining cost at step " + std::to_string(i));
+            expect(ho <= remaining + 1e-6, "h_ocp exceeds the remaining cost at step " + std::to_string(i));
+            expect(ho >= hu - 1e-6, "h_ocp below h_ucp at step " + std::to_string(i));
+            if (i == R.plan.size()) {
+                expect(hu == 0.0 && ho == 0.0, "h is not 0 at the goal");
+                break;
+            }
+            const auto& op = T.ops[R.plan[i]];
+            planner::sas::Undo undo;
+            planner::sas::apply_inplace(T, op, s, undo);
+            remaining -= op.cost;
+        }
+
+        // 許容的なので A* は最適なコストのプランを返す
+        const auto Ru = planner::sas::astar(T, planner::sas::hlm_ucp(T), true, P);
+        const auto Ro = planner::sas::astar(T, planner::sas::hlm_ocp(T), true, P);
+        expect(Ru.solved && near(Ru.plan_cost, R.plan_cost), "A* with h_ucp is not optimal");
+        expect(Ro.solved && near(Ro.plan_cost, R.plan_cost), "A* with h_ocp is not optimal");
+        std::cout << "expanded: blind " << R.stats.expanded << ", ucp " << Ru.stats.expanded
+                  << ", ocp " << Ro.stats.expanded << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
@@ -0,0 +1,184 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <sas/sas_reader.hpp>
+#include <sas/sas_search.hpp>
+#include <sas/sas_heuristic.hpp>
+#include <sas/search_utils.hpp>
+#include <sas/multi_goal.hpp>
+
+using planner::sas::Task;
+using planner::sas::State;
+using planner::sas::GoalCondition;
+using planner::sas::read_file;
+
+namespace fs = std::filesystem;
+
+static void die_usage(const char* argv0) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << argv0 << " <path/to/output.sas>\n\n"
+        << "Picks several goal conditions reachable from the initial state and checks that one multi-goal search\n"
+        << "finds, for every goal, a valid plan as cheap as a separate A* (with h = 0 and with lm_ucp), that a cost\n"
+        << "bound cuts off exactly the goals at or above it, and that read_goals_file parses names and numbers.\n"
+        << "Returns non-zero on failure.\n";
+    std::exit(2);
+}
+
+// --- helpers ---
+
+static void expect(bool cond, const std::string& what) {
+    if (!cond) {
+        throw std::runtime_error(what);
+    }
+}
+
+static bool satisfies(const GoalCondition& g, const State& s) {
+    for (const auto& [v, val] : g) {
+        if (s[v] != val) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// プランを初期状態から順に適用し、全ての演算子が適用可能で、最後にゴール条件 g を満たすことを確かめる関数
+static void check_plan(const Task& T, const GoalCondition& g, const std::vector<uint32_t>& plan, const std::string& name) {
+    State s = T.init;
+    planner::sas::Undo undo;
+    for (std::size_t i = 0; i < plan.size(); ++i) {
+        expect(plan[i] < T.ops.size(), name + ": operator out of range at step " + std::to_string(i));
+        expect(planner::sas::is_applicable(T, s, T.ops[plan[i]]), name + ": not applicable at step " + std::to_string(i));
+        planner::sas::apply_inplace(T, T.ops[plan[i]], s, undo);
+        undo.clear();
+    }
+    expect(satisfies(g, s), name + ": plan does not reach the goal condition");
+}
+
+// 初期状態からのランダムウォークで到達した状態の fact から、到達可能なゴール条件を作る関数
+static std::vector<GoalCondition> reachable_goals(const Task& T, std::mt19937_64& rng) {
+    std::vector<GoalCondition> goals{T.goal};
+    planner::sas::Undo undo;
+    for (int walk = 0; walk < 5; ++walk) {
+        State s = T.init;
+        const int len = 4 + 6 * walk;
+        for (int step = 0; step < len; ++step) {
+            std::vector<std::size_t> app;
+            for (std::size_t a = 0; a < T.ops.size(); ++a) {
+                if (planner::sas::is_applicable(T, s, T.ops[a])) {
+                    app.push_back(a);
+                }
+            }
+            if (app.empty()) {
+                break;
+            }
+            planner::sas::apply_inplace(T, T.ops[app[rng() % app.size()]], s, undo);
+            undo.clear();
+        }
+        // 1 つの fact と 2 つの fact の条件 (初期状態で既に満たす条件も含みうる)
+        const int v1 = static_cast<int>(rng() % T.vars.size());
+        const int v2 = static_cast<int>(rng() % T.vars.size());
+        goals.push_back(GoalCondition{{v1, s[v1]}});
+        if (v2 != v1) {
+            goals.push_back(GoalCondition{{v1, s[v1]}, {v2, s[v2]}});
+        }
+    }
+    return goals;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+
+    try {
+        const Task T = read_file(argv[1]);
+        planner::sas::Params P;
+        P.verbose = false;
+
+        std::mt19937_64 rng(110u);
+        const std::vector<GoalCondition> goals = reachable_goals(T, rng);
+
+        // 基準: ゴールごとに別々に解く A*
+        std::vector<double> ref(goals.size());
+        for (std::size_t i = 0; i < goals.size(); ++i) {
+            Task Ti = T;
+            Ti.goal = goals[i];
+            const auto R = planner::sas::astar(Ti, planner::sas::blind(), true, P);
+            expect(R.solved, "reference A* did not solve goal " + std::to_string(i));
+            ref[i] = R.plan_cost;
+        }
+
+        const planner::sas::HeuristicFactory none;
+        const planner::sas::HeuristicFactory ucp = [](const Task& G) { return planner::sas::hlm_ucp(G); };
+        for (const auto& [name, make_h] : {std::pair<std::string, planner::sas::HeuristicFactory>{"h=0", none}, {"lm_ucp", ucp}}) {
+            const auto M = planner::sas::multi_goal_search(T, goals, make_h, P);
+            expect(M.stop == planner::sas::StopReason::None, name + ": search was interrupted");
+            expect(M.goals.size() == goals.size(), name + ": wrong number of results");
+            expect(M.num_solved() == goals.size(), name + ": solved " + std::to_string(M.num_solved()) + " of " +
+                                                    std::to_string(goals.size()) + " goals");
+            for (std::size_t i = 0; i < goals.size(); ++i) {
+                const auto& gp = M.goals[i];
+                const std::string what = name + ", goal " + std::to_string(i);
+                check_plan(T, goals[i], gp.plan, what);
+                expect(gp.plan_cost == planner::sas::eval_plan_cost(T, gp.plan), what + ": wrong plan cost");
+                expect(gp.plan_cost == ref[i], what + ": cost " + std::to_string(gp.plan_cost) + ", separate A* " +
+                                               std::to_string(ref[i]));
+                // h = 0 では、安いゴールほど先に (少ない展開数で) 見つかる
+                if (!make_h) {
+                    for (std::size_t j = 0; j < goals.size(); ++j) {
+                        expect(!(ref[j] < ref[i]) || M.goals[j].expanded_at <= gp.expanded_at,
+                               what + ": found before the cheaper goal " + std::to_string(j));
+                    }
+                }
+            }
+            std::cout << name << ": " << goals.size() << " goals, expanded " << M.stats.expanded << "\n";
+        }
+
+        // 上界以上のゴールだけが未到達となり、上界未満にプランがないことが示される
+        double bound = 0.0;
+        for (double c : ref) {
+            bound = std::max(bound, c);
+        }
+        if (bound > 0.0) {
+            planner::sas::Params Pb = P;
+            Pb.cost_bound = bound;
+            const auto M = planner::sas::multi_goal_search(T, goals, none, Pb);
+            for (std::size_t i = 0; i < goals.size(); ++i) {
+                expect(M.goals[i].solved == (ref[i] < bound), "bound " + std::to_string(bound) + ": goal " +
+                                                              std::to_string(i) + " has the wrong solved flag");
+                expect(!M.goals[i].solved || M.goals[i].plan_cost == ref[i], "bound: wrong cost for goal " + std::to_string(i));
+            }
+            expect(M.bound_exhausted, "bound: bound_exhausted is not set");
+        }
+
+        // ゴール条件のファイル: 変数の名前と番号、空行とコメント
+        const fs::path path = fs::temp_directory_path() / ("multi_goal_test_" + std::to_string(rng()) + ".txt");
+        {
+            std::ofstream ofs(path);
+            ofs << "# goals\n\n";
+            for (const auto& g : goals) {
+                for (std::size_t k = 0; k < g.size(); ++k) {
+                    const auto [v, val] = g[k];
+                    ofs << (k ? " " : "") << ((k % 2 == 0) ? T.vars[v].name : std::to_string(v)) << "=" << val;
+                }
+                ofs << "  # trailing comment\n";
+            }
+        }
+        const auto parsed = planner::sas::read_goals_file(T, path.string());
+        fs::remove(path);
+        expect(parsed == goals, "read_goals_file returned different goal conditions");
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
@@ -0,0 +1,187 @@
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <sas/sas_reader.hpp>
+#include <sas/sas_search.hpp>
+#include <sas/sas_heuristic.hpp>
+#include <sas/search_utils.hpp>
+#include <sas/lp_solver.hpp>
+
+using planner::sas::Task;
+using planner::sas::State;
+using planner::sas::read_file;
+using planner::sas::LinearProgram;
+using planner::sas::LPStatus;
+using planner::sas::SparseMatrix;
+using planner::sas::MinCostLP;
+using planner::sas::DualSimplex;
+
+static void die_usage(const char* argv0) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << argv0 << " <path/to/output.sas>\n\n"
+        << "Checks the dual simplex against the primal simplex on random LPs (cold and warm-started), and checks\n"
+        << "that the operator-counting heuristics never exceed the remaining cost along an optimal plan.\n"
+        << "Returns non-zero on failure.\n";
+    std::exit(2);
+}
+
+// --- helpers ---
+
+static void expect(bool cond, const std::string& what) {
+    if (!cond) {
+        throw std::runtime_error(what);
+    }
+}
+
+static bool near(double a, double b) {
+    return std::fabs(a - b) < 1e-6 * std::max(1.0, std::fabs(b));
+}
+
+// min c^T y s.t. A y >= b, y >= 0 を、その双対 max b^T pi s.t. A^T pi <= c, pi >= 0 として solve_lp で解く関数
+static double reference_min(const std::vector<std::vector<std::pair<int, double>>>& rows, int n,
+                            const std::vector<double>& c, const std::vector<double>& b, LPStatus& status) {
+    LinearProgram lp;
+    lp.num_cols = static_cast<int>(rows.size());
+    lp.obj = b;
+    std::vector<std::vector<std::pair<int, double>>> cols(n);
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        for (auto [j, a] : rows[i]) {
+            cols[j].emplace_back(static_cast<int>(i), a);
+        }
+    }
+    for (int j = 0; j < n; ++j) {
+        lp.add_row(cols[j], c[j]);
+    }
+    const auto sol = planner::sas::solve_lp(lp);
+    status = sol.status;
+    return sol.objective;
+}
+
+// ランダムな疎な LP で、双対単体法の値を (双対問題を解いた) 単体法の値と比べる関数
+static void check_dual_simplex() {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> coef(-2, 3);
+    int solved = 0, infeasible = 0;
+    for (int t = 0; t < 200; ++t) {
+        const int m = 1 + static_cast<int>(rng() % 8);
+        const int n = 1 + static_cast<int>(rng() % 10);
+        std::vector<std::vector<std::pair<int, double>>> rows(m);
+        for (int i = 0; i < m; ++i) {
+            for (int j = 0; j < n; ++j) {
+                const int a = coef(rng);
+                if (a != 0 && rng() % 2 == 0) {
+                    rows[i].emplace_back(j, static_cast<double>(a));
+                }
+            }
+        }
+        std::vector<double> c(n);
+        for (double& x : c) {
+            x = static_cast<double>(rng() % 5);
+        }
+        auto lp = std::make_shared<const MinCostLP>(SparseMatrix::from_rows(n, rows), c);
+        DualSimplex warm(lp);
+
+        // 同じ行列で右辺だけを変えて解き直す (warm は基底を引き継ぎ、cold は毎回スラック変数の基底から)
+        for (int k = 0; k < 5; ++k) {
+            std::vector<double> b(m);
+            for (double& x : b) {
+                x = static_cast<double>(static_cast<int>(rng() % 5) - 1);
+            }
+            DualSimplex cold(lp);
+            const auto sc = cold.solve(b);
+            const auto sw = warm.solve(b);
+            expect(sc.status == sw.status, "warm and cold status differ in LP " + std::to_string(t));
+
+            LPStatus ref_status;
+            const double ref = reference_min(rows, n, c, b, ref_status);
+            if (ref_status == LPStatus::Unbounded) { // 双対が非有界なら主問題は実行不可能
+                expect(sc.status == LPStatus::Infeasible, "infeasible LP not detected in LP " + std::to_string(t));
+                ++infeasible;
+                continue;
+            }
+            expect(ref_status == LPStatus::Optimal && sc.status == LPStatus::Optimal, "LP " + std::to_string(t) + " not optimal");
+            expect(near(sc.objective, ref), "cold objective differs in LP " + std::to_string(t));
+            expect(near(sw.objective, ref), "warm objective differs in LP " + std::to_string(t));
+
+            // 解が実行可能であること
+            for (int i = 0; i < m; ++i) {
+                double lhs = 0.0;
+                for (auto [j, a] : rows[i]) {
+                    lhs += a * sw.x[j];
+                }
+                expect(lhs >= b[i] - 1e-6, "warm solution violates row " + std::to_string(i));
+            }
+            for (double x : sw.x) {
+                expect(x >= -1e-9, "negative variable");
+            }
+            ++solved;
+        }
+    }
+    expect(solved > 0 && infeasible > 0, "random LPs did not cover both outcomes");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+
+    try {
+        check_dual_simplex();
+
+        const Task T = read_file(argv[1]);
+        planner::sas::Params P;
+        P.verbose = false;
+        const auto R = planner::sas::astar(T, planner::sas::blind(), true, P);
+        expect(R.solved, "A* did not find a plan");
+
+        auto seq = planner::sas::hseq(T);
+        auto pho = planner::sas::hpho(T);
+        auto oc = planner::sas::hoc(T);
+        auto ocp = planner::sas::hlm_ocp(T);
+
+        // 最適なプランに沿った各状態で、h が残りのコスト以下であること (許容性) を確かめる
+        // oc は他の制約を全て含むので、それぞれの値以上になる
+        State s = T.init;
+        double remaining = R.plan_cost;
+        for (std::size_t i = 0; i <= R.plan.size(); ++i) {
+            const double hs = seq(T, s);
+            const double hp = pho(T, s);
+            const double ho = oc(T, s);
+            const double hl = ocp(T, s);
+            if (i == 0) {
+                std::cout << "h_seq(init) " << hs << ", h_pho(init) " << hp << ", h_oc(init) " << ho
+                          << ", h_lm_ocp(init) " << hl << ", optimal cost " << R.plan_cost << "\n";
+            }
+            for (auto [name, h] : {std::pair<const char*, double>{"h_seq", hs}, {"h_pho", hp}, {"h_oc", ho}}) {
+                expect(h <= remaining + 1e-6, std::string(name) + " exceeds the remaining cost at step " + std::to_string(i));
+            }
+            expect(ho >= std::max({hs, hp, hl}) - 1e-6, "h_oc below one of its components at step " + std::to_string(i));
+            if (i == R.plan.size()) {
+                expect(hs == 0.0 && hp == 0.0 && ho == 0.0, "h is not 0 at the goal");
+                break;
+            }
+            const auto& op = T.ops[R.plan[i]];
+            planner::sas::Undo undo;
+            planner::sas::apply_inplace(T, op, s, undo);
+            remaining -= op.cost;
+        }
+
+        // 許容的なので A* は最適なコストのプランを返す
+        const auto Ro = planner::sas::astar(T, planner::sas::hoc(T), true, P);
+        expect(Ro.solved && near(Ro.plan_cost, R.plan_cost), "A* with h_oc is not optimal");
+        std::cout << "expanded: blind " << R.stats.expanded << ", oc " << Ro.stats.expanded << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
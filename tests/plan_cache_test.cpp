@@ -0,0 +1,136 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+#include <filesystem>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <sas/sas_reader.hpp>
+#include <sas/sas_search.hpp>
+#include <sas/sas_heuristic.hpp>
+#include <sas/plan_cache.hpp>
+
+using planner::sas::Task;
+using planner::sas::read_file;
+using planner::sas::PlanCache;
+using planner::sas::CachedPlan;
+
+namespace fs = std::filesystem;
+
+static void die_usage(const char* argv0) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << argv0 << " <path/to/output.sas>\n\n"
+        << "Stores a plan found by A* in a temporary plan cache and checks lookups, rejection of\n"
+        << "invalid plans, LRU eviction, and concurrent use from several processes. Returns non-zero on failure.\n";
+    std::exit(2);
+}
+
+// --- helpers ---
+
+static void expect(bool cond, const std::string& what) {
+    if (!cond) {
+        throw std::runtime_error(what);
+    }
+}
+
+// 複数のプロセスから同時に保存と参照を行い、返ってくるプランが常に保存したものと一致するか確認する関数
+static void check_concurrent(const Task& T, const std::string& dir, const CachedPlan& p) {
+    const int procs = 4, per_proc = 25;
+    std::vector<pid_t> kids;
+    for (int r = 0; r < procs; ++r) {
+        const pid_t pid = ::fork();
+        expect(pid >= 0, "fork failed");
+        if (pid == 0) {
+            int code = 0;
+            try {
+                PlanCache cache(dir, 10);
+                for (int i = 0; i < per_proc; ++i) {
+                    const std::string cfg = "proc" + std::to_string(r) + "/" + std::to_string(i % 12);
+                    cache.store(T, cfg, p);
+                    const auto hit = cache.lookup(T, "proc" + std::to_string((r + 1) % procs) + "/" + std::to_string(i % 12));
+                    if (hit && (hit->plan != p.plan || hit->cost != p.cost)) {
+                        code = 1;
+                    }
+                }
+            } catch (...) {
+                code = 1;
+            }
+            ::_exit(code);
+        }
+        kids.push_back(pid);
+    }
+    for (pid_t pid : kids) {
+        int st = 0;
+        ::waitpid(pid, &st, 0);
+        expect(WIFEXITED(st) && WEXITSTATUS(st) == 0, "a concurrent cache user failed");
+    }
+    expect(PlanCache(dir, 10).size() <= 10, "concurrent stores exceed the entry limit");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+
+    std::string tmpl = (fs::temp_directory_path() / "plan_cache_test_XXXXXX").string();
+    if (::mkdtemp(tmpl.data()) == nullptr) {
+        std::cerr << "FAILED: cannot create a temporary directory\n";
+        return 1;
+    }
+    const std::string dir = tmpl;
+
+    int rc = 0;
+    try {
+        const Task T = read_file(argv[1]);
+        planner::sas::Params P;
+        P.verbose = false;
+        const auto R = planner::sas::astar(T, planner::sas::blind(), true, P);
+        expect(R.solved, "A* did not find a plan");
+        const CachedPlan p{R.plan, R.plan_cost, true};
+
+        {
+            PlanCache cache(dir, 3);
+            expect(!cache.lookup(T, "a"), "hit in an empty cache");
+            cache.store(T, "a", p);
+            const auto hit = cache.lookup(T, "a");
+            expect(hit && hit->plan == p.plan && hit->cost == p.cost && hit->optimal, "stored plan not returned");
+            expect(!cache.lookup(T, "b"), "hit for another configuration");
+
+            // ゴールに達しないプランは検証で外れ、項目も消える
+            if (!p.plan.empty()) {
+                CachedPlan bad = p;
+                bad.plan.pop_back();
+                bad.cost = planner::sas::eval_plan_cost(T, bad.plan);
+                cache.store(T, "bad", bad);
+                expect(!cache.lookup(T, "bad"), "invalid plan returned");
+                expect(cache.size() == 1, "invalid entry not removed");
+            }
+
+            // 上限 3 で 4 つ目を保存すると、最後に使われた時刻が最も古い項目が消える
+            cache.store(T, "b", p);
+            cache.store(T, "c", p);
+            expect(cache.lookup(T, "a").has_value(), "entry lost before the limit");
+            cache.store(T, "d", p);
+            expect(cache.size() == 3, "entry limit not kept");
+            expect(!cache.lookup(T, "b"), "least recently used entry not evicted");
+            expect(cache.lookup(T, "a") && cache.lookup(T, "c") && cache.lookup(T, "d"), "recent entries evicted");
+        }
+
+        check_concurrent(T, dir, p);
+        std::cout << "plan cost " << p.cost << ", length " << p.plan.size() << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << "\n";
+        rc = 1;
+    }
+
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+    if (rc == 0) {
+        std::cout << "OK\n";
+    }
+    return rc;
+}
@@ -0,0 +1,128 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <sas/planner_session.hpp>
+
+using planner::sas::PlannerSession;
+using planner::sas::SolveOptions;
+using planner::sas::SolveResult;
+using planner::sas::SolveStatus;
+using planner::sas::Progress;
+
+static void die_usage(const char* argv0) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << argv0 << " <path/to/output.sas>\n\n"
+        << "Solves the given task through PlannerSession and checks cancellation,\n"
+        << "progress callbacks, deadlines, the expansion limit under a cost bound and the status of an exhausted\n"
+        << "bound (a proof only with an admissible heuristic). Returns non-zero on failure.\n";
+    std::exit(2);
+}
+
+// --- helpers ---
+
+static void expect(bool cond, const std::string& what) {
+    if (!cond) {
+        throw std::runtime_error(what);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+
+    try {
+        auto session = PlannerSession::from_sas_file(argv[1]);
+        session->prepare_heuristic("blind");
+
+        // 通常の探索で解けること
+        SolveOptions opt;
+        opt.heuristic = "blind";
+        const SolveResult solved = session->solve(opt);
+        expect(solved.status == SolveStatus::Solved, std::string("astar: expected solved, got ") + to_string(solved.status));
+        expect(solved.plan_cost == planner::sas::eval_plan_cost(session->task(), solved.plan), "astar: plan cost mismatch");
+        std::cout << "solved: cost " << solved.plan_cost << ", expanded " << solved.stats.expanded << "\n";
+
+        // 事前に中断を要求しておくと、何も展開せずに打ち切られること
+        SolveOptions pre = opt;
+        pre.cancel = planner::sas::CancelToken{}; // コピーしたトークンはフラグを共有するので作り直す
+        pre.cancel.cancel();
+        const SolveResult cancelled = session->solve(pre);
+        expect(cancelled.status == SolveStatus::Cancelled, std::string("pre-cancelled: got ") + to_string(cancelled.status));
+
+        // 進捗の通知から中断できること (展開数が通知間隔に届かないほど小さいタスクでは解けてもよい)
+        SolveOptions cb = opt;
+        cb.cancel = planner::sas::CancelToken{}; // コピーしたトークンはフラグを共有するので作り直す
+        cb.progress_interval = 1;
+        uint64_t calls = 0;
+        cb.on_progress = [&](const Progress& pr) {
+            ++calls;
+            if (pr.stats.expanded >= 2) {
+                cb.cancel.cancel();
+            }
+        };
+        const SolveResult by_cb = session->solve(cb);
+        expect(calls > 0, "progress callback was never called");
+        expect(by_cb.status == SolveStatus::Cancelled || (by_cb.status == SolveStatus::Solved && by_cb.stats.expanded <= 3),
+               std::string("progress cancel: got ") + to_string(by_cb.status));
+
+        // 期限 0 ms では打ち切られるか、最初の確認までに解けていること
+        SolveOptions dl = opt;
+        dl.cancel = planner::sas::CancelToken{}; // コピーしたトークンはフラグを共有するので作り直す
+        dl.time_limit_ms = 0;
+        const SolveResult by_deadline = session->solve(dl);
+        expect(by_deadline.status == SolveStatus::Timeout || by_deadline.status == SolveStatus::Solved,
+               std::string("deadline: got ") + to_string(by_deadline.status));
+
+        // 展開数の上限で打ち切った場合は、上界があっても上界未満に解がないとは報告しないこと
+        for (const char* algo : {"astar", "gbfs"}) {
+            for (const char* hname : {"blind", "ff"}) {
+                for (const bool dense : {true, false}) {
+                    SolveOptions lim = opt;
+                    lim.cancel = planner::sas::CancelToken{};
+                    lim.algo = algo;
+                    lim.heuristic = hname;
+                    lim.cost_bound = 1000.0;
+                    lim.params.max_expansions = 0;
+                    if (!dense) {
+                        lim.params.dense_max_states = 0;
+                    }
+                    const std::string name = std::string(algo) + "/" + hname + (dense ? "/dense" : "/hash");
+                    const SolveResult by_limit = session->solve(lim);
+                    expect(by_limit.status == SolveStatus::ExpansionLimit ||
+                           (by_limit.status == SolveStatus::Solved && solved.plan.empty()),
+                           name + " with max_expansions = 0: got " + to_string(by_limit.status));
+                }
+            }
+        }
+
+        // 上界が最適コストの場合、許容的なヒューリスティックでは証明になり、そうでなければ見つからなかったとだけ報告すること
+        if (solved.plan_cost > 0.0) {
+            for (const char* hname : {"blind", "ff"}) {
+                SolveOptions at_opt = opt;
+                at_opt.cancel = planner::sas::CancelToken{};
+                at_opt.heuristic = hname;
+                at_opt.cost_bound = solved.plan_cost;
+                const SolveResult by_bound = session->solve(at_opt);
+                const SolveStatus want = planner::sas::heuristic_is_admissible(hname) ? SolveStatus::BoundExhausted
+                                                                                       : SolveStatus::NotFound;
+                expect(by_bound.status == want, std::string("bound = optimum with ") + hname + ": expected " + to_string(want) +
+                                                ", got " + to_string(by_bound.status));
+            }
+        }
+
+        // 同じセッションで再び解けること
+        const SolveResult again = session->solve(opt);
+        expect(again.status == SolveStatus::Solved && again.plan_cost == solved.plan_cost, "second solve differs from the first");
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
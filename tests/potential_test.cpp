@@ -0,0 +1,138 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <sas/sas_reader.hpp>
+#include <sas/sas_search.hpp>
+#include <sas/sas_heuristic.hpp>
+#include <sas/search_utils.hpp>
+
+using planner::sas::Task;
+using planner::sas::State;
+using planner::sas::read_file;
+
+static void die_usage(const char* argv0) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << argv0 << " <path/to/output.sas>\n\n"
+        << "Checks that the potential heuristics (optimized for the initial state and for sampled states) are\n"
+        << "consistent on every transition from random-walk states, are 0 at the goal, and that the\n"
+        << "initial-state potentials reach the state-equation bound at the initial state.\n"
+        << "Returns non-zero on failure.\n";
+    std::exit(2);
+}
+
+// --- helpers ---
+
+static void expect(bool cond, const std::string& what) {
+    if (!cond) {
+        throw std::runtime_error(what);
+    }
+}
+
+// 初期状態からのランダムウォークで状態を集める関数
+static std::vector<State> sample_states(const Task& T, std::size_t n) {
+    std::mt19937 rng(99);
+    std::vector<State> out;
+    State s = T.init;
+    planner::sas::Undo undo;
+    while (out.size() < n) {
+        out.push_back(s);
+        std::vector<int> app;
+        for (int a = 0; a < (int)T.ops.size(); ++a) {
+            if (planner::sas::is_applicable(T, s, T.ops[a])) {
+                app.push_back(a);
+            }
+        }
+        if (app.empty() || rng() % 32 == 0) {
+            s = T.init;
+            continue;
+        }
+        planner::sas::apply_inplace(T, T.ops[app[rng() % app.size()]], s, undo);
+        undo.clear();
+    }
+    return out;
+}
+
+// 全ての遷移 s -> s' で h(s) <= cost + h(s') であることを確かめる関数
+static void check_consistent(const Task& T, const planner::sas::HeuristicFn& h, const std::vector<State>& states,
+                             const std::string& name) {
+    planner::sas::Undo undo;
+    for (std::size_t i = 0; i < states.size(); ++i) {
+        State s = states[i];
+        const double hs = h(T, s);
+        for (const auto& op : T.ops) {
+            if (!planner::sas::is_applicable(T, s, op)) {
+                continue;
+            }
+            planner::sas::apply_inplace(T, op, s, undo);
+            const double ht = h(T, s);
+            planner::sas::undo_to(s, undo, 0);
+            expect(hs <= op.cost + ht + 1e-6, name + " is inconsistent at state " + std::to_string(i) + " with " + op.name);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+
+    try {
+        const Task T = read_file(argv[1]);
+        const auto states = sample_states(T, 300);
+
+        const planner::sas::PotentialFunction pot_init(T, planner::sas::PotentialOptions{});
+        planner::sas::PotentialOptions so;
+        so.objective = planner::sas::PotentialObjective::Samples;
+        so.num_samples = 200;
+        const planner::sas::PotentialFunction pot_samples(T, so);
+        auto h_init = [&pot_init](const Task&, const State& s) { return pot_init(s); };
+        auto h_samples = [&pot_samples](const Task&, const State& s) { return pot_samples(s); };
+
+        check_consistent(T, h_init, states, "pot");
+        check_consistent(T, h_samples, states, "pot_samples");
+
+        // 初期状態に対して最適化した値は、状態方程式の LP の値と一致する
+        const double seq0 = planner::sas::hseq(T)(T, T.init);
+        expect(pot_init(T.init) == seq0, "pot(init) " + std::to_string(pot_init(T.init)) +
+                                         " differs from seq(init) " + std::to_string(seq0));
+        double sum_init = 0.0, sum_samples = 0.0;
+        for (const State& s : states) {
+            sum_init += pot_init(s);
+            sum_samples += pot_samples(s);
+        }
+        std::cout << "pot(init) " << pot_init(T.init) << ", pot_samples(init) " << pot_samples(T.init)
+                  << ", relevant vars " << pot_init.num_relevant_vars() << "/" << T.vars.size()
+                  << ", mean over samples " << sum_init / static_cast<double>(states.size()) << " / "
+                  << sum_samples / static_cast<double>(states.size()) << "\n";
+
+        // 整合的かつゴールで 0 なので許容的であり、A* は最適なコストのプランを返す
+        planner::sas::Params P;
+        P.verbose = false;
+        const auto R = planner::sas::astar(T, planner::sas::blind(), true, P);
+        const auto Rp = planner::sas::astar(T, planner::sas::hpot_init(T), true, P);
+        const auto Rs = planner::sas::astar(T, planner::sas::hpot_samples(T), true, P);
+        expect(R.solved && Rp.solved && Rs.solved, "A* did not find a plan");
+        expect(Rp.plan_cost == R.plan_cost, "A* with pot is not optimal");
+        expect(Rs.plan_cost == R.plan_cost, "A* with pot_samples is not optimal");
+        State g = T.init;
+        planner::sas::Undo undo;
+        for (int a : Rp.plan) {
+            planner::sas::apply_inplace(T, T.ops[a], g, undo);
+        }
+        expect(pot_init(g) == 0.0 && pot_samples(g) == 0.0, "h is not 0 at the goal");
+        std::cout << "expanded: blind " << R.stats.expanded << ", pot " << Rp.stats.expanded
+                  << ", pot_samples " << Rs.stats.expanded << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
@@ -187,6 +187,27 @@ static void spot_check_operators_do_not_introduce_mutex(const Task& T) {
     }
 }
 
+// 演算子を作業スレッドで解析しても、呼び出し元のみで解析した場合と同じタスクになるか確認する
+static void check_parallel_parse_matches(const std::string& sas_path, const Task& T) {
+    const Task S = read_file(sas_path, 0);
+    for (int threads : {1, 3}) {
+        const Task P = read_file(sas_path, threads);
+        if (P.ops.size() != S.ops.size() || P.ops.size() != T.ops.size()) {
+            throw std::runtime_error("parallel parse: operator count differs");
+        }
+        for (size_t oi = 0; oi < S.ops.size(); ++oi) {
+            const auto& a = S.ops[oi];
+            const auto& b = P.ops[oi];
+            if (a.name != b.name || a.prevail != b.prevail || a.pre_posts != b.pre_posts || a.cost != b.cost) {
+                throw std::runtime_error("parallel parse: operator " + std::to_string(oi) + " differs");
+            }
+        }
+        if (P.init != S.init || P.goal != S.goal || P.vars.size() != S.vars.size() || P.mutexes.size() != S.mutexes.size()) {
+            throw std::runtime_error("parallel parse: task header differs");
+        }
+    }
+}
+
 // --- main ---
 
 int main(int argc, char** argv) {
@@ -204,6 +225,7 @@ int main(int argc, char** argv) {
         check_bounds(T);
         check_mutex_invariants_on_init(T);
         spot_check_operators_do_not_introduce_mutex(T);
+        check_parallel_parse_matches(sas_path, T);
 
         std::cout << "[OK] All checks passed.\n";
         return 0;
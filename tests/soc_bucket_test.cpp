@@ -0,0 +1,140 @@
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <sas/sas_reader.hpp>
+#include <sas/sas_search.hpp>
+#include <sas/sas_heuristic.hpp>
+#include <sas/search_utils.hpp>
+#include <sas/parallel_SOC/params.hpp>
+#include <sas/parallel_SOC/parallel_search.hpp>
+
+using planner::sas::Task;
+using planner::sas::State;
+using planner::sas::read_file;
+namespace soc = planner::sas::parallel_SOC;
+
+static void die_usage(const char* argv0) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << argv0 << " <path/to/output.sas>\n\n"
+        << "Runs soc_astar with several weights, bucket widths and tie-breaks (blind and pot). With one thread and\n"
+        << "one shard the open list is exact, so the plan cost must stay below the bucket of W * C* (C* from A*)\n"
+        << "and equal C* when W = D = 1; cost bounds at C* and C* + 1 are checked too. With several threads and\n"
+        << "shards (default tie-break only), plans must be valid and the reported lower bound must not exceed C*.\n"
+        << "Returns non-zero on failure.\n";
+    std::exit(2);
+}
+
+// --- helpers ---
+
+static void expect(bool cond, const std::string& what) {
+    if (!cond) {
+        throw std::runtime_error(what);
+    }
+}
+
+// プランを初期状態から順に適用し、全ての演算子が適用可能で、最後にゴールを満たすことを確かめる関数
+static void check_plan(const Task& T, const std::vector<uint32_t>& plan, const std::string& name) {
+    State s = T.init;
+    planner::sas::Undo undo;
+    for (std::size_t i = 0; i < plan.size(); ++i) {
+        expect(plan[i] < T.ops.size(), name + ": operator out of range at step " + std::to_string(i));
+        expect(planner::sas::is_applicable(T, s, T.ops[plan[i]]), name + ": not applicable at step " + std::to_string(i));
+        planner::sas::apply_inplace(T, T.ops[plan[i]], s, undo);
+        undo.clear();
+    }
+    expect(planner::sas::is_goal(T, s), name + ": plan does not reach the goal");
+}
+
+static std::string describe(const soc::Params& P) {
+    const char* tb = (P.tie_break == soc::TieBreak::HThenG) ? "h" : (P.tie_break == soc::TieBreak::GThenH) ? "g" : "fifo";
+    return std::string(P.heuristic_kind == 0 ? "blind" : "pot") + " threads=" + std::to_string(P.num_threads) +
+           " W=" + std::to_string(P.weight) + " D=" + std::to_string(P.bucket_delta) + " tie=" + tb;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+
+    try {
+        const Task T = read_file(argv[1]);
+        planner::sas::Params P;
+        P.verbose = false;
+        const auto ref = planner::sas::astar(T, planner::sas::blind(), true, P);
+        expect(ref.solved, "reference A* did not solve the task");
+        const double opt = ref.plan_cost;
+
+        for (const uint32_t h : {0u, 5u}) {
+            for (const float w : {1.0f, 1.5f, 2.0f}) {
+                for (const float d : {1.0f, 3.0f}) {
+                    for (const auto tb : {soc::TieBreak::HThenG, soc::TieBreak::GThenH, soc::TieBreak::FIFO}) {
+                        for (const uint32_t threads : {1u, 4u}) {
+                            // 複数スレッドでは、既定のタイブレークのみを試す
+                            if (threads > 1 && tb != soc::TieBreak::HThenG) {
+                                continue;
+                            }
+                            soc::Params S;
+                            S.heuristic_kind = h;
+                            S.weight = w;
+                            S.bucket_delta = d;
+                            S.tie_break = tb;
+                            S.num_threads = threads;
+                            // 1 スレッドでは 1 つのシャードから 1 つずつ取り出すので、オープンリストは厳密な優先度順になる
+                            const bool exact = (threads == 1);
+                            if (exact) {
+                                S.bucket_shards = 1;
+                                S.bucket_select_k = 1;
+                            }
+                            const std::string name = describe(S);
+
+                            const auto R = soc::astar_soc(T, S);
+                            expect(R.solved, name + ": no plan found");
+                            check_plan(T, R.plan_ops, name);
+                            expect(R.cost == planner::sas::eval_plan_cost(T, R.plan_ops), name + ": wrong plan cost");
+                            expect(R.cost >= opt, name + ": cost " + std::to_string(R.cost) + " is below the optimum " +
+                                                  std::to_string(opt));
+                            expect(R.lower_bound <= opt, name + ": lower bound " + std::to_string(R.lower_bound) +
+                                                         " exceeds the optimum " + std::to_string(opt));
+
+                            if (exact) {
+                                // 最適なプラン上のノードの g + W·h は W·C* 以下なので、ゴールはそのバケット以前に展開される
+                                const double last = (std::floor(w * opt / d + 1e-9) + 1.0) * d;
+                                expect(R.cost < last, name + ": cost " + std::to_string(R.cost) + " is not below " +
+                                                      std::to_string(last));
+                                if (w == 1.0f && d == 1.0f) {
+                                    expect(R.cost == opt, name + ": plain A* is not optimal");
+                                }
+                            }
+                            std::cout << name << ": cost " << R.cost << ", lower bound " << R.lower_bound << "\n";
+                        }
+                    }
+                }
+            }
+        }
+
+        // 上界: 最適コストでは解がないことを示し、それより 1 大きければ最適解を返す
+        if (opt > 0.0) {
+            soc::Params S;
+            S.heuristic_kind = 5;
+            S.bucket_shards = 1;
+            S.bucket_select_k = 1;
+            S.cost_bound = opt;
+            const auto B0 = soc::astar_soc(T, S);
+            expect(!B0.solved && B0.bound_exhausted, "bound = optimum did not prove that no plan exists");
+            S.cost_bound = opt + 1.0;
+            const auto B1 = soc::astar_soc(T, S);
+            expect(B1.solved && B1.cost == opt, "bound = optimum + 1 did not return an optimal plan");
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
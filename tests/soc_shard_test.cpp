@@ -0,0 +1,215 @@
+#include <algorithm>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <sas/sas_reader.hpp>
+#include <sas/sas_search.hpp>
+#include <sas/sas_heuristic.hpp>
+#include <sas/search_utils.hpp>
+#include <sas/parallel_SOC/params.hpp>
+#include <sas/parallel_SOC/parallel_search.hpp>
+#include <sas/parallel_SOC/shard_hasher.hpp>
+
+using planner::sas::Task;
+using planner::sas::State;
+using planner::sas::read_file;
+namespace soc = planner::sas::parallel_SOC;
+
+static void die_usage(const char* argv0) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << argv0 << " <path/to/output.sas>\n\n"
+        << "Checks ShardHasher (the abstraction variables reach num_shards * balance abstract states, grow as a\n"
+        << "prefix with the balance, and a successor by an operator that changes none of them keeps its parent's\n"
+        << "hash) on random walks, then runs soc_astar with --soc-shard abstraction. With one thread and one shard\n"
+        << "it must expand exactly as many nodes as node-ID sharding (the closed list is striped by the abstract\n"
+        << "hash instead); with several shards and threads, over both open lists, plans must be valid and the\n"
+        << "lower bound must not exceed the optimal cost from A*. Returns non-zero on failure.\n";
+    std::exit(2);
+}
+
+// --- helpers ---
+
+static void expect(bool cond, const std::string& what) {
+    if (!cond) {
+        throw std::runtime_error(what);
+    }
+}
+
+// プランを初期状態から順に適用し、全ての演算子が適用可能で、最後にゴールを満たすことを確かめる関数
+static void check_plan(const Task& T, const std::vector<uint32_t>& plan, const std::string& name) {
+    State s = T.init;
+    planner::sas::Undo undo;
+    for (std::size_t i = 0; i < plan.size(); ++i) {
+        expect(plan[i] < T.ops.size(), name + ": operator out of range at step " + std::to_string(i));
+        expect(planner::sas::is_applicable(T, s, T.ops[plan[i]]), name + ": not applicable at step " + std::to_string(i));
+        planner::sas::apply_inplace(T, T.ops[plan[i]], s, undo);
+        undo.clear();
+    }
+    expect(planner::sas::is_goal(T, s), name + ": plan does not reach the goal");
+}
+
+// 演算子 a が変数集合 vars のいずれかを変更するかどうか
+static bool changes_any(const Task& T, std::size_t a, const std::vector<char>& in_vars) {
+    for (const auto& pp : T.ops[a].pre_posts) {
+        if (in_vars[std::get<1>(pp)]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ShardHasher の抽象化変数の選び方と、ハッシュ値が抽象化変数のみで決まることを確かめる関数
+static void check_hasher(const Task& T, uint32_t num_shards, std::mt19937_64& rng) {
+    std::vector<int> prev_vars;
+    for (const uint32_t balance : {1u, 4u, 16u, 64u}) {
+        const soc::ShardHasher zh(T, num_shards, balance);
+        const std::string name = "shards=" + std::to_string(num_shards) + " balance=" + std::to_string(balance);
+        const auto& vars = zh.vars();
+
+        // 抽象化変数は重複せず、値が変化しうる変数のみ
+        std::vector<char> in_vars(T.vars.size(), 0);
+        double states = 1.0;
+        for (int v : vars) {
+            expect(v >= 0 && static_cast<std::size_t>(v) < T.vars.size(), name + ": variable out of range");
+            expect(!in_vars[v], name + ": variable " + std::to_string(v) + " chosen twice");
+            expect(T.vars[v].domain >= 2, name + ": constant variable " + std::to_string(v) + " chosen");
+            in_vars[v] = 1;
+            states *= T.vars[v].domain;
+        }
+
+        // 抽象状態の数が足りない場合は、値が変化しうる変数を全て選んでいる
+        if (states < static_cast<double>(num_shards) * balance) {
+            for (std::size_t a = 0; a < T.ops.size(); ++a) {
+                for (const auto& pp : T.ops[a].pre_posts) {
+                    const int v = std::get<1>(pp);
+                    expect(in_vars[v] || T.vars[v].domain < 2, name + ": too few abstract states, but variable " +
+                                                               std::to_string(v) + " is not chosen");
+                }
+            }
+        }
+
+        // balance を大きくすると、小さい場合の抽象化変数に変数を追加したものになる
+        expect(vars.size() >= prev_vars.size() && std::equal(prev_vars.begin(), prev_vars.end(), vars.begin()),
+               name + ": variables are not an extension of those for a smaller balance");
+        prev_vars = vars;
+
+        // 移動する演算子の割合
+        std::size_t moving = 0;
+        for (std::size_t a = 0; a < T.ops.size(); ++a) {
+            moving += changes_any(T, a, in_vars) ? 1 : 0;
+        }
+        const double ratio = T.ops.empty() ? 0.0 : static_cast<double>(moving) / static_cast<double>(T.ops.size());
+        expect(zh.moving_op_ratio() == ratio, name + ": moving_op_ratio " + std::to_string(zh.moving_op_ratio()) +
+                                              ", expected " + std::to_string(ratio));
+
+        // ランダムウォーク: 抽象化変数を変更しない演算子による後続状態は、親と同じハッシュ値を持つ
+        planner::sas::Undo undo;
+        std::size_t kept = 0, transitions = 0;
+        for (int walk = 0; walk < 20; ++walk) {
+            State s = T.init;
+            for (int step = 0; step < 50; ++step) {
+                std::vector<std::size_t> app;
+                for (std::size_t a = 0; a < T.ops.size(); ++a) {
+                    if (planner::sas::is_applicable(T, s, T.ops[a])) {
+                        app.push_back(a);
+                    }
+                }
+                if (app.empty()) {
+                    break;
+                }
+                const uint32_t h_parent = zh(s);
+                const std::size_t a = app[rng() % app.size()];
+                planner::sas::apply_inplace(T, T.ops[a], s, undo);
+                undo.clear();
+                ++transitions;
+                if (!changes_any(T, a, in_vars)) {
+                    expect(zh(s) == h_parent, name + ": operator " + std::to_string(a) +
+                                              " changes no abstraction variable but moves the state");
+                    ++kept;
+                }
+            }
+        }
+        std::cout << name << ": " << vars.size() << " variables, " << states << " abstract states, moving ops "
+                  << ratio << ", kept on the parent's shard " << kept << " / " << transitions << "\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+
+    try {
+        const Task T = read_file(argv[1]);
+        std::mt19937_64 rng(116u);
+        for (const uint32_t shards : {2u, 8u, 64u}) {
+            check_hasher(T, shards, rng);
+        }
+
+        planner::sas::Params P;
+        P.verbose = false;
+        const auto ref = planner::sas::astar(T, planner::sas::blind(), true, P);
+        expect(ref.solved, "reference A* did not solve the task");
+        const double opt = ref.plan_cost;
+
+        for (const uint32_t h : {0u, 5u}) {
+            const std::string hname = (h == 0) ? "blind" : "pot";
+
+            // 1 スレッド・1 シャードでは、オープンリストは同じ順に取り出すので、クローズドリストの分割方法によらず同じ数だけ展開する
+            soc::Params S;
+            S.heuristic_kind = h;
+            S.bucket_shards = 1;
+            S.bucket_select_k = 1;
+            planner::sas::soc::GlobalStats gs_id, gs_abs;
+            const auto Rid = soc::astar_soc(T, S, &gs_id);
+            S.shard_mode = soc::ShardMode::Abstraction;
+            const auto Rabs = soc::astar_soc(T, S, &gs_abs);
+            expect(Rid.solved && Rabs.solved, hname + ": exact search did not find a plan");
+            check_plan(T, Rabs.plan_ops, hname + " exact abstraction");
+            expect(Rabs.cost == opt && Rid.cost == opt, hname + ": exact search is not optimal");
+            expect(gs_abs.sum().expanded == gs_id.sum().expanded,
+                   hname + ": abstraction sharding expanded " + std::to_string(gs_abs.sum().expanded) + ", node-ID sharding " +
+                   std::to_string(gs_id.sum().expanded));
+            expect(gs_abs.sum().remote_pushes == 0, hname + ": remote pushes with a single shard");
+
+            // 複数シャード・複数スレッド
+            for (const auto kind : {soc::QueueKind::BucketPQ, soc::QueueKind::MultiQueue}) {
+                for (const uint32_t threads : {1u, 4u}) {
+                    for (const uint32_t balance : {1u, 16u}) {
+                        soc::Params M;
+                        M.heuristic_kind = h;
+                        M.queue_kind = kind;
+                        M.num_threads = threads;
+                        M.shard_mode = soc::ShardMode::Abstraction;
+                        M.shard_balance = balance;
+                        const std::string name = hname + (kind == soc::QueueKind::BucketPQ ? " bucket" : " multi") +
+                                                 " threads=" + std::to_string(threads) + " balance=" + std::to_string(balance);
+                        planner::sas::soc::GlobalStats gs;
+                        const auto R = soc::astar_soc(T, M, &gs);
+                        expect(R.solved, name + ": no plan found");
+                        check_plan(T, R.plan_ops, name);
+                        expect(R.cost == planner::sas::eval_plan_cost(T, R.plan_ops), name + ": wrong plan cost");
+                        expect(R.cost >= opt, name + ": cost below the optimum");
+                        expect(R.lower_bound <= opt, name + ": lower bound " + std::to_string(R.lower_bound) +
+                                                     " exceeds the optimum " + std::to_string(opt));
+                        const auto total = gs.sum();
+                        expect(total.remote_pushes <= total.pushes, name + ": more remote pushes than pushes");
+                        std::cout << name << ": cost " << R.cost << ", expanded " << total.expanded << ", remote pushes "
+                                  << total.remote_pushes << " / " << total.pushes << "\n";
+                    }
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
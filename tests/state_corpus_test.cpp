@@ -0,0 +1,96 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <stdexcept>
+
+#include <sas/sas_reader.hpp>
+#include <sas/sas_search.hpp>
+#include <sas/sas_heuristic.hpp>
+#include <sas/search_utils.hpp>
+#include <sas/state_corpus.hpp>
+
+using planner::sas::Task;
+using planner::sas::State;
+using planner::sas::read_file;
+
+static void die_usage(const char* argv0) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << argv0 << " <path/to/output.sas>\n\n"
+        << "Writes the task back as SAS text and re-reads it, records the states evaluated by an A* search\n"
+        << "into a state corpus, and checks that the corpus reads back with the same states and values.\n"
+        << "Returns non-zero on failure.\n";
+    std::exit(2);
+}
+
+// --- helpers ---
+
+static void expect(bool cond, const std::string& what) {
+    if (!cond) {
+        throw std::runtime_error(what);
+    }
+}
+
+// write_sas で書き出したテキストを読み戻し、同じタスクになるか確認する関数
+static void check_round_trip(const Task& T) {
+    std::stringstream ss;
+    planner::sas::write_sas(T, ss);
+    const Task U = planner::sas::read_stream(ss);
+    expect(planner::sas::task_fingerprint(U) == planner::sas::task_fingerprint(T), "round trip changes the task");
+    expect(U.mutexes.size() == T.mutexes.size(), "round trip changes the mutex groups");
+    for (std::size_t i = 0; i < T.ops.size(); ++i) {
+        expect(U.ops[i].name == T.ops[i].name, "round trip changes an operator name");
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+
+    try {
+        const Task T = read_file(argv[1]);
+        check_round_trip(T);
+
+        // 標本の数を評価回数より小さくして、reservoir sampling の置き換えも通す
+        const std::size_t capacity = 64;
+        planner::sas::StateRecorder rec(capacity);
+        planner::sas::Params P;
+        P.verbose = false;
+        const auto R = planner::sas::astar(T, rec.wrap(planner::sas::hff(T)), true, P);
+        expect(rec.seen() > 0, "no states were recorded");
+        expect(rec.size() == std::min<uint64_t>(capacity, rec.seen()), "wrong number of sampled states");
+
+        const std::string path = "state_corpus_test.corpus";
+        rec.write(path, T, "ff");
+        const auto C = planner::sas::read_corpus(path);
+        std::remove(path.c_str());
+
+        expect(C.heuristic == "ff", "heuristic name not kept");
+        expect(C.seen == rec.seen(), "evaluation count not kept");
+        expect(C.states.size() == rec.size() && C.values.size() == rec.size(), "wrong number of states read");
+        expect(planner::sas::task_fingerprint(C.task) == planner::sas::task_fingerprint(T), "task not kept");
+
+        // 読み戻した状態を評価し直すと、記録した値と一致する
+        const auto h = planner::sas::hff(C.task);
+        for (std::size_t i = 0; i < C.states.size(); ++i) {
+            expect(C.states[i].size() == T.vars.size(), "state has the wrong size");
+            for (std::size_t v = 0; v < T.vars.size(); ++v) {
+                expect(C.states[i][v] >= 0 && C.states[i][v] < T.vars[v].domain, "state value out of its domain");
+            }
+            expect(h(C.task, C.states[i]) == C.values[i], "recorded value differs from a fresh evaluation");
+        }
+
+        std::cout << "recorded " << C.states.size() << " of " << C.seen << " evaluated states"
+                  << " (A* " << (R.solved ? "solved" : "unsolved") << ")\n";
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <sas/sas_reader.hpp>
+#include <sas/sas_search.hpp>
+#include <sas/search_utils.hpp>
+#include <sas/state_index.hpp>
+
+using planner::sas::Task;
+using planner::sas::State;
+using planner::sas::StateIndex;
+using planner::sas::SuccessorBatch;
+using planner::sas::read_file;
+
+static void die_usage(const char* argv0) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << argv0 << " <path/to/output.sas>\n\n"
+        << "Explores the reachable states breadth-first with SuccessorBatch and StateIndex (starting from a tiny\n"
+        << "table so that it grows many times) and checks every lookup against std::map. Also checks that A* and\n"
+        << "GBFS over the hash table agree with the dense state table. Returns non-zero on failure.\n";
+    std::exit(2);
+}
+
+// --- helpers ---
+
+static void expect(bool cond, const std::string& what) {
+    if (!cond) {
+        throw std::runtime_error(what);
+    }
+}
+
+// ランダムな状態を生成する関数
+static State random_state(const Task& T, std::mt19937_64& rng) {
+    State s(T.vars.size());
+    for (std::size_t v = 0; v < T.vars.size(); ++v) {
+        std::uniform_int_distribution<int> dist(0, T.vars[v].domain - 1);
+        s[v] = dist(rng);
+    }
+    return s;
+}
+
+// 探索エンジンと同じ手順 (まとめて生成 -> ハッシュ値の計算と先読み -> 元の順に検索・登録) で幅優先に状態を集め、
+// 全ての検索結果を std::map と比べる関数
+static std::vector<State> explore(const Task& T, std::size_t max_states, StateIndex& index,
+                                  std::map<State, int>& ref) {
+    std::vector<State> nodes{T.init};
+    auto state_of = [&nodes](int id) -> const State& { return nodes[id]; };
+    index.insert(StateIndex::hash(T.init), 0, state_of);
+    ref.emplace(T.init, 0);
+
+    SuccessorBatch batch;
+    State work;
+    planner::sas::Undo undo;
+    for (std::size_t u = 0; u < nodes.size() && nodes.size() < max_states; ++u) {
+        const State su = nodes[u];
+        batch.clear();
+        for (const auto& op : T.ops) {
+            if (!planner::sas::is_applicable(T, su, op)) {
+                continue;
+            }
+            work = su;
+            undo.clear();
+            planner::sas::apply_inplace(T, op, work, undo);
+            batch.push(work, static_cast<int>(&op - T.ops.data()));
+        }
+        batch.hash_and_prefetch(index);
+
+        for (std::size_t i = 0; i < batch.size(); ++i) {
+            const State& succ = batch.state(i);
+            expect(batch.hash(i) == StateIndex::hash(succ), "batch hash differs from StateIndex::hash");
+
+            const int found = index.find(succ, batch.hash(i), state_of);
+            const auto it = ref.find(succ);
+            if (it == ref.end()) {
+                expect(found == StateIndex::EMPTY, "found a state that was never inserted");
+                const int v = static_cast<int>(nodes.size());
+                nodes.push_back(succ);
+                index.insert(batch.hash(i), v, state_of);
+                ref.emplace(succ, v);
+            } else {
+                expect(found == it->second, "lookup returned node " + std::to_string(found) + ", expected " +
+                                            std::to_string(it->second));
+            }
+        }
+    }
+    return nodes;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+
+    try {
+        const Task T = read_file(argv[1]);
+
+        StateIndex index(16);
+        std::map<State, int> ref;
+        const std::vector<State> nodes = explore(T, 200000, index, ref);
+        auto state_of = [&nodes](int id) -> const State& { return nodes[id]; };
+        expect(index.size() == nodes.size(), "index size differs from the number of inserted states");
+
+        // 表が何度大きくなっても、登録済みの状態は全て元のノード ID で引ける
+        for (std::size_t id = 0; id < nodes.size(); ++id) {
+            expect(index.find(nodes[id], StateIndex::hash(nodes[id]), state_of) == static_cast<int>(id),
+                   "state " + std::to_string(id) + " is lost after growing the table");
+        }
+
+        // 未登録の状態は EMPTY になる
+        std::mt19937_64 rng(104u);
+        std::size_t absent = 0;
+        for (int i = 0; i < 20000; ++i) {
+            const State s = random_state(T, rng);
+            const int found = index.find(s, StateIndex::hash(s), state_of);
+            const auto it = ref.find(s);
+            expect(found == (it == ref.end() ? StateIndex::EMPTY : it->second), "random lookup disagrees with std::map");
+            absent += (it == ref.end());
+        }
+        std::cout << "states: " << nodes.size() << ", random lookups not in the table: " << absent << " / 20000\n";
+
+        // ハッシュ表を用いる探索は、密な状態表を用いる探索と同じ結果になる
+        planner::sas::Params P;
+        P.verbose = false;
+        planner::sas::Params Ph = P;
+        Ph.dense_max_states = 0;
+        const auto Ad = planner::sas::astar(T, planner::sas::blind(), true, P);
+        const auto Ah = planner::sas::astar(T, planner::sas::blind(), true, Ph);
+        expect(Ad.solved == Ah.solved, "A* over the hash table disagrees on solvability");
+        expect(Ad.plan_cost == Ah.plan_cost, "A* over the hash table found cost " + std::to_string(Ah.plan_cost) +
+                                             ", dense table " + std::to_string(Ad.plan_cost));
+        expect(Ah.plan_cost == planner::sas::eval_plan_cost(T, Ah.plan), "A* plan cost is wrong");
+        const auto Gd = planner::sas::gbfs(T, planner::sas::goalcount(), true, P);
+        const auto Gh = planner::sas::gbfs(T, planner::sas::goalcount(), true, Ph);
+        expect(Gd.solved == Gh.solved, "GBFS over the hash table disagrees on solvability");
+        expect(Gd.stats.expanded == Gh.stats.expanded, "GBFS over the hash table expanded a different number of nodes");
+        std::cout << "A*: cost " << Ah.plan_cost << ", expanded " << Ah.stats.expanded << " (dense " << Ad.stats.expanded
+                  << "); GBFS: expanded " << Gh.stats.expanded << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+#include <random>
+
+#include <sas/sas_reader.hpp>
+#include <sas/dense_state_table.hpp>
+
+using planner::sas::Task;
+using planner::sas::State;
+using planner::sas::StateRanker;
+using planner::sas::DenseStateTable;
+using planner::sas::DenseMeta;
+using planner::sas::read_file;
+
+static void die_usage(const char* argv0) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << argv0 << " <path/to/output.sas>\n\n"
+        << "Checks that rank/unrank of the given task is a bijection on random states\n"
+        << "and that incremental reranking agrees with full ranking. Returns non-zero on failure.\n";
+    std::exit(2);
+}
+
+// --- helpers ---
+
+// ランダムな状態を生成する関数
+static State random_state(const Task& T, std::mt19937_64& rng) {
+    State s(T.vars.size());
+    for (std::size_t v = 0; v < T.vars.size(); ++v) {
+        std::uniform_int_distribution<int> dist(0, T.vars[v].domain - 1);
+        s[v] = dist(rng);
+    }
+    return s;
+}
+
+// rank → unrank で元の状態に戻るかを判定する関数
+static void check_roundtrip(const Task& T, const StateRanker& R, std::mt19937_64& rng, int trials) {
+    State back;
+    for (int i = 0; i < trials; ++i) {
+        const State s = random_state(T, rng);
+        const uint64_t r = R.rank(s);
+        if (r >= R.num_states()) {
+            throw std::runtime_error("rank out of range");
+        }
+        R.unrank(r, back);
+        if (back != s) {
+            throw std::runtime_error("unrank(rank(s)) != s at trial " + std::to_string(i));
+        }
+    }
+}
+
+// 1 変数の書き換えに対する差分ランク計算が、全体のランク計算と一致するかを判定する関数
+static void check_rerank(const Task& T, const StateRanker& R, std::mt19937_64& rng, int trials) {
+    for (int i = 0; i < trials; ++i) {
+        State s = random_state(T, rng);
+        const uint64_t r = R.rank(s);
+        std::uniform_int_distribution<int> pick(0, static_cast<int>(T.vars.size()) - 1);
+        const int var = pick(rng);
+        std::uniform_int_distribution<int> val(0, T.vars[var].domain - 1);
+        const int old_val = s[var];
+        s[var] = val(rng);
+        if (R.rerank(r, var, old_val, s[var]) != R.rank(s)) {
+            throw std::runtime_error("rerank mismatch at trial " + std::to_string(i));
+        }
+    }
+}
+
+// 密な状態表がゼロ初期化され、メタ情報の bit 操作が正しく動くか判定する関数
+static void check_table(const StateRanker& R) {
+    DenseStateTable table(R.num_states());
+    for (uint64_t r = 0; r < R.num_states(); r += 1 + R.num_states() / 64) {
+        if (table[r].seen()) {
+            throw std::runtime_error("dense table is not zero-initialized");
+        }
+    }
+    DenseMeta& m = table[R.num_states() - 1];
+    m.set(7, DenseMeta::NO_PARENT, 12345);
+    m.set_h(3);
+    m.close();
+    if (!m.seen() || m.g() != 7 || m.h() != 3 || !m.closed() || m.op() != 12345) {
+        throw std::runtime_error("dense meta encoding is broken");
+    }
+    m.reopen();
+    m.set(5, 0, 12345); // g-value の改善では h は変わらない
+    if (m.closed() || m.op() != 12345 || m.g() != 5 || m.h() != 3) {
+        throw std::runtime_error("dense meta reopen is broken");
+    }
+}
+
+// --- main ---
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+    const std::string sas_path = argv[1];
+
+    try {
+        Task T = read_file(sas_path);
+
+        const StateRanker R(T, DenseStateTable::MAX_STATES);
+        std::cout << "#vars  : " << T.vars.size() << "\n";
+        if (!R.fits()) {
+            std::cout << "state space does not fit into a dense table; nothing to check\n";
+            return 0;
+        }
+        std::cout << "#states: " << R.num_states() << "\n";
+
+        // 小さい上限では fits() が false になること
+        if (R.num_states() > 1 && StateRanker(T, R.num_states() - 1).fits()) {
+            throw std::runtime_error("fits() ignores the state limit");
+        }
+
+        std::mt19937_64 rng(634u);
+        check_roundtrip(T, R, rng, 10000);
+        check_rerank(T, R, rng, 10000);
+        if (R.num_states() <= (1ull << 26)) {
+            check_table(R);
+        }
+
+        std::cout << "OK\n";
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << "\n";
+        return 1;
+    }
+}
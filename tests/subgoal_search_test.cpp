@@ -0,0 +1,94 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <sas/sas_reader.hpp>
+#include <sas/sas_search.hpp>
+#include <sas/sas_heuristic.hpp>
+#include <sas/search_utils.hpp>
+#include <sas/subgoal_search.hpp>
+
+using planner::sas::Task;
+using planner::sas::State;
+using planner::sas::read_file;
+
+static void die_usage(const char* argv0) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << argv0 << " <path/to/output.sas>\n\n"
+        << "Runs the landmark subgoal search with hff and goalcount and checks that the concatenated plans are\n"
+        << "valid, and that the gbfs fallback still solves the task when every subproblem is cut off.\n"
+        << "Returns non-zero on failure.\n";
+    std::exit(2);
+}
+
+// --- helpers ---
+
+static void expect(bool cond, const std::string& what) {
+    if (!cond) {
+        throw std::runtime_error(what);
+    }
+}
+
+// プランを初期状態から順に適用し、全ての演算子が適用可能で、最後にゴールを満たすことを確かめる関数
+static void check_plan(const Task& T, const std::vector<uint32_t>& plan, const std::string& name) {
+    State s = T.init;
+    planner::sas::Undo undo;
+    for (std::size_t i = 0; i < plan.size(); ++i) {
+        expect(plan[i] < T.ops.size(), name + ": operator out of range at step " + std::to_string(i));
+        expect(planner::sas::is_applicable(T, s, T.ops[plan[i]]), name + ": not applicable at step " + std::to_string(i));
+        planner::sas::apply_inplace(T, T.ops[plan[i]], s, undo);
+        undo.clear();
+    }
+    expect(planner::sas::is_goal(T, s), name + ": plan does not reach the goal");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+
+    try {
+        const Task T = read_file(argv[1]);
+        planner::sas::Params P;
+        P.verbose = false;
+
+        const auto Rg = planner::sas::gbfs(T, planner::sas::hff(T), true, P);
+        expect(Rg.solved, "gbfs did not find a plan");
+
+        const planner::sas::HeuristicFactory ff = [](const Task& G) { return planner::sas::hff(G); };
+        const planner::sas::HeuristicFactory gc = [](const Task&) { return planner::sas::goalcount(); };
+        for (const auto& [name, make_h] : {std::pair<std::string, planner::sas::HeuristicFactory>{"ff", ff}, {"goalcount", gc}}) {
+            const auto S = planner::sas::subgoal_search(T, make_h, true, planner::sas::SubgoalParams{}, P);
+            expect(S.result.solved, name + ": subgoal search did not find a plan");
+            check_plan(T, S.result.plan, name);
+            expect(S.result.plan_cost == planner::sas::eval_plan_cost(T, S.result.plan), name + ": wrong plan cost");
+            std::cout << name << ": landmarks " << S.num_landmarks << ", subgoals solved " << S.subgoals_solved
+                      << ", failed " << S.subgoals_failed << ", backtracks " << S.backtracks
+                      << (S.fell_back ? ", fell back" : "") << ", expanded " << S.result.stats.expanded
+                      << ", plan cost " << S.result.plan_cost << " (gbfs: expanded " << Rg.stats.expanded
+                      << ", plan cost " << Rg.plan_cost << ")\n";
+        }
+
+        // 部分問題を全て打ち切っても、元のタスクの gbfs で解ける
+        planner::sas::SubgoalParams tight;
+        tight.max_sub_expansions = 1;
+        const auto S = planner::sas::subgoal_search(T, ff, true, tight, P);
+        expect(S.result.solved, "fallback did not find a plan");
+        check_plan(T, S.result.plan, "fallback");
+
+        // 探索の上限は部分問題と fallback を合わせて守る
+        planner::sas::Params small = P;
+        small.max_expansions = 2;
+        const auto L = planner::sas::subgoal_search(T, ff, true, tight, small);
+        expect(L.result.stats.expanded <= 2, "expansion limit exceeded: " + std::to_string(L.result.stats.expanded));
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
@@ -0,0 +1,299 @@
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <sas/sas_reader.hpp>
+#include <sas/sas_search.hpp>
+#include <sas/sas_heuristic.hpp>
+#include <sas/search_utils.hpp>
+#include <sas/state_index.hpp>
+#include <sas/topk_search.hpp>
+
+using planner::sas::Task;
+using planner::sas::State;
+using planner::sas::StateIndex;
+using planner::sas::read_file;
+
+static void die_usage(const char* argv0) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << argv0 << " <path/to/output.sas>\n\n"
+        << "Checks that topk returns K distinct valid plans whose costs are exactly the K cheapest plan costs,\n"
+        << "counted by brute force over the explicit state graph (blind and pot), that a cost bound makes it\n"
+        << "return every plan below the bound, and that --diverse plans keep their Jaccard distance.\n"
+        << "Returns non-zero on failure.\n";
+    std::exit(2);
+}
+
+// --- helpers ---
+
+static void expect(bool cond, const std::string& what) {
+    if (!cond) {
+        throw std::runtime_error(what);
+    }
+}
+
+// プランを初期状態から順に適用し、全ての演算子が適用可能で、最後にゴールを満たすことを確かめる関数
+static void check_plan(const Task& T, const std::vector<uint32_t>& plan, const std::string& name) {
+    State s = T.init;
+    planner::sas::Undo undo;
+    for (std::size_t i = 0; i < plan.size(); ++i) {
+        expect(plan[i] < T.ops.size(), name + ": operator out of range at step " + std::to_string(i));
+        expect(planner::sas::is_applicable(T, s, T.ops[plan[i]]), name + ": not applicable at step " + std::to_string(i));
+        planner::sas::apply_inplace(T, T.ops[plan[i]], s, undo);
+        undo.clear();
+    }
+    expect(planner::sas::is_goal(T, s), name + ": plan does not reach the goal");
+}
+
+// 演算子集合の Jaccard 距離
+static double jaccard_distance(std::vector<uint32_t> x, std::vector<uint32_t> y) {
+    std::sort(x.begin(), x.end());
+    x.erase(std::unique(x.begin(), x.end()), x.end());
+    std::sort(y.begin(), y.end());
+    y.erase(std::unique(y.begin(), y.end()), y.end());
+    std::vector<uint32_t> common;
+    std::set_intersection(x.begin(), x.end(), y.begin(), y.end(), std::back_inserter(common));
+    const double uni = static_cast<double>(x.size() + y.size() - common.size());
+    return uni == 0.0 ? 0.0 : 1.0 - static_cast<double>(common.size()) / uni;
+}
+
+// --- 総当たり: 到達可能な状態のグラフ上で、コストごとのプランの数を数える ---
+// topk と同じく、同じ状態を何度も通るプランや、ゴールを通り抜けるプランも別のプランとして数える
+class PlanCounter {
+public:
+    // 状態数が max_states を超える場合は ok() が false になる
+    PlanCounter(const Task& T, std::size_t max_states) : T_(T) {
+        auto state_of = [this](int id) -> const State& { return states_[id]; };
+        StateIndex index(1 << 10);
+        states_.push_back(T.init);
+        index.insert(StateIndex::hash(T.init), 0, state_of);
+        const bool check_mutex = planner::sas::should_check_mutex_runtime(T);
+        State work;
+        planner::sas::Undo undo;
+        for (std::size_t u = 0; u < states_.size(); ++u) {
+            if (states_.size() > max_states) {
+                return;
+            }
+            out_.emplace_back();
+            for (std::size_t a = 0; a < T.ops.size(); ++a) {
+                if (!planner::sas::is_applicable(T, states_[u], T.ops[a])) {
+                    continue;
+                }
+                work = states_[u];
+                undo.clear();
+                planner::sas::apply_inplace(T, T.ops[a], work, undo);
+                if (check_mutex && planner::sas::violates_mutex(T, work)) {
+                    continue;
+                }
+                const std::size_t hv = StateIndex::hash(work);
+                int v = index.find(work, hv, state_of);
+                if (v == StateIndex::EMPTY) {
+                    v = static_cast<int>(states_.size());
+                    states_.push_back(work);
+                    index.insert(hv, v, state_of);
+                }
+                out_[u].push_back({v, static_cast<int>(a)});
+            }
+        }
+        ok_ = true;
+
+        // ゴールまでの最小コスト (逆向きの Dijkstra)
+        std::vector<std::vector<std::pair<int, int>>> in(states_.size());
+        for (std::size_t u = 0; u < states_.size(); ++u) {
+            for (auto [v, a] : out_[u]) {
+                in[v].push_back({static_cast<int>(u), a});
+            }
+        }
+        dist_.assign(states_.size(), INF);
+        using Entry = std::pair<long long, int>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> pq;
+        for (std::size_t s = 0; s < states_.size(); ++s) {
+            if (planner::sas::is_goal(T, states_[s])) {
+                dist_[s] = 0;
+                pq.emplace(0, static_cast<int>(s));
+            }
+        }
+        while (!pq.empty()) {
+            const auto [d, v] = pq.top();
+            pq.pop();
+            if (d != dist_[v]) {
+                continue;
+            }
+            for (auto [u, a] : in[v]) {
+                const long long du = d + cost(a);
+                if (du < dist_[u]) {
+                    dist_[u] = du;
+                    pq.emplace(du, u);
+                }
+            }
+        }
+    }
+
+    bool ok() const { return ok_; }
+    std::size_t num_states() const { return states_.size(); }
+    long long optimal() const { return dist_[0]; }
+
+    // コストが limit 以下のプランの数をコストごとに返す関数 (各コストの数は cap で飽和させる)
+    std::vector<uint64_t> count(long long limit, uint64_t cap) const {
+        std::vector<uint64_t> plans(static_cast<std::size_t>(limit) + 1, 0);
+        std::vector<std::unordered_map<int, uint64_t>> level(static_cast<std::size_t>(limit) + 1);
+        if (dist_[0] <= limit) {
+            level[0][0] = 1;
+        }
+        for (long long c = 0; c <= limit; ++c) {
+            for (const auto& [s, n] : level[c]) {
+                if (planner::sas::is_goal(T_, states_[s])) {
+                    plans[c] = std::min(cap, plans[c] + n);
+                }
+                for (auto [v, a] : out_[s]) {
+                    const long long c2 = c + cost(a);
+                    if (c2 + dist_[v] <= limit) { // ゴールに届かない経路は数えない
+                        uint64_t& m = level[c2][v];
+                        m = std::min(cap, m + n);
+                    }
+                }
+            }
+            level[c].clear();
+        }
+        return plans;
+    }
+
+private:
+    static constexpr long long INF = std::numeric_limits<long long>::max() / 4;
+
+    long long cost(int a) const { return std::llround(T_.ops[a].cost); }
+
+    const Task& T_;
+    std::vector<State> states_;
+    std::vector<std::vector<std::pair<int, int>>> out_; // (後続状態, 演算子)
+    std::vector<long long> dist_;
+    bool ok_ = false;
+};
+
+// コストごとのプランの数から、小さい順に k 個のコストを並べる関数
+static std::vector<double> cheapest_costs(const std::vector<uint64_t>& plans, std::size_t k) {
+    std::vector<double> out;
+    for (std::size_t c = 0; c < plans.size() && out.size() < k; ++c) {
+        for (uint64_t n = 0; n < plans[c] && out.size() < k; ++n) {
+            out.push_back(static_cast<double>(c));
+        }
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+
+    try {
+        const Task T = read_file(argv[1]);
+        planner::sas::Params P;
+        P.verbose = false;
+
+        const auto A = planner::sas::astar(T, planner::sas::blind(), true, P);
+        expect(A.solved, "A* did not find a plan");
+
+        // 総当たりは、全ての演算子のコストが正の整数の場合にのみ行う (コスト 0 の閉路があるとプランの数が有限にならない)
+        bool positive_int = planner::sas::all_action_costs_are_integers(T);
+        for (const auto& op : T.ops) {
+            positive_int = positive_int && op.cost >= 1.0;
+        }
+        const PlanCounter counter(T, 2000000);
+        const bool brute = positive_int && counter.ok();
+        if (brute) {
+            expect(static_cast<double>(counter.optimal()) == A.plan_cost, "brute force disagrees with A* on the optimal cost");
+        }
+
+        const std::size_t K = 20;
+        for (const auto& [name, h] : {std::pair<std::string, planner::sas::HeuristicFn>{"blind", planner::sas::blind()},
+                                      {"pot", planner::sas::hpot_init(T)}}) {
+            planner::sas::TopKParams kp;
+            kp.k = K;
+            const auto R = planner::sas::topk_search(T, h, kp, P);
+            expect(R.stop == planner::sas::StopReason::None, name + ": search was interrupted");
+            expect(R.plans.size() == R.costs.size() && R.plans.size() <= K && !R.plans.empty(), name + ": wrong number of plans");
+            // K 個に満たないのは、プランが K 個ない場合 (探索空間を網羅した場合) のみ
+            expect(R.plans.size() == K || R.exhausted, name + ": returned " + std::to_string(R.plans.size()) + " plans");
+            for (std::size_t i = 0; i < R.plans.size(); ++i) {
+                const std::string what = name + ", plan " + std::to_string(i);
+                check_plan(T, R.plans[i], what);
+                expect(R.costs[i] == planner::sas::eval_plan_cost(T, R.plans[i]), what + ": wrong cost");
+                expect(i == 0 || R.costs[i - 1] <= R.costs[i], what + ": costs are not in ascending order");
+                for (std::size_t j = 0; j < i; ++j) {
+                    expect(R.plans[j] != R.plans[i], what + ": same as plan " + std::to_string(j));
+                }
+            }
+            expect(R.costs[0] == A.plan_cost, name + ": the first plan is not optimal");
+
+            if (brute) {
+                // 返したコストは、総当たりで数えた小さい方から K 個のコストと一致する
+                // K 個に満たない場合は、それより少し高いコストまで数えてもプランが増えない
+                const auto limit = static_cast<long long>(R.costs.back()) + (R.plans.size() < K ? 20 : 0);
+                const auto expected = cheapest_costs(counter.count(limit, K), K);
+                expect(R.costs == expected, name + ": cost distribution differs from brute force");
+            }
+            std::cout << name << ": costs " << R.costs.front() << " .. " << R.costs.back() << ", expanded "
+                      << R.stats.expanded << "\n";
+        }
+
+        // 上界未満のプランが少なければ、全てを返して網羅したことを示す
+        if (brute) {
+            const long long bound = counter.optimal() + 2;
+            const auto plans = counter.count(bound - 1, 100000);
+            uint64_t total = 0;
+            for (uint64_t n : plans) {
+                total += n;
+            }
+            if (total < 5000) {
+                planner::sas::TopKParams kp;
+                kp.k = static_cast<std::size_t>(total) + 5;
+                planner::sas::Params Pb = P;
+                Pb.cost_bound = static_cast<double>(bound);
+                const auto R = planner::sas::topk_search(T, planner::sas::blind(), kp, Pb);
+                expect(R.exhausted, "bound: search space was not exhausted");
+                expect(R.plans.size() == total, "bound: returned " + std::to_string(R.plans.size()) + " plans, brute force " +
+                                                std::to_string(total));
+                expect(R.costs == cheapest_costs(plans, static_cast<std::size_t>(total)), "bound: cost distribution differs");
+                std::cout << "bound " << bound << ": all " << total << " plans\n";
+            }
+        }
+
+        // --diverse: 選んだプランは互いに Jaccard 距離 D 以上離れ、最初のプランは最適
+        for (double D : {0.2, 0.5}) {
+            planner::sas::TopKParams kp;
+            kp.k = 4;
+            kp.diversity = D;
+            kp.max_candidates = 200000;
+            const auto R = planner::sas::topk_search(T, planner::sas::blind(), kp, P);
+            const std::string name = "diverse " + std::to_string(D);
+            expect(!R.plans.empty(), name + ": no plan");
+            expect(R.plans.size() <= kp.k && R.plans.size() == R.costs.size(), name + ": wrong number of plans");
+            expect(R.costs[0] == A.plan_cost, name + ": the first plan is not optimal");
+            for (std::size_t i = 0; i < R.plans.size(); ++i) {
+                check_plan(T, R.plans[i], name + ", plan " + std::to_string(i));
+                expect(R.costs[i] == planner::sas::eval_plan_cost(T, R.plans[i]), name + ": wrong cost");
+                expect(i == 0 || R.costs[i - 1] <= R.costs[i], name + ": costs are not in ascending order");
+                for (std::size_t j = 0; j < i; ++j) {
+                    expect(jaccard_distance(R.plans[i], R.plans[j]) >= D, name + ": plans " + std::to_string(j) + " and " +
+                                                                         std::to_string(i) + " are too similar");
+                }
+            }
+            std::cout << name << ": " << R.plans.size() << " plans, costs " << R.costs.front() << " .. " << R.costs.back() << "\n";
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}
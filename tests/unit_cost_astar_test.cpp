@@ -0,0 +1,142 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <stdexcept>
+
+#include <sas/sas_reader.hpp>
+#include <sas/sas_search.hpp>
+#include <sas/sas_heuristic.hpp>
+#include <sas/search_utils.hpp>
+#include <sas/resumable_search.hpp>
+
+using planner::sas::Task;
+using planner::sas::State;
+using planner::sas::ResumableSearch;
+using planner::sas::StepStatus;
+using planner::sas::read_file;
+
+static void die_usage(const char* argv0) {
+    std::cerr
+        << "Usage:\n"
+        << "  " << argv0 << " <path/to/output.sas>\n\n"
+        << "Sets every action cost to 1 and checks the unit-cost A* (goal test at generation, FIFO buckets) over\n"
+        << "the dense table and the hash table: the plan cost matches the generic real-valued A* and twice the cost\n"
+        << "of the same task with costs 2 (integer A*), cost bounds just below and above the optimum behave, and\n"
+        << "ResumableSearch expands exactly the same nodes. Returns non-zero on failure.\n";
+    std::exit(2);
+}
+
+// --- helpers ---
+
+static void expect(bool cond, const std::string& what) {
+    if (!cond) {
+        throw std::runtime_error(what);
+    }
+}
+
+// プランを初期状態から順に適用し、全ての演算子が適用可能で、最後にゴールを満たすことを確かめる関数
+static void check_plan(const Task& T, const std::vector<uint32_t>& plan, const std::string& name) {
+    State s = T.init;
+    planner::sas::Undo undo;
+    for (std::size_t i = 0; i < plan.size(); ++i) {
+        expect(plan[i] < T.ops.size(), name + ": operator out of range at step " + std::to_string(i));
+        expect(planner::sas::is_applicable(T, s, T.ops[plan[i]]), name + ": not applicable at step " + std::to_string(i));
+        planner::sas::apply_inplace(T, T.ops[plan[i]], s, undo);
+        undo.clear();
+    }
+    expect(planner::sas::is_goal(T, s), name + ": plan does not reach the goal");
+}
+
+// 全ての演算子のコストを c にしたタスク
+static Task with_costs(const Task& T, int c) {
+    Task out = T;
+    for (auto& op : out.ops) {
+        op.cost = c;
+    }
+    return out;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        die_usage(argv[0]);
+    }
+
+    try {
+        const Task Tu = with_costs(read_file(argv[1]), 1);
+        const Task T2 = with_costs(Tu, 2);
+        expect(planner::sas::all_action_costs_are_unit(Tu), "unit-cost copy is not detected as unit cost");
+        expect(!planner::sas::all_action_costs_are_unit(T2), "cost-2 copy is detected as unit cost");
+
+        for (const bool dense : {true, false}) {
+            for (const auto storage : {planner::sas::StateStorage::Full, planner::sas::StateStorage::Delta}) {
+                planner::sas::Params P;
+                P.verbose = false;
+                P.state_storage = storage;
+                if (!dense) {
+                    P.dense_max_states = 0;
+                }
+                const std::string name = std::string(dense ? "dense" : "hash") +
+                                         (storage == planner::sas::StateStorage::Delta ? "/delta" : "");
+
+                // 単位コストの A* (UnitCost) と、実数の A* (コストモデルによる特殊化なし)、コスト 2 の整数 A* (IntegerCost)
+                const auto U = planner::sas::astar(Tu, planner::sas::blind(), true, P);
+                const auto D = planner::sas::astar(Tu, planner::sas::blind(), false, P);
+                const auto I = planner::sas::astar(T2, planner::sas::blind(), true, P);
+                expect(U.solved && D.solved && I.solved, name + ": some A* did not find a plan");
+                check_plan(Tu, U.plan, name + " unit");
+                expect(U.plan_cost == planner::sas::eval_plan_cost(Tu, U.plan), name + ": wrong plan cost");
+                expect(U.plan_cost == D.plan_cost, name + ": unit-cost A* cost " + std::to_string(U.plan_cost) +
+                                                   ", real-valued A* " + std::to_string(D.plan_cost));
+                expect(2.0 * U.plan_cost == I.plan_cost, name + ": unit-cost A* cost " + std::to_string(U.plan_cost) +
+                                                         ", integer A* with costs 2 " + std::to_string(I.plan_cost));
+
+                // 許容的なヒューリスティックでも最適
+                const auto Up = planner::sas::astar(Tu, planner::sas::hpot_init(Tu), true, P);
+                expect(Up.solved && Up.plan_cost == U.plan_cost, name + ": unit-cost A* with pot is not optimal");
+                check_plan(Tu, Up.plan, name + " unit pot");
+
+                // 上界: 最適コストでは解がないことを示し、それより 1 大きければ最適解を返す
+                if (U.plan_cost > 0.0) {
+                    planner::sas::Params Pb = P;
+                    Pb.cost_bound = U.plan_cost;
+                    const auto B0 = planner::sas::astar(Tu, planner::sas::blind(), true, Pb);
+                    expect(!B0.solved && B0.bound_exhausted, name + ": bound = optimum did not prove that no plan exists");
+                    Pb.cost_bound = U.plan_cost + 1.0;
+                    const auto B1 = planner::sas::astar(Tu, planner::sas::blind(), true, Pb);
+                    expect(B1.solved && B1.plan_cost == U.plan_cost, name + ": bound = optimum + 1 did not return an optimal plan");
+                }
+
+                // 1 ノードずつ展開しても、同じノードを展開して同じコストのプランを得る
+                ResumableSearch rs(Tu, planner::sas::blind(), ResumableSearch::Mode::AStar, P);
+                while (rs.step(1) == StepStatus::Running) {
+                }
+                expect(rs.status() == StepStatus::Solved, name + ": resumable unit-cost A* did not solve the task");
+                expect(rs.result().plan_cost == U.plan_cost, name + ": resumable unit-cost A* cost differs");
+                expect(rs.result().stats.expanded == U.stats.expanded, name + ": resumable unit-cost A* expanded " +
+                                                                       std::to_string(rs.result().stats.expanded) + ", astar " +
+                                                                       std::to_string(U.stats.expanded));
+
+                std::cout << name << ": cost " << U.plan_cost << ", expanded " << U.stats.expanded << " (real-valued A* "
+                          << D.stats.expanded << ", integer A* " << I.stats.expanded << ")\n";
+            }
+        }
+
+        // 初期状態がゴールを満たす場合は空のプラン
+        Task Tg = Tu;
+        Tg.goal.clear();
+        for (std::size_t v = 0; v < Tg.vars.size(); ++v) {
+            Tg.goal.emplace_back(static_cast<int>(v), Tg.init[v]);
+        }
+        planner::sas::Params P;
+        P.verbose = false;
+        const auto G = planner::sas::astar(Tg, planner::sas::blind(), true, P);
+        expect(G.solved && G.plan.empty() && G.plan_cost == 0.0, "goal in the initial state: expected an empty plan");
+    } catch (const std::exception& e) {
+        std::cerr << "FAILED: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "OK\n";
+    return 0;
+}